@@ -101,6 +101,13 @@ void AddControllerSlide::undo()
     }
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t AddControllerSlide::getMemoryFootprint() const
+{
+    return sizeof(*this) + relocator.getMemoryFootprint() + getOwnedObjectsFootprint(removedControlEvents);
+}
+
 void AddControllerSlide::addOneEvent(ControllerEvent* ptr, ptr_vector<ControllerEvent>* vector, int id)
 {
     vector->add( ptr, id );
@@ -46,6 +46,8 @@ namespace AriaMaestosa
             void perform();
             void undo();
             
+            virtual size_t getMemoryFootprint() const;
+            
             
             virtual ~AddControllerSlide();
         };
@@ -56,15 +56,11 @@ void AddNote::undo()
     
     while ((current_note = relocator.getNextNote()) and current_note != NULL)
     {
-        const int noteAmount = m_track->getNoteAmount();
-        for (int n=0; n<noteAmount; n++)
-        {
-            if (m_track->getNote(n) == current_note)
-            {
-                m_track->removeNote(n);
-                break;
-            }//endif
-        }//next
+        const int id = m_track->findNoteID(current_note);
+        ASSERT_E(id,>=,0);
+        
+        // keep the note around, redo will add this same object back
+        m_removed_notes.push_back( m_track->extractNote(id) );
     }//wend
 }
 
@@ -78,21 +74,9 @@ void AddNote::perform()
     if (m_string == -1) tmp_note = new Note(m_track, m_pitch_ID, m_start_tick, m_end_tick, m_volume);
     else                tmp_note = new Note(m_track, m_pitch_ID, m_start_tick, m_end_tick, m_volume, m_string, 0);
     
-    MeasureData* md = m_track->getSequence()->getMeasureData();
-    const int len = md->getTotalTickAmount();
-    
     const bool success = m_track->addNote( tmp_note );
     
-    if (success)
-    {
-        if (m_select)
-        {
-            // select last added note
-            m_track->selectNote(ALL_NOTES, false, true /* ignoreModifiers */);
-            tmp_note->setSelected(true);
-        }
-    }
-    else
+    if (not success)
     {
         delete tmp_note;
         return;
@@ -102,7 +86,36 @@ void AddNote::perform()
     
     tmp_note->play(true);
     
-    if (m_end_tick > len)
+    noteAdded(tmp_note);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void AddNote::redo()
+{
+    // the relocator still holds the notes that were removed on undo
+    const int count = m_removed_notes.size();
+    for (int n=0; n<count; n++)
+    {
+        m_track->addNote( m_removed_notes.get(n), false );
+        noteAdded( m_removed_notes.get(n) );
+    }
+    m_removed_notes.clearWithoutDeleting();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void AddNote::noteAdded(Note* note)
+{
+    if (m_select)
+    {
+        // select last added note
+        m_track->selectNote(ALL_NOTES, false, true /* ignoreModifiers */);
+        note->setSelected(true);
+    }
+    
+    MeasureData* md = m_track->getSequence()->getMeasureData();
+    if (m_end_tick > md->getTotalTickAmount())
     {        
         md->extendToTick(m_end_tick);
     }
@@ -114,6 +127,13 @@ void AddNote::perform()
     m_track->reorderNoteVector();
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t AddNote::getMemoryFootprint() const
+{
+    return sizeof(*this) + relocator.getMemoryFootprint() + getOwnedObjectsFootprint(m_removed_notes);
+}
+
 // ----------------------------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------------------------
 
@@ -262,5 +282,47 @@ namespace TestAddNote
         delete seq;
     }
     
+    // ----------------------------------------------------------------------------------------------------------
+    
+    UNIT_TEST(TestRedo)
+    {            
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        Track* t = new Track(seq);
+        
+        // make a factory sequence to work from
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(100 /* pitch */, 0   /* start */, 100 /* end */, 127 /* volume */, -1);
+            t->addNote_import(101 /* pitch */, 101 /* start */, 200 /* end */, 127 /* volume */, -1);
+        }
+        seq->addTrack(t);
+        
+        seq->getTrack(0)->action(new AddNote(104 /* pitch */, 150 /* start */, 250 /* end */, 127 /* volume */, -1));
+        require(t->getNoteAmount() == 3, "the number of events was increased");
+        Note* added = t->getNote(2);
+        require(added->getPitchID() == 104, "events were properly ordered");
+        
+        seq->undo();
+        require(t->getNoteAmount() == 2, "the number of events was restored on undo");
+        require(t->findNoteID(added) == -1, "the note is no longer part of the track after undo");
+        
+        seq->redo();
+        require(t->getNoteAmount() == 3, "the note was added back on redo");
+        require(t->getNote(2) == added, "redo added back the same note object");
+        require(t->getNote(2)->getTick() == 150, "the note was not modified by undo/redo");
+        require(t->getNoteOffVector().size() == 3, "Note off vector was increased on redo");
+        require(t->getNoteOffVector()[2].getEndTick() == 250, "Note off vector is properly ordered");
+        
+        // and the same note can be removed again
+        seq->undo();
+        require(t->getNoteAmount() == 2, "the number of events was restored on second undo");
+        
+        delete seq;
+    }
+    
 }
 // ----------------------------------------------------------------------------------------------------------
@@ -45,6 +45,11 @@ namespace AriaMaestosa
             
             NoteRelocator relocator;
             
+            /** notes taken out of the track by undo, owned here until redo adds them back */
+            ptr_vector<Note> m_removed_notes;
+            
+            void noteAdded(Note* note);
+            
         public:
             
             AddNote(const int pitchID, const int startTick, const int endTick, const int volume,
@@ -53,6 +58,10 @@ namespace AriaMaestosa
 
             virtual void perform();
             virtual void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
         };
     }
 }
@@ -79,6 +79,13 @@ void DeleteControllerEvent::undo()
 
 // ----------------------------------------------------------------------------------------------------------
 
+size_t DeleteControllerEvent::getMemoryFootprint() const
+{
+    return sizeof(*this) + getOwnedObjectsFootprint(removedControlEvents);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void DeleteControllerEvent::perform()
 {
     ASSERT(m_track != NULL);
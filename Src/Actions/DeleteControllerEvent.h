@@ -46,6 +46,8 @@ namespace AriaMaestosa
             DeleteControllerEvent(int tick);
             void perform();
             void undo();
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~DeleteControllerEvent();
         };
         
@@ -72,6 +72,7 @@ void DeleteSelected::undo()
         for (int n=0; n<noteAmount; n++)
         {
             m_track->addNote( removedNotes.get(n), false );
+            m_restored_notes.rememberNote( removedNotes.get(n) );
         }
         // we will be using the notes again, make sure it doesn't delete them
         removedNotes.clearWithoutDeleting();
@@ -191,6 +192,23 @@ void DeleteSelected::perform()
     m_track->reorderNoteOffVector();
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void DeleteSelected::redo()
+{
+    m_restored_notes.selectOnly(m_track);
+    m_restored_notes.clear();
+    perform();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t DeleteSelected::getMemoryFootprint() const
+{
+    return sizeof(*this) + getOwnedObjectsFootprint(removedNotes) +
+           getOwnedObjectsFootprint(removedControlEvents) + m_restored_notes.getMemoryFootprint();
+}
+
 // ----------------------------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------------------------
 
@@ -359,5 +377,65 @@ namespace DeleteSelectedTest
         provider.verifyUndo();      
     }
     
+    UNIT_TEST(TestDeleteRedo)
+    {
+        TestSeqProvider provider;
+        Sequence* seq = provider.m_seq;
+        Track* t = seq->getTrack(0);
+        
+        t->selectNote(1, true);
+        t->action(new DeleteSelected(NULL));
+        seq->undo();
+        provider.verifyUndo();
+        require(seq->somethingToRedo(), "the undone action can be redone");
+        
+        // the selection is not part of the history, redo must delete the same notes anyway
+        t->selectNote(ALL_NOTES, false, true);
+        t->selectNote(3, true);
+        
+        seq->redo();
+        require(not seq->somethingToRedo(), "the redo stack was emptied");
+        require(t->getNoteAmount() == 3, "the number of events was decreased");
+        require(t->getNote(0)->getPitchID() == 100, "the same notes were deleted");
+        require(t->getNote(1)->getPitchID() == 102, "the same notes were deleted");
+        require(t->getNote(2)->getPitchID() == 103, "the same notes were deleted");
+        require(t->getNoteOffVector().size() == 3, "Note off vector was decreased");
+        
+        seq->undo();
+        provider.verifyUndo();
+        
+        // a new action drops what could be redone
+        t->selectNote(ALL_NOTES, false, true);
+        t->selectNote(0, true);
+        t->action(new DeleteSelected(NULL));
+        require(not seq->somethingToRedo(), "a new action clears the redo stack");
+    }
+    
+    UNIT_TEST(TestUndoMemoryBudget)
+    {
+        TestSeqProvider provider;
+        Sequence* seq = provider.m_seq;
+        Track* t = seq->getTrack(0);
+        
+        for (int n=0; n<3; n++)
+        {
+            t->selectNote(ALL_NOTES, false, true);
+            t->selectNote(0, true);
+            t->action(new DeleteSelected(NULL));
+        }
+        require_e(seq->getUndoLevelAmount(), ==, 3, "the history is not limited by a number of steps");
+        
+        // each action keeps one note, so a budget for about two actions keeps the two most recent ones
+        const size_t oneAction = seq->getUndoMemoryUsage()/3;
+        seq->setUndoMemoryBudget(oneAction*2 + oneAction/2);
+        require_e(seq->getUndoLevelAmount(), ==, 2, "the oldest action was dropped to fit the budget");
+        
+        seq->setUndoMemoryBudget(0);
+        require_e(seq->getUndoLevelAmount(), ==, 1, "the last action is always kept");
+        
+        seq->undo();
+        require(t->getNoteAmount() == 2, "the last action can still be undone");
+    }
+    
 }
 #endif
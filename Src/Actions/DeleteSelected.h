@@ -42,11 +42,19 @@ namespace AriaMaestosa
             Editor* m_editor;
             int m_provider_type;
             
+            /** the notes put back by undo, to delete the same ones on redo */
+            NoteRelocator m_restored_notes;
+            
         public:
             
             DeleteSelected(Editor* editor);
             void perform();
             void undo();
+            
+            /** deleting notes can be redone; controllers depend on the editor selection, which is not kept */
+            virtual bool canRedo() const { return m_provider_type == -1; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~DeleteSelected();
         };
         
@@ -54,6 +54,18 @@ void DeleteTrack::undo()
     m_removed_track = NULL;
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t DeleteTrack::getMemoryFootprint() const
+{
+    if (m_removed_track == NULL) return sizeof(*this);
+    
+    // the whole track is kept; count its notes (and their note off entries) and controller events
+    return sizeof(*this) + sizeof(Track) +
+           m_removed_track->getNoteAmount()*(sizeof(Note) + 2*sizeof(Note*)) +
+           m_removed_track->getControllerEventAmount()*(sizeof(ControllerEvent) + sizeof(ControllerEvent*));
+}
+
 // --------------------------------------------------------------------------------------------------------
 
 void DeleteTrack::perform()
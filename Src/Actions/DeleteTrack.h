@@ -44,6 +44,8 @@ namespace AriaMaestosa
 
             void perform();
             void undo();
+            
+            virtual size_t getMemoryFootprint() const;
         };
         
     }
@@ -73,6 +73,13 @@ void Duplicate::undo()
     }//wend
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t Duplicate::getMemoryFootprint() const
+{
+    return sizeof(*this) + relocator.getMemoryFootprint();
+}
+
 // -------------------------------------------------------------------------------------------------------------
 
 void Duplicate::perform()
@@ -46,6 +46,8 @@ namespace AriaMaestosa
             void perform();
             void undo();
             
+            virtual size_t getMemoryFootprint() const;
+            
             void moveEvent(Action::MoveNotes* event);
             
             virtual ~Duplicate();
@@ -17,8 +17,12 @@
 #include "Actions/EditAction.h"
 #include "Midi/Track.h"
 #include "Midi/ControllerEvent.h"
+#include "UnitTest.h"
+#include "UnitTestUtils.h"
 
 //#include "GUI/GraphicalTrack.h"
+#include <algorithm>
+#include <stdint.h>
 #include <vector>
 
 using namespace AriaMaestosa;
@@ -69,6 +73,23 @@ void MultiTrackAction::setParentSequence(Sequence* parent, SequenceVisitor* visi
 // ----------------------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------------------
 
+/**
+  * Collects the sorted addresses of the notes of a track. Remembered notes are looked up in there by
+  * address only, so notes that were deleted in the meantime are never dereferenced.
+  */
+static void getSortedNoteAddresses(Track* t, std::vector<const Note*>& addresses)
+{
+    const int count = t->getNoteAmount();
+    addresses.resize(count);
+    for (int n=0; n<count; n++)
+    {
+        addresses[n] = t->getNote(n);
+    }
+    std::sort(addresses.begin(), addresses.end());
+}
+
+// ----------------------------------------------------------------------------------------------------
+
 void NoteRelocator::setParent(Track* t)
 {
     m_track = t;
@@ -81,16 +102,51 @@ void NoteRelocator::prepareToRelocate()
     m_id                      = 0;
     m_noteamount_in_track     = m_track->getNoteAmount();
     m_noteamount_in_relocator = notes.size();
+    
+    getSortedNoteAddresses(m_track, m_live_notes);
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+bool NoteRelocator::isLive(const Note* n) const
+{
+    return std::binary_search(m_live_notes.begin(), m_live_notes.end(), n);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 Note* NoteRelocator::getNextNote()
 {
-    if (m_id >= m_noteamount_in_relocator) return NULL;
+    while (m_id < m_noteamount_in_relocator)
+    {
+        m_id++;
+        Note* note = notes.get(m_id - 1);
+        
+        // the note must still be in the track, otherwise the action stack is inconsistent
+        ASSERT( isLive(note) );
+        if (isLive(note)) return note;
+    }
     
-    m_id++;
-    return notes.get(m_id - 1);
+    m_live_notes.clear();
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void NoteRelocator::selectOnly(Track* t)
+{
+    t->selectNote(ALL_NOTES, false, true /* ignoreModifiers */);
+    
+    getSortedNoteAddresses(t, m_live_notes);
+    
+    const int count = notes.size();
+    for (int n=0; n<count; n++)
+    {
+        ASSERT( isLive(notes.get(n)) );
+        if (isLive(notes.get(n))) notes[n].setSelected(true);
+    }
+    
+    m_live_notes.clear();
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -155,3 +211,234 @@ ControlEventRelocator::~ControlEventRelocator()
 {
 }
 
+
+// ----------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+namespace
+{
+    /** bits telling which fields of a note a NoteChangeRecord entry holds */
+    enum ChangedField
+    {
+        CHANGED_TICK       = 1,
+        CHANGED_END_TICK   = 2,
+        CHANGED_PITCH      = 4,
+        CHANGED_VOLUME     = 8,
+        CHANGED_STRING     = 16,
+        CHANGED_FRET       = 32,
+        CHANGED_ACCIDENTAL = 64
+    };
+    
+    /** appends a signed value in 7-bit groups, small magnitudes first (zigzag encoding) */
+    void writeVarInt(std::vector<unsigned char>& out, const int64_t value)
+    {
+        uint64_t bits = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+        while (bits >= 0x80)
+        {
+            out.push_back( (unsigned char)(bits | 0x80) );
+            bits >>= 7;
+        }
+        out.push_back( (unsigned char)bits );
+    }
+    
+    int64_t readVarInt(const unsigned char*& in)
+    {
+        uint64_t bits = 0;
+        int shift = 0;
+        while (*in & 0x80)
+        {
+            bits |= (uint64_t)(*in & 0x7F) << shift;
+            shift += 7;
+            in++;
+        }
+        bits |= (uint64_t)(*in) << shift;
+        in++;
+        
+        return (int64_t)(bits >> 1) ^ -(int64_t)(bits & 1);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void NoteChangeRecord::readState(const Note* note, NoteState& state)
+{
+    state.m_tick       = note->m_start_tick;
+    state.m_end_tick   = note->m_end_tick;
+    state.m_pitch      = note->m_pitch_ID;
+    state.m_volume     = note->m_volume;
+    state.m_string     = note->string;
+    state.m_fret       = note->fret;
+    state.m_accidental = note->m_preferred_accidental_sign;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void NoteChangeRecord::rememberNote(Note* note)
+{
+    NoteState state;
+    state.m_note = note;
+    readState(note, state);
+    m_pending.push_back(state);
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void NoteChangeRecord::commit()
+{
+    // sorting by address makes the distances between notes small; a note remembered several times
+    // keeps its first (oldest) state
+    std::stable_sort(m_pending.begin(), m_pending.end(), addressLess);
+    
+    m_data.clear();
+    m_note_amount = 0;
+    
+    intptr_t previous = 0;
+    const int count = m_pending.size();
+    for (int n=0; n<count; n++)
+    {
+        const NoteState& before = m_pending[n];
+        if (n > 0 and m_pending[n - 1].m_note == before.m_note) continue;
+        
+        NoteState after;
+        readState(before.m_note, after);
+        
+        int changed = 0;
+        if (after.m_tick       != before.m_tick      ) changed |= CHANGED_TICK;
+        if (after.m_end_tick   != before.m_end_tick  ) changed |= CHANGED_END_TICK;
+        if (after.m_pitch      != before.m_pitch     ) changed |= CHANGED_PITCH;
+        if (after.m_volume     != before.m_volume    ) changed |= CHANGED_VOLUME;
+        if (after.m_string     != before.m_string    ) changed |= CHANGED_STRING;
+        if (after.m_fret       != before.m_fret      ) changed |= CHANGED_FRET;
+        if (after.m_accidental != before.m_accidental) changed |= CHANGED_ACCIDENTAL;
+        if (changed == 0) continue;
+        
+        writeVarInt(m_data, (intptr_t)before.m_note - previous);
+        previous = (intptr_t)before.m_note;
+        
+        m_data.push_back(changed);
+        if (changed & CHANGED_TICK      ) writeVarInt(m_data, before.m_tick);
+        if (changed & CHANGED_END_TICK  ) writeVarInt(m_data, before.m_end_tick);
+        if (changed & CHANGED_PITCH     ) writeVarInt(m_data, before.m_pitch);
+        if (changed & CHANGED_VOLUME    ) writeVarInt(m_data, before.m_volume);
+        if (changed & CHANGED_STRING    ) writeVarInt(m_data, before.m_string);
+        if (changed & CHANGED_FRET      ) writeVarInt(m_data, before.m_fret);
+        if (changed & CHANGED_ACCIDENTAL) writeVarInt(m_data, before.m_accidental);
+        m_note_amount++;
+    }
+    
+    std::vector<NoteState>().swap(m_pending);
+    std::vector<unsigned char>(m_data).swap(m_data); // shrink to fit
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+/**
+  * exchanges the value of a note field with the next one in the record, writing the old value in 'out'.
+  * Fields of notes that are no longer in the track are copied through untouched.
+  */
+#define SWAP_FIELD( FLAG, FIELD ) \
+    if (changed & FLAG) \
+    { \
+        const int value = readVarInt(in); \
+        if (live) { writeVarInt(out, note->FIELD); note->FIELD = value; } \
+        else      { writeVarInt(out, value); } \
+    }
+
+void NoteChangeRecord::swap(Track* track)
+{
+    ASSERT(m_pending.empty()); // not committed
+    if (m_data.empty()) return;
+    
+    // the record only holds addresses; check each of them is still a note of the track before writing to it
+    std::vector<const Note*> liveNotes;
+    getSortedNoteAddresses(track, liveNotes);
+    
+    std::vector<unsigned char> out;
+    out.reserve(m_data.size());
+    
+    const unsigned char* in  = &m_data[0];
+    const unsigned char* end = in + m_data.size();
+    
+    intptr_t address = 0;
+    while (in < end)
+    {
+        const int64_t distance = readVarInt(in);
+        writeVarInt(out, distance);
+        address += distance;
+        Note* note = (Note*)address;
+        
+        const bool live = std::binary_search(liveNotes.begin(), liveNotes.end(), note);
+        ASSERT(live);
+        
+        const int changed = *in++;
+        out.push_back(changed);
+        
+        SWAP_FIELD( CHANGED_TICK,       m_start_tick                );
+        SWAP_FIELD( CHANGED_END_TICK,   m_end_tick                  );
+        SWAP_FIELD( CHANGED_PITCH,      m_pitch_ID                  );
+        SWAP_FIELD( CHANGED_VOLUME,     m_volume                    );
+        SWAP_FIELD( CHANGED_STRING,     string                      );
+        SWAP_FIELD( CHANGED_FRET,       fret                        );
+        SWAP_FIELD( CHANGED_ACCIDENTAL, m_preferred_accidental_sign );
+    }
+    
+    m_data.swap(out);
+}
+
+#undef SWAP_FIELD
+
+// ----------------------------------------------------------------------------------------------------
+
+void NoteChangeRecord::clear()
+{
+    std::vector<NoteState>().swap(m_pending);
+    std::vector<unsigned char>().swap(m_data);
+    m_note_amount = 0;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+namespace TestNoteChangeRecord
+{
+    UNIT_TEST(TestSwapRestoresChangedFields)
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(60 /* pitch */, 0   /* start */, 100 /* end */, 80 /* volume */, -1);
+            t->addNote_import(62 /* pitch */, 100 /* start */, 200 /* end */, 80 /* volume */, -1);
+            t->addNote_import(64 /* pitch */, 200 /* start */, 300 /* end */, 80 /* volume */, -1);
+        }
+        seq->addTrack(t);
+        
+        Note& a = *t->getNote(0);
+        Note& b = *t->getNote(1);
+        Note& c = *t->getNote(2);
+        
+        NoteChangeRecord record;
+        record.rememberNote(&b);
+        record.rememberNote(&a);
+        a.setVolume(20);
+        b.setEndTick(250);
+        record.rememberNote(&a); // remembered twice, the first state must win
+        a.setVolume(40);
+        record.rememberNote(&c); // remembered but left untouched
+        record.commit();
+        
+        require(record.getNoteAmount() == 2, "unchanged notes are not recorded");
+        
+        record.swap(t);
+        require(a.getVolume() == 80 and b.getEndTick() == 200, "swap restores the remembered state");
+        require(a.getTick() == 0 and b.getVolume() == 80 and c.getEndTick() == 300, "other fields are left alone");
+        
+        record.swap(t);
+        require(a.getVolume() == 40 and b.getEndTick() == 250, "swapping again redoes the change");
+        
+        delete seq;
+    }
+}
@@ -19,6 +19,8 @@
 
 #include "ptr_vector.h"
 
+#include <vector>
+
 #include "Midi/ControllerEvent.h"
 #include "Midi/Note.h"
 #include "Midi/Sequence.h"
@@ -55,6 +57,11 @@ namespace AriaMaestosa
         int m_noteamount_in_track, m_noteamount_in_relocator;
         Track* m_track;
         
+        /** sorted addresses of the notes that were in the track when relocation started */
+        std::vector<const Note*> m_live_notes;
+        
+        bool isLive(const Note* n) const;
+        
     public:
         
         void rememberNote(Note& n);
@@ -65,8 +72,19 @@ namespace AriaMaestosa
         void setParent(Track* t);
         void prepareToRelocate();
         
-        /** returns one note at a time, and NULL when all of them where given */
+        /**
+          * returns one note at a time, and NULL when all of them where given.
+          * Remembered notes that are no longer part of the track are never returned.
+          */
         Note* getNextNote(); 
+        
+        /** @brief forget all remembered notes, before performing an action again */
+        void clear() { notes.clearWithoutDeleting(); }
+        
+        /** @brief select the remembered notes, and only them */
+        void selectOnly(Track* t);
+        
+        size_t getMemoryFootprint() const { return notes.size()*sizeof(Note*); }
     };
     
     class ControlEventRelocator
@@ -88,6 +106,71 @@ namespace AriaMaestosa
         
         /** returns one note at a time, and NULL when all of them where given */
         ControllerEvent* getNextControlEvent(); 
+        
+        size_t getMemoryFootprint() const { return events.size()*sizeof(ControllerEvent*); }
+    };
+    
+    /**
+     * @brief compact record of the fields an action changed in a set of notes
+     *
+     * Call rememberNote for every note before changing it, then commit once the action is done. Only the
+     * fields that did change are kept, packed in a byte buffer (variable-length integers, notes identified
+     * by the distance to the previous one in memory), so that editing a large track costs a few bytes per
+     * note in the undo history instead of copies of the notes.
+     *
+     * swap() writes the recorded values back into the notes and records the values they had instead, so the
+     * same call undoes the change, then redoes it. Like relocators, it refers to notes by pointer and never
+     * deletes them; swap checks that each address is still a note of the track before writing to it.
+     */
+    class NoteChangeRecord
+    {
+        /** full state of a note while the action is being performed, before commit() */
+        struct NoteState
+        {
+            Note* m_note;
+            int   m_tick, m_end_tick;
+            int   m_pitch, m_volume;
+            int   m_string, m_fret;
+            int   m_accidental;
+        };
+        
+        std::vector<NoteState> m_pending;
+        
+        std::vector<unsigned char> m_data;
+        int m_note_amount;
+        
+        static void readState(const Note* note, NoteState& state);
+        
+        static bool addressLess(const NoteState& a, const NoteState& b) { return a.m_note < b.m_note; }
+        
+    public:
+        
+        NoteChangeRecord() : m_note_amount(0) {}
+        
+        /** @brief remember the current state of a note, that is about to be changed */
+        void rememberNote(Note* note);
+        
+        /** @brief compare remembered notes to their current state and keep only the differences */
+        void commit();
+        
+        /**
+         * @brief exchange the recorded values with those currently in the notes
+         * @param track the track the notes belong to; recorded notes that are no longer part of it
+         *              trip an assert and are left alone
+         * @note  the caller must reorder the note vectors of the track afterwards if ticks may have changed
+         */
+        void swap(Track* track);
+        
+        /** @brief forget everything, e.g. before performing an action again */
+        void clear();
+        
+        /** @return the amount of notes with at least one changed field (once committed) */
+        int getNoteAmount() const { return m_note_amount; }
+        
+        size_t getMemoryFootprint() const
+        {
+            return m_data.capacity() + m_pending.capacity()*sizeof(NoteState);
+        }
     };
     
     /**
@@ -123,11 +206,42 @@ namespace AriaMaestosa
             /** Some actions may not be undoable at any time */
             virtual bool canUndoNow() { return true; }
             
+            /** @return whether this action can be done again once undone, see redo() */
+            virtual bool canRedo() const { return false; }
+            
+            /**
+              * @brief does the action again after undo() was called.
+              *
+              * Only called when canRedo() returns true. The sequence is then back to the state it was in
+              * before perform(), except for the selection, which is not part of the undo history.
+              */
+            virtual void redo() { perform(); }
+            
+            /**
+              * @return approximately how much memory this action keeps alive, in bytes; used to bound the
+              *         undo history. Actions that hold notes or per-note data must override it.
+              */
+            virtual size_t getMemoryFootprint() const { return sizeof(EditAction); }
+            
             virtual ~EditAction() {}
             
             wxString getName() const { return m_name; }
         };
         
+        /** @return the memory used by the elements of a vector, for getMemoryFootprint implementations */
+        template<typename T>
+        size_t getVectorFootprint(const std::vector<T>& vector)
+        {
+            return vector.capacity()*sizeof(T);
+        }
+        
+        /** @return the memory used by a ptr_vector and the objects it owns */
+        template<typename T>
+        size_t getOwnedObjectsFootprint(const ptr_vector<T, HOLD>& vector)
+        {
+            return vector.size()*(sizeof(T*) + sizeof(T));
+        }
+        
         /**
           * @brief an EditAction that modifies a single track
           */
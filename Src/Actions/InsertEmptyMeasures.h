@@ -39,6 +39,8 @@ namespace AriaMaestosa
             InsertEmptyMeasures(int measureID, int amount);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
             virtual ~InsertEmptyMeasures();
         };
         
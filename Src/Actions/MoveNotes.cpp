@@ -41,7 +41,6 @@ MoveNotes::MoveNotes(AriaMaestosa::Editor* editor, const int relativeX, const in
     m_relativeY = relativeY;
     m_note_ID = noteID;
     m_editor = editor;
-    m_move_mode = DELTA;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -54,30 +53,7 @@ MoveNotes::~MoveNotes()
 
 void MoveNotes::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    
-    int n = 0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        if (m_move_mode == SCORE_VERTICAL or m_move_mode == DRUMS_VERTICAL)
-        {
-            current_note->setPitchID( undo_pitch[n] );
-            m_editor->moveNote(*current_note, -m_relativeX, 0);
-            n++;
-        }
-        else if (m_move_mode == GUITAR_VERTICAL)
-        {
-            current_note->setStringAndFret(undo_string[n], undo_fret[n]);
-            m_editor->moveNote(*current_note, -m_relativeX, 0);
-            n++;
-        }
-        else
-        {
-            m_editor->moveNote(*current_note, -m_relativeX, -m_relativeY);
-        }
-    }
+    m_changes.swap(m_track);
     m_track->reorderNoteVector();
     m_track->reorderNoteOffVector();
 }
@@ -91,11 +67,6 @@ void MoveNotes::perform()
     ptr_vector<Note>& notes = m_visitor->getNotesVector();
     MeasureData* md = m_track->getSequence()->getMeasureData();
     const int len = md->getTotalTickAmount();
-    
-    m_mode = m_editor->getNotationType();
-    if      (m_mode == SCORE  and m_relativeY != 0) m_move_mode = SCORE_VERTICAL;
-    else if (m_mode == GUITAR and m_relativeY != 0) m_move_mode = GUITAR_VERTICAL;
-    else if (m_mode == DRUM   and m_relativeY != 0) m_move_mode = DRUMS_VERTICAL;
 
     // perform action
     ASSERT(m_note_ID != ALL_NOTES); // not supported in this function (not needed)
@@ -152,6 +123,23 @@ void MoveNotes::perform()
     
     // FIXME: maybe this should be automatic?
     if (m_track->isNotationTypeEnabled(GUITAR)) m_track->updateNotesForGuitarEditor();
+    
+    m_changes.commit();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MoveNotes::redo()
+{
+    // the record holds the moved positions again after undo
+    undo();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t MoveNotes::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -160,26 +148,8 @@ void MoveNotes::doMoveOneNote(const int noteID)
 {
     ptr_vector<Note>& notes = m_visitor->getNotesVector();
     
-    /*
-      In score and drum mode, it is necessary to remember the pitch of the note on vertical moves
-         In score editor because sharp/flats are not accounted in the number of steps
-         In drum editor because the black headers can introduce additional space vertically between notes
-      In guitar editor, it is easier to remember the string and fret, as it's easy for notes to reach the bottom or top
-         of the editor. When this happens, some notes moves while others don't. So the amount of steps isn't enough,
-         we need to track the moves for all notes individually.
-     */
-    if (m_move_mode == SCORE_VERTICAL or m_move_mode == DRUMS_VERTICAL)
-    {
-        undo_pitch.push_back( notes[noteID].getPitchID() );
-    }
-    else if (m_move_mode == GUITAR_VERTICAL)
-    {
-        undo_fret.push_back( notes[noteID].getFretConst() );
-        undo_string.push_back( notes[noteID].getStringConst() );
-    }
-
+    m_changes.rememberNote( notes.get(noteID) );
     m_editor->moveNote(notes[noteID], m_relativeX, m_relativeY);
-    relocator.rememberNote( notes[noteID] );
 }
 
 // ----------------------------------------------------------------------------------------------------------
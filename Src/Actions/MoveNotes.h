@@ -32,27 +32,12 @@ namespace AriaMaestosa
          */
         class MoveNotes : public SingleTrackAction
         {
-            enum MoveMode
-            {
-                DELTA,           //!< move that only requires to know the amount of steps to perform a correct undo
-                SCORE_VERTICAL,  //!< this modes requires more info than just amount of steps to undo correctly
-                GUITAR_VERTICAL, //!< this modes requires more info than just amount of steps to undo correctly
-                DRUMS_VERTICAL   //!< this modes requires more info than just amount of steps to undo correctly
-            };
-            
             int m_relativeX, m_relativeY, m_note_ID;
             friend class AriaMaestosa::Track;
             
-            MoveMode m_move_mode;
-            
-            // for undo
-            NoteRelocator relocator;
-            int m_mode;
-            
-            // vertical movements in score require a little more than others because of possible accidentals
-            std::vector<short> undo_pitch; // for SCORE_VERTICAL mode
-            std::vector<short> undo_fret;  // for GUITAR_VERTICAL mode
-            std::vector<short> undo_string;
+            // for undo; a move may change the pitch, or the string and fret, in ways that can't be
+            // computed back from the amount of steps (accidentals, notes stopped at the edge...)
+            NoteChangeRecord m_changes;
             
             Editor* m_editor;
             
@@ -66,6 +51,10 @@ namespace AriaMaestosa
             void perform();
             void undo();
             
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
+            
             void doMoveOneNote(const int noteid);
             
             virtual ~MoveNotes();
@@ -41,10 +41,14 @@ NumberPressed::~NumberPressed()
 
 void NumberPressed::undo()
 {
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    Note* note = relocator.getNextNote();
-    note->setFret(m_previous_number);
+    m_changes.swap(m_track);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t NumberPressed::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -60,16 +64,17 @@ void NumberPressed::perform()
     {
         if (not notes[n].isSelected()) continue;
 
-        m_previous_number = notes[n].getFret();
+        m_changes.rememberNote( notes.get(n) );
         notes[n].setFret(m_number);
-        relocator.rememberNote( notes[n] );
         if (not played)
         {
             notes[n].play(true);
             played = true;
         }
-        return;
+        break;
     }//next
+    
+    m_changes.commit();
 }
 
 
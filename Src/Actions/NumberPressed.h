@@ -33,15 +33,19 @@ namespace AriaMaestosa
         {
             friend class AriaMaestosa::Track;
             int m_number;
-            int m_previous_number;
 
-            NoteRelocator relocator;
+            NoteChangeRecord m_changes;
             
         public:
             
             NumberPressed(const int number);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo() { undo(); }
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~NumberPressed();
         };
         
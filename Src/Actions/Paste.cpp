@@ -73,6 +73,13 @@ void Paste::undo()
     }//wend
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t Paste::getMemoryFootprint() const
+{
+    return sizeof(*this) + relocator.getMemoryFootprint();
+}
+
 // -------------------------------------------------------------------------------------------------------------
 
 int Paste::getShiftForRegularPaste()
@@ -45,6 +45,8 @@ namespace AriaMaestosa
             Paste(Editor* editor, const bool atMouse);
             void perform();
             void undo();
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~Paste();
         };
     }
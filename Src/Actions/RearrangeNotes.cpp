@@ -24,30 +24,36 @@
 
 using namespace AriaMaestosa::Action;
 
+// ----------------------------------------------------------------------------------------------------------
+
 RearrangeNotes::RearrangeNotes() :
     //I18N: (undoable) action name
     SingleTrackAction( _("rearrange notes") )
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
 RearrangeNotes::~RearrangeNotes()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
 void RearrangeNotes::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
+    m_changes.swap(m_track);
+}
 
-    int i=0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setStringAndFret( string[i], fret[i] );
-        i++;
-    }//wend
+// ----------------------------------------------------------------------------------------------------------
+
+size_t RearrangeNotes::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
 void RearrangeNotes::perform()
 {
     ASSERT( MAGIC_NUMBER_OK_FOR(*m_visitor.raw_ptr) );
@@ -155,11 +161,7 @@ void RearrangeNotes::perform()
                     for (int m=0; m<abs(fstr); m++)
                     {
                         //FIXME: why do I do this to note 0 fstr times???
-                        Note* current = m_track->getNote(candidates[0]);
-                        relocator.rememberNote( current );
-
-                        fret.push_back( m_track->getNoteFret(candidates[0]) );
-                        string.push_back( m_track->getNoteString(candidates[0]) );
+                        m_changes.rememberNote( m_track->getNote(candidates[0]) );
 
                         Action::ShiftString action( 1, candidates[0] );
                         action.setParentTrack(m_track, new Track::TrackVisitor(*m_visitor.raw_ptr));
@@ -174,11 +176,7 @@ void RearrangeNotes::perform()
                 // lay them out
                 for (int i=1; i<size; i++)
                 {
-                    Note* current = m_track->getNote(candidates[i]);
-                    relocator.rememberNote( current );
-
-                    fret.push_back( m_track->getNoteFret(candidates[i]) );
-                    string.push_back( m_track->getNoteString(candidates[i]) );
+                    m_changes.rememberNote( m_track->getNote(candidates[i]) );
 
                     // place lowest note on lowest needed string, then second lowest note on second lowest string, etc
                     Action::ShiftString action( base_string - i - m_track->getNoteString(candidates[i]) , candidates[i]);
@@ -193,6 +191,7 @@ void RearrangeNotes::perform()
         ASSERT( MAGIC_NUMBER_OK_FOR(*m_visitor.raw_ptr) );
     }//next
 
+    m_changes.commit();
 }
 
 
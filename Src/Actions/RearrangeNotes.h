@@ -33,13 +33,16 @@ namespace AriaMaestosa
         {
             friend class AriaMaestosa::Track;
             
-            NoteRelocator relocator;
-            std::vector<int> fret;
-            std::vector<int> string;
+            NoteChangeRecord m_changes;
         public:
             RearrangeNotes();
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo() { undo(); }
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~RearrangeNotes();
         };
         
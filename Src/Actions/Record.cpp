@@ -52,6 +52,20 @@ void Record::undo()
 
 // ----------------------------------------------------------------------------------------------------------
 
+size_t Record::getMemoryFootprint() const
+{
+    size_t total = sizeof(*this);
+    
+    const int amount = m_actions.size();
+    for (int n=0; n<amount; n++)
+    {
+        total += m_actions[n].getMemoryFootprint();
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void Record::perform()
 {
     ASSERT( MAGIC_NUMBER_OK_FOR(*m_visitor.raw_ptr) );
@@ -42,6 +42,8 @@ namespace AriaMaestosa
             virtual void perform();
             virtual void undo();
             
+            virtual size_t getMemoryFootprint() const;
+            
             void action(SingleTrackAction* action);
 
             virtual bool canUndoNow();
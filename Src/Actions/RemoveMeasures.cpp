@@ -124,6 +124,22 @@ void RemoveMeasures::undo()
 
 // ----------------------------------------------------------------------------------------------------------
 
+size_t RemoveMeasures::getMemoryFootprint() const
+{
+    size_t total = sizeof(*this) + getOwnedObjectsFootprint(removedTempoEvents) +
+                   getOwnedObjectsFootprint(removedTextEvents) + getVectorFootprint(timeSigChangesBackup);
+    
+    const int amount = removedTrackParts.size();
+    for (int n=0; n<amount; n++)
+    {
+        total += sizeof(RemovedTrackPart) + getOwnedObjectsFootprint(removedTrackParts[n].removedNotes) +
+                 getOwnedObjectsFootprint(removedTrackParts[n].removedControlEvents);
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void RemoveMeasures::perform()
 {
     
@@ -54,6 +54,8 @@ namespace AriaMaestosa
             RemoveMeasures(int from_measure, int to_measure);
             void perform();
             void undo();
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~RemoveMeasures();
         };
         
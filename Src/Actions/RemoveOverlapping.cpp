@@ -19,12 +19,13 @@
 #include "Midi/Track.h"
 #include "Midi/Note.h"
 #include "AriaCore.h"
+#include "UnitTest.h"
 
 #include <wx/intl.h>
-#include <wx/utils.h>
 
 #include <algorithm>
 
+using namespace AriaMaestosa;
 using namespace AriaMaestosa::Action;
 
 
@@ -49,54 +50,139 @@ void RemoveOverlapping::undo()
     removedNotes.clearWithoutDeleting();
 }
 
-void RemoveOverlapping::perform()
+// ----------------------------------------------------------------------------------------------------------
+
+size_t RemoveOverlapping::getMemoryFootprint() const
 {
-    ASSERT(m_track != NULL);
-    wxBeginBusyCursor();
-    
-    ptr_vector<Note>& notes = m_visitor->getNotesVector();
+    return sizeof(*this) + getOwnedObjectsFootprint(removedNotes);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    /** orders note indices by pitch, keeping notes of the same pitch in vector order */
+    struct PitchLess
+    {
+        const ptr_vector<Note>& m_notes;
+        PitchLess(const ptr_vector<Note>& notes) : m_notes(notes) {}
+        
+        bool operator()(const int a, const int b) const
+        {
+            return m_notes[a].getPitchID() < m_notes[b].getPitchID();
+        }
+    };
+}
+
+void RemoveOverlapping::findOverlappingNotes(const ptr_vector<Note>& notes, std::vector<int>& removedIDs)
+{
+    /*
+      The all-pairs version of this action visited notes in order and removed a note as soon as it
+      overlapped any other note that was not removed yet. A note that is kept therefore overlaps no
+      note after it, so in the end a note is removed exactly when one of the notes after it overlaps
+      it. Since notes are ordered by start tick, walking each pitch backwards and remembering the
+      earliest start of the notes seen so far is enough to answer that.
+     */
     const int noteAmount = notes.size();
+    removedIDs.clear();
     
-    // compare all notes to see if they match
-    for (int n1=0; n1<noteAmount; n1++)
+    std::vector<int> byPitch(noteAmount);
+    for (int n=0; n<noteAmount; n++) byPitch[n] = n;
+    std::stable_sort(byPitch.begin(), byPitch.end(), PitchLess(notes));
+    
+    std::vector<bool> removed(noteAmount, false);
+    
+    int groupEnd = noteAmount;
+    while (groupEnd > 0)
     {
+        const int pitch = notes[byPitch[groupEnd - 1]].getPitchID();
+        
+        // earliest start of the later notes that have a length, and tick of the nearest later note
+        // without one
+        int  earliestStart     = -1;
+        bool haveEarliestStart = false;
+        int  emptyNoteTick     = -1;
+        bool haveEmptyNote     = false;
         
-        for (int n2=0; n2<noteAmount; n2++)
+        int i = groupEnd - 1;
+        for (; i >= 0 and notes[byPitch[i]].getPitchID() == pitch; i--)
         {
+            const Note& note  = notes[byPitch[i]];
+            const int   start = note.getTick();
+            const int   end   = note.getEndTick();
             
-            if (n1 == n2) continue; // don't compare a note with itself
-            if (notes.isMarked(n1)) continue; // skip notes already removed
-            if (notes.isMarked(n2)) continue; // skip notes already removed
-            
-            // both notes have the same pitch, they are candidates for overlapping
-            if (notes[n1].getPitchID() == notes[n2].getPitchID())
+            if ((haveEarliestStart and earliestStart < end) or
+                (start == end and haveEmptyNote and emptyNoteTick == start))
             {
-                const int from = std::min(notes[n1].getTick(), notes[n2].getTick());
-                const int to = std::max(notes[n1].getEndTick(), notes[n2].getEndTick());
-                // total length of both notes
-                const int length =  (notes[n1].getEndTick() - notes[n1].getTick()) +
-                (notes[n2].getEndTick() - notes[n2].getTick());
-                
-                // if difference between beginning of first note and ending of second note is smaller than their lengths, then the notes overlap
-                // if they both begin at the same tick they also overlap
-                if ( (to - from < length) or (to - from == 0) )
-                {
-                    removedNotes.push_back(&notes[n1]);
-                    m_track->markNoteToBeRemoved(n1);
-                }
-                
-                
-            }// end if pitches match
+                removed[byPitch[i]] = true;
+            }
             
-        }//next n2
-        
-    }//next n1
+            if (end > start)
+            {
+                if (not haveEarliestStart or start < earliestStart) earliestStart = start;
+                haveEarliestStart = true;
+            }
+            else if (start == end)
+            {
+                emptyNoteTick = start;
+                haveEmptyNote = true;
+            }
+        }
+        groupEnd = i + 1;
+    }
+    
+    for (int n=0; n<noteAmount; n++)
+    {
+        if (removed[n]) removedIDs.push_back(n);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void RemoveOverlapping::perform()
+{
+    ASSERT(m_track != NULL);
+    
+    ptr_vector<Note>& notes = m_visitor->getNotesVector();
+    
+    std::vector<int> removedIDs;
+    findOverlappingNotes(notes, removedIDs);
+    
+    const int removedAmount = removedIDs.size();
+    for (int n=0; n<removedAmount; n++)
+    {
+        removedNotes.push_back( notes.get(removedIDs[n]) );
+        m_track->markNoteToBeRemoved(removedIDs[n]);
+    }
     
     m_track->removeMarkedNotes();
-    wxEndBusyCursor();
     
     Display::render();
-    
 }
 
+// ----------------------------------------------------------------------------------------------------------
 
+namespace TestRemoveOverlapping
+{
+    UNIT_TEST(TestFindOverlappingNotes)
+    {
+        ptr_vector<Note> notes;
+        notes.push_back( new Note(NULL, 60, 0,   100, 80) ); // 0: overlapped by 1
+        notes.push_back( new Note(NULL, 60, 50,  150, 80) ); // 1: kept
+        notes.push_back( new Note(NULL, 62, 50,  100, 80) ); // 2: other pitch, kept
+        notes.push_back( new Note(NULL, 60, 150, 200, 80) ); // 3: only touches 1, kept
+        notes.push_back( new Note(NULL, 64, 200, 200, 80) ); // 4: same empty note as 5
+        notes.push_back( new Note(NULL, 64, 200, 200, 80) ); // 5: kept
+        notes.push_back( new Note(NULL, 60, 300, 400, 80) ); // 6: overlapped by 8
+        notes.push_back( new Note(NULL, 60, 300, 300, 80) ); // 7: empty, not an overlap, kept
+        notes.push_back( new Note(NULL, 60, 350, 360, 80) ); // 8: kept
+        
+        std::vector<int> removed;
+        RemoveOverlapping::findOverlappingNotes(notes, removed);
+        
+        require_e(removed.size(), ==, 3, "the right amount of notes is removed");
+        require_e(removed[0], ==, 0, "an overlapped note is removed");
+        require_e(removed[1], ==, 4, "an empty note on the same tick as another is removed");
+        require_e(removed[2], ==, 6, "an overlapped note is removed");
+    }
+}
@@ -20,6 +20,8 @@
 #include "Actions/EditAction.h"
 #include "ptr_vector.h"
 
+#include <vector>
+
 namespace AriaMaestosa
 {
     class Track;
@@ -40,7 +42,21 @@ namespace AriaMaestosa
             RemoveOverlapping();
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual size_t getMemoryFootprint() const;
             virtual ~RemoveOverlapping();
+            
+            /**
+              * @brief finds the notes this action removes
+              *
+              * A note is removed when a note that comes after it in the vector has the same pitch and
+              * overlaps it (or, for notes of no length, starts and ends on the same tick). Runs in
+              * O(n log n); expects the notes to be ordered by start tick, as in a track.
+              *
+              * @param[out] removedIDs the indices of the notes to remove, in increasing order
+              */
+            static void findOverlappingNotes(const ptr_vector<Note>& notes, std::vector<int>& removedIDs);
         };
         
     }
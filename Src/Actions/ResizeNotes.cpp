@@ -44,13 +44,7 @@ ResizeNotes::~ResizeNotes()
 
 void ResizeNotes::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->resize( -m_relative_width );
-    }
+    m_changes.swap(m_track);
     m_track->reorderNoteVector();
     m_track->reorderNoteOffVector();
 }
@@ -75,8 +69,8 @@ void ResizeNotes::perform()
         {
             if (not notes[n].isSelected()) continue;
             
+            m_changes.rememberNote(notes.get(n));
             notes[n].resize(m_relative_width);
-            relocator.rememberNote(notes[n]);
             
             if (notes[n].getEndTick() > last_tick) last_tick = notes[n].getEndTick();
             
@@ -94,13 +88,15 @@ void ResizeNotes::perform()
         ASSERT_E(m_note_ID,<,notes.size());
         ASSERT_E(m_note_ID,>=,0);
         
+        m_changes.rememberNote(notes.get(m_note_ID));
         notes[m_note_ID].resize(m_relative_width);
         notes[m_note_ID].play(false);
         
         last_tick = notes[m_note_ID].getEndTick();
-        relocator.rememberNote(notes[m_note_ID]);
     }
     
+    m_changes.commit();
+    
     MeasureData* md = m_track->getSequence()->getMeasureData();
     if (last_tick > md->getTotalTickAmount())
     {        
@@ -111,3 +107,18 @@ void ResizeNotes::perform()
 }
 
 // ----------------------------------------------------------------------------------------------------------
+
+void ResizeNotes::redo()
+{
+    // the record holds the new lengths again after undo
+    undo();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ResizeNotes::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
+}
+
+// ----------------------------------------------------------------------------------------------------------
@@ -35,11 +35,16 @@ namespace AriaMaestosa
             int m_note_ID;
             friend class AriaMaestosa::Track;
             
-            NoteRelocator relocator;
+            NoteChangeRecord m_changes;
+            
         public:
             ResizeNotes(const int relativeWidth, const int noteID);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~ResizeNotes();
         };
         
@@ -59,3 +59,28 @@ void ScaleSong::undo()
     }
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void ScaleSong::redo()
+{
+    const int amount = actions.size();
+    for (int a=0; a<amount; a++)
+    {
+        actions[a].redo();
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ScaleSong::getMemoryFootprint() const
+{
+    size_t total = sizeof(*this);
+    
+    const int amount = actions.size();
+    for (int a=0; a<amount; a++)
+    {
+        total += actions[a].getMemoryFootprint();
+    }
+    return total;
+}
+
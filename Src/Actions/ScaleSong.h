@@ -42,6 +42,10 @@ namespace AriaMaestosa
             ScaleSong(float factor, int relative_to);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~ScaleSong();
         };
         
@@ -44,16 +44,7 @@ ScaleTrack::~ScaleTrack()
 
 void ScaleTrack::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    int n=0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setTick( m_note_start[n] );
-        current_note->setEndTick( m_note_end[n] );
-        n++;
-    }
+    m_changes.swap(m_track);
     m_track->reorderNoteVector();
     m_track->reorderNoteOffVector();
 }
@@ -77,17 +68,16 @@ void ScaleTrack::perform()
         const int startTick = notes[n].getTick();
         const int endTick   = notes[n].getEndTick();
         
-        m_note_start.push_back( startTick );
-        m_note_end.push_back( endTick );
-        
+        m_changes.rememberNote(notes.get(n));
         notes[n].setTick   ( (int)( (startTick - m_relative_to)*m_factor + m_relative_to ) );
         notes[n].setEndTick( (int)( (endTick   - m_relative_to)*m_factor + m_relative_to ) );
-        relocator.rememberNote(notes[n]);
         
         if (notes[n].getEndTick() > last_tick) last_tick = notes[n].getEndTick();
         
     }//next
     
+    m_changes.commit();
+    
     MeasureData* md = m_track->getSequence()->getMeasureData();
     if (last_tick > md->getTotalTickAmount())
     {        
@@ -101,3 +91,18 @@ void ScaleTrack::perform()
 
 // ----------------------------------------------------------------------------------------------------------
 
+void ScaleTrack::redo()
+{
+    // the record holds the scaled positions again after undo
+    undo();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ScaleTrack::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
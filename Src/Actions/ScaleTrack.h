@@ -36,15 +36,17 @@ namespace AriaMaestosa
             int   m_relative_to;
             bool  m_selection_only;
             
-            NoteRelocator relocator;
-            std::vector<int> m_note_start;
-            std::vector<int> m_note_end;
+            NoteChangeRecord m_changes;
             
         public:
             
             ScaleTrack(float factor, int relative_to, bool selectionOnly);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~ScaleTrack();
         };
         
@@ -58,6 +58,13 @@ void ScrollNotesIntoView::undo()
     }
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ScrollNotesIntoView::getMemoryFootprint() const
+{
+    return sizeof(*this) + getVectorFootprint(m_positions);
+}
+
 // --------------------------------------------------------------------------------------------------------
 
 void ScrollNotesIntoView::perform()
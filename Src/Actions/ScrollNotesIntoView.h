@@ -41,6 +41,8 @@ namespace AriaMaestosa
 
             void perform();
             void undo();
+            
+            virtual size_t getMemoryFootprint() const;
         };
         
     }
@@ -46,17 +46,14 @@ SetAccidentalSign::~SetAccidentalSign()
 
 void SetAccidentalSign::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
+    m_changes.swap(m_track);
+}
 
-    int n = 0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setPreferredAccidentalSign( m_original_signs[n] );
-        current_note->setPitchID( m_pitch[n] );
-        n++;
-    }
+// ----------------------------------------------------------------------------------------------------------
+
+size_t SetAccidentalSign::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -72,11 +69,8 @@ void SetAccidentalSign::perform()
     {
         if (not notes[n].isSelected()) continue;
 
-        m_original_signs.push_back( notes[n].getPreferredAccidentalSign() );
-        m_pitch.push_back( notes[n].getPitchID() );
-
+        m_changes.rememberNote( notes.get(n) );
         m_track->getGraphics()->getScoreEditor()->setNoteSign(m_sign, n);
-        relocator.rememberNote( notes[n] );
 
         if (not played)
         {
@@ -87,6 +81,8 @@ void SetAccidentalSign::perform()
 
     // FIXME: maybe this should be automatic?
     if (m_track->isNotationTypeEnabled(GUITAR)) m_track->updateNotesForGuitarEditor();
+    
+    m_changes.commit();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -34,15 +34,18 @@ namespace AriaMaestosa
             friend class AriaMaestosa::Track;
             
             // for undo
-            NoteRelocator relocator;
-            std::vector<int> m_original_signs;
-            std::vector<int> m_pitch;
+            NoteChangeRecord m_changes;
             
         public:
             
             SetAccidentalSign(const int sign);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo() { undo(); }
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~SetAccidentalSign();
         };
     }
@@ -37,15 +37,7 @@ SetNoteVolume::~SetNoteVolume()
 
 void SetNoteVolume::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    int n = 0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setVolume( m_volumes[n] );
-        n++;
-    }
+    m_changes.swap(m_track);
 }
 
 void SetNoteVolume::perform()
@@ -65,10 +57,9 @@ void SetNoteVolume::perform()
             if (notes[n].isSelected())
             {
                 volume = notes[n].getVolume();
-                m_volumes.push_back(volume);
                 adjustVolume(volume);
+                m_changes.rememberNote(notes.get(n));
                 notes[n].setVolume(volume);
-                relocator.rememberNote(notes[n]);
                 if (not played)
                 {
                     notes[n].play(true);
@@ -87,13 +78,29 @@ void SetNoteVolume::perform()
         
         // if user changed the volume of a note that is not selected, change the volume of this note only
         volume = notes[m_note_ID].getVolume();
-        m_volumes.push_back(volume);
         adjustVolume(volume);
+        m_changes.rememberNote(notes.get(m_note_ID));
         notes[m_note_ID].setVolume(volume);
-        relocator.rememberNote(notes[m_note_ID]);
         notes[m_note_ID].play(true);
     }
     
+    m_changes.commit();
+    
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void SetNoteVolume::redo()
+{
+    // the record holds the new volumes again after undo
+    m_changes.swap(m_track);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t SetNoteVolume::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 void SetNoteVolume::adjustVolume(int& volume)
@@ -38,8 +38,7 @@ namespace AriaMaestosa
             /** for undo */
             int m_old_volume;
             
-            NoteRelocator relocator;
-            std::vector<int> m_volumes;
+            NoteChangeRecord m_changes;
             
             void adjustVolume(int& volume);
             
@@ -52,6 +51,10 @@ namespace AriaMaestosa
             SetNoteVolume(const int value, const int noteID, const bool increment = false);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~SetNoteVolume();
         };
         
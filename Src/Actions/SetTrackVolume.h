@@ -41,6 +41,8 @@ namespace AriaMaestosa
             SetTrackVolume(const int volume);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
             virtual ~SetTrackVolume();
         };
         
@@ -43,16 +43,7 @@ ShiftBySemiTone::~ShiftBySemiTone()
 
 void ShiftBySemiTone::undo()
 {
-    Note* current_note;
-    m_relocator.setParent(m_track);
-    m_relocator.prepareToRelocate();
-    
-    int n = 0;
-    while ((current_note = m_relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setPitchID( current_note->getPitchID() - m_delta_y );
-        n++;
-    }
+    m_changes.swap(m_track);
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -79,8 +70,8 @@ void ShiftBySemiTone::perform()
             
             if (not note->isSelected()) continue;
             
+            m_changes.rememberNote(note);
             note->setPitchID( note->getPitchID() + m_delta_y );
-            m_relocator.rememberNote( notes[n] );
             
             if (not played)
             {
@@ -98,15 +89,31 @@ void ShiftBySemiTone::perform()
         ASSERT_E(m_note_id,<,notes.size());
         
         Note* note = notes.get(m_note_id);
-
+        m_changes.rememberNote(note);
         note->setPitchID( note->getPitchID() + m_delta_y );
-        m_relocator.rememberNote( notes[m_note_id] );
         
         note->play(true);
     }
     
     // FIXME: maybe this should be automatic?
     if (m_track->isNotationTypeEnabled(GUITAR)) m_track->updateNotesForGuitarEditor();
+    
+    m_changes.commit();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ShiftBySemiTone::redo()
+{
+    // the record holds the new pitches again after undo
+    m_changes.swap(m_track);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ShiftBySemiTone::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -36,13 +36,17 @@ namespace AriaMaestosa
             int m_delta_y;
             int m_note_id;
             
-            NoteRelocator m_relocator;
+            NoteChangeRecord m_changes;
             
         public:
             
             ShiftBySemiTone(const int deltaY, const int noteid);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~ShiftBySemiTone();
         };
         
@@ -33,16 +33,14 @@ ShiftFrets::ShiftFrets(const int amount, const int noteID) :
 
 void ShiftFrets::undo()
 {
-    //undo_obj.restoreState(track);
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    int n = 0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setStringAndFret( m_strings[n], m_frets[n] );
-        n++;
-    }
+    m_changes.swap(m_track);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ShiftFrets::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 void ShiftFrets::perform()
@@ -65,10 +63,8 @@ void ShiftFrets::perform()
         {
             if (not notes[n].isSelected()) continue;
             
-            m_strings.push_back( notes[n].getString() );
-            m_frets.push_back( notes[n].getFret() );
+            m_changes.rememberNote( notes.get(n) );
             notes[n].shiftFret(m_amount);
-            relocator.rememberNote( notes[n] );
             
             if (not played)
             {
@@ -85,14 +81,14 @@ void ShiftFrets::perform()
         ASSERT_E(m_note_id,>=,0);
         ASSERT_E(m_note_id,<,notes.size());
         
-        m_frets.push_back( notes[m_note_id].getFret() );
-        m_strings.push_back( notes[m_note_id].getString() );
+        m_changes.rememberNote( notes.get(m_note_id) );
         notes[m_note_id].shiftFret(m_amount);
-        relocator.rememberNote( notes[m_note_id] );
         
         notes[m_note_id].play(true);
     }
     
+    m_changes.commit();
+    
 }
 
 
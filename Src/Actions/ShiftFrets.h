@@ -36,9 +36,7 @@ namespace AriaMaestosa
             friend class AriaMaestosa::Track;
             int m_amount, m_note_id;
             
-            NoteRelocator relocator;
-            std::vector<int> m_frets;
-            std::vector<int> m_strings;
+            NoteChangeRecord m_changes;
 
         public:
             
@@ -47,6 +45,11 @@ namespace AriaMaestosa
 
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo() { undo(); }
+            
+            virtual size_t getMemoryFootprint() const;
         };
         
         
@@ -40,16 +40,14 @@ ShiftString::~ShiftString()
 
 void ShiftString::undo()
 {
-    Note* current_note;
-    m_relocator.setParent(m_track);
-    m_relocator.prepareToRelocate();
-    
-    int n = 0;
-    while ((current_note = m_relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setStringAndFret( m_strings[n], m_frets[n] );
-        n++;
-    }
+    m_changes.swap(m_track);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ShiftString::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -77,13 +75,9 @@ void ShiftString::perform()
         {
             if (not notes[n].isSelected()) continue;
             
-            m_frets.push_back( notes[n].getFret() );
-            m_strings.push_back( notes[n].getString() );
-            
+            m_changes.rememberNote( notes.get(n) );
             notes[n].shiftString(m_amount);
             
-            m_relocator.rememberNote( notes[n] );
-            
             if (not played)
             {
                 notes[n].play(false);
@@ -97,13 +91,13 @@ void ShiftString::perform()
         ASSERT_E(m_note_id,>=,0);
         ASSERT_E(m_note_id,<,notes.size());
         
-        m_frets.push_back( notes[m_note_id].getFret() );
-        m_strings.push_back( notes[m_note_id].getString() );
+        m_changes.rememberNote( notes.get(m_note_id) );
         notes[m_note_id].shiftString(m_amount);
-        m_relocator.rememberNote( notes[m_note_id] );
         notes[m_note_id].play(false);
     }
     
+    m_changes.commit();
+    
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -37,15 +37,18 @@ namespace AriaMaestosa
             int m_amount;
             int m_note_id;
             
-            NoteRelocator m_relocator;
-            std::vector<int> m_frets;
-            std::vector<int> m_strings;
+            NoteChangeRecord m_changes;
             
         public:
             
             ShiftString(const int amount, const int noteid);
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo() { undo(); }
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~ShiftString();
         };
     }
@@ -35,16 +35,7 @@ SnapNotesToGrid::~SnapNotesToGrid()
 
 void SnapNotesToGrid::undo()
 {
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    int n = 0;
-    while ((current_note = relocator.getNextNote()) and current_note != NULL)
-    {
-        current_note->setTick( note_start[n] );
-        current_note->setEndTick( note_end[n] );
-        n++;
-    }
+    m_changes.swap(m_track);
     m_track->reorderNoteVector();
     m_track->reorderNoteOffVector();
 }
@@ -63,8 +54,7 @@ void SnapNotesToGrid::perform()
         Note* note = notes.get(n);
         if (not note->isSelected()) continue;
         
-        note_start.push_back( note->getTick() );
-        note_end.push_back( note->getEndTick() );
+        m_changes.rememberNote(note);
         
         int len = note->getEndTick() - note->getTick();
         note->setTick( m_track->snapMidiTickToGrid( note->getTick(), true ) );
@@ -78,13 +68,28 @@ void SnapNotesToGrid::perform()
         }
         
         note->setEndTick( end_tick );
-        relocator.rememberNote(notes[n]);
     }
+    m_changes.commit();
     
     
     m_track->reorderNoteVector();
     m_track->reorderNoteOffVector();
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void SnapNotesToGrid::redo()
+{
+    // the record holds the snapped positions again after undo
+    undo();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t SnapNotesToGrid::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint();
+}
+
 
 
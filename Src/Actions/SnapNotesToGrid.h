@@ -33,15 +33,17 @@ namespace AriaMaestosa
         {
             friend class AriaMaestosa::Track;
             
-            NoteRelocator relocator;
-            std::vector<int> note_start;
-            std::vector<int> note_end;
+            NoteChangeRecord m_changes;
             
         public:
             
             SnapNotesToGrid();
             void perform();
             void undo();
+            
+            virtual bool canRedo() const { return true; }
+            virtual void redo();
+            virtual size_t getMemoryFootprint() const;
             virtual ~SnapNotesToGrid();
         };
         
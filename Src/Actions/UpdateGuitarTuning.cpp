@@ -39,18 +39,7 @@ void UpdateGuitarTuning::undo()
     GuitarTuning* tuning = m_track->getGuitarTuning();
     tuning->tuning = previous_tuning;
     
-    Note* current_note;
-    relocator.setParent(m_track);
-    relocator.prepareToRelocate();
-    
-    {
-        int n = 0;
-        while ((current_note = relocator.getNextNote()) and current_note != NULL)
-        {
-            current_note->setStringAndFret( strings[n], frets[n] );
-            n++;
-        }
-    }
+    m_changes.swap(m_track);
     
     ptr_vector<Note>& notes = m_visitor->getNotesVector();
     const int amount_n = notes.size();
@@ -60,6 +49,13 @@ void UpdateGuitarTuning::undo()
     }//next
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+size_t UpdateGuitarTuning::getMemoryFootprint() const
+{
+    return sizeof(*this) + m_changes.getMemoryFootprint() + getVectorFootprint(previous_tuning);
+}
+
 void UpdateGuitarTuning::perform()
 {
     ASSERT(m_track != NULL);
@@ -70,14 +66,11 @@ void UpdateGuitarTuning::perform()
     const int amount_n = notes.size();
     for (int n=0; n<amount_n; n++)
     {
-        frets.push_back( notes[n].getFret() );
-        strings.push_back( notes[n].getString() );
-        
+        m_changes.rememberNote( notes.get(n) );
         notes[n].checkIfStringAndFretMatchNote(true);
-        
-        relocator.rememberNote( notes[n] );
     }//next
     
+    m_changes.commit();
 }
 
 
@@ -34,9 +34,7 @@ namespace AriaMaestosa
             friend class AriaMaestosa::Track;
             int id;
             
-            NoteRelocator relocator;
-            std::vector<int> frets;
-            std::vector<int> strings;
+            NoteChangeRecord m_changes;
             
             std::vector<int> previous_tuning;
             
@@ -45,6 +43,8 @@ namespace AriaMaestosa
             UpdateGuitarTuning();
             void perform();
             void undo();
+            
+            virtual size_t getMemoryFootprint() const;
             virtual ~UpdateGuitarTuning();
         };
         
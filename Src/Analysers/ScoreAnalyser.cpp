@@ -402,6 +402,22 @@ void NoteRenderInfo::setY(const int newY)
     m_y = newY;
 }
 
+// -----------------------------------------------------------------------------------------------------------
+
+bool NoteRenderInfo::sameNoteAs(const NoteRenderInfo& other) const
+{
+    // everything else is derived from these by ScoreAnalyser::addToVector
+    return m_tick           == other.m_tick           and
+           m_tick_length    == other.m_tick_length    and
+           m_level          == other.m_level          and
+           m_sign           == other.m_sign           and
+           m_selected       == other.m_selected       and
+           m_pitch          == other.m_pitch          and
+           m_tied_with_tick == other.m_tied_with_tick and
+           m_measure_begin  == other.m_measure_begin  and
+           m_measure_end    == other.m_measure_end;
+}
+
 // -----------------------------------------------------------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------
 
@@ -604,6 +620,45 @@ void ScoreAnalyser::analyseNoteInfo()
 
 // -----------------------------------------------------------------------------------------------------------
 
+bool ScoreAnalyser::analyseMeasure(const std::vector<NoteRenderInfo>& added, AnalysedMeasure& measure,
+                                   const bool reuse)
+{
+    if (reuse and added.size() == measure.m_added.size())
+    {
+        bool same = true;
+        const int count = added.size();
+        for (int n=0; n<count and same; n++)
+        {
+            same = added[n].sameNoteAs(measure.m_added[n]);
+        }
+        if (same) return false;
+    }
+    
+    m_note_render_info.assign(added.begin(), added.end());
+    analyseNoteInfo();
+    
+    measure.m_added = added;
+    measure.m_analysed.assign(m_note_render_info.begin(), m_note_render_info.end());
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void ScoreAnalyser::loadMeasures(const std::vector<AnalysedMeasure>& measures, const int fromMeasure,
+                                 const int toMeasure, const bool analysed)
+{
+    ASSERT_E(toMeasure, <, (int)measures.size());
+    
+    m_note_render_info.clear();
+    for (int n=fromMeasure; n<=toMeasure; n++)
+    {
+        const std::vector<NoteRenderInfo>& notes = (analysed ? measures[n].m_analysed : measures[n].m_added);
+        m_note_render_info.insert(m_note_render_info.end(), notes.begin(), notes.end());
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 ScoreAnalyser* ScoreAnalyser::getSubset(const int fromTick, const int toTick) const
 {
     ScoreAnalyser* out = new ScoreAnalyser();
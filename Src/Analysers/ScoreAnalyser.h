@@ -52,7 +52,8 @@ namespace AriaMaestosa
       * A vector of these objects is created inthe first rendering pass.
       * This vector contains one of these for each visible note. This vector is then analysed and used in the
       * next rendering passes. The object starts with a few info fields, passed in the constructors, and builds/tweaks
-      * the others as needed in the next passes. The vector is destroyed and recreated with each render.
+      * the others as needed in the next passes. The score editor keeps these vectors measure by measure
+      * between renders, see AnalysedMeasure.
       *
       * A few utility methods will ease setting some variables, but they are usually changed directly from code.
       * @ingroup analysers
@@ -214,6 +215,29 @@ namespace AriaMaestosa
         {
             return m_tick == other.m_tick;
         }
+        
+        /**
+          * @return whether both objects were added to the analyser for the same note; unlike operator==,
+          *         which only compares ticks, this compares everything the analysis is based on
+          */
+        bool sameNoteAs(const NoteRenderInfo& other) const;
+    };
+    
+    /**
+      * @brief The notes of one measure, as added to a ScoreAnalyser and after analysis.
+      *
+      * Chords, triplet signs and beams never cross a measure bar, so each measure can be analysed on its
+      * own and its result reused for as long as its notes do not change. The score editor keeps one of
+      * these per measure and clef between renders (see ScoreAnalyser::analyseMeasure).
+      * @ingroup analysers
+      */
+    struct AnalysedMeasure
+    {
+        /** the notes of the measure as they were added (see ScoreAnalyser::addToVector), in time order */
+        std::vector<NoteRenderInfo> m_added;
+        
+        /** the same notes after ScoreAnalyser::analyseNoteInfo */
+        std::vector<NoteRenderInfo> m_analysed;
     };
         
     class BeamGroup;
@@ -284,6 +308,29 @@ namespace AriaMaestosa
          */
         void analyseNoteInfo();
         
+        /**
+          * @brief analyse the notes of a single measure, unless they are the ones analysed last time
+          *
+          * The notes of the analyser are used as scratch space, call clearAndPrepare before adding notes
+          * again.
+          *
+          * @param added   the notes of the measure, as added with addToVector, in time order
+          * @param measure the previous analysis of this measure, replaced if it can't be reused
+          * @param reuse   false if the previous analysis is obsolete even for the same notes (for instance
+          *                because the time signature of the measure changed)
+          * @return whether the measure was analysed again
+          */
+        bool analyseMeasure(const std::vector<NoteRenderInfo>& added, AnalysedMeasure& measure,
+                            const bool reuse);
+        
+        /**
+          * @brief replace the notes of the analyser with those of a range of measures
+          * @param analysed whether to load the notes as they were after analysis, which can then be
+          *                 rendered without calling analyseNoteInfo, or as they were added
+          */
+        void loadMeasures(const std::vector<AnalysedMeasure>& measures, const int fromMeasure,
+                          const int toMeasure, const bool analysed);
+        
         /** @brief set the level below which the stem is up, and above which it is down */
         void setStemPivot(const int level);
         
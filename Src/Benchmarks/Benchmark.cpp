@@ -0,0 +1,62 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Benchmarks/Benchmark.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/** benchmarks register themselves while static objects are built, so the list must be built on first use */
+static std::vector<BenchmarkCase*>& getBenchmarks()
+{
+    static std::vector<BenchmarkCase*> benchmarks;
+    return benchmarks;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+BenchmarkCase::BenchmarkCase(const char* name)
+{
+    m_name = name;
+    getBenchmarks().push_back(this);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BenchmarkCase::runAll()
+{
+    std::vector<BenchmarkCase*>& benchmarks = getBenchmarks();
+    if (benchmarks.empty())
+    {
+        std::cerr << "Error: Benchmarks were not compiled into this binary (build with benchmarks=1)." << std::endl;
+        return;
+    }
+    
+    for (unsigned int n=0; n<benchmarks.size(); n++)
+    {
+        std::cout << "==== " << benchmarks[n]->getName() << " ====" << std::endl;
+        
+        try
+        {
+            benchmarks[n]->run();
+        }
+        catch (const std::exception& ex)
+        {
+            std::cout << "\033[1m\033[31mFAILED\033[0m : \033[43m" << ex.what() << "\033[0m" << std::endl;
+        }
+    }
+}
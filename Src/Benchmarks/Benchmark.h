@@ -0,0 +1,52 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <string>
+
+/**
+  * @brief a timing run, declared with the BENCHMARK macro
+  *
+  * Benchmarks are kept out of the unit tests since they take long and print their timings. They
+  * are only compiled in when building with 'scons benchmarks=1' (which defines ARIA_BENCHMARKS),
+  * preferably in the release configuration, and run with 'Aria --benchmark'. Like unit tests,
+  * they can check their results with 'require'.
+  */
+class BenchmarkCase
+{
+    std::string m_name;
+public:
+    BenchmarkCase(const char* name);
+    virtual ~BenchmarkCase() {}
+    virtual void run() = 0;
+    
+    const std::string& getName() const { return m_name; }
+    
+    /** @brief run all the benchmarks compiled into this binary */
+    static void runAll();
+};
+
+#ifdef ARIA_BENCHMARKS
+#define BENCHMARK( NAME ) class NAME : public BenchmarkCase { public: NAME(const char* name) : BenchmarkCase(name){} void run(); }; \
+                          static NAME benchmark_##NAME( #NAME ); void NAME::run()
+#else
+// same trick as UNIT_TEST in release mode : the template is never instantiated, so the code is discarded
+#define BENCHMARK( NAME ) template<typename T> void NAME ## _uninstantiated()
+#endif
+
+#endif
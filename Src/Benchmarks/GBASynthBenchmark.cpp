@@ -0,0 +1,191 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Renders a full polyphony of GBA synth voices (direct sound, square, noise and programmable
+ * wave) with the block renderer and with the original per-sample renderer it replaced (see
+ * GBASynthEngine::setBlockRendering), and checks both produce the same output. The unit test
+ * renders a few seconds; the benchmark renders one minute and reports how many times faster than
+ * realtime each renderer is (see Benchmark.h).
+ */
+
+#include "Benchmarks/Benchmark.h"
+#include "Midi/Players/GBA/GBASynthEngine.h"
+#include "UnitTest.h"
+
+#include <cmath>
+#include <iostream>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace GBASynthBenchmark
+{
+    const int BENCHMARK_SAMPLE_RATE = 48000;
+    const int TEST_SECONDS          = 3;
+    const int BENCHMARK_SECONDS     = 60;
+    const int BENCHMARK_BLOCK_SIZE  = 512;
+    
+    static GBAVoice makeVoice(GBAVoice::Type type, GBASample* sample)
+    {
+        GBAVoice voice;
+        voice.type        = type;
+        voice.baseMidiKey = 60;
+        voice.pan         = 0;
+        voice.sample      = sample;
+        voice.dutyCycle   = 2;
+        voice.sweep       = 0;
+        voice.period      = 0;
+        voice.decay       = 0;
+        voice.release     = 0;
+        
+        const bool cgb = (type != GBAVoice::DIRECT_SOUND);
+        voice.attack      = cgb ? 0 : 255;
+        voice.sustain     = cgb ? 15 : 255;
+        return voice;
+    }
+    
+    /** starts the same voices on a fresh engine, so that both renderers get the same input */
+    static void startVoices(GBASynthEngine& engine, const GBAVoice* directSound, const GBAVoice* square,
+                            const GBAVoice* noise, const GBAVoice* progWave)
+    {
+        engine.setSampleRate(BENCHMARK_SAMPLE_RATE);
+        
+        for (int n=0; n<MAX_ACTIVE_VOICES; n++)
+        {
+            const GBAVoice* voice = (n < 12 ? directSound : n < 18 ? square : n < 21 ? noise : progWave);
+            engine.noteOn(40 + n*2, 100, n % 16, voice);
+        }
+        
+        // exercise the LFO paths too (tremolo on one channel)
+        engine.controlChange(1, 40, 3);
+        engine.controlChange(22, 1, 3);
+    }
+    
+    /** @brief what rendering the same voices with both renderers gave */
+    struct Comparison
+    {
+        long m_block_time, m_sample_time;
+        double m_mean_difference;
+        int m_different_samples;
+    };
+    
+    static Comparison compareRenderers(const int seconds)
+    {
+        // a looped sine-ish sample and a 32-step programmable wave
+        GBASample pcm;
+        pcm.sampleRate   = 13379;
+        pcm.loopStart    = 1000;
+        pcm.numSamples   = 4000;
+        pcm.isLooped     = true;
+        pcm.isCompressed = false;
+        for (unsigned int n=0; n<pcm.numSamples; n++)
+        {
+            pcm.pcmData.push_back( (int8_t)(100.0*sin(n*0.05)) );
+        }
+        
+        GBASample wave;
+        wave.sampleRate   = 0;
+        wave.loopStart    = 0;
+        wave.numSamples   = 32;
+        wave.isLooped     = true;
+        wave.isCompressed = false;
+        for (unsigned int n=0; n<wave.numSamples; n++)
+        {
+            wave.pcmData.push_back( (int8_t)(n*8 - 128) );
+        }
+        
+        const GBAVoice directSound = makeVoice(GBAVoice::DIRECT_SOUND, &pcm);
+        const GBAVoice square      = makeVoice(GBAVoice::SQUARE_1, NULL);
+        const GBAVoice noise       = makeVoice(GBAVoice::NOISE, NULL);
+        const GBAVoice progWave    = makeVoice(GBAVoice::PROG_WAVE, &wave);
+        
+        GBASynthEngine blockEngine;
+        startVoices(blockEngine, &directSound, &square, &noise, &progWave);
+        
+        GBASynthEngine sampleEngine;
+        sampleEngine.setBlockRendering(false);
+        startVoices(sampleEngine, &directSound, &square, &noise, &progWave);
+        
+        float blockBuffer[BENCHMARK_BLOCK_SIZE * 2];
+        float sampleBuffer[BENCHMARK_BLOCK_SIZE * 2];
+        const int totalFrames = BENCHMARK_SAMPLE_RATE * seconds;
+        double peak = 0.0;
+        double totalDifference = 0.0;
+        
+        Comparison result;
+        result.m_different_samples = 0;
+        
+        wxStopWatch blockTimer;
+        blockTimer.Pause();
+        wxStopWatch sampleTimer;
+        sampleTimer.Pause();
+        
+        for (int frame=0; frame<totalFrames; frame += BENCHMARK_BLOCK_SIZE)
+        {
+            blockTimer.Resume();
+            blockEngine.renderFrames(blockBuffer, BENCHMARK_BLOCK_SIZE);
+            blockTimer.Pause();
+            
+            sampleTimer.Resume();
+            sampleEngine.renderFrames(sampleBuffer, BENCHMARK_BLOCK_SIZE);
+            sampleTimer.Pause();
+            
+            for (int n=0; n<BENCHMARK_BLOCK_SIZE*2; n++)
+            {
+                if (fabs(blockBuffer[n]) > peak) peak = fabs(blockBuffer[n]);
+                
+                const double difference = fabs(blockBuffer[n] - sampleBuffer[n]);
+                totalDifference += difference;
+                if (difference > 0.001) result.m_different_samples++;
+            }
+        }
+        result.m_block_time  = blockTimer.Time();
+        result.m_sample_time = sampleTimer.Time();
+        
+        require(peak > 0.0, "The voices produce sound");
+        require(peak <= 1.0, "The output is clipped to full scale");
+        
+        // the renderers only differ by float rounding : single precision interpolation offsets
+        // within a block, gain and pan applied once per block, and now and then a square wave
+        // edge that moves by one sample
+        result.m_mean_difference = totalDifference / (totalFrames * 2.0);
+        require_e(result.m_mean_difference, <, 0.0001, "The block renderer matches the per-sample renderer");
+        require_e(result.m_different_samples, <, totalFrames / 1000, "Few samples differ by more than rounding");
+        
+        return result;
+    }
+    
+    UNIT_TEST( BlockRendererMatchesPerSampleRenderer )
+    {
+        compareRenderers(TEST_SECONDS);
+    }
+    
+    BENCHMARK( RenderVoicesBenchmark )
+    {
+        const Comparison result = compareRenderers(BENCHMARK_SECONDS);
+        
+        std::cout << "    " << MAX_ACTIVE_VOICES << " voices x " << BENCHMARK_SECONDS << " s : per-sample renderer "
+                  << result.m_sample_time << " ms, block renderer " << result.m_block_time << " ms" << std::endl;
+        if (result.m_sample_time > 0 and result.m_block_time > 0)
+        {
+            std::cout << "    realtime factor " << (BENCHMARK_SECONDS*1000.0 / result.m_sample_time) << "x -> "
+                      << (BENCHMARK_SECONDS*1000.0 / result.m_block_time) << "x" << std::endl;
+        }
+        std::cout << "    mean difference " << result.m_mean_difference << ", " << result.m_different_samples
+                  << " samples differ by more than 0.001" << std::endl;
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Compares RemoveOverlapping::findOverlappingNotes with the all-pairs comparison it replaced, on
+ * synthetic tracks dense enough to have many overlaps. The unit test checks both find the same
+ * notes on small tracks; the benchmark times both on larger ones, then the sweep alone on tracks
+ * too large for the all-pairs version (see Benchmark.h).
+ */
+
+#include "Actions/RemoveOverlapping.h"
+#include "Benchmarks/Benchmark.h"
+#include "Midi/Note.h"
+#include "ptr_vector.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace RemoveOverlappingBenchmark
+{
+    /** notes are spread on 'pitchRange' pitches, about one note start every 'spacing' ticks */
+    static void fillNotes(ptr_vector<Note>& notes, const int count, const int pitchRange, const int spacing)
+    {
+        srand(1234);
+
+        int tick = 0;
+        for (int n=0; n<count; n++)
+        {
+            tick += rand() % (spacing*2 + 1);
+            const int length = rand() % 8 == 0 ? 0 : 1 + rand() % (spacing*pitchRange);
+            notes.push_back( new Note(NULL, 60 + rand() % pitchRange, tick, tick + length, 80) );
+        }
+    }
+
+    /** the comparison RemoveOverlapping::perform used to do, kept to check the results */
+    static void findOverlappingNotesAllPairs(const ptr_vector<Note>& notes, std::vector<int>& removedIDs)
+    {
+        const int noteAmount = notes.size();
+        std::vector<bool> removed(noteAmount, false);
+
+        for (int n1=0; n1<noteAmount; n1++)
+        {
+            for (int n2=0; n2<noteAmount; n2++)
+            {
+                if (n1 == n2 or removed[n1] or removed[n2]) continue;
+                if (notes[n1].getPitchID() != notes[n2].getPitchID()) continue;
+
+                const int from   = std::min(notes[n1].getTick(), notes[n2].getTick());
+                const int to     = std::max(notes[n1].getEndTick(), notes[n2].getEndTick());
+                const int length = (notes[n1].getEndTick() - notes[n1].getTick()) +
+                                   (notes[n2].getEndTick() - notes[n2].getTick());
+
+                if ( (to - from < length) or (to - from == 0) ) removed[n1] = true;
+            }
+        }
+
+        removedIDs.clear();
+        for (int n=0; n<noteAmount; n++)
+        {
+            if (removed[n]) removedIDs.push_back(n);
+        }
+    }
+
+    /** @brief runs both versions on the same notes and checks they remove the same ones */
+    static void compareCase(const char* name, const int count, const int pitchRange, const int spacing,
+                            const bool printTimes)
+    {
+        ptr_vector<Note> notes;
+        fillNotes(notes, count, pitchRange, spacing);
+
+        std::vector<int> allPairs;
+        wxStopWatch allPairsTimer;
+        findOverlappingNotesAllPairs(notes, allPairs);
+        const long allPairsTime = allPairsTimer.Time();
+
+        std::vector<int> sweep;
+        wxStopWatch sweepTimer;
+        Action::RemoveOverlapping::findOverlappingNotes(notes, sweep);
+        const long sweepTime = sweepTimer.Time();
+
+        require(allPairs == sweep, "Both versions remove the same notes");
+
+        if (printTimes)
+        {
+            std::cout << "    " << name << " (" << count << " notes, " << sweep.size() << " removed) : all pairs "
+                      << allPairsTime << " ms, sweep " << sweepTime << " ms" << std::endl;
+        }
+    }
+
+    static void timeCase(const char* name, const int count, const int pitchRange, const int spacing)
+    {
+        ptr_vector<Note> notes;
+        fillNotes(notes, count, pitchRange, spacing);
+
+        std::vector<int> sweep;
+        wxStopWatch sweepTimer;
+        Action::RemoveOverlapping::findOverlappingNotes(notes, sweep);
+        const long sweepTime = sweepTimer.Time();
+
+        std::cout << "    " << name << " (" << count << " notes, " << sweep.size() << " removed) : sweep "
+                  << sweepTime << " ms" << std::endl;
+    }
+
+    UNIT_TEST( SweepMatchesAllPairs )
+    {
+        compareCase("chords",       400, 12, 4,  false);
+        compareCase("single pitch", 400, 1,  10, false);
+        compareCase("wide range",   400, 88, 1,  false);
+    }
+
+    BENCHMARK( RemoveOverlappingBenchmark )
+    {
+        compareCase("chords",          4000, 12, 4,  true);
+        compareCase("single pitch",    4000, 1,  10, true);
+        compareCase("wide range",      4000, 88, 1,  true);
+        timeCase   ("dense track",     30000,  12, 4);
+        timeCase   ("very long track", 300000, 24, 4);
+    }
+}
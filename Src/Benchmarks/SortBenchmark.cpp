@@ -0,0 +1,126 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Compares ptr_vector::insertionSort and ptr_vector::mergeSort on the kind of note vectors
+ * Track::reorderNoteVector has to deal with. The unit test checks both sorts give the same order
+ * on small vectors; the benchmark times them on large ones (see Benchmark.h).
+ */
+
+#include "Benchmarks/Benchmark.h"
+#include "Midi/Note.h"
+#include "ptr_vector.h"
+#include "UnitTest.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace SortBenchmark
+{
+    const int TEST_NOTE_COUNT      = 1000;
+    const int BENCHMARK_NOTE_COUNT = 100000;
+    
+    static int getBenchmarkNoteTick(Note* note)
+    {
+        return note->getTick();
+    }
+    
+    enum Layout
+    {
+        SHUFFLED,
+        NEARLY_SORTED,
+        REVERSED
+    };
+    
+    static void fillNotes(ptr_vector<Note>& notes, const int count, Layout layout)
+    {
+        srand(1234);
+        
+        for (int n=0; n<count; n++)
+        {
+            int tick;
+            switch (layout)
+            {
+                case SHUFFLED:
+                    tick = rand() % (count*10);
+                    break;
+                case NEARLY_SORTED:
+                    // a selection of 10% of the notes was moved past the rest of the track, like
+                    // MoveNotes does before the track is reordered
+                    tick = n*10;
+                    if (n >= count/4 and n < count/4 + count/10)
+                    {
+                        tick += count*5;
+                    }
+                    break;
+                case REVERSED:
+                default:
+                    tick = (count - n)*10;
+                    break;
+            }
+            notes.push_back( new Note(NULL, 60 + n%12, tick, tick + 5, 80) );
+        }
+    }
+    
+    /** @brief sorts the same notes both ways and checks the results match; times are in milliseconds */
+    static void compareSorts(const int count, Layout layout, long& insertionTime, long& mergeTime)
+    {
+        ptr_vector<Note> insertionSorted;
+        ptr_vector<Note> mergeSorted;
+        fillNotes(insertionSorted, count, layout);
+        fillNotes(mergeSorted, count, layout);
+        
+        wxStopWatch insertionTimer;
+        insertionSorted.insertionSort(getBenchmarkNoteTick);
+        insertionTime = insertionTimer.Time();
+        
+        wxStopWatch mergeTimer;
+        mergeSorted.mergeSort(getBenchmarkNoteTick);
+        mergeTime = mergeTimer.Time();
+        
+        for (int n=0; n<count; n++)
+        {
+            require_e(insertionSorted[n].getTick(), ==, mergeSorted[n].getTick(), "Both sorts give the same order");
+        }
+    }
+    
+    UNIT_TEST( MergeSortMatchesInsertionSort )
+    {
+        long insertionTime, mergeTime;
+        compareSorts(TEST_NOTE_COUNT, SHUFFLED,      insertionTime, mergeTime);
+        compareSorts(TEST_NOTE_COUNT, NEARLY_SORTED, insertionTime, mergeTime);
+        compareSorts(TEST_NOTE_COUNT, REVERSED,      insertionTime, mergeTime);
+    }
+    
+    static void timeCase(const char* name, Layout layout)
+    {
+        long insertionTime, mergeTime;
+        compareSorts(BENCHMARK_NOTE_COUNT, layout, insertionTime, mergeTime);
+        
+        std::cout << "    " << name << " (" << BENCHMARK_NOTE_COUNT << " notes) : insertion sort "
+                  << insertionTime << " ms, merge sort " << mergeTime << " ms" << std::endl;
+    }
+    
+    BENCHMARK( ReorderNotesBenchmark )
+    {
+        timeCase("shuffled",      SHUFFLED);
+        timeCase("nearly sorted", NEARLY_SORTED);
+        timeCase("reversed",      REVERSED);
+    }
+}
@@ -297,9 +297,10 @@ void ControllerEditor::renderEvents()
     const int eventAmount = m_track->getControllerEventAmount(currentController == PSEUDO_CONTROLLER_LYRICS,
                                                               Track::isTempoController(currentController) );
     
-    if (currentController == PSEUDO_CONTROLLER_LYRICS or
-        currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE or
-        currentController == 0 /* bank select */)
+    const bool labelledEvents = (currentController == PSEUDO_CONTROLLER_LYRICS or
+                                 currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE or
+                                 currentController == 0 /* bank select */);
+    if (labelledEvents)
     {
         AriaRender::images();
     }
@@ -307,7 +308,22 @@ void ControllerEditor::renderEvents()
     const int x_scroll = m_gsequence->getXScrollInPixels();
     int eventsOfThisType = 0;
     
-    for (int n=0; n<eventAmount; n++)
+    // skip events left of the view; labels are drawn right of their event so they show up to 200 pixels
+    // early, and lines start from the previous event of this controller, so start from that one
+    int firstEvent = m_graphical_track->getFirstVisibleControllerEvent(currentController,
+                                                                       labelledEvents ? -200 : 0);
+    if (not labelledEvents)
+    {
+        int previous = firstEvent - 1;
+        while (previous >= 0 and m_track->getControllerEvent(previous, currentController)->getController() !=
+                                 currentController)
+        {
+            previous--;
+        }
+        if (previous >= 0) firstEvent = previous;
+    }
+    
+    for (int n=firstEvent; n<eventAmount; n++)
     {        
         tmp = m_track->getControllerEvent(n, currentController);
         if (tmp->getController() != currentController) continue; // only draw events of this controller
@@ -315,6 +331,9 @@ void ControllerEditor::renderEvents()
         
         const int xloc = ControllerEditor::getPositionInPixels(tmp->getTick(), m_gsequence);
         
+        // labelled events are not joined by lines, nothing more to draw once they are past the view
+        if (labelledEvents and xloc - x_scroll > getXEnd()) break;
+        
         if (dynamic_cast<TextEvent*>(tmp) != NULL)
         {
             // we support lyrics up to 100 pixels long
@@ -450,9 +469,7 @@ void ControllerEditor::renderEvents()
         previous_location = xloc;
     }// next
     
-    if (currentController == PSEUDO_CONTROLLER_LYRICS or
-        currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE or
-        currentController == 0 /* bank select */)
+    if (labelledEvents)
     {
         AriaRender::primitives();
     }
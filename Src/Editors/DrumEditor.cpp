@@ -908,8 +908,12 @@ void DrumEditor::render(RelativeXCoord mousex_current, int mousey_current,
     const bool playing = PlatformMidiManager::get()->isPlaying();
     const int playbackTick = playing ? m_sequence->getPlaybackStartTick() + PlatformMidiManager::get()->getAccurateTick() : -1;
 
-    const int noteAmount = m_track->getNoteAmount();
-    for (int n=0; n<noteAmount; n++)
+    // drum notes are drawn where they start, and may show in the area left of the editor
+    int firstNote, endNote;
+    m_graphical_track->getVisibleNoteSpan(-Editor::getEditorXStart(), m_width - Editor::getEditorXStart(),
+                                          firstNote, endNote);
+    
+    for (int n=firstNote; n<endNote; n++)
     {
         const int drumx = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels() +
                           Editor::getEditorXStart();
@@ -995,7 +999,7 @@ void DrumEditor::render(RelativeXCoord mousex_current, int mousey_current,
         else
         {
             // move a bunch of notes
-
+            const int noteAmount = m_track->getNoteAmount();
             for (int n=0; n<noteAmount; n++)
             {
                 if (not m_track->isNoteSelected(n)) continue;
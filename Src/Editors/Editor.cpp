@@ -27,6 +27,7 @@
 #include "GUI/MainPane.h"
 #include "IO/IOUtils.h"
 #include "Midi/MeasureData.h"
+#include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
 #include "Pickers/MagneticGridPicker.h"
@@ -94,12 +95,15 @@ Editor::Editor(GraphicalTrack* track)
     m_is_duplicating_note = false;
 
     m_relative_height = 1.0f;
+    
+    m_saved_area = NULL;
 }
 
 // ------------------------------------------------------------------------------------------------------------
 
 Editor::~Editor()
 {
+    AriaRender::freeSavedArea(m_saved_area);
 }
 
 // ------------------------------------------------------------------------------------------------------------
@@ -134,6 +138,76 @@ void Editor::render()
 
 // ------------------------------------------------------------------------------------------------------------
 
+bool Editor::LayerKey::operator==(const LayerKey& other) const
+{
+    return m_generation == other.m_generation and
+           m_from_y     == other.m_from_y     and m_to_y     == other.m_to_y     and
+           m_width      == other.m_width      and m_height   == other.m_height   and
+           m_x_scroll   == other.m_x_scroll   and m_y_scroll == other.m_y_scroll and
+           m_zoom       == other.m_zoom       and m_focus    == other.m_focus    and
+           m_revisions  == other.m_revisions  and m_sounding_notes == other.m_sounding_notes;
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
+Editor::LayerKey Editor::getLayerKey(const bool focus)
+{
+    LayerKey key;
+    key.m_generation = m_main_frame->getMainPane()->getLayersGeneration();
+    key.m_from_y     = m_from_y;
+    key.m_to_y       = m_to_y;
+    key.m_width      = m_width;
+    key.m_height     = m_height;
+    key.m_x_scroll   = m_gsequence->getXScrollInPixels();
+    key.m_y_scroll   = getYScrollInPixels();
+    key.m_zoom       = m_gsequence->getZoom();
+    key.m_focus      = focus;
+    
+    // notes may be recorded while playing
+    key.m_revisions.push_back(m_track->getRevision());
+    const int backgroundTrackAmount = m_background_tracks.size();
+    for (int n=0; n<backgroundTrackAmount; n++)
+    {
+        key.m_revisions.push_back(m_background_tracks.get(n)->getRevision());
+    }
+    
+    // same tick as the editors use to highlight the notes being played
+    const int tick = m_sequence->getPlaybackStartTick() + PlatformMidiManager::get()->getAccurateTick();
+    m_graphical_track->getSoundingNotes(tick, key.m_sounding_notes);
+    
+    return key;
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
+void Editor::renderCached(RelativeXCoord mousex_current, int mousey_current,
+                          RelativeXCoord mousex_initial, int mousey_initial, bool focus)
+{
+    ASSERT( MAGIC_NUMBER_OK() );
+    
+    if (not PlatformMidiManager::get()->isPlaying())
+    {
+        render(mousex_current, mousey_current, mousex_initial, mousey_initial, focus);
+        return;
+    }
+    
+    const LayerKey key = getLayerKey(focus);
+    if (m_saved_area != NULL and key == m_saved_area_key)
+    {
+        AriaRender::restoreArea(m_saved_area);
+        return;
+    }
+    
+    render(mousex_current, mousey_current, mousex_initial, mousey_initial, focus);
+    
+    // editors clip what they draw to this rectangle
+    m_saved_area = AriaRender::saveArea(m_saved_area, LEFT_EDGE_X, getEditorYStart(),
+                                        m_width - RIGHT_SCISSOR, m_height);
+    m_saved_area_key = key;
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
 void Editor::drawVerticalMeasureLines(const int from_y, const int to_y)
 {
     ASSERT( MAGIC_NUMBER_OK() );
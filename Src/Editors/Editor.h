@@ -30,6 +30,7 @@
 namespace AriaMaestosa
 {
     namespace Action { class Duplicate; }
+    namespace AriaRender { class SavedArea; }
     
     const int BORDER_SIZE = 20;
     const int MARGIN = 5;
@@ -131,6 +132,36 @@ namespace AriaMaestosa
         
         ptr_vector<Track, REF> m_background_tracks;
         
+        /** 
+          * @brief everything the contents of an editor depend on that may change between two frames
+          *        without the whole pane being refreshed (see Editor::renderCached)
+          */
+        struct LayerKey
+        {
+            unsigned int m_generation;
+            int m_from_y, m_to_y, m_width, m_height;
+            int m_x_scroll, m_y_scroll;
+            float m_zoom;
+            bool m_focus;
+            
+            /** revisions of the track and of the background tracks (compared in full, a hash could collide) */
+            std::vector<unsigned int> m_revisions;
+            
+            /**
+              * the playback position only matters through which notes are highlighted as sounding,
+              * so this holds the IDs of these notes
+              */
+            std::vector<int> m_sounding_notes;
+            
+            bool operator==(const LayerKey& other) const;
+        };
+        
+        /** what was drawn in the last frame during playback, or NULL */
+        AriaRender::SavedArea* m_saved_area;
+        LayerKey m_saved_area_key;
+        
+        LayerKey getLayerKey(const bool focus);
+        
         /** Only used upon loading aria file */
         wxString m_background_tracks_temp_string;
         
@@ -271,6 +302,16 @@ namespace AriaMaestosa
         virtual void render(RelativeXCoord mousex_current, int mousey_current,
                             RelativeXCoord mousex_initial, int, bool focus=false) = 0;
         
+        /**
+          * @brief renders the editor, unless it only needs to show what it did in the previous frame
+          *
+          * During playback, moving the playback cursor changes nothing in most editors, so they save
+          * the area they drew and draw that copy in the following frames, as long as the pane was only
+          * refreshed for the playback cursor and nothing else they show has changed.
+          */
+        void renderCached(RelativeXCoord mousex_current, int mousey_current,
+                          RelativeXCoord mousex_initial, int mousey_initial, bool focus);
+        
         // ----------------------------------------------------------------------------------------------------
         // methods children must implement
         // ----------------------------------------------------------------------------------------------------
@@ -133,7 +133,8 @@ void GuitarEditor::render(RelativeXCoord mousex_current, int mousey_current,
     const bool playing = PlatformMidiManager::get()->isPlaying();
     const int playbackTick = playing ? m_sequence->getPlaybackStartTick() + PlatformMidiManager::get()->getAccurateTick() : -1;
 
-    const int noteAmount = m_track->getNoteAmount();
+    int firstNote, endNote;
+    m_graphical_track->getVisibleNoteSpan(0, m_width, firstNote, endNote);
 
     const bool mouseValid = (mousex_current.isValid() and mousex_initial.isValid());
 
@@ -142,7 +143,7 @@ void GuitarEditor::render(RelativeXCoord mousex_current, int mousey_current,
     const int mouse_y1 = std::min(mousey_current, mousey_initial);
     const int mouse_y2 = std::max(mousey_current, mousey_initial);
 
-    for (int n=0; n<noteAmount; n++)
+    for (int n=firstNote; n<endNote; n++)
     {
         const int pscroll = m_gsequence->getXScrollInPixels();
         int x1 = m_graphical_track->getNoteStartInPixels(n) - pscroll;
@@ -486,40 +486,42 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
         for (int bgtrack=0; bgtrack<amount; bgtrack++)
         {
             Track* otherTrack = m_background_tracks.get(bgtrack);
-            GraphicalTrack* otherGTrack = m_gsequence->getGraphicsFor(otherTrack);
-            ASSERT(otherGTrack != NULL);
-            const int noteAmount = otherTrack->getNoteAmount();
+            const NoteColumns& notes = otherTrack->getNoteColumns();
+            const float zoom = m_gsequence->getZoom();
+            
+            int firstNote, endNote;
+            otherTrack->getGraphics()->getVisibleNoteSpan(0, m_width, firstNote, endNote);
             
             ariaColor = pickColor(colorIndex);
         
             // render the notes
-            for (int n=0; n<noteAmount; n++)
+            AriaRender::primitives();
+            for (int n=firstNote; n<endNote; n++)
             {
                 int x,y;
-                int x1 = otherGTrack->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
-                int x2 = otherGTrack->getNoteEndInPixels(n)   - m_gsequence->getXScrollInPixels();
+                int x1 = (int)((float)notes.getStartTick(n) * zoom) - m_gsequence->getXScrollInPixels();
+                int x2 = (int)((float)notes.getEndTick(n)   * zoom) - m_gsequence->getXScrollInPixels();
 
                 // don't draw notes that won't be visible
                 if (x2 < 0)       continue;
                 if (x1 > m_width) break;
 
-                const int pitch = otherTrack->getNotePitchID(n);
+                const int pitch = notes.getPitchID(n);
                 
                 x = x1 + getEditorXStart();
                 y = levelToY(pitch+1);
 
-                AriaRender::primitives();
                 applyColor(ariaColor);
                 AriaRender::rect(x, levelToY(pitch), x2 + getEditorXStart()-1, y);
                                  
                 if (showNoteNames)
                 {
-                    AriaRender::images();
-                    applyInvertedColor(ariaColor);
-                    AriaRender::renderString(getNoteName(pitch), x+1, y, x2 + getEditorXStart()-1 - x);
+                    addNoteName(pitch, x+1, y, x2 + getEditorXStart()-1 - x, ariaColor);
                 }
             }
         }
+        
+        renderNoteNames();
     }
 
     AriaRender::primitives();
@@ -537,20 +539,26 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
     const bool playing = PlatformMidiManager::get()->isPlaying();
     const int playbackTick = playing ? m_sequence->getPlaybackStartTick() + PlatformMidiManager::get()->getAccurateTick() : -1;
 
-    const int noteAmount = m_track->getNoteAmount();
-    for (int n=0; n<noteAmount; n++)
+    // read the notes in columns, and only those that may be in view
+    const NoteColumns& notes = m_track->getNoteColumns();
+    const float zoom = m_gsequence->getZoom();
+    
+    int firstNote, endNote;
+    m_graphical_track->getVisibleNoteSpan(0, m_width, firstNote, endNote);
+    
+    for (int n=firstNote; n<endNote; n++)
     {
         int x;
-        const int x1 = m_graphical_track->getNoteStartInPixels(n) - pscroll;
-        const int x2 = m_graphical_track->getNoteEndInPixels(n)   - pscroll;
+        const int x1 = (int)((float)notes.getStartTick(n) * zoom) - pscroll;
+        const int x2 = (int)((float)notes.getEndTick(n)   * zoom) - pscroll;
 
         // don't draw notes that won't be visible
         if (x2 < 0)       continue;
         if (x1 > m_width) break;
 
-        const int pitch = m_track->getNotePitchID(n);
+        const int pitch = notes.getPitchID(n);
         const int level = pitch;
-        float volume    = m_track->getNoteVolume(n)/127.0;
+        float volume    = notes.getVolume(n)/127.0;
 
         const int y1 = levelToY(level);
         const int y2 = levelToY(level+1);
@@ -559,7 +567,7 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
         {
             ariaColor.set(1.0f, 0.0f, 0.0f, 1.0f);
         }
-        else if (playing and playbackTick >= m_track->getNoteStartInMidiTicks(n) and playbackTick <= m_track->getNoteEndInMidiTicks(n))
+        else if (playing and playbackTick >= notes.getStartTick(n) and playbackTick <= notes.getEndTick(n))
         {
             ariaColor.set(0.0f, 0.85f, 0.0f, 1.0f);
         }
@@ -568,7 +576,7 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
         {
             ariaColor.set(0.94f, 1.0f, 0.0f, 1.0f);
         }
-        else if (m_track->isNoteSelected(n) and focus)
+        else if (notes.isSelected(n) and focus)
         {
             ariaColor.set((1-volume)*1, (1-(volume/2))*1, 0, 1.0f);
         }
@@ -577,7 +585,6 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
             ariaColor.set((1-volume)*0.9, (1-volume)*0.9,  (1-volume)*0.9, 1.0f);
         }
 
-        AriaRender::primitives();
         applyColor(ariaColor);
 
         x = x1 + getEditorXStart() + 1;
@@ -586,12 +593,11 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
         
         if (showNoteNames)
         {
-            AriaRender::images();
-            applyInvertedColor(ariaColor);
-            AriaRender::renderString(getNoteName(pitch), x+1, y2 + 1, x2 + getEditorXStart() - x + 1);
+            addNoteName(pitch, x+1, y2 + 1, x2 + getEditorXStart() - x + 1, ariaColor);
         }
     }
-
+    
+    renderNoteNames();
 
     AriaRender::primitives();
 
@@ -790,6 +796,42 @@ wxString KeyboardEditor::getNoteName(int pitchID, bool addOctave)
 
 // -----------------------------------------------------------------------------------------------------------
 
+void KeyboardEditor::addNoteName(const int pitch, const int x, const int y, const int maxWidth,
+                                 const AriaColor& noteColor)
+{
+    NoteNameLabel label;
+    label.m_pitch      = pitch;
+    label.m_x          = x;
+    label.m_y          = y;
+    label.m_max_width  = maxWidth;
+    label.m_note_color = noteColor;
+    m_note_names.push_back(label);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void KeyboardEditor::renderNoteNames()
+{
+    if (m_note_names.empty()) return;
+    
+    // names are only drawn over their own note, so drawing them after all notes looks the same, but
+    // lets the renderer draw them together instead of switching between notes and text for each one
+    AriaRender::images();
+    
+    const int count = m_note_names.size();
+    for (int n=0; n<count; n++)
+    {
+        const NoteNameLabel& label = m_note_names[n];
+        applyInvertedColor(label.m_note_color);
+        AriaRender::renderString(getNoteName(label.m_pitch), label.m_x, label.m_y, label.m_max_width);
+    }
+    
+    AriaRender::primitives();
+    m_note_names.clear();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 void KeyboardEditor::applyColor(AriaColor color)
 {
     AriaRender::color(color.r, color.g ,color.b, color.a);
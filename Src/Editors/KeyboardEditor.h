@@ -18,6 +18,7 @@
 #ifndef __KEYBOARD_EDITOR_H__
 #define __KEYBOARD_EDITOR_H__
 
+#include <vector>
 #include <wx/intl.h>
 
 #include "Editors/Editor.h"
@@ -112,6 +113,21 @@ namespace AriaMaestosa
         bool m_resizing_mode;
         
         int m_octave_height;
+        
+        /** a note name waiting to be drawn on top of its note */
+        struct NoteNameLabel
+        {
+            int m_pitch;
+            int m_x, m_y, m_max_width;
+            AriaColor m_note_color;
+        };
+        
+        /** note names are collected while drawing notes, then all drawn at once (kept to reuse memory) */
+        std::vector<NoteNameLabel> m_note_names;
+        
+        void addNoteName(const int pitch, const int x, const int y, const int maxWidth,
+                         const AriaColor& noteColor);
+        void renderNoteNames();
     
         wxString getNoteName(int pitchID, bool addOctave = true);
         void applyColor(AriaColor color);
@@ -89,6 +89,7 @@ ScoreMidiConverter::ScoreMidiConverter(GraphicalSequence* parent)
     m_going_in_sharps = false;
     m_going_in_flats = false;
     m_octave_shift = 0;
+    m_revision = 0;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -127,6 +128,7 @@ PitchSign ScoreMidiConverter::getKeySigSharpnessSignForLevel(const unsigned int
 void ScoreMidiConverter::setOctaveShift(int octaves)
 {
     m_octave_shift = octaves;
+    m_revision++;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -313,6 +315,7 @@ int ScoreMidiConverter::levelToNote7(const unsigned int level) const
 
 void ScoreMidiConverter::updateConversionData()
 {
+    m_revision++;
 
     // FIXME - mess
 
@@ -939,9 +942,6 @@ void ScoreEditor::render(RelativeXCoord mousex_current, int mousey_current,
     AriaRender::color(0,0,0);
     AriaRender::pointSize(4);
 
-    
-    if (m_musical_notation_enabled) m_converter->resetAccidentalsForNewRender();
-
 
     MeasureBar* mb = m_gsequence->getMeasureBar();
     const bool mouseValid = (mousex_current.isValid() and mousex_initial.isValid());
@@ -950,6 +950,11 @@ void ScoreEditor::render(RelativeXCoord mousex_current, int mousey_current,
     
     ctx.first_x_to_consider = mb->firstPixelInMeasure( mb->measureAtPixel(0) ) + 1;
     ctx.last_x_to_consider  = mb->lastPixelInMeasure( mb->measureAtPixel(m_width + 15) );
+
+    // notes may ring a little past the end of the song, but not further (see MeasureData::measureAtTick)
+    const int lastMeasure = m_sequence->getMeasureData()->getMeasureAmount() + 10;
+    ctx.last_measure  = std::min(mb->measureAtPixel(m_width + 15), lastMeasure);
+    ctx.first_measure = std::min(mb->measureAtPixel(0), ctx.last_measure);
     ctx.mouse_x1 = std::min(mxc, mxi) ;
     ctx.mouse_x2 = std::max(mxc, mxi) ;
     ctx.mouse_y1 = std::min(mousey_current, mousey_initial);
@@ -973,6 +978,23 @@ void ScoreEditor::render(RelativeXCoord mousex_current, int mousey_current,
 
     ariaColor.set(0.0f, 0.0f, 0.0f, 1.0f);
     renderTrack(m_track, ctx, focus, true, renderSilences, ariaColor);
+
+    // forget the analysis of tracks that are no longer shown
+    if ((int)m_analyses.size() > m_background_tracks.size() + 1)
+    {
+        std::map<const Track*, TrackAnalysis>::iterator it = m_analyses.begin();
+        while (it != m_analyses.end())
+        {
+            bool shown = (it->first == m_track);
+            for (int n=0; n<m_background_tracks.size() and not shown; n++)
+            {
+                shown = (it->first == m_background_tracks.get(n));
+            }
+            
+            if (shown) ++it;
+            else       m_analyses.erase(it++);
+        }
+    }
   
 
     AriaRender::lineWidth(1);
@@ -1242,48 +1264,51 @@ void ScoreEditor::render(RelativeXCoord mousex_current, int mousey_current,
 void ScoreEditor::renderTrack(Track* track, const TrackRenderContext& ctx, bool focus, 
                 bool enableSelection, bool renderSilences, const AriaColor& baseColor)
 {
-    const int noteAmount = track->getNoteAmount();
-    int previous_tick = -1;
-    
-    GraphicalTrack* otherGTrack = m_gsequence->getGraphicsFor(track);
-    ASSERT(otherGTrack != NULL);
-    
-    m_g_clef_analyser->clearAndPrepare();
-    m_f_clef_analyser->clearAndPrepare();
-    
-    // render pass 1. draw linear notation if relevant, gather information and do initial rendering for
-    // musical notation
-    for (int n=0; n<noteAmount; n++)
-    {
-        PitchSign note_sign;
-        const int noteLevel = m_converter->noteToLevel(track->getNote(n), &note_sign);
-
-        if (noteLevel == -1) continue;
+    // render pass 1 for linear notation. musical notation is gathered and analysed measure by measure
+    // below, and only when the notes changed
+    if (m_linear_notation_enabled)
+    {
+        // the ticks, volume and selection of the notes are read in columns; only visible notes need the
+        // Note object itself, to find where they go on the staff
+        const NoteColumns& notes = track->getNoteColumns();
+        const float zoom = m_gsequence->getZoom();
+        int previous_tick = -1;
         
-        const int tick = track->getNoteStartInMidiTicks(n);
-        ASSERT_E(tick, >=, previous_tick);
-        previous_tick = tick;
-        const int noteLength = track->getNoteEndInMidiTicks(n) - tick;
-
-        const int original_x1 = otherGTrack->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels() +
-                                Editor::getEditorXStart();
-        int       x1 = original_x1;
-        const int x2 = otherGTrack->getNoteEndInPixels(n)   - m_gsequence->getXScrollInPixels() +
-                       Editor::getEditorXStart();
+        m_converter->resetAccidentalsForNewRender();
+        
+        int firstNote, endNote;
+        track->getGraphics()->getVisibleNoteSpan(ctx.first_x_to_consider - Editor::getEditorXStart(),
+                                                 ctx.last_x_to_consider  - Editor::getEditorXStart(),
+                                                 firstNote, endNote);
+        
+        for (int n=firstNote; n<endNote; n++)
+        {
+            const int tick = notes.getStartTick(n);
+            ASSERT_E(tick, >=, previous_tick);
+            previous_tick = tick;
+
+            const int original_x1 = (int)((float)tick * zoom) - m_gsequence->getXScrollInPixels() +
+                                    Editor::getEditorXStart();
+            int       x1 = original_x1;
+            const int x2 = (int)((float)notes.getEndTick(n) * zoom) - m_gsequence->getXScrollInPixels() +
+                           Editor::getEditorXStart();
+
+            // don't consider notes that won't be visible
+            if (x2 < ctx.first_x_to_consider) continue;
+            if (x1 > ctx.last_x_to_consider)  break;
+            
+            PitchSign note_sign;
+            const int noteLevel = m_converter->noteToLevel(track->getNote(n), &note_sign);
 
-        // don't consider notes that won't be visible
-        if (x2 < ctx.first_x_to_consider) continue;
-        if (x1 > ctx.last_x_to_consider)  break;
+            if (noteLevel == -1) continue;
 
-        if (m_linear_notation_enabled)
-        {
             if (m_musical_notation_enabled) x1 += 8;
 
             if (x1 < x2) // when notes are too short to be visible, don't draw them
             {
                 const int y1 = noteLevel*Y_STEP_HEIGHT     + getEditorYStart() - getYScrollInPixels();
                 const int y2 = (noteLevel+1)*Y_STEP_HEIGHT + getEditorYStart() - getYScrollInPixels() - 1;
-                float volume = track->getNoteVolume(n)/127.0;
+                float volume = notes.getVolume(n)/127.0;
 
                 // draw the quad with black border that is visible in linear notation mode
                 AriaRender::primitives();
@@ -1293,7 +1318,7 @@ void ScoreEditor::renderTrack(Track* track, const TrackRenderContext& ctx, bool
                 {
                     AriaRender::color(0.94f, 1.0f, 0.0f);
                 }
-                else if (enableSelection and track->isNoteSelected(n) and focus)
+                else if (enableSelection and notes.isSelected(n) and focus)
                 {
                     AriaRender::color((1-volume)*1, (1-(volume/2))*1, 0);
                 }
@@ -1341,100 +1366,259 @@ void ScoreEditor::renderTrack(Track* track, const TrackRenderContext& ctx, bool
 
                 AriaRender::primitives();
             }
-        }// end if linear
+        } // next note
+    } // end if linear
+    
+    // render musical notation if enabled
+    if (m_musical_notation_enabled)
+    {
+        TrackAnalysis& analysis = m_analyses[track];
+        updateAnalysis(track, analysis, ctx.first_measure, ctx.last_measure, enableSelection);
+        
+        if (m_g_clef)
+        {
+            const int silences_y = getEditorYStart() +
+                                   Y_STEP_HEIGHT*(m_converter->getScoreCenterCLevel()-8) -
+                                   getYScrollInPixels() + 1;
+            renderScore(m_g_clef_analyser, analysis.m_g_clef_measures, ctx, silences_y, renderSilences,
+                        baseColor);
+        }
 
-        if (m_musical_notation_enabled)
+        if (m_f_clef)
         {
-            MeasureData* md = m_sequence->getMeasureData();
-            
-            // build visible notes vector with initial info in it
-            NoteRenderInfo currentNote = NoteRenderInfo::factory(tick, noteLevel, noteLength, note_sign,
-                                                                 enableSelection and track->isNoteSelected(n),
-                                                                 track->getNotePitchID(n), md);
+            const int silences_y = getEditorYStart() +
+                                   Y_STEP_HEIGHT*(m_converter->getScoreCenterCLevel()+4) -
+                                  getYScrollInPixels() + 1;
+            renderScore(m_f_clef_analyser, analysis.m_f_clef_measures, ctx, silences_y, renderSilences,
+                        baseColor);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+ScoreEditor::TrackAnalysis::TrackAnalysis()
+{
+    m_converter_revision = 0;
+    m_g_clef             = false;
+    m_f_clef             = false;
+    m_selection_enabled  = false;
+    m_beat_length        = -1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool ScoreEditor::MeasureKey::sameMeasureAs(const MeasureKey& other) const
+{
+    return m_valid and other.m_valid and
+           m_first_tick  == other.m_first_tick  and
+           m_end_tick    == other.m_end_tick    and
+           m_numerator   == other.m_numerator   and
+           m_denominator == other.m_denominator;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool ScoreEditor::MeasureKey::operator==(const MeasureKey& other) const
+{
+    return sameMeasureAs(other) and
+           m_revision           == other.m_revision and
+           m_selection_revision == other.m_selection_revision;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+ScoreEditor::MeasureKey ScoreEditor::makeMeasureKey(Track* track, const int measure)
+{
+    MeasureData* md = m_sequence->getMeasureData();
+    
+    MeasureKey key;
+    key.m_revision           = track->getRevision();
+    key.m_selection_revision = track->getNoteColumns().getSelectionRevision();
+    key.m_first_tick         = md->firstTickInMeasure(measure);
+    key.m_end_tick           = md->lastTickInMeasure(measure);
+    key.m_numerator          = md->getTimeSigNumerator(measure);
+    key.m_denominator        = md->getTimeSigDenominator(measure);
+    key.m_valid              = true;
+    return key;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ScoreEditor::updateAnalysis(Track* track, TrackAnalysis& analysis, const int firstMeasure,
+                                 const int lastMeasure, const bool enableSelection)
+{
+    // these change where all notes go, start over when they change
+    const int beatLength = m_sequence->ticksPerQuarterNote();
+    if (analysis.m_converter_revision != m_converter->getRevision() or
+        analysis.m_g_clef             != m_g_clef                   or
+        analysis.m_f_clef             != m_f_clef                   or
+        analysis.m_selection_enabled  != enableSelection            or
+        analysis.m_beat_length        != beatLength)
+    {
+        analysis.m_converter_revision = m_converter->getRevision();
+        analysis.m_g_clef             = m_g_clef;
+        analysis.m_f_clef             = m_f_clef;
+        analysis.m_selection_enabled  = enableSelection;
+        analysis.m_beat_length        = beatLength;
+        
+        analysis.m_keys.clear();
+        analysis.m_g_clef_measures.clear();
+        analysis.m_f_clef_measures.clear();
+    }
+    
+    if ((int)analysis.m_keys.size() <= lastMeasure)
+    {
+        analysis.m_keys.resize(lastMeasure + 1);
+        analysis.m_g_clef_measures.resize(lastMeasure + 1);
+        analysis.m_f_clef_measures.resize(lastMeasure + 1);
+    }
+    
+    // gather consecutive measures that may have changed, to add their notes in a single pass
+    int measure = firstMeasure;
+    while (measure <= lastMeasure)
+    {
+        if (analysis.m_keys[measure] == makeMeasureKey(track, measure))
+        {
+            measure++;
+            continue;
+        }
+        
+        int last = measure;
+        while (last < lastMeasure and not (analysis.m_keys[last+1] == makeMeasureKey(track, last+1))) last++;
+        
+        analyseMeasures(track, analysis, measure, last, enableSelection);
+        measure = last + 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
 
-            // add note to either G clef score or F clef score
-            if (m_g_clef and not m_f_clef)
+void ScoreEditor::analyseMeasures(Track* track, TrackAnalysis& analysis, const int firstMeasure,
+                                  const int lastMeasure, const bool enableSelection)
+{
+    const NoteColumns& notes = track->getNoteColumns();
+    const int noteAmount = notes.size();
+    MeasureData* md = m_sequence->getMeasureData();
+    
+    const int fromTick = md->firstTickInMeasure(firstMeasure);
+    const int toTick   = md->lastTickInMeasure(lastMeasure);
+    
+    // notes that end before the measures don't appear in them, but the accidentals they set last
+    // until the end of their measure, so start from the measure where the first note we need begins
+    const int firstNote = track->findFirstNoteEndingAfter(fromTick - 1);
+    int n = noteAmount;
+    if (firstNote < noteAmount)
+    {
+        const int fromMeasure = md->measureAtTick(notes.getStartTick(firstNote));
+        n = track->findFirstNoteInRange(md->firstTickInMeasure(fromMeasure), toTick);
+        if (n == -1) n = noteAmount;
+    }
+    
+    m_converter->resetAccidentalsForNewRender();
+    m_g_clef_analyser->clearAndPrepare();
+    m_f_clef_analyser->clearAndPrepare();
+    
+    for (; n<noteAmount and notes.getStartTick(n) < toTick; n++)
+    {
+        PitchSign note_sign;
+        const int noteLevel = m_converter->noteToLevel(track->getNote(n), &note_sign);
+        
+        if (n < firstNote or noteLevel == -1) continue;
+        
+        // build visible notes vector with initial info in it
+        const int tick = notes.getStartTick(n);
+        NoteRenderInfo currentNote = NoteRenderInfo::factory(tick, noteLevel, notes.getEndTick(n) - tick,
+                                                             note_sign, enableSelection and notes.isSelected(n),
+                                                             notes.getPitchID(n), md);
+
+        // add note to either G clef score or F clef score
+        if (m_g_clef and not m_f_clef)
+        {
+            m_g_clef_analyser->addToVector(currentNote);
+        }
+        else if (m_f_clef and not m_g_clef)
+        {
+            m_f_clef_analyser->addToVector(currentNote);
+        }
+        else if (m_f_clef and m_g_clef)
+        {
+            const int middleC = m_converter->getScoreCenterCLevel();
+            if (noteLevel < middleC)
             {
                 m_g_clef_analyser->addToVector(currentNote);
             }
-            else if (m_f_clef and not m_g_clef)
+            else if (noteLevel > middleC)
             {
                 m_f_clef_analyser->addToVector(currentNote);
             }
-            else if (m_f_clef and m_g_clef)
+            else
             {
-                const int middleC = m_converter->getScoreCenterCLevel();
-                if (noteLevel < middleC)
-                {
-                    m_g_clef_analyser->addToVector(currentNote);
-                }
-                else if (noteLevel > middleC)
+                // note is exactly on middle C... do our best to
+                // guess on which clef to put this note
+                // we'll check nearby notes in case it can help us
+                int check_note = -1;
+                if      (n > 0)            check_note = n-1;
+                else if (n+1 < noteAmount) check_note = n+1;
+
+                if (check_note != -1)
                 {
-                    m_f_clef_analyser->addToVector(currentNote);
+                    const int checkNoteLevel = m_converter->noteToLevel( track->getNote(check_note), (PitchSign*)NULL );
+                    
+                    if (checkNoteLevel > middleC)  m_f_clef_analyser->addToVector(currentNote);
+                    else                           m_g_clef_analyser->addToVector(currentNote);
                 }
                 else
                 {
-                    // note is exactly on middle C... do our best to
-                    // guess on which clef to put this note
-                    // we'll check nearby notes in case it can help us
-                    int check_note = -1;
-                    if      (n > 0)            check_note = n-1;
-                    else if (n+1 < noteAmount) check_note = n+1;
-
-                    if (check_note != -1)
-                    {
-                        const int checkNoteLevel = m_converter->noteToLevel( track->getNote(check_note), (PitchSign*)NULL );
-                        
-                        if (checkNoteLevel > middleC)  m_f_clef_analyser->addToVector(currentNote);
-                        else                           m_g_clef_analyser->addToVector(currentNote);
-                    }
-                    else
-                    {
-                        m_g_clef_analyser->addToVector(currentNote);
-                    }
-                    
-                } // end if note on middle C
-            } // end if both G and F clefs
-        } // end if musical notation enabled
+                    m_g_clef_analyser->addToVector(currentNote);
+                }
+                
+            } // end if note on middle C
+        } // end if both G and F clefs
     } // next note
     
+    m_g_clef_analyser->doneAdding();
+    m_f_clef_analyser->doneAdding();
     
-    if (m_g_clef)
+    // long notes were split at measure bars; sort the parts by measure, dropping those outside the range
+    const int measureAmount = lastMeasure - firstMeasure + 1;
+    std::vector< std::vector<NoteRenderInfo> > gClefNotes(measureAmount);
+    std::vector< std::vector<NoteRenderInfo> > fClefNotes(measureAmount);
+    
+    for (unsigned int i=0; i<m_g_clef_analyser->m_note_render_info.size(); i++)
     {
-        m_g_clef_analyser->doneAdding();
+        const NoteRenderInfo& info = m_g_clef_analyser->m_note_render_info[i];
+        if (info.m_measure_begin < firstMeasure or info.m_measure_begin > lastMeasure) continue;
+        gClefNotes[info.m_measure_begin - firstMeasure].push_back(info);
     }
-    if (m_f_clef)
+    for (unsigned int i=0; i<m_f_clef_analyser->m_note_render_info.size(); i++)
     {
-        m_f_clef_analyser->doneAdding();
+        const NoteRenderInfo& info = m_f_clef_analyser->m_note_render_info[i];
+        if (info.m_measure_begin < firstMeasure or info.m_measure_begin > lastMeasure) continue;
+        fClefNotes[info.m_measure_begin - firstMeasure].push_back(info);
     }
     
-    // render musical notation if enabled
-    if (m_musical_notation_enabled)
+    // analyse again only the measures whose notes changed
+    for (int measure=firstMeasure; measure<=lastMeasure; measure++)
     {
-        if (m_g_clef)
-        {
-            const int silences_y = getEditorYStart() +
-                                   Y_STEP_HEIGHT*(m_converter->getScoreCenterCLevel()-8) -
-                                   getYScrollInPixels() + 1;
-            renderScore(m_g_clef_analyser, silences_y, renderSilences, baseColor);
-        }
-
-        if (m_f_clef)
-        {
-            const int silences_y = getEditorYStart() +
-                                   Y_STEP_HEIGHT*(m_converter->getScoreCenterCLevel()+4) -
-                                  getYScrollInPixels() + 1;
-            renderScore(m_f_clef_analyser, silences_y, renderSilences, baseColor);
-        }
+        const MeasureKey key = makeMeasureKey(track, measure);
+        const bool reuse = key.sameMeasureAs(analysis.m_keys[measure]);
+        
+        m_g_clef_analyser->analyseMeasure(gClefNotes[measure - firstMeasure],
+                                          analysis.m_g_clef_measures[measure], reuse);
+        m_f_clef_analyser->analyseMeasure(fClefNotes[measure - firstMeasure],
+                                          analysis.m_f_clef_measures[measure], reuse);
+        analysis.m_keys[measure] = key;
     }
 }
 
-
 // ----------------------------------------------------------------------------------------------------------
 
-void ScoreEditor::renderScore(ScoreAnalyser* analyser, const int silences_y, 
-            bool renderSilences, const AriaColor& baseColor)
+void ScoreEditor::renderScore(ScoreAnalyser* analyser, const std::vector<AnalysedMeasure>& measures,
+                              const TrackRenderContext& ctx, const int silences_y,
+                              bool renderSilences, const AriaColor& baseColor)
 {
+    analyser->loadMeasures(measures, ctx.first_measure, ctx.last_measure, false /* as added */);
     int visibleNoteAmount = analyser->getNoteCount();
     
     // first note rendering pass
@@ -1457,8 +1641,8 @@ void ScoreEditor::renderScore(ScoreAnalyser* analyser, const int silences_y,
 
     // ------------------------- second note rendering pass -------------------
 
-    // analyse notes to know how to build the score
-    analyser->analyseNoteInfo();
+    // the notes as analysed to know how to build the score (see updateAnalysis)
+    analyser->loadMeasures(measures, ctx.first_measure, ctx.last_measure, true /* analysed */);
 
     // triplet signs, tied notes, flags and beams
     const bool scorePlaying = PlatformMidiManager::get()->isPlaying();
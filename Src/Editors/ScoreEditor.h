@@ -18,8 +18,11 @@
 #ifndef __SCORE_EDITOR_H__
 #define __SCORE_EDITOR_H__
 
+#include "Analysers/ScoreAnalyser.h"
 #include "Editors/Editor.h"
 
+#include <map>
+#include <vector>
 #include <wx/intl.h>
 
 namespace AriaMaestosa
@@ -32,10 +35,8 @@ namespace AriaMaestosa
         SHARP_OR_FLAT
     };
     
-    class NoteRenderInfo;
     class Note;
     class Track;
-    class ScoreAnalyser;
     
     const int sign_dist = 5;
     
@@ -74,6 +75,8 @@ namespace AriaMaestosa
     {
         int first_x_to_consider;
         int last_x_to_consider;
+        int first_measure;
+        int last_measure;
         int mouse_x1;
         int mouse_x2;
         int mouse_y1;
@@ -117,6 +120,9 @@ namespace AriaMaestosa
         
         GraphicalSequence* m_sequence;
         
+        /** Changed every time the conversion settings change, see getRevision */
+        unsigned int m_revision;
+        
     public:
         
         LEAK_CHECK();
@@ -163,6 +169,12 @@ namespace AriaMaestosa
         void setOctaveShift(int octaves);
         
         void resetAccidentalsForNewRender();
+        
+        /**
+          * @return a number that changes every time the key or the octave shift changes, which may move
+          *         notes to other levels and change their signs
+          */
+        unsigned int getRevision() const { return m_revision; }
     };
     
     
@@ -184,9 +196,69 @@ namespace AriaMaestosa
         /** Used when clicking on notes in the left part to hear them */
         int m_clicked_note;
         
+        /** What the analysis of a measure depends on, apart from the notes themselves */
+        struct MeasureKey
+        {
+            /** revision of the track (see Track::getRevision) and of its selection
+              * (see NoteColumns::getSelectionRevision) */
+            unsigned int m_revision, m_selection_revision;
+            
+            int m_first_tick, m_end_tick;
+            int m_numerator, m_denominator;
+            
+            /** false until the measure is analysed */
+            bool m_valid;
+            
+            MeasureKey() { m_valid = false; }
+            
+            /** @return whether both keys are for the same measure bounds and time signature */
+            bool sameMeasureAs(const MeasureKey& other) const;
+            
+            bool operator==(const MeasureKey& other) const;
+        };
+        
+        /**
+          * @brief score analysis of a track, kept between renders
+          *
+          * Only the measures that were visible at some point are analysed. A measure is analysed again
+          * when its notes change; settings that affect all measures discard everything.
+          */
+        struct TrackAnalysis
+        {
+            unsigned int m_converter_revision;
+            bool m_g_clef, m_f_clef, m_selection_enabled;
+            int m_beat_length;
+            
+            /** indexed by measure */
+            std::vector<MeasureKey> m_keys;
+            std::vector<AnalysedMeasure> m_g_clef_measures;
+            std::vector<AnalysedMeasure> m_f_clef_measures;
+            
+            TrackAnalysis();
+        };
+        
+        /** Analysis of the track and of the background tracks shown in this editor. The tracks are only
+          * used to tell the analyses apart, never dereferenced. */
+        std::map<const Track*, TrackAnalysis> m_analyses;
+        
+        /** @return the current key of a measure of a track */
+        MeasureKey makeMeasureKey(Track* track, const int measure);
+        
+        /** @brief make sure the analysis of the given measures is up to date */
+        void updateAnalysis(Track* track, TrackAnalysis& analysis, const int firstMeasure,
+                            const int lastMeasure, const bool enableSelection);
+        
+        /**
+          * @brief add the notes of a range of measures to the analysers, then analyse the measures
+          *        whose notes changed
+          */
+        void analyseMeasures(Track* track, TrackAnalysis& analysis, const int firstMeasure,
+                             const int lastMeasure, const bool enableSelection);
+        
         /** helper method for rendering */
-        void renderScore(ScoreAnalyser* analyser, const int silences_y, 
-                        bool renderSilences, const AriaColor& baseColor);
+        void renderScore(ScoreAnalyser* analyser, const std::vector<AnalysedMeasure>& measures,
+                         const TrackRenderContext& ctx, const int silences_y,
+                         bool renderSilences, const AriaColor& baseColor);
         
         /** helper method for rendering */
         void renderNote_pass1(NoteRenderInfo& renderInfo, const AriaColor& baseColor);
@@ -0,0 +1,68 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "GUI/FrameTimeCounter.h"
+
+#include <wx/defs.h>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    /** weight of the newest frame in the moving average; about the last 30 frames count */
+    const double AVERAGE_WEIGHT = 1.0 / 30.0;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+FrameTimeCounter::FrameTimeCounter()
+{
+    reset();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void FrameTimeCounter::beginFrame()
+{
+    m_timer.Start();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void FrameTimeCounter::endFrame()
+{
+#if wxCHECK_VERSION(2,9,3)
+    m_last_ms = m_timer.TimeInMicro().ToDouble() / 1000.0;
+#else
+    m_last_ms = m_timer.Time();
+#endif
+    
+    if (m_frame_count == 0) m_average_ms = m_last_ms;
+    else                    m_average_ms += (m_last_ms - m_average_ms) * AVERAGE_WEIGHT;
+    
+    if (m_last_ms > m_worst_ms) m_worst_ms = m_last_ms;
+    m_frame_count++;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void FrameTimeCounter::reset()
+{
+    m_frame_count = 0;
+    m_last_ms     = 0.0;
+    m_average_ms  = 0.0;
+    m_worst_ms    = 0.0;
+}
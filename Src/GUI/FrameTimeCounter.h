@@ -0,0 +1,60 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __FRAME_TIME_COUNTER_H__
+#define __FRAME_TIME_COUNTER_H__
+
+#include <wx/stopwatch.h>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief keeps track of how long drawing frames takes, to measure changes to the render paths
+      * @ingroup gui
+      */
+    class FrameTimeCounter
+    {
+        wxStopWatch m_timer;
+        
+        long   m_frame_count;
+        double m_last_ms;
+        double m_average_ms;
+        double m_worst_ms;
+        
+    public:
+        
+        FrameTimeCounter();
+        
+        void beginFrame();
+        void endFrame();
+        
+        /** @brief forget the frames measured so far */
+        void reset();
+        
+        long   getFrameCount() const { return m_frame_count; }
+        double getLastFrameTime() const { return m_last_ms; }
+        
+        /** @return a moving average of the time of the last frames, in milliseconds */
+        double getAverageFrameTime() const { return m_average_ms; }
+        
+        /** @return the time of the slowest frame since the last reset, in milliseconds */
+        double getWorstFrameTime() const { return m_worst_ms; }
+    };
+    
+}
+
+#endif
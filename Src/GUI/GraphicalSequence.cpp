@@ -467,7 +467,7 @@ void GraphicalSequence::selectNone()
 #pragma mark I/O
 #endif
 
-void GraphicalSequence::saveToFile(wxFileOutputStream& fileout)
+void GraphicalSequence::saveToFile(wxOutputStream& fileout, const bool includeTrackEvents)
 {
     writeData("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", fileout);
     writeData(wxT("<seqview xscroll=\"") + to_wxString(m_x_scroll_in_pixels) +
@@ -475,7 +475,7 @@ void GraphicalSequence::saveToFile(wxFileOutputStream& fileout)
               wxT("\" zoom=\"")          + to_wxString(m_zoom_percent) +
               wxT("\">\n"), fileout);
     
-    m_sequence->saveToFile(fileout);
+    m_sequence->saveToFile(fileout, includeTrackEvents);
     
     writeData(wxT("</seqview>\n"), fileout);
 }
@@ -151,7 +151,8 @@ namespace AriaMaestosa
         
         void copy();
         
-        void saveToFile(wxFileOutputStream& fileout);
+        /** @param includeTrackEvents whether to write the notes and controller events of each track */
+        void saveToFile(wxOutputStream& fileout, const bool includeTrackEvents=true);
         bool readFromFile(irr::io::IrrXMLReader* xml);
     };
     
@@ -15,6 +15,7 @@
  */
 
 
+#include <algorithm>
 #include <iostream>
 #include <wx/numdlg.h>
 #include <wx/wfstream.h>
@@ -1313,6 +1314,59 @@ int GraphicalTrack::getNoteEndInPixels(const int id) const
 
 // ---------------------------------------------------------------------------------------------------------------
 
+void GraphicalTrack::getVisibleNoteSpan(const int fromX, const int toX, int& firstNote, int& endNote) const
+{
+    const float zoom   = m_gsequence->getZoom();
+    const int   scroll = m_gsequence->getXScrollInPixels();
+    
+    // editors truncate when converting ticks to pixels, keep a tick of margin on each side so that
+    // the span never leaves out a note their pixel tests would have drawn
+    const int fromTick = (int)((scroll + fromX) / zoom) - 1;
+    const int toTick   = (int)((scroll + toX + 1) / zoom) + 1;
+    
+    // all notes before 'firstNote' end before 'fromTick', even if a long note started way earlier
+    firstNote = m_track->findFirstNoteEndingAfter(fromTick);
+    endNote   = std::max(firstNote, m_track->findLastNoteInRange(0, toTick) + 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+int GraphicalTrack::getFirstVisibleControllerEvent(const int controller, const int fromX)
+{
+    const int fromTick = (int)((m_gsequence->getXScrollInPixels() + fromX) / m_gsequence->getZoom()) - 1;
+    
+    // events of all controllers are kept together, sorted by tick
+    int first = 0;
+    int last  = m_track->getControllerEventAmount(controller == PSEUDO_CONTROLLER_LYRICS,
+                                                  Track::isTempoController(controller));
+    while (first < last)
+    {
+        const int middle = (first + last) / 2;
+        if (m_track->getControllerEvent(middle, controller)->getTick() < fromTick) first = middle + 1;
+        else                                                                      last  = middle;
+    }
+    return first;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+void GraphicalTrack::getSoundingNotes(const int tick, std::vector<int>& ids) const
+{
+    const NoteColumns& notes = m_track->getNoteColumns();
+    
+    // notes before 'firstNote' end before 'tick', notes from 'endNote' on start after it
+    const int firstNote = m_track->findFirstNoteEndingAfter(tick - 1);
+    const int endNote   = m_track->findLastNoteInRange(0, tick + 1) + 1;
+    
+    ids.clear();
+    for (int n=firstNote; n<endNote; n++)
+    {
+        if (notes.getStartTick(n) <= tick and notes.getEndTick(n) >= tick) ids.push_back(n);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
 void GraphicalTrack::selectNote(const int id, const bool selected, bool ignoreModifiers)
 {    
     ASSERT(id != SELECTED_NOTES); // not supported in this function
@@ -1848,7 +1902,7 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         if (m_track->isNotationTypeEnabled(SCORE))
         {
             rcount++;
-            m_score_editor->render(x1, y1, x2, y2, focus);
+            m_score_editor->renderCached(x1, y1, x2, y2, focus);
             
             if (rcount < count)
             {
@@ -1861,7 +1915,7 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         if (m_track->isNotationTypeEnabled(GUITAR))
         {
             rcount++;
-            m_guitar_editor->render(x1, y1, x2, y2, focus);
+            m_guitar_editor->renderCached(x1, y1, x2, y2, focus);
             
             if (rcount < count)
             {
@@ -1874,7 +1928,7 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         if (m_track->isNotationTypeEnabled(KEYBOARD))
         {
             rcount++;
-            m_keyboard_editor->render(x1, y1, x2, y2, focus);
+            m_keyboard_editor->renderCached(x1, y1, x2, y2, focus);
             
             if (rcount < count)
             {
@@ -1887,7 +1941,7 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         if (m_track->isNotationTypeEnabled(DRUM))
         {
             rcount++;
-            m_drum_editor->render(x1, y1, x2, y2, focus);
+            m_drum_editor->renderCached(x1, y1, x2, y2, focus);
             
             if (rcount < count)
             {
@@ -1899,7 +1953,7 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         }
         if (m_track->isNotationTypeEnabled(CONTROLLER))
         {
-            m_controller_editor->render(x1, y1, x2, y2, focus);
+            m_controller_editor->renderCached(x1, y1, x2, y2, focus);
         }
         
         
@@ -2045,7 +2099,7 @@ void GraphicalTrack::scrollKeyboardEditorNotesIntoView()
 #pragma mark Serialization
 #endif
 
-void GraphicalTrack::saveToFile(wxFileOutputStream& fileout)
+void GraphicalTrack::saveToFile(wxOutputStream& fileout)
 {
     const int octave_shift = m_score_editor->getScoreMidiConverter()->getOctaveShift();
 
@@ -25,7 +25,7 @@
 #include "Renderers/RenderAPI.h"
 
 
-class wxFileOutputStream;
+class wxOutputStream;
 // forward
 namespace irr { namespace io {
     class IXMLBase;
@@ -240,6 +240,32 @@ namespace AriaMaestosa
         
         int getNoteStartInPixels(const int id) const;
         int getNoteEndInPixels(const int id) const;
+        
+        /**
+          * @brief find the notes that may be visible in a part of the editors, at the current scroll and zoom
+          *
+          * Notes outside the returned span are certainly hidden; notes inside may still be hidden (a long
+          * note before them can be what made them candidates), so editors keep their own pixel tests.
+          *
+          * @param fromX, toX    the range to look at, in pixels relative to the scrolled start of the
+          *                      notes (i.e. where getNoteStartInPixels(id) - scroll would place notes)
+          * @param[out] firstNote  ID of the first note that may be visible
+          * @param[out] endNote    one past the ID of the last note that may be visible
+          */
+        void getVisibleNoteSpan(const int fromX, const int toX, int& firstNote, int& endNote) const;
+        
+        /**
+          * @brief like getVisibleNoteSpan, for the (point-like) controller events of the given controller
+          * @return ID of the first event (of any controller) that may be at 'fromX' or after; the
+          *         events before it are all further left
+          */
+        int getFirstVisibleControllerEvent(const int controller, const int fromX);
+        
+        /**
+          * @brief finds the notes sounding at 'tick' (those editors highlight during playback)
+          * @param[out] ids the IDs of these notes, in increasing order
+          */
+        void getSoundingNotes(const int tick, std::vector<int>& ids) const;
                 
         void onTrackRemoved(Track* t);
         
@@ -255,7 +281,7 @@ namespace AriaMaestosa
         void scrollKeyboardEditorNotesIntoView();
 
         // serialization
-        void saveToFile(wxFileOutputStream& fileout);
+        void saveToFile(wxOutputStream& fileout);
         bool readFromFile(irr::io::IrrXMLReader* xml);
         
     };
@@ -16,6 +16,7 @@
 
 #include "AriaCore.h"
 #include "Clipboard.h"
+#include "ObjectPool.h"
 #include "Utils.h"
 
 #include "Actions/EditAction.h"
@@ -69,6 +70,7 @@
 #include <wx/textctrl.h>
 #include <wx/choice.h>
 #include <wx/bmpbuttn.h>
+#include <wx/dir.h>
 #include <wx/notebook.h>
 #include <wx/imaglist.h>
 #include <wx/log.h>
@@ -76,6 +78,7 @@
 #include <wx/hyperlink.h>
 #include <wx/timer.h>
 #include <wx/stdpaths.h>
+#include <wx/snglinst.h>
 
 #ifdef __WXMAC__
 #include <ApplicationServices/ApplicationServices.h>
@@ -98,6 +101,7 @@ namespace AriaMaestosa
 
 static const int SCROLL_NOTES_INTO_VIEW_DELAY = 200;
 static const int SCROLL_NOTES_INTO_VIEW_TIMER = 10000;
+static const int AUTOSAVE_TIMER = 9000;
 
 class MyCustomScrollbar : public wxScrollBar
 {
@@ -349,6 +353,9 @@ MainFrame::MainFrame() : wxFrame(NULL, wxID_ANY, wxT("Aria Maestosa"), wxPoint(1
     m_disabled_for_welcome_screen = false;
     m_paused = false;
     m_reload_mode = false;
+    m_autosave_timer = NULL;
+    m_autosave_session = 0;
+    m_autosave_lock = NULL;
 
     m_root_sizer = new wxBoxSizer(wxVERTICAL);
     m_root_sizer->Add(m_main_panel, 1, wxEXPAND | wxALL, 0);
@@ -394,6 +401,14 @@ MainFrame::~MainFrame()
         wxDELETE(timer);
     }
     
+    if (m_autosave_timer != NULL)
+    {
+        m_autosave_timer->Stop();
+        wxDELETE(m_autosave_timer);
+    }
+    m_autosave_writer.waitForCompletion();
+    wxDELETE(m_autosave_lock);
+    
     saveWindowPos();
 
     m_border_sizer->Detach(m_main_panel);
@@ -922,6 +937,9 @@ void MainFrame::onShow(wxShowEvent& evt)
         loadFile(m_files_to_open[n]);
     }
     
+    recoverAutosaves();
+    startAutosaveTimer();
+    
     
     if ( pd->getBoolValue(SETTING_ID_LOAD_LAST_SESSION, false) && !m_file_in_command_line )
     {
@@ -1941,7 +1959,11 @@ bool MainFrame::closeSequence(int id_arg) // -1 means current
     }
 
 
-    if (m_sequences[id].getModel()->somethingToUndo())
+    // a recovered sequence holds unsaved work even though it has nothing to undo
+    std::map<Sequence*, AutosaveState>::iterator autosave = m_autosave_states.find(m_sequences[id].getModel());
+    const bool recovered = (autosave != m_autosave_states.end() and autosave->second.m_recovered);
+    
+    if (m_sequences[id].getModel()->somethingToUndo() or recovered)
     {
         wxString message = _("You have unsaved changes in sequence '%s'. Do you want to save them before proceeding?") +
                            wxString(wxT("\n\n")) +
@@ -1969,7 +1991,13 @@ bool MainFrame::closeSequence(int id_arg) // -1 means current
     }
 
     m_seq_warnings.erase(m_sequences[id].getModel());
+    discardAutosave(m_sequences[id].getModel());
     m_sequences.erase( id );
+    
+    // give back the slabs that held only this sequence's notes and events; slabs shared with other
+    // sequences or the clipboard are kept until those are gone too
+    ObjectPool::releaseAllUnusedMemory();
+    
     m_paused = false;
     m_toolbar->SetToolNormalBitmap(PLAY_CLICKED, m_play_bitmap);
 
@@ -2639,3 +2667,255 @@ bool MainFrame::areFilesIdentical(const wxString& filePath1, const wxString& fil
 }
    
 
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+#if 0
+#pragma mark -
+#pragma mark Autosave
+#endif
+
+/** @return the directory where crash-recovery copies of the open sequences are kept */
+static wxString getAutosaveDirectory()
+{
+    return wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + wxT("autosave");
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+/** @return the name of the lock held by the instance writing the copies of the given session */
+static wxString getAutosaveLockName(int session)
+{
+    return wxString::Format(wxT("AriaMaestosa-autosave%i-"), session) + wxGetUserId();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+/** @return the session a crash-recovery copy was written by (see getNewAutosavePath), or 0 */
+static int getAutosaveSession(const wxString& filepath)
+{
+    wxString rest;
+    long session = 0;
+    if (not wxFileName(filepath).GetName().StartsWith(wxT("session"), &rest) or
+        not rest.BeforeFirst(wxT('-')).ToLong(&session))
+    {
+        return 0;
+    }
+    return session;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool MainFrame::lockAutosaveSession()
+{
+    const wxString directory = getAutosaveDirectory();
+    if (not wxDirExists(directory) and not wxFileName::Mkdir(directory, 0777, wxPATH_MKDIR_FULL))
+    {
+        std::cerr << "[MainFrame] ERROR: cannot create " << directory.mb_str() << std::endl;
+        return false;
+    }
+    
+    // the lock of an instance that crashed is taken over, along with the copies it left
+    for (int session=1; ; session++)
+    {
+        wxSingleInstanceChecker* lock = new wxSingleInstanceChecker(getAutosaveLockName(session), directory);
+        if (lock->IsAnotherRunning())
+        {
+            delete lock;
+            continue;
+        }
+        
+        m_autosave_session = session;
+        m_autosave_lock = lock;
+        return true;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MainFrame::startAutosaveTimer()
+{
+    const long interval = PreferencesData::getInstance()->getIntValue(SETTING_ID_AUTOSAVE_INTERVAL);
+    if (interval <= 0 or m_autosave_lock == NULL) return;
+    
+    m_autosave_timer = new wxTimer(this, AUTOSAVE_TIMER);
+    Connect(AUTOSAVE_TIMER, wxEVT_TIMER, wxTimerEventHandler(MainFrame::onAutosaveTimer));
+    m_autosave_timer->Start(interval*1000);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MainFrame::onAutosaveTimer(wxTimerEvent& event)
+{
+    // on a slow disk the previous copies may still be being written; the next tick will catch up
+    if (m_autosave_writer.isBusy()) return;
+    
+    std::vector<BackgroundSnapshotWriter::Job> jobs;
+    
+    for (int n=0; n<m_sequences.size(); n++)
+    {
+        GraphicalSequence* gseq = m_sequences.get(n);
+        if (not gseq->getModel()->somethingToUndo()) continue;
+        
+        // only the tracks edited since the last copy are encoded again, the rest is shared with it
+        AutosaveState& state = m_autosave_states[gseq->getModel()];
+        std::shared_ptr<const SequenceSnapshot> snapshot =
+            std::make_shared<const SequenceSnapshot>(gseq, state.m_snapshot.get());
+        if (state.m_snapshot and snapshot->sameContentsAs(*state.m_snapshot)) continue;
+        
+        if (state.m_filepath.IsEmpty())
+        {
+            state.m_filepath = getNewAutosavePath();
+            if (state.m_filepath.IsEmpty()) return;
+        }
+        state.m_snapshot = snapshot;
+        
+        BackgroundSnapshotWriter::Job job;
+        job.m_snapshot = snapshot;
+        job.m_filepath = state.m_filepath;
+        jobs.push_back(job);
+    }
+    
+    const bool compress = PreferencesData::getInstance()->getBoolValue(SETTING_ID_COMPRESS_PROJECTS, true);
+    m_autosave_writer.start(jobs, compress);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+wxString MainFrame::getNewAutosavePath()
+{
+    const wxString directory = getAutosaveDirectory();
+    if (not wxDirExists(directory) and not wxFileName::Mkdir(directory, 0777, wxPATH_MKDIR_FULL))
+    {
+        std::cerr << "[MainFrame] ERROR: cannot create " << directory.mb_str() << std::endl;
+        return wxEmptyString;
+    }
+    
+    for (int n=1; ; n++)
+    {
+        const wxString path = directory + wxFileName::GetPathSeparator() +
+                              wxString::Format(wxT("session%i-recovery%i.aria"), m_autosave_session, n);
+        if (wxFileExists(path)) continue;
+        
+        // another sequence may have picked this name without having written it yet
+        bool taken = false;
+        std::map<Sequence*, AutosaveState>::iterator it;
+        for (it = m_autosave_states.begin(); it != m_autosave_states.end(); ++it)
+        {
+            if (it->second.m_filepath == path) taken = true;
+        }
+        if (not taken) return path;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MainFrame::markAutosaveClean(GraphicalSequence* gseq)
+{
+    AutosaveState& state = m_autosave_states[gseq->getModel()];
+    
+    // the file that was just saved is now more recent than the crash-recovery copy
+    m_autosave_writer.waitForCompletion();
+    if (not state.m_filepath.IsEmpty() and wxFileExists(state.m_filepath)) wxRemoveFile(state.m_filepath);
+    state.m_filepath = wxEmptyString;
+    state.m_recovered = false;
+    
+    // remember what was saved, so that the next copy is only written once there are new changes
+    state.m_snapshot = std::make_shared<const SequenceSnapshot>(gseq, state.m_snapshot.get());
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MainFrame::discardAutosave(Sequence* seq)
+{
+    std::map<Sequence*, AutosaveState>::iterator it = m_autosave_states.find(seq);
+    if (it == m_autosave_states.end()) return;
+    
+    m_autosave_writer.waitForCompletion();
+    if (not it->second.m_filepath.IsEmpty() and wxFileExists(it->second.m_filepath))
+    {
+        wxRemoveFile(it->second.m_filepath);
+    }
+    m_autosave_states.erase(it);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MainFrame::recoverAutosaves()
+{
+    if (not lockAutosaveSession()) return;
+    
+    wxArrayString allFiles;
+    wxDir::GetAllFiles(getAutosaveDirectory(), &allFiles, wxT("session*.aria"), wxDIR_FILES);
+    
+    // only offer the copies of instances that are no longer running; their locks are held until the
+    // copies are moved to this session, so that an instance starting meanwhile doesn't offer them too
+    wxArrayString files;
+    std::map<int, bool> running;
+    ptr_vector<wxSingleInstanceChecker> locks;
+    for (unsigned int n=0; n<allFiles.GetCount(); n++)
+    {
+        const int session = getAutosaveSession(allFiles[n]);
+        if (session == 0) continue;
+        
+        if (session != m_autosave_session and running.find(session) == running.end())
+        {
+            wxSingleInstanceChecker* lock = new wxSingleInstanceChecker(getAutosaveLockName(session),
+                                                                        getAutosaveDirectory());
+            running[session] = lock->IsAnotherRunning();
+            if (running[session]) delete lock;
+            else                  locks.push_back(lock);
+        }
+        
+        if (session == m_autosave_session or not running[session]) files.Add(allFiles[n]);
+    }
+    if (files.IsEmpty()) return;
+    
+    //I18N: shown on startup when Aria finds copies of unsaved work left by a crash
+    const int answer = wxMessageBox(_("Aria Maestosa did not quit normally the last time it was used, but it kept a copy of the changes that were not saved. Do you want to open them?") +
+                                    wxString(wxT("\n\n")) + _("Selecting 'No' will discard these changes"),
+                                    _("Recover unsaved changes"), wxYES_NO, this);
+    
+    for (unsigned int n=0; n<files.GetCount(); n++)
+    {
+        if (answer != wxYES)
+        {
+            wxRemoveFile(files[n]);
+            continue;
+        }
+        
+        // from now on the copy belongs to this instance
+        wxString filepath = files[n];
+        const wxString ownPath = getNewAutosavePath();
+        if (not ownPath.IsEmpty() and wxRenameFile(files[n], ownPath)) filepath = ownPath;
+        
+        addSequence(false);
+        setCurrentSequence( getSequenceAmount()-1 );
+        GraphicalSequence* gseq = getCurrentGraphicalSequence();
+        
+        if (not AriaMaestosa::loadAriaFile(gseq, filepath))
+        {
+            // keep the copy, in case a later version can make something out of it
+            std::cerr << "[MainFrame] ERROR: could not load " << filepath.mb_str() << std::endl;
+            closeSequence();
+            continue;
+        }
+        
+        // saving will ask where to put the recovered work instead of overwriting the copy
+        gseq->getModel()->setFilepath(wxEmptyString);
+        //I18N: title of a sequence recovered after a crash
+        gseq->getModel()->setSequenceFilename(_("Recovered"));
+        
+        AutosaveState& state = m_autosave_states[gseq->getModel()];
+        state.m_filepath  = filepath;
+        state.m_snapshot  = std::make_shared<const SequenceSnapshot>(gseq, (const SequenceSnapshot*)NULL);
+        state.m_recovered = true;
+    }
+    
+    if (getSequenceAmount() > 0)
+    {
+        updateVerticalScrollbar();
+        setCurrentSequence( getSequenceAmount()-1 );
+        Display::render();
+    }
+}
@@ -32,6 +32,7 @@
 
 #include "AriaCore.h"
 #include "GUI/GraphicalSequence.h"
+#include "IO/SequenceSnapshot.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "ptr_vector.h"
@@ -51,6 +52,7 @@ class wxBoxSizer;
 class wxStaticBitmap;
 class wxTimer;
 class wxTimerEvent;
+class wxSingleInstanceChecker;
 
 #ifdef __WXMAC__
 #include <wx/textctrl.h>
@@ -168,6 +170,7 @@ namespace AriaMaestosa
         MENU_FILE_RELOAD,
         MENU_FILE_IMPORT_MIDI,
         MENU_FILE_EXPORT_MIDI,
+        MENU_FILE_EXPORT_XML,
         MENU_FILE_EXPORT_SAMPLED_AUDIO,
         MENU_FILE_EXPORT_NOTATION,
         MENU_FILE_CLOSE,
@@ -183,6 +186,7 @@ namespace AriaMaestosa
         MENU_EDIT_SCALE,
         MENU_EDIT_REMOVE_OVERLAPPING,
         MENU_EDIT_UNDO,
+        MENU_EDIT_REDO,
         MENU_EDIT_SCROLL_NOTES_INTO_VIEW,
 
         MENU_SETTINGS_FOLLOW_PLAYBACK,
@@ -204,6 +208,8 @@ namespace AriaMaestosa
         MENU_STOP,
         MENU_RECORD,
 
+        MENU_HELP_DEBUG_STATS,
+
         MENU_FILE_LOAD_RECENT_FILE = wxID_HIGHEST + 100,
         MENU_OUTPUT_DEVICE = wxID_HIGHEST + 200,
         MENU_INPUT_DEVICE = wxID_HIGHEST + 300
@@ -419,6 +425,30 @@ namespace AriaMaestosa
         bool m_file_in_command_line;
         
         std::map<int, wxTimer*> m_timer_map;
+        
+        /** Crash-recovery copy of one open sequence */
+        struct AutosaveState
+        {
+            /** where the copy is written, empty until one is needed */
+            wxString m_filepath;
+            
+            /** contents of the last copy (or of the last real save), to skip writing it again */
+            std::shared_ptr<const SequenceSnapshot> m_snapshot;
+            
+            /** whether the sequence was opened from a crash-recovery copy and not saved since */
+            bool m_recovered;
+            
+            AutosaveState() : m_recovered(false) {}
+        };
+        
+        std::map<Sequence*, AutosaveState> m_autosave_states;
+        BackgroundSnapshotWriter m_autosave_writer;
+        wxTimer* m_autosave_timer;
+        
+        /** Crash-recovery copies are named after a session number that this instance holds a lock on,
+          * so that other instances can tell them from the copies left behind by a crash */
+        int m_autosave_session;
+        wxSingleInstanceChecker* m_autosave_lock;
        
 #if !defined(__WXOSX_CARBON__)
         wxStaticBitmap* m_tools_bitmap;
@@ -439,6 +469,12 @@ namespace AriaMaestosa
         void saveRecentFileList();
         void saveOpenedFiles();
         void requestForScrollKeyboardEditorNotesIntoView();
+        void startAutosaveTimer();
+        void recoverAutosaves();
+        bool lockAutosaveSession();
+        wxString getNewAutosavePath();
+        void markAutosaveClean(GraphicalSequence* gseq);
+        void discardAutosave(Sequence* seq);
         void scrollKeyboardEditorNotesIntoView(int sequenceId);
         bool areFilesIdentical(const wxString& filePath1, const wxString& filePath2);
         void addRecentFile(const wxString& path);
@@ -510,6 +546,7 @@ namespace AriaMaestosa
         void menuEvent_open(wxCommandEvent& evt);
         void menuEvent_copy(wxCommandEvent& evt);
         void menuEvent_undo(wxCommandEvent& evt);
+        void menuEvent_redo(wxCommandEvent& evt);
         void menuEvent_paste(wxCommandEvent& evt);
         void menuEvent_pasteAtMouse(wxCommandEvent& evt);
         void menuEvent_save(wxCommandEvent& evt);
@@ -525,6 +562,7 @@ namespace AriaMaestosa
         void menuEvent_trackBackground(wxCommandEvent& evt);
         void menuEvent_importmidi(wxCommandEvent& evt);
         void menuEvent_exportmidi(wxCommandEvent& evt);
+        void menuEvent_exportXml(wxCommandEvent& evt);
         void menuEvent_exportSampledAudio(wxCommandEvent& evt);
         void menuEvent_customNoteSelect(wxCommandEvent& evt);
         void menuEvent_snapToGrid(wxCommandEvent& evt);
@@ -540,6 +578,7 @@ namespace AriaMaestosa
         void menuEvent_quit(wxCommandEvent& evt);
         void menuEvent_about(wxCommandEvent& evt);
         void menuEvent_manual(wxCommandEvent& evt);
+        void menuEvent_debugStats(wxCommandEvent& evt);
         void menuEvent_automaticChannelModeSelected(wxCommandEvent& evt);
         void menuEvent_manualChannelModeSelected(wxCommandEvent& evt);
         void menuEvent_expandedMeasuresSelected(wxCommandEvent& evt);
@@ -556,6 +595,7 @@ namespace AriaMaestosa
         void onMouseWheel(wxMouseEvent& event);
         void onShow(wxShowEvent& evt);
         void onTimer(wxTimerEvent & event);
+        void onAutosaveTimer(wxTimerEvent& event);
 
         // ---- playback
         void songHasFinishedPlaying();
@@ -43,7 +43,9 @@
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "Midi/Players/PlatformMidiManager.h"
+#include "Midi/Players/Sequencer.h"
 #include "Midi/CommonMidiUtils.h"
+#include "ObjectPool.h"
 #include "Pickers/KeyPicker.h"
 #include "Pickers/TuningPicker.h"
 #include "Pickers/InstrumentPicker.h"
@@ -70,6 +72,14 @@ using namespace AriaMaestosa;
 
 // -----------------------------------------------------------------------------------------------------------
 
+#ifdef __WXMSW__
+#define REDO_SHORTCUT wxT("\tCtrl-Y")
+#else
+#define REDO_SHORTCUT wxT("\tCtrl-Shift-Z")
+#endif
+
+// -----------------------------------------------------------------------------------------------------------
+
 void MainFrame::initMenuBar()
 {
     m_menu_bar = new wxMenuBar();
@@ -131,6 +141,9 @@ void MainFrame::initMenuBar()
     //I18N: menu item in the "file" menu
     m_file_menu -> QUICK_ADD_MENU ( MENU_FILE_EXPORT_MIDI, _("&Export to Midi..."),
                                     MainFrame::menuEvent_exportmidi );
+    //I18N: menu item in the "file" menu
+    m_file_menu -> QUICK_ADD_MENU ( MENU_FILE_EXPORT_XML, _("Export to XML .aria..."),
+                                    MainFrame::menuEvent_exportXml );
 
     // disable export to sampled audio if this feature is not supported by the current PlatformMidiManager
     if (not PlatformMidiManager::get()->getAudioExtension().IsEmpty())
@@ -156,6 +169,10 @@ void MainFrame::initMenuBar()
     addIconItem(m_edit_menu, MENU_EDIT_UNDO, wxString(_("&Undo"))+wxT("\tCtrl-Z"), wxART_UNDO);
     Connect(MENU_EDIT_UNDO, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(MainFrame::menuEvent_undo));
 
+    //I18N: menu item in the "edit" menu
+    addIconItem(m_edit_menu, MENU_EDIT_REDO, wxString(_("&Redo"))+REDO_SHORTCUT, wxART_REDO);
+    Connect(MENU_EDIT_REDO, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(MainFrame::menuEvent_redo));
+
 
     m_edit_menu->AppendSeparator();
 
@@ -377,6 +394,11 @@ void MainFrame::initMenuBar()
     //I18N: - in help menu - see the help files
     m_help_menu->QUICK_ADD_MENU(wxID_HELP,  _("User's &Manual"), MainFrame::menuEvent_manual);
 
+    m_help_menu->AppendSeparator();
+    m_help_menu->QUICK_ADD_MENU(MENU_HELP_DEBUG_STATS,
+                                wxT("Debug Statistics (memory, frame times, playback timing)"),
+                                MainFrame::menuEvent_debugStats);
+
 #ifdef __WXMAC__
     // On OSX a menu item named "&Help" will be translated by wx into a native help menu
     m_menu_bar->Append(m_help_menu, wxT("&Help"));
@@ -425,6 +447,7 @@ void MainFrame::disableMenus(const bool disable)
     m_file_menu->Enable(MENU_FILE_CLOSE, on);
     m_file_menu->Enable(MENU_FILE_IMPORT_MIDI, on);
     m_file_menu->Enable(MENU_FILE_EXPORT_MIDI, on);
+    m_file_menu->Enable(MENU_FILE_EXPORT_XML, on);
 
     if (not PlatformMidiManager::get()->getAudioExtension().IsEmpty())
     {
@@ -465,6 +488,7 @@ void MainFrame::doDisableMenusForWelcomeScreen(const bool disable)
     m_file_menu->Enable(MENU_FILE_RELOAD, on);
     m_file_menu->Enable(MENU_FILE_CLOSE, on);
     m_file_menu->Enable(MENU_FILE_EXPORT_MIDI, on);
+    m_file_menu->Enable(MENU_FILE_EXPORT_XML, on);
 
     if (not PlatformMidiManager::get()->getAudioExtension().IsEmpty())
     {
@@ -544,12 +568,32 @@ void MainFrame::updateUndoMenuLabel()
 #endif
         }
 
+        wxString redo_what = getCurrentSequence()->getRedoActionName();
+        if (redo_what.size() > 0)
+        {
+            //I18N: menu item in the "edit" menu, followed by the name of the action to redo
+            wxString label = wxString(_("&Redo %s"))+REDO_SHORTCUT;
+            label.Replace(wxT("%s"), redo_what);
+            menuBar->SetLabel( MENU_EDIT_REDO, label );
+            menuBar->Enable( MENU_EDIT_REDO, true );
+        }
+        else
+        {
+            menuBar->SetLabel( MENU_EDIT_REDO, wxString(_("Can't Redo"))+REDO_SHORTCUT );
+            menuBar->Enable( MENU_EDIT_REDO, false );
+        }
+
 #ifndef __WXMAC__
         wxMenuItem* undoMenuItem = menuBar->FindItem(MENU_EDIT_UNDO, NULL);
         if (undoMenuItem != NULL)
         {
             undoMenuItem->SetBitmap(wxArtProvider::GetBitmap(wxART_UNDO));
         }
+        wxMenuItem* redoMenuItem = menuBar->FindItem(MENU_EDIT_REDO, NULL);
+        if (redoMenuItem != NULL)
+        {
+            redoMenuItem->SetBitmap(wxArtProvider::GetBitmap(wxART_REDO));
+        }
 #endif
     }
 }
@@ -669,7 +713,10 @@ bool MainFrame::doSave()
     }
     else
     {
-        saveAriaFile(getCurrentGraphicalSequence(), getCurrentSequence()->getFilepath());
+        if (saveAriaFile(getCurrentGraphicalSequence(), getCurrentSequence()->getFilepath()))
+        {
+            markAutosaveClean(getCurrentGraphicalSequence());
+        }
         return true;
     }
     
@@ -714,7 +761,10 @@ bool MainFrame::doSaveAs()
 #endif
 
         getCurrentSequence()->setFilepath( givenPath );
-        saveAriaFile(getCurrentGraphicalSequence(), getCurrentSequence()->getFilepath());
+        if (saveAriaFile(getCurrentGraphicalSequence(), getCurrentSequence()->getFilepath()))
+        {
+            markAutosaveClean(getCurrentGraphicalSequence());
+        }
 
         // change song name
         getCurrentSequence()->setSequenceFilename( extractTitle(getCurrentSequence()->getFilepath()) );
@@ -790,6 +840,34 @@ void MainFrame::menuEvent_exportmidi(wxCommandEvent& evt)
 
 // -----------------------------------------------------------------------------------------------------------
 
+void MainFrame::menuEvent_exportXml(wxCommandEvent& evt)
+{
+    wxString suggestedName = getCurrentSequence()->suggestFileName() + wxT(".aria");
+
+    // show file dialog
+    wxString xmlFilePath = showFileDialog(this, _("Select destination file"), m_current_dir,
+                                          suggestedName, wxString(_("Aria Maestosa file"))+wxT("|*.aria"),
+                                          true /*save*/);
+    updateCurrentDir(xmlFilePath);
+    if (xmlFilePath.IsEmpty()) return;
+
+#ifndef __WXOSX_COCOA__
+    // Check if file already exists and ask before overwriting it, EXCEPT on Cocoa where the native
+    // file dialog has a built-in replace dialog
+    if ( wxFileExists(xmlFilePath) )
+    {
+        int answer = wxMessageBox(  _("The file already exists. Do you wish to overwrite it?"), _("Confirm"),
+                                    wxYES_NO, this);
+        if (answer != wxYES) return;
+    }
+#endif
+
+    // unlike "save as", exporting does not change the file the sequence is saved to
+    saveAriaFile(getCurrentGraphicalSequence(), xmlFilePath, ARIA_FILE_XML);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 void MainFrame::menuEvent_exportSampledAudio(wxCommandEvent& evt)
 {
     if (getSequenceAmount() == 0) return;
@@ -936,6 +1014,13 @@ void MainFrame::menuEvent_undo(wxCommandEvent& evt)
 
 // -----------------------------------------------------------------------------------------------------------
 
+void MainFrame::menuEvent_redo(wxCommandEvent& evt)
+{
+    getCurrentSequence()->redo();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 void MainFrame::menuEvent_selectNone(wxCommandEvent& evt)
 {
     getCurrentGraphicalSequence()->selectNone();
@@ -1443,6 +1528,66 @@ void MainFrame::menuEvent_manual(wxCommandEvent& evt)
  */
 }
 
+// -----------------------------------------------------------------------------------------------------------
+
+void MainFrame::menuEvent_debugStats(wxCommandEvent& evt)
+{
+    const std::vector<ObjectPool*>& pools = ObjectPool::getPools();
+
+    wxString message;
+    for (unsigned int n=0; n<pools.size(); n++)
+    {
+        const ObjectPool* pool = pools[n];
+        message += wxString::Format(wxT("%s\n    live : %i (peak %i)\n    allocations : %li\n")
+                                    wxT("    slabs : %i (%.1f KiB)\n    released : %.1f KiB\n\n"),
+                                    wxString(pool->getName(), wxConvUTF8).c_str(),
+                                    pool->getLiveCount(), pool->getPeakCount(), pool->getAllocationCount(),
+                                    pool->getSlabCount(), pool->getReservedBytes()/1024.0,
+                                    pool->getReleasedBytes()/1024.0);
+    }
+    if (message.IsEmpty()) message = wxT("No object pool in use\n\n");
+
+    FrameTimeCounter& frameTime = m_main_pane->getFrameTimeCounter();
+    message += wxString::Format(wxT("Frames drawn : %li\n    last : %.2f ms\n    average : %.2f ms\n")
+                                wxT("    worst : %.2f ms\n"),
+                                frameTime.getFrameCount(), frameTime.getLastFrameTime(),
+                                frameTime.getAverageFrameTime(), frameTime.getWorstFrameTime());
+
+    // so that the next time the statistics are shown, they only cover the frames drawn since
+    frameTime.reset();
+
+    // the histogram is updated from the sequencer thread
+    if (PlatformMidiManager::get()->isPlaying())
+    {
+        message += wxT("\nPlayback timing : stop playback to see it\n");
+    }
+    else
+    {
+        const LatenessHistogram& lateness = AriaSequenceTimer::getLatenessHistogram();
+        message += wxString::Format(wxT("\nLateness of the %i events sent during the last playback\n")
+                                    wxT("    mean : %.0f us\n    max : %.0f us\n"),
+                                    lateness.getEventCount(), lateness.getMeanLatenessMicros(),
+                                    lateness.getMaxLatenessMicros());
+        for (int n=0; n<LatenessHistogram::BUCKET_COUNT; n++)
+        {
+            if (n < LatenessHistogram::BUCKET_COUNT - 1)
+            {
+                message += wxString::Format(wxT("    < %i us : %i\n"), LatenessHistogram::getBucketLimit(n),
+                                            lateness.getBucketCount(n));
+            }
+            else
+            {
+                message += wxString::Format(wxT("    >= %i us : %i\n"), LatenessHistogram::getBucketLimit(n-1),
+                                            lateness.getBucketCount(n));
+            }
+        }
+    }
+
+    wxMessageBox(message, wxT("Debug Statistics"));
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 void MainFrame::updateCurrentDir(wxString& path)
 {
     if (!path.IsEmpty())
@@ -19,6 +19,7 @@
 #include "AriaCore.h"
 
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 
 #include "Actions/EditAction.h"
@@ -160,6 +161,7 @@ MainPane::MainPane(wxWindow* parent, int* args) :
     m_quit_label.setFont(getWelcomeMenuFont());
     
     m_current_tick        = -1;
+    m_layers_generation   = 0;
     m_dragged_track_id    = -1;
     m_is_visible          = false;
     m_is_mouse_down       = false;
@@ -243,7 +245,15 @@ void MainPane::paintEvent(wxPaintEvent& evt)
     #ifdef RENDERER_OPENGL
     wxPaintDC mydc(this); // OpenGL handles double-buffering on its own
     #else
-    wxAutoBufferedPaintDC mydc(this);
+    // always draw in a buffer of our own, even where the system already double-buffers, since
+    // editors copy parts of what was drawn back from it
+    const wxSize size = GetClientSize();
+    if (not m_back_buffer.IsOk() or m_back_buffer.GetWidth()  < size.x or
+                                    m_back_buffer.GetHeight() < size.y)
+    {
+        m_back_buffer.Create(std::max(size.x, 1), std::max(size.y, 1));
+    }
+    wxBufferedPaintDC mydc(this, m_back_buffer);
     #endif
     
     
@@ -252,9 +262,11 @@ void MainPane::paintEvent(wxPaintEvent& evt)
     
     Display::renderDC = &mydc;
 
+    m_frame_time.beginFrame();
     beginFrame();
     if (do_render()) endFrame();
     else { printf("***** do_render returned false!!\n"); }
+    m_frame_time.endFrame();
     Display::renderDC = NULL;
 }
 
@@ -273,6 +285,21 @@ void MainPane::renderNow()
      */
     Refresh();
 }
+
+// -----------------------------------------------------------------------------------------------------------
+
+void MainPane::Refresh(bool eraseBackground, const wxRect* rect)
+{
+    m_layers_generation++;
+    RenderPane::Refresh(eraseBackground, rect);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void MainPane::refreshPlaybackCursor()
+{
+    RenderPane::Refresh();
+}
         
 // -----------------------------------------------------------------------------------------------------------
 
@@ -1617,8 +1644,8 @@ void MainPane::playbackRenderLoop()
 
         setCurrentTick( startTick + currentTick );
 
-        RelativeXCoord tick(m_current_tick, MIDI, gseq);
-        Display::render();
+        // when scrolling, editors notice it themselves and draw again
+        refreshPlaybackCursor();
         m_last_tick = startTick + currentTick;
     }
 }
@@ -1645,7 +1672,7 @@ void MainPane::setCurrentTick(int currentTick)
 #pragma mark Serialization
 #endif
 
-void MainPane::saveToFile(wxFileOutputStream& fileout)
+void MainPane::saveToFile(wxOutputStream& fileout)
 {
     getMainFrame()->getCurrentGraphicalSequence()->saveToFile(fileout);
 }
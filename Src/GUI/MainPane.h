@@ -19,6 +19,7 @@
 
 #include "Utils.h"
 #include "Editors/RelativeXCoord.h"
+#include "GUI/FrameTimeCounter.h"
 
 #ifdef RENDERER_OPENGL
 #include "Renderers/GLPane.h"
@@ -31,6 +32,9 @@
 #include "Renderers/RenderAPI.h"
 
 #include <vector>
+#ifdef RENDERER_WXWIDGETS
+#include <wx/bitmap.h>
+#endif
 
 namespace AriaMaestosa
 {
@@ -130,6 +134,16 @@ namespace AriaMaestosa
         bool     m_have_plus_cursor;
         wxCursor m_plus_cursor;
         
+        FrameTimeCounter m_frame_time;
+        
+        /** changes on every refresh, except those only meant to move the playback cursor */
+        unsigned int m_layers_generation;
+        
+#ifdef RENDERER_WXWIDGETS
+        /** what is drawn is kept here, so that editors can read it back (see Editor::renderCached) */
+        wxBitmap m_back_buffer;
+#endif
+        
     public:
         LEAK_CHECK();
 
@@ -162,6 +176,9 @@ namespace AriaMaestosa
 
         bool isLeftArrowVisible () const { return m_left_arrow;  }
         bool isRightArrowVisible() const { return m_right_arrow; }
+        
+        /** @brief time spent painting this pane, for debugging and measuring render code */
+        FrameTimeCounter& getFrameTimeCounter() { return m_frame_time; }
 
         
         // ---- events
@@ -221,12 +238,24 @@ namespace AriaMaestosa
         
         void renderNow();
         
+        /** @brief asks for a new frame; the areas saved by editors will not be reused in it */
+        virtual void Refresh(bool eraseBackground = true, const wxRect* rect = NULL);
+        
+        /**
+          * @brief asks for a new frame after the playback position moved. Editors may draw the area they
+          *        saved in the previous frame instead of redrawing their contents (see Editor::renderCached)
+          */
+        void refreshPlaybackCursor();
+        
+        /** @brief saved editor areas are only drawn again in frames of the same generation */
+        unsigned int getLayersGeneration() const { return m_layers_generation; }
+        
         // ---- rendering
         bool isVisible() const { return m_is_visible; }
         void paintEvent(wxPaintEvent& evt);
 
         // ---- serialization
-        void saveToFile(wxFileOutputStream& fileout);
+        void saveToFile(wxOutputStream& fileout);
 
         void handleTooltipOnTabs(wxMouseEvent& event);
 
@@ -0,0 +1,750 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Layout of a binary .aria file (all integers little-endian) :
+ *
+ *   "ARIABIN" + '\0', u32 format version
+ *   then a list of sections, each one being :
+ *      4-character tag, u32 flags, u32 stored size, u32 decompressed size, stored bytes
+ *
+ *   "PROJ" : the project as written by the XML writer, minus the notes and controller events
+ *   "TRAK" : the notes and controller events of one track, see Track::saveEventsToBinary.
+ *            There is one such section per track, in track order.
+ *
+ * Unknown sections are skipped, so new kinds of data can be added without breaking older readers.
+ */
+
+#include "IO/AriaBinaryFile.h"
+
+#include "AriaCore.h"
+#include "GUI/GraphicalSequence.h"
+#include "IO/SequenceSnapshot.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "UnitTest.h"
+#include "UnitTestUtils.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+#include <wx/ffile.h>
+#include <wx/file.h>
+#include <wx/mstream.h>
+#include "irrXML/irrXML.h"
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    const char BINARY_MAGIC[8] = { 'A', 'R', 'I', 'A', 'B', 'I', 'N', '\0' };
+
+    /** bump when the container layout changes in a way older readers cannot skip */
+    const unsigned int BINARY_FORMAT_VERSION = 1;
+
+    const unsigned int SECTION_FLAG_COMPRESSED = 1;
+
+    // ---- LZ4-style block compression ----
+
+    /** number of bits of the hash table used to find matches */
+    const int LZ_HASH_BITS = 12;
+
+    /** matches are at least this long; shorter ones cost more than the literals they replace */
+    const int LZ_MIN_MATCH = 4;
+
+    /** the last bytes of a block are always stored as literals */
+    const int LZ_LAST_LITERALS = 5;
+
+    /** no match may start this close to the end of a block */
+    const int LZ_MATCH_LIMIT = 12;
+
+    const int LZ_MAX_OFFSET = 65535;
+
+    inline unsigned int read32(const unsigned char* p)
+    {
+        unsigned int value;
+        memcpy(&value, p, 4);
+        return value;
+    }
+
+    inline unsigned int hashSequence(const unsigned int sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+    }
+
+    /** writes the part of a length that does not fit in its 4-bit token field */
+    void writeLengthTail(std::vector<unsigned char>& out, int length)
+    {
+        while (length >= 255)
+        {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(length);
+    }
+
+    void writeLzSequence(std::vector<unsigned char>& out, const unsigned char* literals, const int literalCount,
+                         const int offset, const int matchLength)
+    {
+        const int literalToken = std::min(literalCount, 15);
+        const int matchToken   = (matchLength == 0 ? 0 : std::min(matchLength - LZ_MIN_MATCH, 15));
+        out.push_back((literalToken << 4) | matchToken);
+
+        if (literalCount >= 15) writeLengthTail(out, literalCount - 15);
+        out.insert(out.end(), literals, literals + literalCount);
+
+        if (matchLength == 0) return; // last sequence of the block
+
+        out.push_back(offset & 0xFF);
+        out.push_back((offset >> 8) & 0xFF);
+        if (matchLength - LZ_MIN_MATCH >= 15) writeLengthTail(out, matchLength - LZ_MIN_MATCH - 15);
+    }
+
+    /** reads the part of a length stored after its token; returns -1 if the data ends first */
+    int readLengthTail(const unsigned char* in, const int inSize, int& position)
+    {
+        int length = 0;
+        int byte;
+        do
+        {
+            if (position >= inSize) return -1;
+            byte = in[position++];
+            length += byte;
+        } while (byte == 255);
+        return length;
+    }
+
+    // ---- XML from memory ----
+
+    /** lets irrXML parse the XML part of a binary file straight from memory */
+    class MemoryReadCallBack : public irr::io::IFileReadCallBack
+    {
+        const unsigned char* m_data;
+        int m_size;
+        int m_position;
+
+    public:
+
+        MemoryReadCallBack(const unsigned char* data, const int size)
+        {
+            m_data     = data;
+            m_size     = size;
+            m_position = 0;
+        }
+
+        virtual int read(void* buffer, int sizeToRead)
+        {
+            const int count = std::min(sizeToRead, m_size - m_position);
+            memcpy(buffer, m_data + m_position, count);
+            m_position += count;
+            return count;
+        }
+
+        virtual int getSize()
+        {
+            return m_size;
+        }
+    };
+
+    // ---- sections ----
+
+    void writeSection(BinaryWriter& file, const char tag[4], const std::vector<unsigned char>& data,
+                      const bool compress)
+    {
+        std::vector<unsigned char> compressed;
+        if (compress and not data.empty())
+        {
+            compressed.reserve(data.size());
+            compressBlock(&data[0], data.size(), compressed);
+        }
+
+        // only keep the compressed form if it actually helps
+        const bool useCompressed = (compress and not data.empty() and compressed.size() < data.size());
+        const std::vector<unsigned char>& stored = (useCompressed ? compressed : data);
+
+        file.writeBytes(tag, 4);
+        file.writeU32(useCompressed ? SECTION_FLAG_COMPRESSED : 0);
+        file.writeU32(stored.size());
+        file.writeU32(data.size());
+        if (not stored.empty()) file.writeBytes(&stored[0], stored.size());
+    }
+
+    struct Section
+    {
+        char tag[5];
+        std::vector<unsigned char> data;
+    };
+
+    /** splits the body of a binary file into its (decompressed) sections */
+    bool readSections(BinaryReader& file, std::vector<Section>& sections)
+    {
+        while (not file.atEnd())
+        {
+            const unsigned char* tag = file.readBytes(4);
+            const unsigned int flags      = file.readU32();
+            const unsigned int storedSize = file.readU32();
+            const unsigned int rawSize    = file.readU32();
+            if (file.failed() or storedSize > 0x7FFFFFFF or rawSize > 0x7FFFFFFF) return false;
+
+            const unsigned char* stored = file.readBytes(storedSize);
+            if (stored == NULL) return false;
+
+            sections.push_back(Section());
+            Section& section = sections.back();
+            memcpy(section.tag, tag, 4);
+            section.tag[4] = '\0';
+
+            if (flags & SECTION_FLAG_COMPRESSED)
+            {
+                // a compressed byte never expands to more than 255 bytes; don't trust larger sizes
+                if (rawSize / 255 > storedSize) return false;
+
+                section.data.resize(rawSize);
+                if (rawSize > 0 and not decompressBlock(stored, storedSize, &section.data[0], rawSize))
+                {
+                    std::cerr << "[AriaBinaryFile] ERROR: section " << section.tag << " is corrupt" << std::endl;
+                    return false;
+                }
+            }
+            else
+            {
+                if (storedSize != rawSize) return false;
+                section.data.assign(stored, stored + storedSize);
+            }
+        }
+        return true;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// --------------------------------------------- BinaryWriter -----------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+void BinaryWriter::writeU8(const int value)
+{
+    m_data.push_back(value & 0xFF);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BinaryWriter::writeU16(const int value)
+{
+    m_data.push_back(value & 0xFF);
+    m_data.push_back((value >> 8) & 0xFF);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BinaryWriter::writeI32(const int value)
+{
+    writeU32((unsigned int)value);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BinaryWriter::writeU32(const unsigned int value)
+{
+    m_data.push_back(value & 0xFF);
+    m_data.push_back((value >> 8) & 0xFF);
+    m_data.push_back((value >> 16) & 0xFF);
+    m_data.push_back((value >> 24) & 0xFF);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BinaryWriter::writeF64(const double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    writeU32(bits & 0xFFFFFFFF);
+    writeU32(bits >> 32);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BinaryWriter::writeBytes(const void* data, const int size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    m_data.insert(m_data.end(), bytes, bytes + size);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// --------------------------------------------- BinaryReader -----------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+BinaryReader::BinaryReader(const unsigned char* data, const int size)
+{
+    m_data     = data;
+    m_size     = size;
+    m_position = 0;
+    m_failed   = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool BinaryReader::hasBytes(const int count)
+{
+    if (m_failed or count < 0 or count > m_size - m_position)
+    {
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int BinaryReader::readU8()
+{
+    if (not hasBytes(1)) return 0;
+    return m_data[m_position++];
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int BinaryReader::readU16()
+{
+    if (not hasBytes(2)) return 0;
+    const int value = m_data[m_position] | (m_data[m_position + 1] << 8);
+    m_position += 2;
+    return value;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int BinaryReader::readI32()
+{
+    return (int)readU32();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+unsigned int BinaryReader::readU32()
+{
+    if (not hasBytes(4)) return 0;
+    const unsigned char* p = m_data + m_position;
+    m_position += 4;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+double BinaryReader::readF64()
+{
+    const uint64_t low  = readU32();
+    const uint64_t high = readU32();
+    const uint64_t bits = low | (high << 32);
+
+    double value;
+    memcpy(&value, &bits, 8);
+    return value;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const unsigned char* BinaryReader::readBytes(const int size)
+{
+    if (not hasBytes(size)) return NULL;
+    const unsigned char* bytes = m_data + m_position;
+    m_position += size;
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ------------------------------------------- Block compression --------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+void AriaMaestosa::compressBlock(const unsigned char* in, const int size, std::vector<unsigned char>& out)
+{
+    // position of the last occurrence of each hashed 4-byte sequence
+    std::vector<int> table(1 << LZ_HASH_BITS, -1);
+
+    int anchor   = 0; // start of the literals not yet written
+    int position = 0;
+    const int lastMatchStart = size - LZ_MATCH_LIMIT;
+
+    while (position < lastMatchStart)
+    {
+        const unsigned int sequence = read32(in + position);
+        const unsigned int hash     = hashSequence(sequence);
+        const int candidate = table[hash];
+        table[hash] = position;
+
+        if (candidate < 0 or position - candidate > LZ_MAX_OFFSET or read32(in + candidate) != sequence)
+        {
+            position++;
+            continue;
+        }
+
+        int matchLength = LZ_MIN_MATCH;
+        const int maxLength = size - LZ_LAST_LITERALS - position;
+        while (matchLength < maxLength and in[candidate + matchLength] == in[position + matchLength])
+        {
+            matchLength++;
+        }
+
+        writeLzSequence(out, in + anchor, position - anchor, position - candidate, matchLength);
+        position += matchLength;
+        anchor = position;
+    }
+
+    writeLzSequence(out, in + anchor, size - anchor, 0, 0);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::decompressBlock(const unsigned char* in, const int inSize, unsigned char* out, const int outSize)
+{
+    int inPosition  = 0;
+    int outPosition = 0;
+
+    while (inPosition < inSize)
+    {
+        const int token = in[inPosition++];
+
+        int literalCount = token >> 4;
+        if (literalCount == 15)
+        {
+            const int tail = readLengthTail(in, inSize, inPosition);
+            if (tail < 0) return false;
+            literalCount += tail;
+        }
+
+        if (literalCount > inSize - inPosition or literalCount > outSize - outPosition) return false;
+        memcpy(out + outPosition, in + inPosition, literalCount);
+        inPosition  += literalCount;
+        outPosition += literalCount;
+
+        if (inPosition == inSize) break; // the last sequence has no match
+
+        if (inSize - inPosition < 2) return false;
+        const int offset = in[inPosition] | (in[inPosition + 1] << 8);
+        inPosition += 2;
+        if (offset == 0 or offset > outPosition) return false;
+
+        int matchLength = (token & 15);
+        if (matchLength == 15)
+        {
+            const int tail = readLengthTail(in, inSize, inPosition);
+            if (tail < 0) return false;
+            matchLength += tail;
+        }
+        matchLength += LZ_MIN_MATCH;
+
+        if (matchLength > outSize - outPosition) return false;
+
+        // the match may overlap the bytes it produces, so copy one byte at a time
+        const unsigned char* from = out + outPosition - offset;
+        for (int n=0; n<matchLength; n++) out[outPosition + n] = from[n];
+        outPosition += matchLength;
+    }
+
+    return outPosition == outSize;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- Files --------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::isBinaryAriaFile(wxString filepath)
+{
+    wxFFile file(filepath, wxT("rb"));
+    if (not file.IsOpened()) return false;
+
+    char magic[8];
+    if (file.Read(magic, 8) != 8) return false;
+    return memcmp(magic, BINARY_MAGIC, 8) == 0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::saveBinaryAriaFile(GraphicalSequence* gseq, wxString filepath, const bool compress)
+{
+    SequenceSnapshot snapshot(gseq, NULL);
+    return saveBinaryAriaFile(snapshot, filepath, compress);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::saveBinaryAriaFile(const SequenceSnapshot& snapshot, wxString filepath, const bool compress)
+{
+    BinaryWriter file;
+    file.writeBytes(BINARY_MAGIC, 8);
+    file.writeU32(BINARY_FORMAT_VERSION);
+
+    writeSection(file, "PROJ", snapshot.getProject(), compress);
+
+    const int trackAmount = snapshot.getTrackAmount();
+    for (int n=0; n<trackAmount; n++)
+    {
+        writeSection(file, "TRAK", snapshot.getTrackEvents(n), compress);
+    }
+
+    wxFile out;
+    if (not out.Create(filepath, true /* overwrite */))
+    {
+        std::cerr << "[AriaBinaryFile] ERROR: could not open " << filepath.mb_str() << " for writing" << std::endl;
+        return false;
+    }
+
+    const std::vector<unsigned char>& bytes = file.getData();
+    if (out.Write(&bytes[0], bytes.size()) != bytes.size())
+    {
+        std::cerr << "[AriaBinaryFile] ERROR: could not write " << filepath.mb_str() << std::endl;
+        return false;
+    }
+    return out.Close();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::loadBinaryAriaFile(GraphicalSequence* gseq, wxString filepath)
+{
+    std::vector<unsigned char> bytes;
+    {
+        wxFFile file(filepath, wxT("rb"));
+        if (not file.IsOpened()) return false;
+
+        const wxFileOffset length = file.Length();
+        if (length < 12 or length > 0x7FFFFFFF) return false;
+
+        bytes.resize(length);
+        if (file.Read(&bytes[0], length) != (size_t)length) return false;
+    }
+
+    BinaryReader file(&bytes[0], bytes.size());
+    const unsigned char* magic = file.readBytes(8);
+    if (magic == NULL or memcmp(magic, BINARY_MAGIC, 8) != 0) return false;
+
+    const unsigned int version = file.readU32();
+    if (version > BINARY_FORMAT_VERSION)
+    {
+        std::cerr << "[AriaBinaryFile] ERROR: file format version " << version
+                  << " is more recent than this version of Aria Maestosa supports" << std::endl;
+        return false;
+    }
+
+    std::vector<Section> sections;
+    if (not readSections(file, sections))
+    {
+        std::cerr << "[AriaBinaryFile] ERROR: " << filepath.mb_str() << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    const Section* project = NULL;
+    std::vector<const Section*> tracks;
+    for (unsigned int n=0; n<sections.size(); n++)
+    {
+        if      (strcmp(sections[n].tag, "PROJ") == 0) project = &sections[n];
+        else if (strcmp(sections[n].tag, "TRAK") == 0) tracks.push_back(&sections[n]);
+    }
+
+    if (project == NULL or project->data.empty())
+    {
+        std::cerr << "[AriaBinaryFile] ERROR: file contains no project section" << std::endl;
+        return false;
+    }
+
+    {
+        MemoryReadCallBack callback(&project->data[0], project->data.size());
+        irr::io::IrrXMLReader* xml = irr::io::createIrrXMLReader(&callback);
+        if (xml == NULL) return false;
+
+        const bool success = gseq->readFromFile(xml);
+        delete xml;
+        if (not success) return false;
+    }
+
+    Sequence* sequence = gseq->getModel();
+    if ((int)tracks.size() != sequence->getTrackAmount())
+    {
+        std::cerr << "[AriaBinaryFile] ERROR: file has " << tracks.size() << " event sections for "
+                  << sequence->getTrackAmount() << " tracks" << std::endl;
+        return false;
+    }
+
+    OwnerPtr<Sequence::Import> import(sequence->startImport());
+    for (unsigned int n=0; n<tracks.size(); n++)
+    {
+        const std::vector<unsigned char>& data = tracks[n]->data;
+        BinaryReader events((data.empty() ? NULL : &data[0]), data.size());
+        if (not sequence->getTrack(n)->readEventsFromBinary(events))
+        {
+            std::cerr << "[AriaBinaryFile] ERROR: events of track " << n << " are corrupt" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestAriaBinaryFile
+{
+    using namespace AriaMaestosa;
+
+    /** the XML form of every note and controller event of a track, used to compare tracks */
+    std::string eventsToXml(Track* track)
+    {
+        wxMemoryOutputStream xml;
+
+        const int noteAmount = track->getNoteAmount();
+        for (int n=0; n<noteAmount; n++) track->getNote(n)->saveToFile(xml);
+
+        const int controlAmount = track->getControllerEventAmount();
+        for (int n=0; n<controlAmount; n++) track->getControllerEvent(n, 0)->saveToFile(xml);
+
+        std::string out(xml.GetSize(), '\0');
+        if (not out.empty()) xml.CopyTo(&out[0], out.size());
+        return out;
+    }
+
+    UNIT_TEST( TestBlockCompressionRoundTrip )
+    {
+        std::vector<unsigned char> data;
+        unsigned int seed = 1234;
+        for (int n=0; n<100000; n++)
+        {
+            // long runs, repeated patterns and noise, to exercise every kind of sequence
+            seed = seed * 1103515245 + 12345;
+            if      (n < 20000) data.push_back(7);
+            else if (n < 60000) data.push_back((n % 37) * 3);
+            else                data.push_back((seed >> 16) & 0xFF);
+        }
+
+        std::vector<unsigned char> compressed;
+        compressBlock(&data[0], data.size(), compressed);
+        require(compressed.size() < data.size(), "compressible data gets smaller");
+
+        std::vector<unsigned char> decompressed(data.size());
+        require(decompressBlock(&compressed[0], compressed.size(), &decompressed[0], decompressed.size()),
+                "compressed block decompresses");
+        require(decompressed == data, "block is restored exactly");
+
+        require(not decompressBlock(&compressed[0], compressed.size() / 2, &decompressed[0], decompressed.size()),
+                "truncated block is rejected");
+
+        std::vector<unsigned char> tiny(3, 42);
+        compressed.clear();
+        compressBlock(&tiny[0], tiny.size(), compressed);
+        std::vector<unsigned char> tinyOut(3);
+        require(decompressBlock(&compressed[0], compressed.size(), &tinyOut[0], tinyOut.size()) and tinyOut == tiny,
+                "blocks too small to hold a match are stored as literals");
+    }
+
+    UNIT_TEST( TestTrackEventsRoundTrip )
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+
+        Track* original = new Track(seq);
+        Track* copy     = new Track(seq);
+
+        // there is no guitar editor to set a tuning here; string and fret values need one
+        std::vector<int> tuning;
+        tuning.push_back( Note::findNotePitch(NOTE_7_E, PITCH_SIGN_NONE, 4) );
+        tuning.push_back( Note::findNotePitch(NOTE_7_B, PITCH_SIGN_NONE, 3) );
+        tuning.push_back( Note::findNotePitch(NOTE_7_G, PITCH_SIGN_NONE, 3) );
+        tuning.push_back( Note::findNotePitch(NOTE_7_D, PITCH_SIGN_NONE, 3) );
+        tuning.push_back( Note::findNotePitch(NOTE_7_A, PITCH_SIGN_NONE, 2) );
+        tuning.push_back( Note::findNotePitch(NOTE_7_E, PITCH_SIGN_NONE, 2) );
+        original->getGuitarTuning()->setTuning(tuning, false);
+        copy->getGuitarTuning()->setTuning(tuning, false);
+
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<500; n++)
+            {
+                original->addNote_import(40 + n % 50, n*120, n*120 + 60 + n % 300, 10 + n % 110, (n % 7 == 0 ? n % 6 : -1));
+                original->addControlEvent_import(n*96, (n*13) % 128, (n % 3 == 0 ? PSEUDO_CONTROLLER_PITCH_BEND : 7));
+            }
+            original->getNote(3)->setSelected(true);
+            original->getNote(4)->setPreferredAccidentalSign(FLAT);
+            original->getNote(5)->setStringAndFret(2, 5);
+            original->getNote(6)->setStringAndFret(5, -3); // lower than the lowest string
+        }
+        original->reorderNoteOffVector();
+        seq->addTrack(original);
+        seq->addTrack(copy);
+
+        BinaryWriter out;
+        original->saveEventsToBinary(out);
+
+        // round trip through compression too, as saving does
+        std::vector<unsigned char> compressed;
+        compressBlock(&out.getData()[0], out.size(), compressed);
+        std::vector<unsigned char> data(out.size());
+        require(decompressBlock(&compressed[0], compressed.size(), &data[0], data.size()), "events decompress");
+
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            BinaryReader in(&data[0], data.size());
+            require(copy->readEventsFromBinary(in), "events are read back");
+            require(in.atEnd() and not in.failed(), "all the data is consumed");
+        }
+
+        require_e(copy->getNoteAmount(), ==, original->getNoteAmount(), "all notes are restored");
+        require_e(copy->getControllerEventAmount(), ==, original->getControllerEventAmount(),
+                  "all controller events are restored");
+        require(eventsToXml(copy) == eventsToXml(original), "binary round trip saves the same XML as the original");
+
+        BinaryReader truncated(&data[0], data.size() - 10);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            require(not copy->readEventsFromBinary(truncated), "truncated events are rejected");
+        }
+
+        // the byte columns come after the note count and the start, length and fret columns
+        const int noteCount   = original->getNoteAmount();
+        const int pitchColumn = 4 + noteCount*(4 + 4 + 2);
+
+        std::vector<unsigned char> corrupt = data;
+        corrupt[pitchColumn + 10] = 200;
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            BinaryReader in(&corrupt[0], corrupt.size());
+            require(not copy->readEventsFromBinary(in), "out of range pitches are rejected");
+        }
+
+        corrupt = data;
+        corrupt[pitchColumn + noteCount*2 + 5] = 50;
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            BinaryReader in(&corrupt[0], corrupt.size());
+            require(not copy->readEventsFromBinary(in), "strings the tuning does not have are rejected");
+        }
+
+        // a fret giving an impossible pitch is dropped, string and fret are then found from the pitch
+        corrupt = data;
+        corrupt[4 + noteCount*8 + 5*2 + 1] = 0x40;
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            BinaryReader in(&corrupt[0], corrupt.size());
+            require(copy->readEventsFromBinary(in), "out of range frets are not fatal");
+        }
+        require_e(copy->getNote(5)->getStringConst(), ==, -1, "out of range fret is dropped");
+        require_e(copy->getNote(5)->getFretConst(),   ==, -1, "out of range fret is dropped");
+        require_e(copy->getNote(5)->getPitchID(), ==, original->getNote(5)->getPitchID(), "pitch is kept");
+
+        delete seq;
+    }
+}
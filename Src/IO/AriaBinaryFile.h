@@ -0,0 +1,122 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __ARIA_BINARY_FILE_H__
+#define __ARIA_BINARY_FILE_H__
+
+#include <vector>
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+
+    class GraphicalSequence; // forward
+    class SequenceSnapshot;  // forward
+
+    /**
+      * @brief Little-endian byte buffer used to build the sections of binary .aria files
+      * @ingroup io
+      */
+    class BinaryWriter
+    {
+        std::vector<unsigned char> m_data;
+
+    public:
+
+        void writeU8 (const int value);
+        void writeU16(const int value);
+        void writeI32(const int value);
+        void writeU32(const unsigned int value);
+        void writeF64(const double value);
+        void writeBytes(const void* data, const int size);
+
+        int size() const { return m_data.size(); }
+
+        const std::vector<unsigned char>& getData() const { return m_data; }
+    };
+
+    /**
+      * @brief Reads back the values written by a BinaryWriter.
+      *
+      * Reading past the end of the data does not crash; it returns zeros and marks the reader as
+      * failed, so callers can check once after reading a whole block.
+      * @ingroup io
+      */
+    class BinaryReader
+    {
+        const unsigned char* m_data;
+        int m_size;
+        int m_position;
+        bool m_failed;
+
+        /** @return whether 'count' more bytes are available; marks the reader as failed if not */
+        bool hasBytes(const int count);
+
+    public:
+
+        BinaryReader(const unsigned char* data, const int size);
+
+        int          readU8 ();
+        int          readU16();
+        int          readI32();
+        unsigned int readU32();
+        double       readF64();
+
+        /** @return a pointer to the next 'size' bytes, or NULL if there are not that many left */
+        const unsigned char* readBytes(const int size);
+
+        bool failed() const { return m_failed; }
+        bool atEnd () const { return m_position >= m_size; }
+    };
+
+    /**
+      * @brief Compresses a block with a byte-oriented LZ77 scheme in the LZ4 block layout
+      * @param[out] out the compressed data is appended to this vector
+      * @ingroup io
+      */
+    void compressBlock(const unsigned char* in, const int size, std::vector<unsigned char>& out);
+
+    /**
+      * @brief Decompresses a block made by compressBlock
+      * @return false if the data is corrupt or does not decompress to exactly 'outSize' bytes
+      * @ingroup io
+      */
+    bool decompressBlock(const unsigned char* in, const int inSize, unsigned char* out, const int outSize);
+
+    /** @ingroup io */
+    bool isBinaryAriaFile(wxString filepath);
+
+    /**
+      * @brief Saves a project in the binary .aria format
+      * @param compress whether to compress the sections of the file
+      * @ingroup io
+      */
+    bool saveBinaryAriaFile(GraphicalSequence* sequence, wxString filepath, const bool compress);
+
+    /**
+      * @brief Saves a snapshot in the binary .aria format.
+      *
+      * Only reads the snapshot, so it may be called from any thread.
+      * @ingroup io
+      */
+    bool saveBinaryAriaFile(const SequenceSnapshot& snapshot, wxString filepath, const bool compress);
+
+    /** @ingroup io */
+    bool loadBinaryAriaFile(GraphicalSequence* sequence, wxString filepath);
+
+}
+
+#endif
@@ -17,7 +17,9 @@
 #include "AriaFileWriter.h"
 
 #include "GUI/GraphicalSequence.h"
+#include "IO/AriaBinaryFile.h"
 #include "Midi/Sequence.h"
+#include "PreferencesData.h"
 
 #include <wx/string.h>
 #include <wx/wfstream.h>
@@ -27,7 +29,7 @@
 namespace AriaMaestosa
 {
     
-    void saveAriaFile(GraphicalSequence* sequence, wxString filepath)
+    bool saveAriaFile(GraphicalSequence* sequence, wxString filepath, AriaFileFormat format)
     {
         // do not override a file previously there. If a file was there, move it to a different name and do not delete
         // it until we know the new file was successfully saved
@@ -35,14 +37,35 @@ namespace AriaMaestosa
         const bool overriding_file = wxFileExists(filepath);
         if (overriding_file) wxRenameFile( filepath, temp_name, false );
         
-        wxFileOutputStream file( filepath );
-        sequence->saveToFile(file);
+        if (format == ARIA_FILE_BINARY)
+        {
+            const bool compress = PreferencesData::getInstance()->getBoolValue(SETTING_ID_COMPRESS_PROJECTS, true);
+            if (not saveBinaryAriaFile(sequence, filepath, compress))
+            {
+                // keep the previous version of the file
+                if (overriding_file) wxRenameFile( temp_name, filepath, true );
+                wxMessageBox(wxString::Format( _("Could not open file '%s' for writing"),
+                             (const char*)filepath.utf8_str() ) );
+                return false;
+            }
+        }
+        else
+        {
+            wxFileOutputStream file( filepath );
+            sequence->saveToFile(file);
+        }
         
         if (overriding_file) wxRemoveFile( temp_name );
+        return true;
     }
     
     bool loadAriaFile(GraphicalSequence* sequence, wxString filepath)
     {
+        if (isBinaryAriaFile(filepath))
+        {
+            return loadBinaryAriaFile(sequence, filepath);
+        }
+        
         wxFFile file(filepath);
         if (not file.IsOpened())
         {
@@ -26,10 +26,27 @@ namespace AriaMaestosa
     class GraphicalSequence; // forward
     
     /** @ingroup io */
+    enum AriaFileFormat
+    {
+        /** compact format, faster to save and load; the default */
+        ARIA_FILE_BINARY,
+        
+        /** human-readable format, readable by older versions of Aria */
+        ARIA_FILE_XML
+    };
+    
+    /**
+      * @brief loads a .aria file, whichever format it was saved in
+      * @ingroup io
+      */
     bool loadAriaFile(GraphicalSequence* sequence, wxString filepath);
     
-    /** @ingroup io */
-    void saveAriaFile(GraphicalSequence* sequence, wxString filepath);
+    /**
+      * @brief saves a .aria file, keeping the previous version of the file if saving fails
+      * @return whether the file was saved
+      * @ingroup io
+      */
+    bool saveAriaFile(GraphicalSequence* sequence, wxString filepath, AriaFileFormat format=ARIA_FILE_BINARY);
     
 }
 
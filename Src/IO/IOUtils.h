@@ -22,7 +22,7 @@
 
 #include <wx/string.h>
 
-class wxFileOutputStream;
+class wxOutputStream;
 class wxWindow;
 
 namespace AriaMaestosa
@@ -48,7 +48,7 @@ namespace AriaMaestosa
     wxString to_wxString(bool b);
     
     /** @ingroup io */
-    void writeData(wxString data, wxFileOutputStream& fileout);
+    void writeData(wxString data, wxOutputStream& fileout);
     
     wxString extract_filename(wxString filepath);
     
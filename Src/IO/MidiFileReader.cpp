@@ -32,13 +32,19 @@
 #include "jdksmidi/fileshow.h"
 #include "jdksmidi/filewritemultitrack.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <set>
 #include <string>
+#include <vector>
 #include <wx/intl.h>
+#include <wx/thread.h>
 #include <wx/filename.h>
 #include <wx/textfile.h>
 
+using namespace AriaMaestosa;
+
 class AriaMIDIFileReadMultiTrack : public jdksmidi::MIDIFileReadMultiTrack
 {
 public:
@@ -131,18 +137,499 @@ static std::set<int> parseDrumPrograms(const wxString& projectDir, int voiceGrou
     return drums;
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    /** Warnings a track conversion can raise; they are turned into translated messages once all tracks
+      * are converted, since worker threads should not be using the translation catalogs */
+    enum ImportWarning
+    {
+        WARNING_MULTI_CHANNEL_NOTES,
+        WARNING_MULTI_CHANNEL_EVENTS,
+        WARNING_GBA_CONTROLLER,
+        WARNING_NON_STANDARD_CONTROLLER,
+        WARNING_REGISTERED_PARAMETERS,
+        WARNING_NRPN,
+        WARNING_CHANNEL_MODE,
+        WARNING_UNSUPPORTED_CONTROLLER
+    };
+
+    /** A note read from a MIDI track, already paired with its note off */
+    struct ImportedNote
+    {
+        int pitch;
+        int start;
+        int end;
+        int volume;
+    };
+
+    /** A controller, pitch bend or instrument change read from a MIDI track */
+    struct ImportedControl
+    {
+        int tick;
+        float value;
+        int controller;
+    };
+
+    /** A meta event found in a MIDI track but that applies to the whole sequence */
+    struct ImportedSequenceEvent
+    {
+        enum Type { TEMPO, TIME_SIG, KEY_SIG, COPYRIGHT, TEXT };
+
+        Type type;
+        int tick;
+        float tempo;
+        int value1;    //!< time sig numerator, key sig sharp/flat amount or text controller
+        int value2;    //!< time sig denominator
+        wxString text;
+    };
+
+    /**
+      * Everything a MIDI track contributes to the song. Tracks are converted independently of each other
+      * (and in parallel), then merged into the sequence in their original order.
+      */
+    struct TrackImport
+    {
+        jdksmidi::MIDITrack* source;
+        int sourceID;
+        bool isDrumTrack;
+
+        std::vector<ImportedNote> notes;
+        std::vector<ImportedControl> controls;
+        std::vector<ImportedSequenceEvent> sequenceEvents;
+
+        /** (ImportWarning, controller ID) pairs */
+        std::set< std::pair<int, int> > warnings;
+
+        wxString name;
+        int channel;         //!< -1 if the track contains no channel event
+        int program;         //!< first program change of the track, -1 if none
+        bool drumProgram;    //!< whether the first program change selects a drum kit
+        bool needReorder;
+        bool discardedLSB;
+        int lastEventTick;
+        int orphanedNotes;
+
+        TrackImport(jdksmidi::MIDITrack* track, int trackID, bool isDrum) :
+            source(track), sourceID(trackID), isDrumTrack(isDrum), channel(-1), program(-1),
+            drumProgram(false), needReorder(false), discardedLSB(false), lastEventTick(0), orphanedNotes(0)
+        {
+        }
+    };
+
+    // ------------------------------------------------------------------------------------------------------
+
+    wxString describeImportWarning(const int warning, const int controllerID)
+    {
+        switch (warning)
+        {
+            case WARNING_MULTI_CHANNEL_NOTES:
+                return _("This MIDI file has tracks that play on multiple MIDI channels. This is not supported by Aria Maestosa.");
+            case WARNING_MULTI_CHANNEL_EVENTS:
+                return _("This MIDI file has a track that sends events on multiple MIDI channels. This is not supported by Aria Maestosa.");
+            case WARNING_GBA_CONTROLLER:
+                return wxString::Format(_("This MIDI file uses GBA m4a controller #%i. Playback cannot be fully emulated, but data will be preserved."), controllerID);
+            case WARNING_NON_STANDARD_CONTROLLER:
+                return wxString::Format(_("This MIDI file uses controller #%i, which is not part of the MIDI standard. Data will be preserved but may not play back correctly."), controllerID);
+            case WARNING_REGISTERED_PARAMETERS:
+                return _("This MIDI file uses Registered Parameters, which are currently not supported by Aria Maestosa.");
+            case WARNING_NRPN:
+                return _("This MIDI files uses NRPN (Non-Registered Parameters, i.e. non-standard controllers), which are currently not supported by Aria Maestosa.");
+            case WARNING_CHANNEL_MODE:
+                return _("This MIDI files uses Channel Mode Message, which are currently not supported by Aria Maestosa.");
+            case WARNING_UNSUPPORTED_CONTROLLER:
+            default:
+                return wxString::Format(_("This MIDI file uses unsupported MIDI controller #%i. Data related to this controller will be discarded."), controllerID);
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------------------
+
+    /** Reads the events of one MIDI track into its import buffers. Touches no shared state. */
+    void convertTrack(TrackImport& job, const int drum_note_duration)
+    {
+        jdksmidi::MIDITrack* track = job.source;
+        const int eventAmount = track->GetNumEvents();
+        const bool isDrumTrack = job.isDrumTrack;
+
+        // Flooding the console can slow down imports a lot so avoid printing the same error message repeatedly
+        std::set<int> error_message_choker_note;
+        std::set<int> error_message_choker_evt;
+
+        // indices of the notes waiting for their note off, for each (channel, MIDI pitch) pair
+        std::vector< std::vector<int> > open_notes(16*128);
+
+        int programChanges = 0;
+        int last_channel = -1;
+
+        job.notes.reserve(eventAmount/2);
+
+        for (int eventID=0; eventID<eventAmount; eventID++)
+        {
+            jdksmidi::MIDITimedBigMessage* event = track->GetEvent( eventID );
+
+            const int tick = event->GetTime();
+
+            if (tick < job.lastEventTick) job.needReorder = true;
+            else                          job.lastEventTick = tick;
+
+            const int channel = event->GetChannel();
+            if (channel != last_channel and last_channel != -1)
+            {
+                if (event->IsNoteOn())
+                {
+                    if (error_message_choker_note.find(channel*100 + last_channel) == error_message_choker_note.end())
+                    {
+                        error_message_choker_note.insert(channel*100 + last_channel);
+                        fprintf(stderr, "[MidiFileReader] WARNING: note from channel %i != previous channel %i\n",
+                                channel, last_channel);
+                        job.warnings.insert( std::make_pair(WARNING_MULTI_CHANNEL_NOTES, 0) );
+                    }
+                }
+                else if (not event->IsMetaEvent() and not event->IsAllNotesOff() and
+                         not event->IsTextEvent() and not event->IsTempo() and
+                         not event->IsSystemMessage() and not event->IsSystemExclusive())
+                {
+                    if (error_message_choker_evt.find(channel*100 + last_channel) == error_message_choker_evt.end())
+                    {
+                        error_message_choker_evt.insert(channel*100 + last_channel);
+                        fprintf(stderr, "[MidiFileReader] WARNING: event from channel %i != previous channel %i\n",
+                                channel, last_channel);
+                        job.warnings.insert( std::make_pair(WARNING_MULTI_CHANNEL_EVENTS, 0) );
+                    }
+                }
+            }
+
+            if (last_channel == -1 and not event->IsMetaEvent() and
+               not event->IsTextEvent() and not event->IsTempo() and
+               not event->IsSystemMessage() and not event->IsSystemExclusive())
+            {
+                job.channel = channel; // its first iteration
+                last_channel = channel;
+            }
+
+            // ----------------------------------- note on -------------------------------------
+            if (event->IsNoteOn() and event->GetVelocity() > 0)
+            {
+                ImportedNote note;
+                note.pitch  = ((channel == 9 or isDrumTrack) ? event->GetNote() : 131 - event->GetNote());
+                note.start  = tick;
+                note.end    = tick + drum_note_duration; // temporary end until the corresponding note off event is found
+                note.volume = event->GetVelocity();
+                job.notes.push_back(note);
+
+                // drum notes have no durations, so they will never be closed
+                if (channel != 9 and not isDrumTrack)
+                {
+                    open_notes[channel*128 + event->GetNote()].push_back((int)job.notes.size() - 1);
+                }
+
+                continue;
+            }
+            // ----------------------------------- note off -------------------------------------
+            else if (event->IsNoteOff() or (event->IsNoteOn() and event->GetVelocity() == 0))
+            {
+                if (channel == 9 or isDrumTrack) continue; // drum notes have no durations so dont care about this event
+
+                // a note off event was found; it closes the most recent note still open on
+                // the same channel and pitch
+                std::vector<int>& open = open_notes[channel*128 + event->GetNote()];
+                if (open.empty())
+                {
+                    job.orphanedNotes++;
+                    continue;
+                }
+
+                job.notes[open.back()].end = tick;
+                open.pop_back();
+                continue;
+            }
+            // ----------------------------------- control change -------------------------------------
+            else if ( event->IsControlChange() )
+            {
+                const int controllerID = event->GetController();
+                const int value = 127 - event->GetControllerValue();
+
+                if (controllerID == 0) // MSB for bank select, not supported
+                {
+                    continue; // MSB bank change not supported
+                }
+
+                if (controllerID > 32 and controllerID < 64) // 32 is LSB for bank select
+                {
+                    // LSB... not supported by Aria ATM
+                    job.discardedLSB = true;
+                    continue;
+                }
+
+
+                if (controllerID == 14 or controllerID == 15 or
+                    (controllerID > 19 and controllerID < 32))
+                {
+                    job.warnings.insert( std::make_pair(WARNING_GBA_CONTROLLER, controllerID) );
+                }
+                else if (controllerID == 3 or controllerID == 9 or
+                    (controllerID >= 85 and controllerID <= 87) or
+                    controllerID == 89 or controllerID == 90 or (controllerID >= 102 and controllerID <= 119))
+                {
+                    job.warnings.insert( std::make_pair(WARNING_NON_STANDARD_CONTROLLER, controllerID) );
+                }
+                else if (controllerID == 6 or
+                         controllerID == 79 or
+                         controllerID == 88 or
+                         (controllerID > 95 and controllerID < 200 and controllerID != 127 /*stereo mode*/))
+                {
+                    if (controllerID == 6 or controllerID == 38 or controllerID == 100 or controllerID == 101)
+                    {
+                        // TODO: add support for registered parameters http://www.midi.org/techspecs/midimessages.php#3
+                        job.warnings.insert( std::make_pair(WARNING_REGISTERED_PARAMETERS, 0) );
+                    }
+                    else if (controllerID == 98 or controllerID == 99)
+                    {
+                        job.warnings.insert( std::make_pair(WARNING_NRPN, 0) );
+                    }
+                    else if (controllerID >= 120 and controllerID <= 127)
+                    {
+                        // TODO: 120: all sound off
+                        //       121: reset controllers
+                        //       122: local control on/off
+                        //       123: all notes off
+                        //       124: omni mode off (+ all notes off)
+                        //       125: omni mode on (+ all notes on)
+                        //       126: Mono Mode On
+                        //       127: Poly Mode On (stereo)
+                        job.warnings.insert( std::make_pair(WARNING_CHANNEL_MODE, 0) );
+                    }
+                    else
+                    {
+                        job.warnings.insert( std::make_pair(WARNING_UNSUPPORTED_CONTROLLER, controllerID) );
+                    }
+                    continue;
+                }
+
+                ImportedControl control;
+                control.tick       = tick;
+                control.value      = value;
+                control.controller = (controllerID == 32 ? 0 : controllerID); // 32 is LSB for bank select, map to 0
+                job.controls.push_back(control);
+
+                continue;
+            }
+            // ----------------------------------- pitch bend -------------------------------------
+            else if ( event->IsPitchBend() )
+            {
+
+                int pitchBendVal = event->GetBenderValue();
+                float value = ControllerEvent::fromPitchBendValue(pitchBendVal);
+                //int value = (int)round( (pitchBendVal+8064.0)*128.0/16128.0 );
+
+                if (value > 127) value = 127;
+                if (value < 0)   value = 0;
+
+                ImportedControl control;
+                control.tick       = tick;
+                control.value      = value;
+                control.controller = PSEUDO_CONTROLLER_PITCH_BEND;
+                job.controls.push_back(control);
+                continue;
+            }
+            // ----------------------------------- program chnage -------------------------------------
+            else if ( event->IsProgramChange() )
+            {
+                const int instrument = event->GetPGValue();
+
+                programChanges++;
+                if (programChanges > 1)
+                {
+                    ImportedControl control;
+                    control.tick       = tick;
+                    control.value      = instrument;
+                    control.controller = PSEUDO_CONTROLLER_INSTRUMENT_CHANGE;
+                    job.controls.push_back(control);
+                }
+                else
+                {
+                    job.program     = instrument;
+                    job.drumProgram = (channel == 9 or isDrumTrack);
+                }
+
+                continue;
+            }
+            // ----------------------------------- tempo -------------------------------------
+            else if ( event->IsTempo() )
+            {
+                ImportedSequenceEvent evt;
+                evt.type  = ImportedSequenceEvent::TEMPO;
+                evt.tick  = tick;
+                evt.tempo = event->GetTempo32()/32.0f;
+                job.sequenceEvents.push_back(evt);
+                continue;
+            }
+            // ----------------------------------- time key/sig and beat marker -------------------------------------
+            else if ( event->IsTimeSig() )
+            {
+                ImportedSequenceEvent evt;
+                evt.type   = ImportedSequenceEvent::TIME_SIG;
+                evt.tick   = tick;
+                evt.value1 = (int)event->GetTimeSigNumerator();
+                evt.value2 = (int)event->GetTimeSigDenominator();
+                job.sequenceEvents.push_back(evt);
+                continue;
+            }
+            else if ( event->IsKeySig() )
+            {
+                /*
+                 This meta event is used to specify the key (number of sharps or flats) and scale (major or minor) of a sequence.
+                 A positive value for the key specifies the number of sharps and a negative value specifies the number of flats.
+                 A value of 0 for the scale specifies a major key and a value of 1 specifies a minor key.
+                 source: http://www.sonicspot.com/guide/midifiles.html
+                 */
+                ImportedSequenceEvent evt;
+                evt.type   = ImportedSequenceEvent::KEY_SIG;
+                evt.tick   = tick;
+                evt.value1 = (int)event->GetKeySigSharpFlats();
+                job.sequenceEvents.push_back(evt);
+            }
+            // ----------------------------------- track name / text events -------------------------------------
+            else  if ( event->IsTextEvent() )
+            {
+
+                // sequence/track name
+                if ((int)event->GetByte1() == 3)
+                {
+
+                    const int length = event->GetSysEx()->GetLength(); // get name length
+                    char name[length+1];
+                    name[length] = 0; // make zero-terminated
+
+                    char* buf = (char*) event->GetSysEx()->GetBuf();
+                    for (int n=0; n<length; n++) name[n] = buf[n];
+
+                    job.name = fromCString(name);
+                    continue;
+                }
+                else if ((int)event->GetByte1() == 2) // copyright
+                {
+
+                    const int length = event->GetSysEx()->GetLength(); // get copyright length
+                    char copyright[length+1];
+                    copyright[length] = 0; // make zero-terminated
+
+                    char* buf = (char*) event->GetSysEx()->GetBuf();
+                    for (int n=0; n<length; n++) copyright[n] = buf[n];
+
+                    ImportedSequenceEvent evt;
+                    evt.type = ImportedSequenceEvent::COPYRIGHT;
+                    evt.tick = tick;
+                    evt.text = fromCString(copyright);
+                    job.sequenceEvents.push_back(evt);
+                    continue;
+                }
+                else if ((int)event->GetByte1() == 5) // lyrics
+                {
+                    const char* text = (char*) event->GetSysEx()->GetBuf();
+
+                    if (strlen(text) > 0)
+                    {
+                        wxString s(text, wxConvUTF8, event->GetSysEx()->GetLength());
+                        if (s.size() == 0)
+                        {
+                            fprintf(stderr, "[MidiFileReader] WARNING: error converting lyrics (wrong encoding?)\n");
+                        }
+                        else
+                        {
+                            ImportedSequenceEvent evt;
+                            evt.type   = ImportedSequenceEvent::TEXT;
+                            evt.tick   = tick;
+                            evt.value1 = PSEUDO_CONTROLLER_LYRICS;
+                            evt.text   = s;
+                            job.sequenceEvents.push_back(evt);
+                        }
+                    }
+                }
+                else if ((int)event->GetByte1() == 6) // marker (GBA loop points)
+                {
+                    const char* text = (char*) event->GetSysEx()->GetBuf();
+
+                    if (strlen(text) > 0)
+                    {
+                        wxString s(text, wxConvUTF8, event->GetSysEx()->GetLength());
+                        if (s == wxT("[") or s == wxT("]") or s == wxT("][") or s == wxT(":"))
+                        {
+                            ImportedSequenceEvent evt;
+                            evt.type   = ImportedSequenceEvent::TEXT;
+                            evt.tick   = tick;
+                            evt.value1 = PSEUDO_CONTROLLER_LOOP_MARKER;
+                            evt.text   = s;
+                            job.sequenceEvents.push_back(evt);
+                        }
+                    }
+                }
+            }
+        }//next event
+
+        // notes that never received a note off keep their temporary duration
+        for (unsigned int n=0; n<open_notes.size(); n++)
+        {
+            job.orphanedNotes += (int)open_notes[n].size();
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------------------
+
+    /** Converts tracks until none is left; called concurrently by every thread taking part in the import */
+    void convertTracks(std::vector<TrackImport>& jobs, std::atomic<int>& nextJob, const int drum_note_duration)
+    {
+        int job;
+        while ((job = nextJob++) < (int)jobs.size())
+        {
+            convertTrack(jobs[job], drum_note_duration);
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------------------
+
+    class TrackImportThread : public wxThread
+    {
+        std::vector<TrackImport>& m_jobs;
+        std::atomic<int>& m_next_job;
+        int m_drum_note_duration;
+
+    public:
+
+        TrackImportThread(std::vector<TrackImport>& jobs, std::atomic<int>& nextJob, const int drum_note_duration) :
+            wxThread(wxTHREAD_JOINABLE), m_jobs(jobs), m_next_job(nextJob), m_drum_note_duration(drum_note_duration)
+        {
+        }
+
+        virtual ExitCode Entry()
+        {
+            convertTracks(m_jobs, m_next_job, m_drum_note_duration);
+            return 0;
+        }
+    };
+}
+
+// ----------------------------------------------------------------------------------------------------------
 bool AriaMaestosa::loadMidiFile(GraphicalSequence* gseq, wxString filepath, std::set<wxString>& warnings)
 {
     Sequence* sequence = gseq->getModel();
     
     OwnerPtr<Sequence::Import> import(sequence->startImport());
 
-    // the stream used to read the input file
+    // the stream used to read the input file; the file is memory-mapped so that parsing doesn't
+    // need a library call per byte
 #ifdef WIN32
-    jdksmidi::MIDIFileReadStreamFile rs( (const wchar_t*)filepath.wc_str() );
+    jdksmidi::MIDIFileReadStreamMapped rs( (const wchar_t*)filepath.wc_str() );
 #else
-    jdksmidi::MIDIFileReadStreamFile rs( filepath.mb_str() );
+    jdksmidi::MIDIFileReadStreamMapped rs( filepath.mb_str() );
 #endif
+    if (not rs.IsValid())
+    {
+        std::cerr << "[MidiFileReader] ERROR: could not open midi file" << std::endl;
+        return false;
+    }
 
     // the object which will hold all the tracks
     jdksmidi::MIDIMultiTrack jdksequence;
@@ -160,18 +647,10 @@ bool AriaMaestosa::loadMidiFile(GraphicalSequence* gseq, wxString filepath, std:
         return false;
     }
 
-    jdksmidi::MIDITrack* track;
-    jdksmidi::MIDITimedBigMessage* event;
-
     sequence->setChannelManagementType(CHANNEL_MANUAL);
     
     int lastEventTick = 0; // last event tick for whole song, to find its duration
 
-    // Flooding the console can slow down imports a lot so avoid printing the same error message repeatedly
-    std::set<int> error_message_choker_note;
-    std::set<int> error_message_choker_evt;
-    bool lsb_message_printed = false;
-    
     {
         ScopedMeasureITransaction tr(sequence->getMeasureData()->startImportTransaction());
         
@@ -231,461 +710,163 @@ bool AriaMaestosa::loadMidiFile(GraphicalSequence* gseq, wxString filepath, std:
             }
         }
 
-         // ----------------------------------- for each track -------------------------------------
-        int realTrackID=-1;
+        // ---------------------------- convert each track on its own, in parallel -----------------------------
+        std::vector<TrackImport> jobs;
+        jobs.reserve(real_track_amount);
         for (int trackID=0; trackID<trackAmount; trackID++)
         {
-            track = jdksequence.GetTrack( trackID );
-
-            // FIXME: to get reasonable performance, I have no choice but to kill the progress indicator,
-            // wxYield pauses for way too long??
-            // if there is a huge amount of tracks, only call wxYield once in a while because calling
-            // it everytime could be very slow
-            //if ((trackAmount < 10) or (trackID % (trackAmount/10) == 0))
-            //{
-            //    WaitWindow::setProgress(
-            //                            (int)(
-            //                                  log(trackID)*100/log(trackAmount)
-            //                                  )
-            //                            );
-            //    wxYield(); // FIXME - use a thread instead
-            //}
-            
-            // ----------------------------------- for each event -------------------------------------
-
-            wxString trackName =  wxT("");
-
-            const int eventAmount = track->GetNumEvents();
-
-            int programChanges = 0;
-            
-            if (eventAmount == 0) continue;
-            realTrackID ++;
-            Track* ariaTrack = sequence->getTrack(realTrackID);
-
-            const bool isDrumTrack = (gbaDrumTracks.count(trackID) > 0);
-
-            int lastEventTick_inTrack = 0;
-
-            int last_channel = -1;
+            jdksmidi::MIDITrack* track = jdksequence.GetTrack( trackID );
+            if (track->GetNumEvents() == 0) continue;
+            jobs.push_back( TrackImport(track, trackID, gbaDrumTracks.count(trackID) > 0) );
+        }
 
-            bool need_reorder = false;
+        {
+            std::atomic<int> nextJob(0);
+            std::vector<TrackImportThread*> threads;
 
-            for (int eventID=0; eventID<eventAmount; eventID++)
+            // the calling thread converts tracks too
+            const int threadCount = std::min(wxThread::GetCPUCount(), (int)jobs.size()) - 1;
+            for (int n=0; n<threadCount; n++)
             {
-
-                event = track->GetEvent( eventID );
-
-                const int tick = event->GetTime();
-
-                if (tick < lastEventTick_inTrack) need_reorder = true;
-                else                              lastEventTick_inTrack = tick;
-
-                const int channel = event->GetChannel();
-                if (channel != last_channel and last_channel != -1)
-                {
-                    if (event->IsNoteOn())
-                    {
-                        if (error_message_choker_note.find(channel*100 + last_channel) == error_message_choker_note.end())
-                        {
-                            error_message_choker_note.insert(channel*100 + last_channel);
-                            fprintf(stderr, "[MidiFileReader] WARNING: note from channel %i != previous channel %i\n",
-                                    channel, last_channel);
-                            warnings.insert( _("This MIDI file has tracks that play on multiple MIDI channels. This is not supported by Aria Maestosa.") );
-                        }
-                        
-                        //ariaTrack->setChannel(channel);
-                        //last_channel = channel;
-                    }
-                    else if (not event->IsMetaEvent() and not event->IsAllNotesOff() and
-                             not event->IsTextEvent() and not event->IsTempo() and
-                             not event->IsSystemMessage() and not event->IsSystemExclusive())
-                    {
-                        if (error_message_choker_evt.find(channel*100 + last_channel) == error_message_choker_evt.end())
-                        {
-                            error_message_choker_evt.insert(channel*100 + last_channel);
-                            fprintf(stderr, "[MidiFileReader] WARNING: event from channel %i != previous channel %i\n",
-                                    channel, last_channel);
-                            warnings.insert( _("This MIDI file has a track that sends events on multiple MIDI channels. This is not supported by Aria Maestosa.") );
-                        }
-                    }
-                }
-
-                if (last_channel == -1 and not event->IsMetaEvent() and
-                   not event->IsTextEvent() and not event->IsTempo() and
-                   not event->IsSystemMessage() and not event->IsSystemExclusive())
+                TrackImportThread* thread = new TrackImportThread(jobs, nextJob, drum_note_duration);
+                if (thread->Create() != wxTHREAD_NO_ERROR)
                 {
-                    ariaTrack->setChannel(channel); // its first iteration
-                    last_channel = channel;
+                    delete thread;
+                    break;
                 }
+                thread->Run();
+                threads.push_back(thread);
+            }
 
-                // ----------------------------------- note on -------------------------------------
-                if (event->IsNoteOn() and event->GetVelocity() > 0)
-                {
-
-                    const int note = ((channel == 9 or isDrumTrack) ? event->GetNote() : 131 - event->GetNote());
-                    const int volume = event->GetVelocity();
-
-                    ariaTrack->addNote_import(note,
-                                             tick,
-                                             tick+drum_note_duration /*temporary end until the corresponding note off event is found*/,
-                                             volume);
-
-                    continue;
-                }
-                // ----------------------------------- note off -------------------------------------
-                else if (event->IsNoteOff() or (event->IsNoteOn() and event->GetVelocity() == 0))
-                {
-                    if (channel == 9 or isDrumTrack) continue; // drum notes have no durations so dont care about this event
-                    const int note = (131 - event->GetNote());
-                    
-                    // a note off event was found, find to which note on event it corresponds
-                    // (start iterating from the end, because since events are in order it will probably be found near the end)
-                    for (int n=ariaTrack->getNoteAmount()-1; n>-1; n--)
-                    {
+            convertTracks(jobs, nextJob, drum_note_duration);
 
-                        if (ariaTrack->getNotePitchID(n) == note and
-                           ariaTrack->getNoteEndInMidiTicks(n)==ariaTrack->getNoteStartInMidiTicks(n)+drum_note_duration )
-                        {
-                            ariaTrack->setNoteEnd_import( tick, n );
+            for (unsigned int n=0; n<threads.size(); n++)
+            {
+                threads[n]->Wait();
+                delete threads[n];
+            }
+        }
 
-                            ASSERT_E(ariaTrack->getNoteEndInMidiTicks(n), ==, tick);
+        // ---------------------------- merge the converted tracks into the sequence, in order -----------------------------
+        std::set< std::pair<int, int> > track_warnings;
+        bool lsb_discarded = false;
 
-                            break;
-                        }//end if
+        // note on events without a note off, and note offs without a note on
+        int orphaned_notes = 0;
 
+        for (unsigned int realTrackID=0; realTrackID<jobs.size(); realTrackID++)
+        {
+            TrackImport& job = jobs[realTrackID];
+            Track* ariaTrack = sequence->getTrack(realTrackID);
 
-                        if (n == 0)
-                        {
-                            warnings.insert( wxString::Format(_("This MIDI file appears to be incorrect; a note at tick %i in channel %i does not appear to have an end"), tick, channel) );
-                        }
-                    } // next
+            if (job.channel != -1) ariaTrack->setChannel(job.channel);
 
-                    continue;
-                }
-                // ----------------------------------- control change -------------------------------------
-                else if ( event->IsControlChange() )
+            if (job.program != -1)
+            {
+                if (job.drumProgram)
                 {
-                    const int controllerID = event->GetController();
-                    const int value = 127 - event->GetControllerValue();
-
-                    if (controllerID == 0) // MSB for bank select, not supported
-                    {
-                        continue; // MSB bank change not supported
-                    }
-
-                    if (controllerID > 32 and controllerID < 64) // 32 is LSB for bank select
-                    {
-                        // LSB... not supported by Aria ATM
-                        if (not lsb_message_printed)
-                        {
-                            std::cerr << "[MidiFileReader] WARNING: This MIDI files contains LSB controller data."
-                                      << " Aria does not support fine control changes and will discard this info."
-                                      << std::endl;
-                            lsb_message_printed = true;
-                        }
-                        continue;
-                    }
-
-
-                    if (controllerID == 14 or controllerID == 15 or
-                        (controllerID > 19 and controllerID < 32))
-                    {
-                        warnings.insert( wxString::Format(_("This MIDI file uses GBA m4a controller #%i. Playback cannot be fully emulated, but data will be preserved."), controllerID) );
-                    }
-                    else if (controllerID == 3 or controllerID == 9 or
-                        (controllerID >= 85 and controllerID <= 87) or
-                        controllerID == 89 or controllerID == 90 or (controllerID >= 102 and controllerID <= 119))
-                    {
-                        warnings.insert( wxString::Format(_("This MIDI file uses controller #%i, which is not part of the MIDI standard. Data will be preserved but may not play back correctly."), controllerID) );
-                    }
-                    else if (controllerID == 6 or
-                             controllerID == 79 or
-                             controllerID == 88 or
-                             (controllerID > 95 and controllerID < 200 and controllerID != 127 /*stereo mode*/))
-                    {
-                        if (controllerID == 6 or controllerID == 38 or controllerID == 100 or controllerID == 101)
-                        {
-                            // TODO: add support for registered parameters http://www.midi.org/techspecs/midimessages.php#3
-                            warnings.insert( _("This MIDI file uses Registered Parameters, which are currently not supported by Aria Maestosa.") );
-                        }
-                        else if (controllerID == 98 or controllerID == 99)
-                        {
-                            warnings.insert( _("This MIDI files uses NRPN (Non-Registered Parameters, i.e. non-standard controllers), which are currently not supported by Aria Maestosa.") );
-                        }
-                        else if (controllerID >= 120 and controllerID <= 127)
-                        {
-                            // TODO: 120: all sound off
-                            //       121: reset controllers
-                            //       122: local control on/off
-                            //       123: all notes off
-                            //       124: omni mode off (+ all notes off)
-                            //       125: omni mode on (+ all notes on)
-                            //       126: Mono Mode On
-                            //       127: Poly Mode On (stereo)
-                            warnings.insert( _("This MIDI files uses Channel Mode Message, which are currently not supported by Aria Maestosa.") );
-                        }
-                        else
-                        {
-                            warnings.insert( wxString::Format(_("This MIDI file uses unsupported MIDI controller #%i. Data related to this controller will be discarded."), controllerID) );
-                        }
-                        continue;
-                    }
-
-                    if (controllerID == 32) // 32 is LSB for bank select, map to 0
-                        ariaTrack->addControlEvent_import(tick, value, 0);
-                    else
-                        ariaTrack->addControlEvent_import(tick, value, controllerID);
-
-                    continue;
+                    ariaTrack->setDrumKit(job.program);
+                    ariaTrack->setNotationType(DRUM, true);
+                    ariaTrack->setNotationType(KEYBOARD, false);
+                    ariaTrack->setNotationType(GUITAR, false);
+                    ariaTrack->setNotationType(SCORE, false);
                 }
-                // ----------------------------------- pitch bend -------------------------------------
-                else if ( event->IsPitchBend() )
+                else
                 {
-
-                    int pitchBendVal = event->GetBenderValue();
-                    float value = ControllerEvent::fromPitchBendValue(pitchBendVal);
-                    //int value = (int)round( (pitchBendVal+8064.0)*128.0/16128.0 );
-                    
-                    if (value > 127) value = 127;
-                    if (value < 0)   value = 0;
-
-                    ariaTrack->addControlEvent_import(tick, value, PSEUDO_CONTROLLER_PITCH_BEND);
-                    continue;
+                    ariaTrack->setInstrument(job.program);
                 }
-                // ----------------------------------- program chnage -------------------------------------
-                else if ( event->IsProgramChange() )
-                {
-                    const int instrument = event->GetPGValue();
-
-                    programChanges++;
-                    if (programChanges > 1)
-                    {
-                        ariaTrack->addControlEvent_import(tick, event->GetPGValue(), PSEUDO_CONTROLLER_INSTRUMENT_CHANGE);
-                    }
-                    else
-                    {
-                        if (channel == 9 or isDrumTrack)
-                        {
-                            ariaTrack->setDrumKit(instrument);
-                            ariaTrack->setNotationType(DRUM, true);
-                            ariaTrack->setNotationType(KEYBOARD, false);
-                            ariaTrack->setNotationType(GUITAR, false);
-                            ariaTrack->setNotationType(SCORE, false);
-                        }
-                        else
-                        {
-                            ariaTrack->setInstrument(instrument);
-                        }
-                    }
+            }
 
-                    continue;
-                }
-                // ----------------------------------- tempo -------------------------------------
-                else if ( event->IsTempo() )
-                {
+            const int noteAmount = job.notes.size();
+            for (int n=0; n<noteAmount; n++)
+            {
+                const ImportedNote& note = job.notes[n];
+                ariaTrack->addNote_import(note.pitch, note.start, note.end, note.volume);
+            }
 
-                    const float tempo = event->GetTempo32()/32.0f;
+            const int controlAmount = job.controls.size();
+            for (int n=0; n<controlAmount; n++)
+            {
+                const ImportedControl& control = job.controls[n];
+                ariaTrack->addControlEvent_import(control.tick, control.value, control.controller);
+            }
 
-                    if (firstTempoEvent)
-                    {
-                        sequence->setTempo( (int)round(tempo) );
-                        firstTempoEvent = false;
-                        continue;
-                    }
-                    else
-                    {
-                        import->addTempoEvent(
-                                              new ControllerEvent(PSEUDO_CONTROLLER_TEMPO,
-                                                                  tick,
-                                                                  convertBPMToTempoBend(tempo)
-                                                                  )
-                                              );
-                        continue;
-                    }
-                    // ----------------------------------- time key/sig and beat marker -------------------------------------
-                }
-                else if ( event->IsTimeSig() )
-                {
-                    tr->addTimeSigChange( tick, (int)event->GetTimeSigNumerator(), (int)event->GetTimeSigDenominator() );
-                    continue;
-                }
-                else if ( event->IsKeySig() )
+            const int sequenceEventAmount = job.sequenceEvents.size();
+            for (int n=0; n<sequenceEventAmount; n++)
+            {
+                const ImportedSequenceEvent& evt = job.sequenceEvents[n];
+                switch (evt.type)
                 {
-                    /*
-                     This meta event is used to specify the key (number of sharps or flats) and scale (major or minor) of a sequence.
-                     A positive value for the key specifies the number of sharps and a negative value specifies the number of flats.
-                     A value of 0 for the scale specifies a major key and a value of 1 specifies a minor key.
-                     source: http://www.sonicspot.com/guide/midifiles.html
-                     */
-                    int amount = (int)event->GetKeySigSharpFlats();
-
-                    for (int trackn=0; trackn<real_track_amount; trackn++)
-                    {
-                        if (amount > 0)
+                    case ImportedSequenceEvent::TEMPO:
+                        if (firstTempoEvent)
                         {
-                            sequence->getTrack(trackn)->setKey(amount, KEY_TYPE_SHARPS);
-                            sequence->setDefaultKeySymbolAmount(amount);
-                            sequence->setDefaultKeyType(KEY_TYPE_SHARPS);
+                            sequence->setTempo( (int)round(evt.tempo) );
+                            firstTempoEvent = false;
                         }
-                        else if (amount < 0)
+                        else
                         {
-                            sequence->getTrack(trackn)->setKey(-amount, KEY_TYPE_FLATS);
-                            sequence->setDefaultKeySymbolAmount(-amount);
-                            sequence->setDefaultKeyType(KEY_TYPE_FLATS);
-                        } 
-                    }
-                    // FIXME - does midi allow a different key for each track?
-
-                }
-                /*
-                else if ( event->IsBeatMarker() )
-                {
-                    //std::cout << "Beat marker: " << (int)event->GetByte1() << " " << (int)event->GetByte2() << " " << (int)event->GetByte3() << ", type=" << (int)event->GetType() << std::endl;
-                }
-                 */
-                // ----------------------------------- track name / text events -------------------------------------
-                else  if ( event->IsTextEvent() )
-                {
-
-                    // sequence/track name
-                    if ((int)event->GetByte1() == 3)
-                    {
-
-                        const int length = event->GetSysEx()->GetLength(); // get name length
-                        char name[length+1];
-                        name[length] = 0; // make zero-terminated
-
-                        char* buf = (char*) event->GetSysEx()->GetBuf();
-                        for (int n=0; n<length; n++) name[n] = buf[n];
-
-                        //std::cout << "s/t name: " << name << std::endl;
-
-                        trackName = fromCString(name);
-                        //if (trackName.Length() == 0) trackName = _("Untitled");
-                        continue;
-                    }
-                    else if ((int)event->GetByte1() == 2) // copyright
-                    {
-
-                        const int length = event->GetSysEx()->GetLength(); // get copyright length
-                        char copyright[length+1];
-                        copyright[length] = 0; // make zero-terminated
+                            import->addTempoEvent(
+                                                  new ControllerEvent(PSEUDO_CONTROLLER_TEMPO,
+                                                                      evt.tick,
+                                                                      convertBPMToTempoBend(evt.tempo)
+                                                                      )
+                                                  );
+                        }
+                        break;
 
-                        char* buf = (char*) event->GetSysEx()->GetBuf();
-                        for (int n=0; n<length; n++) copyright[n] = buf[n];
+                    case ImportedSequenceEvent::TIME_SIG:
+                        tr->addTimeSigChange( evt.tick, evt.value1, evt.value2 );
+                        break;
 
-                        sequence->setCopyright( fromCString(copyright) );
-                        continue;
-                    }
-                    /*
-                    else if ((int)event->GetByte1() == 4) // instrument name
-                    {
-                        const char* text = (char*) event->GetSysEx()->GetBuf();
-                        std::cout << "instrument name : " << text << " (ignored)"<< std::endl;
-                    }
-                    */
-                    else if ((int)event->GetByte1() == 5) // lyrics
+                    case ImportedSequenceEvent::KEY_SIG:
                     {
-                        const char* text = (char*) event->GetSysEx()->GetBuf();
-
-                        if (strlen(text) > 0)
+                        const int amount = evt.value1;
+                        for (int trackn=0; trackn<real_track_amount; trackn++)
                         {
-                            wxString s(text, wxConvUTF8, event->GetSysEx()->GetLength());
-                            if (s.size() == 0)
+                            if (amount > 0)
                             {
-                                fprintf(stderr, "[MidiFileReader] WARNING: error converting lyrics (wrong encoding?)\n");
+                                sequence->getTrack(trackn)->setKey(amount, KEY_TYPE_SHARPS);
+                                sequence->setDefaultKeySymbolAmount(amount);
+                                sequence->setDefaultKeyType(KEY_TYPE_SHARPS);
                             }
-                            else
+                            else if (amount < 0)
                             {
-                                sequence->addTextEvent_import(tick, s, PSEUDO_CONTROLLER_LYRICS);
+                                sequence->getTrack(trackn)->setKey(-amount, KEY_TYPE_FLATS);
+                                sequence->setDefaultKeySymbolAmount(-amount);
+                                sequence->setDefaultKeyType(KEY_TYPE_FLATS);
                             }
                         }
+                        // FIXME - does midi allow a different key for each track?
+                        break;
                     }
-                    else if ((int)event->GetByte1() == 6) // marker (GBA loop points)
-                    {
-                        const char* text = (char*) event->GetSysEx()->GetBuf();
-
-                        if (strlen(text) > 0)
-                        {
-                            wxString s(text, wxConvUTF8, event->GetSysEx()->GetLength());
-                            if (s == wxT("[") or s == wxT("]") or s == wxT("][") or s == wxT(":"))
-                            {
-                                sequence->addTextEvent_import(tick, s, PSEUDO_CONTROLLER_LOOP_MARKER);
-                            }
-                        }
-                    }
-                    /*
-                    else if ((int)event->GetByte1() == 1) // comments
-                    {
-                        const char* text = (char*) event->GetSysEx()->GetBuf();
-                        std::cout << "comment : " << text << " (ignored)"<< std::endl;
-                    }
-                    else
-                    {
-                        const char* text = (char*) event->GetSysEx()->GetBuf();
-                        std::cout << "Unknown text=" << text << ", channel="<< channel << ", byte1=" << (int)event->GetByte1() << std::endl;
-                    }*/
-
-
-                }
-                //else{ std::cout << "ignored event" << std::endl; }
-
-                /*
-                else if ( event->IsSystemMessage() )
-                {
-                    std::cout << "System Message: " << (int)event->GetByte1() << " " << (int)event->GetByte2() << " " << (int)event->GetByte3() << " " << (int)event->GetType() << std::endl;
-                }
-                else if ( event->IsSysEx() )
-                {
-                    std::cout << "Sysex: " << (int)event->GetByte1() << " " << (int)event->GetByte2() << " " << (int)event->GetByte3() << " " << (int)event->GetType() << std::endl;
-                }
-                else if ( event->IsMetaEvent() )
-                {
-                    std::cout << "Meta Event: " << (int)event->GetByte1() << " " << (int)event->GetByte2() << " " << (int)event->GetByte3() << ", type= " << (int)event->GetType();
-
-                    if ((int)event->GetByte1() == 0) std::cout << "---> sequence number" << std::endl;
-                    if ((int)event->GetByte1() == 1) std::cout << "---> text" << std::endl;
-                    if ((int)event->GetByte1() == 2) std::cout << "---> copyright" << std::endl;
-                    if ((int)event->GetByte1() == 3) std::cout << "---> track name" << std::endl;
-                    if ((int)event->GetByte1() == 4) std::cout << "---> instrument name" << std::endl;
-                    if ((int)event->GetByte1() == 5) std::cout << "---> lyrics name" << std::endl;
-                    if ((int)event->GetByte1() == 6) std::cout << "---> marker" << std::endl;
-                    if ((int)event->GetByte1() == 7) std::cout << "---> cue point" << std::endl;
-
-                    if ((int)event->GetByte1() == 32) std::cout << "---> prefix" << std::endl;
-
-                    if ((int)event->GetByte1() == 47) std::cout << "---> end of track" << std::endl;
-
-                    if ((int)event->GetByte1() == 81) std::cout << "---> tempo" << std::endl;
-
-                    if ((int)event->GetByte1() == 84) std::cout << "---> SMPTE" << std::endl;
-                    if ((int)event->GetByte1() == 88) std::cout << "---> Time signature" << std::endl;
 
-                    if ((int)event->GetByte1() == 240) std::cout << "---> Sys Ex" << std::endl;
+                    case ImportedSequenceEvent::COPYRIGHT:
+                        sequence->setCopyright( evt.text );
+                        break;
 
+                    case ImportedSequenceEvent::TEXT:
+                        sequence->addTextEvent_import(evt.tick, evt.text, evt.value1);
+                        break;
                 }
-                else
-                {
-                    std::cout << "Unknown --> " << (char)event->GetByte1() << " " << (char)event->GetByte2() << " " << (char)event->GetByte3() << std::endl;
-                }
-    */
-            }//next event
+            }
 
-            //std::cout << "name is " << toCString(trackName) << "  last_channel=" << last_channel << " trackID=" << trackID << std::endl;
+            track_warnings.insert(job.warnings.begin(), job.warnings.end());
+            if (job.discardedLSB) lsb_discarded = true;
+            orphaned_notes += job.orphanedNotes;
 
-            if (last_channel != -1)
+            wxString trackName = job.name;
+            if (job.channel != -1)
             {
                 if (trackName.Length() == 0) trackName = _("Untitled");
                 ariaTrack->setName(trackName);
             }
 
-            if (trackID == 0)
+            if (job.sourceID == 0)
             {
                 sequence->setInternalName( trackName );
             }
 
-            if (ariaTrack->getChannel() == 9 or isDrumTrack)
+            if (ariaTrack->getChannel() == 9 or job.isDrumTrack)
             {
                 ariaTrack->setNotationType(DRUM, true);
             }
@@ -709,7 +890,7 @@ bool AriaMaestosa::loadMidiFile(GraphicalSequence* gseq, wxString filepath, std:
             }
 
             // FIXME: when does it happen?? a MIDI file contains only deltas AFAIK, I don't quite see how you can detect an incorrect order
-            if (need_reorder)
+            if (job.needReorder)
             {
                 std::cerr << "* midi file is wrong, it will be necessary to reorder midi events" << std::endl;
                 ariaTrack->reorderNoteVector();
@@ -718,10 +899,28 @@ bool AriaMaestosa::loadMidiFile(GraphicalSequence* gseq, wxString filepath, std:
             ariaTrack->reorderNoteOffVector();
 
 
-            if (lastEventTick_inTrack > lastEventTick) lastEventTick = lastEventTick_inTrack;
+            if (job.lastEventTick > lastEventTick) lastEventTick = job.lastEventTick;
             
         }//next track
 
+        for (std::set< std::pair<int, int> >::iterator it = track_warnings.begin(); it != track_warnings.end(); it++)
+        {
+            warnings.insert( describeImportWarning(it->first, it->second) );
+        }
+
+        if (lsb_discarded)
+        {
+            std::cerr << "[MidiFileReader] WARNING: This MIDI files contains LSB controller data."
+                      << " Aria does not support fine control changes and will discard this info."
+                      << std::endl;
+        }
+
+        if (orphaned_notes > 0)
+        {
+            fprintf(stderr, "[MidiFileReader] WARNING: %i note events could not be paired\n", orphaned_notes);
+            warnings.insert( wxString::Format(_("This MIDI file appears to be incorrect; %i note(s) do not have both a start and an end"), orphaned_notes) );
+        }
+        
         // erase empty tracks
         for (int n=0; n<sequence->getTrackAmount(); n++)
         {
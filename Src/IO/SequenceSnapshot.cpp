@@ -0,0 +1,288 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "IO/SequenceSnapshot.h"
+
+#include "GUI/GraphicalSequence.h"
+#include "IO/AriaBinaryFile.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "UnitTest.h"
+#include "UnitTestUtils.h"
+
+#include <iostream>
+#include <wx/filefn.h>
+#include <wx/mstream.h>
+#include <wx/thread.h>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    /** writes each snapshot next to its destination, then moves it in place */
+    void writeSnapshots(const std::vector<BackgroundSnapshotWriter::Job>& jobs, const bool compress)
+    {
+        for (unsigned int n=0; n<jobs.size(); n++)
+        {
+            const wxString temporaryPath = jobs[n].m_filepath + wxT(".tmp");
+            if (not saveBinaryAriaFile(*jobs[n].m_snapshot, temporaryPath, compress) or
+                not wxRenameFile(temporaryPath, jobs[n].m_filepath, true /* overwrite */))
+            {
+                std::cerr << "[SequenceSnapshot] ERROR: could not write "
+                          << jobs[n].m_filepath.mb_str() << std::endl;
+                wxRemoveFile(temporaryPath);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------------------
+
+    class SnapshotWriterThread : public wxThread
+    {
+        std::vector<BackgroundSnapshotWriter::Job> m_jobs;
+        bool m_compress;
+        std::atomic<bool>& m_done;
+
+    public:
+
+        SnapshotWriterThread(const std::vector<BackgroundSnapshotWriter::Job>& jobs, const bool compress,
+                             std::atomic<bool>& done) :
+            wxThread(wxTHREAD_JOINABLE), m_jobs(jobs), m_compress(compress), m_done(done)
+        {
+            // wxString may share its buffer between copies without locking, give the thread its own
+            for (unsigned int n=0; n<m_jobs.size(); n++)
+            {
+                m_jobs[n].m_filepath = wxString(m_jobs[n].m_filepath.wc_str());
+            }
+        }
+
+        virtual ExitCode Entry()
+        {
+            writeSnapshots(m_jobs, m_compress);
+            m_done = true;
+            return 0;
+        }
+    };
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// --------------------------------------------- SequenceSnapshot -------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+SequenceSnapshot::SequenceSnapshot(GraphicalSequence* gseq, const SequenceSnapshot* previous)
+{
+    {
+        wxMemoryOutputStream xml;
+        gseq->saveToFile(xml, false /* track events are kept separately */);
+
+        m_project.resize(xml.GetSize());
+        if (not m_project.empty()) xml.CopyTo(&m_project[0], m_project.size());
+    }
+
+    snapshotTracks(gseq->getModel(), previous);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+SequenceSnapshot::SequenceSnapshot(Sequence* sequence, const std::vector<unsigned char>& project,
+                                   const SequenceSnapshot* previous) : m_project(project)
+{
+    snapshotTracks(sequence, previous);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void SequenceSnapshot::snapshotTracks(Sequence* sequence, const SequenceSnapshot* previous)
+{
+    const int trackAmount = sequence->getTrackAmount();
+    m_tracks.resize(trackAmount);
+
+    for (int n=0; n<trackAmount; n++)
+    {
+        Track* track = sequence->getTrack(n);
+        TrackEvents& events = m_tracks[n];
+        events.m_track    = track;
+        events.m_revision = track->getRevision();
+        if (previous != NULL) events.m_events = previous->findTrackEvents(track, events.m_revision, n);
+
+        if (not events.m_events)
+        {
+            BinaryWriter writer;
+            track->saveEventsToBinary(writer);
+            events.m_events = std::make_shared< const std::vector<unsigned char> >(writer.getData());
+            
+            // encoding puts the events in time order first, which changes the revision if they were not
+            events.m_revision = track->getRevision();
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+SequenceSnapshot::Buffer SequenceSnapshot::findTrackEvents(const Track* track, const unsigned int revision,
+                                                           const int hint) const
+{
+    // tracks are rarely reordered, look at the same position first
+    if (hint < (int)m_tracks.size() and m_tracks[hint].m_track == track)
+    {
+        if (m_tracks[hint].m_revision == revision) return m_tracks[hint].m_events;
+        return Buffer();
+    }
+
+    for (unsigned int n=0; n<m_tracks.size(); n++)
+    {
+        if (m_tracks[n].m_track == track and m_tracks[n].m_revision == revision) return m_tracks[n].m_events;
+    }
+    return Buffer();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool SequenceSnapshot::sameContentsAs(const SequenceSnapshot& other) const
+{
+    if (m_tracks.size() != other.m_tracks.size() or m_project != other.m_project) return false;
+
+    for (unsigned int n=0; n<m_tracks.size(); n++)
+    {
+        // unchanged tracks share their buffer, so comparing pointers is usually enough
+        if (m_tracks[n].m_events != other.m_tracks[n].m_events and
+            *m_tracks[n].m_events != *other.m_tracks[n].m_events)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------- BackgroundSnapshotWriter ---------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+BackgroundSnapshotWriter::BackgroundSnapshotWriter() : m_done(false)
+{
+    m_thread = NULL;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+BackgroundSnapshotWriter::~BackgroundSnapshotWriter()
+{
+    join();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void BackgroundSnapshotWriter::join()
+{
+    if (m_thread == NULL) return;
+
+    m_thread->Wait();
+    delete m_thread;
+    m_thread = NULL;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool BackgroundSnapshotWriter::isBusy()
+{
+    if (m_thread == NULL) return false;
+    if (not m_done) return true;
+
+    // the thread is done, clean it up
+    join();
+    return false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool BackgroundSnapshotWriter::start(const std::vector<Job>& jobs, const bool compress)
+{
+    if (isBusy()) return false;
+    if (jobs.empty()) return true;
+
+    m_done = false;
+    SnapshotWriterThread* thread = new SnapshotWriterThread(jobs, compress, m_done);
+    if (thread->Create() != wxTHREAD_NO_ERROR)
+    {
+        delete thread;
+
+        // better to hitch than to lose the data
+        std::cerr << "[SequenceSnapshot] WARNING: could not start a thread, writing snapshots directly" << std::endl;
+        writeSnapshots(jobs, compress);
+        return true;
+    }
+
+    thread->Run();
+    m_thread = thread;
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestSequenceSnapshot
+{
+    using namespace AriaMaestosa;
+    
+    UNIT_TEST( TestUnchangedTracksReuseBuffers )
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        for (int t=0; t<2; t++)
+        {
+            Track* track = new Track(seq);
+            {
+                OwnerPtr<Sequence::Import> import(seq->startImport());
+                for (int n=0; n<200; n++)
+                {
+                    // lengths vary so that the notes end in another order than they start
+                    track->addNote_import(40 + n % 30, n*120, n*120 + 60 + (n*37) % 500, 80, -1);
+                    track->addControlEvent_import(n*96, n % 128, 7);
+                }
+            }
+            track->reorderNoteOffVector();
+            seq->addTrack(track);
+        }
+        
+        const std::vector<unsigned char> project;
+        SequenceSnapshot first(seq, project, NULL);
+        
+        // saving the project puts the events in time order again, as GraphicalSequence::saveToFile does
+        for (int t=0; t<seq->getTrackAmount(); t++)
+        {
+            seq->getTrack(t)->reorderNoteVector();
+            seq->getTrack(t)->reorderNoteOffVector();
+            seq->getTrack(t)->reorderControlVector();
+        }
+        
+        SequenceSnapshot second(seq, project, &first);
+        for (int t=0; t<seq->getTrackAmount(); t++)
+        {
+            require(&second.getTrackEvents(t) == &first.getTrackEvents(t),
+                    "unchanged tracks share the buffers of the previous snapshot");
+        }
+        require(second.sameContentsAs(first), "both snapshots have the same contents");
+        
+        seq->getTrack(1)->markModified();
+        SequenceSnapshot third(seq, project, &second);
+        require(&third.getTrackEvents(0) == &second.getTrackEvents(0), "the unchanged track is reused");
+        require(&third.getTrackEvents(1) != &second.getTrackEvents(1), "the modified track is encoded again");
+        
+        delete seq;
+    }
+}
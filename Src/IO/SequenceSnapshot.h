@@ -0,0 +1,154 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SEQUENCE_SNAPSHOT_H__
+#define __SEQUENCE_SNAPSHOT_H__
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <wx/string.h>
+
+class wxThread;
+
+namespace AriaMaestosa
+{
+
+    class GraphicalSequence; // forward
+    class Sequence;          // forward
+    class Track;             // forward
+
+    /**
+      * @brief Immutable copy of a sequence, in the form it takes in a binary .aria file.
+      *
+      * A snapshot is taken on the GUI thread and can then be written to disk from any thread, while the
+      * user keeps editing the live sequence.
+      *
+      * The events of each track are encoded once per track revision (see Track::getRevision) and the
+      * resulting buffers are shared between snapshots; when given the previous snapshot of the same
+      * sequence, only the tracks edited since are encoded again. The rest of the project (settings,
+      * measures, tempo) is small and re-encoded every time. Changes that do not go through an action,
+      * like the selection, do not bump the revision and may be missed when buffers are reused.
+      * @ingroup io
+      */
+    class SequenceSnapshot
+    {
+    public:
+
+        typedef std::shared_ptr< const std::vector<unsigned char> > Buffer;
+
+    private:
+
+        struct TrackEvents
+        {
+            /** only used to recognize the track, never dereferenced */
+            const Track* m_track;
+            unsigned int m_revision;
+            Buffer m_events;
+        };
+
+        std::vector<unsigned char> m_project;
+        std::vector<TrackEvents> m_tracks;
+
+        /** @return the events of 'track' at 'revision' if this snapshot has them, or an empty buffer */
+        Buffer findTrackEvents(const Track* track, const unsigned int revision, const int hint) const;
+
+        /** @brief fills 'm_tracks', reusing the buffers of 'previous' where possible */
+        void snapshotTracks(Sequence* sequence, const SequenceSnapshot* previous);
+
+        SequenceSnapshot(const SequenceSnapshot&);
+        SequenceSnapshot& operator=(const SequenceSnapshot&);
+
+    public:
+
+        /**
+          * @param previous an older snapshot of the same sequence whose track buffers may be reused,
+          *                 or NULL to encode everything
+          */
+        SequenceSnapshot(GraphicalSequence* sequence, const SequenceSnapshot* previous);
+
+        /**
+          * @brief snapshot of the track events of a sequence, with an already saved project
+          * @param project the project without its track events, in the XML form
+          */
+        SequenceSnapshot(Sequence* sequence, const std::vector<unsigned char>& project,
+                         const SequenceSnapshot* previous);
+
+        /** @return whether both snapshots would produce the same file */
+        bool sameContentsAs(const SequenceSnapshot& other) const;
+
+        /** @return the project without its track events, in the XML form */
+        const std::vector<unsigned char>& getProject() const { return m_project; }
+
+        int getTrackAmount() const { return m_tracks.size(); }
+
+        /** @return the events of a track, as written by Track::saveEventsToBinary */
+        const std::vector<unsigned char>& getTrackEvents(const int track) const
+        {
+            return *m_tracks[track].m_events;
+        }
+    };
+
+    /**
+      * @brief Writes snapshots to disk on a worker thread, one batch at a time.
+      *
+      * Each file is first written under a temporary name then renamed, so that a crash in the middle of
+      * a write never leaves a truncated file behind.
+      * @ingroup io
+      */
+    class BackgroundSnapshotWriter
+    {
+    public:
+
+        struct Job
+        {
+            std::shared_ptr<const SequenceSnapshot> m_snapshot;
+            wxString m_filepath;
+        };
+
+    private:
+
+        wxThread* m_thread;
+
+        /** set by the worker thread when it is done with its batch */
+        std::atomic<bool> m_done;
+
+        /** waits for the worker thread, if there is one, and deletes it */
+        void join();
+
+    public:
+
+        BackgroundSnapshotWriter();
+
+        /** waits for the batch being written, if any */
+        ~BackgroundSnapshotWriter();
+
+        /** @return whether a batch is still being written */
+        bool isBusy();
+
+        /**
+          * @brief starts writing a batch of snapshots
+          * @return false if the previous batch is not done yet, in which case nothing is started
+          */
+        bool start(const std::vector<Job>& jobs, const bool compress);
+
+        /** @brief blocks until the batch being written, if any, is done */
+        void waitForCompletion() { join(); }
+    };
+
+}
+
+#endif
@@ -0,0 +1,455 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "IO/WavWriter.h"
+#include "UnitTest.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <wx/filename.h>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    /** Bytes accumulated before they are written to disk */
+    const unsigned int WAV_WRITER_BUFFER_SIZE = 64*1024;
+    
+    const uint16_t WAVE_FORMAT_PCM        = 1;
+    const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+    const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+    
+    /** Tail of the KSDATAFORMAT_SUBTYPE_* GUIDs; the first two bytes are the WAVE_FORMAT_* tag */
+    const unsigned char SUBFORMAT_GUID_TAIL[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                                    0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+    
+    inline void putLE16(unsigned char* out, const uint16_t value)
+    {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+    }
+    
+    inline void putLE32(unsigned char* out, const uint32_t value)
+    {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+        out[2] = (value >> 16) & 0xFF;
+        out[3] = (value >> 24) & 0xFF;
+    }
+    
+    /**
+      * Converts a sample scaled to the integer range. Plain samples are truncated toward zero, like the
+      * GBA export always did. Dithered samples are rounded, since truncating would add a bias to the
+      * noise, and clamped to [-fullScale-1, fullScale] as the noise may push them past full scale.
+      */
+    inline int32_t quantize(const float scaled, const int32_t fullScale, const bool dithered)
+    {
+        if (not dithered) return (int32_t)scaled;
+        
+        const float rounded = floorf(scaled + 0.5f);
+        if (rounded > fullScale)    return fullScale;
+        if (rounded < -fullScale-1) return -fullScale-1;
+        return (int32_t)rounded;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+WavWriter::WavWriter()
+{
+    m_format       = PCM_16;
+    m_sample_rate  = 0;
+    m_channels     = 0;
+    m_dither       = false;
+    m_dither_state = 0x12345678;
+    m_data_bytes   = 0;
+    m_failed       = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+WavWriter::~WavWriter()
+{
+    if (isOpen()) close();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int WavWriter::getBytesPerSample(const SampleFormat format)
+{
+    switch (format)
+    {
+        case PCM_24:   return 3;
+        case FLOAT_32: return 4;
+        case PCM_16:
+        default:       return 2;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+uint64_t WavWriter::getFramesWritten() const
+{
+    if (m_channels == 0) return 0;
+    return (m_data_bytes + m_buffer.size()) / (m_channels * getBytesPerSample(m_format));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool WavWriter::open(const wxString& path, const int sampleRate, const int channels,
+                     const SampleFormat format, const bool dither)
+{
+    ASSERT(not isOpen());
+    ASSERT_E(channels, >, 0);
+    
+    m_format       = format;
+    m_sample_rate  = sampleRate;
+    m_channels     = channels;
+    m_dither       = dither and format != FLOAT_32;
+    m_dither_state = 0x12345678;
+    m_data_bytes   = 0;
+    m_failed       = false;
+    
+    m_buffer.clear();
+    m_buffer.reserve(WAV_WRITER_BUFFER_SIZE);
+    
+    if (not m_file.Create(path, true /* overwrite */)) return false;
+    
+    // sizes are left at 0 until close()
+    if (not writeHeader())
+    {
+        m_file.Close();
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool WavWriter::isExtensible() const
+{
+    // WAVEFORMATEX cannot tell which speaker each channel goes to
+    return m_channels > 2;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int WavWriter::getFormatChunkSize() const
+{
+    if (isExtensible())            return 40; // WAVEFORMATEXTENSIBLE
+    else if (m_format == FLOAT_32) return 18; // WAVEFORMATEX, with an empty extension
+    else                           return 16; // PCMWAVEFORMAT
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int WavWriter::getHeaderSize() const
+{
+    // non-PCM formats must have a 'fact' chunk holding the amount of frames
+    const bool hasFact = (m_format == FLOAT_32);
+    return 12 + 8 + getFormatChunkSize() + (hasFact ? 12 : 0) + 8;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool WavWriter::writeHeader()
+{
+    const int bytesPerSample = getBytesPerSample(m_format);
+    const int headerSize     = getHeaderSize();
+    const int fmtSize        = getFormatChunkSize();
+    const uint16_t formatTag = (m_format == FLOAT_32 ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+    
+    // the RIFF size fields are 32 bits; larger files can only be read by tools that ignore them
+    const uint64_t maxDataSize = 0xFFFFFFFFULL - (headerSize - 8);
+    const uint32_t dataSize    = (m_data_bytes > maxDataSize ? (uint32_t)maxDataSize : (uint32_t)m_data_bytes);
+    
+    // chunks must have an even size; the pad byte after the samples counts in the RIFF size only
+    const uint64_t riffSize = headerSize - 8 + (uint64_t)dataSize + (m_data_bytes % 2);
+    
+    std::vector<unsigned char> header(headerSize, 0);
+    unsigned char* out = &header[0];
+    
+    memcpy(out, "RIFF", 4);
+    putLE32(out + 4, riffSize > 0xFFFFFFFFULL ? 0xFFFFFFFFu : (uint32_t)riffSize);
+    memcpy(out + 8, "WAVE", 4);
+    out += 12;
+    
+    memcpy(out, "fmt ", 4);
+    putLE32(out + 4, fmtSize);
+    putLE16(out + 8, isExtensible() ? WAVE_FORMAT_EXTENSIBLE : formatTag);
+    putLE16(out + 10, m_channels);
+    putLE32(out + 12, m_sample_rate);
+    putLE32(out + 16, m_sample_rate * m_channels * bytesPerSample);
+    putLE16(out + 20, m_channels * bytesPerSample);
+    putLE16(out + 22, bytesPerSample * 8);
+    if (fmtSize > 16) putLE16(out + 24, fmtSize - 18); // size of the extension
+    if (isExtensible())
+    {
+        putLE16(out + 26, bytesPerSample * 8); // valid bits per sample
+        
+        // the channels go to the first speaker positions, in the standard order
+        putLE32(out + 28, m_channels < 32 ? (1u << m_channels) - 1 : 0xFFFFFFFFu);
+        
+        putLE16(out + 32, formatTag);
+        memcpy(out + 34, SUBFORMAT_GUID_TAIL, sizeof(SUBFORMAT_GUID_TAIL));
+    }
+    out += 8 + fmtSize;
+    
+    if (m_format == FLOAT_32)
+    {
+        const uint64_t frames = m_data_bytes / (m_channels * bytesPerSample);
+        memcpy(out, "fact", 4);
+        putLE32(out + 4, 4);
+        putLE32(out + 8, frames > 0xFFFFFFFFULL ? 0xFFFFFFFFu : (uint32_t)frames);
+        out += 12;
+    }
+    
+    memcpy(out, "data", 4);
+    putLE32(out + 4, dataSize);
+    
+    return m_file.Write(&header[0], headerSize) == (size_t)headerSize;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+float WavWriter::ditherNoise()
+{
+    // TPDF dither : the sum of two uniform variables, spanning +/- 1 LSB
+    m_dither_state = m_dither_state*1664525 + 1013904223;
+    const float a = (m_dither_state >> 8) * (1.0f / 16777216.0f);
+    m_dither_state = m_dither_state*1664525 + 1013904223;
+    const float b = (m_dither_state >> 8) * (1.0f / 16777216.0f);
+    return a - b;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool WavWriter::flush()
+{
+    if (m_buffer.empty()) return not m_failed;
+    
+    if (m_file.Write(&m_buffer[0], m_buffer.size()) != m_buffer.size())
+    {
+        m_failed = true;
+    }
+    m_data_bytes += m_buffer.size();
+    m_buffer.clear();
+    return not m_failed;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool WavWriter::write(const float* samples, const int frameCount)
+{
+    ASSERT(isOpen());
+    if (m_failed) return false;
+    
+    const int bytesPerSample = getBytesPerSample(m_format);
+    const int sampleCount    = frameCount * m_channels;
+    
+    for (int n=0; n<sampleCount; n++)
+    {
+        if (m_buffer.size() + bytesPerSample > WAV_WRITER_BUFFER_SIZE)
+        {
+            if (not flush()) return false;
+        }
+        
+        const size_t at = m_buffer.size();
+        m_buffer.resize(at + bytesPerSample);
+        unsigned char* out = &m_buffer[at];
+        
+        float s = samples[n];
+        switch (m_format)
+        {
+            case FLOAT_32:
+            {
+                uint32_t bits;
+                memcpy(&bits, &s, 4);
+                putLE32(out, bits);
+                break;
+            }
+            case PCM_24:
+            {
+                if (s > 1.0f)  s = 1.0f;
+                if (s < -1.0f) s = -1.0f;
+                const int32_t value = quantize(s*8388607.0f + (m_dither ? ditherNoise() : 0.0f), 8388607, m_dither);
+                out[0] = value & 0xFF;
+                out[1] = (value >> 8) & 0xFF;
+                out[2] = (value >> 16) & 0xFF;
+                break;
+            }
+            case PCM_16:
+            default:
+            {
+                if (s > 1.0f)  s = 1.0f;
+                if (s < -1.0f) s = -1.0f;
+                const int32_t value = quantize(s*32767.0f + (m_dither ? ditherNoise() : 0.0f), 32767, m_dither);
+                putLE16(out, (uint16_t)(int16_t)value);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool WavWriter::close()
+{
+    ASSERT(isOpen());
+    
+    bool success = flush();
+    
+    // the data chunk is padded to an even size, e.g. 24-bit mono with an odd amount of frames
+    if (success and m_data_bytes % 2 != 0)
+    {
+        const unsigned char pad = 0;
+        if (m_file.Write(&pad, 1) != 1) success = false;
+    }
+    
+    // now that the sizes are known, rewrite the header
+    if (m_file.Seek(0) == wxInvalidOffset or not writeHeader()) success = false;
+    
+    m_file.Close();
+    return success;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ------------------------------------------- UNIT TESTS ---------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestWavWriter
+{
+    using namespace AriaMaestosa;
+    
+    static uint32_t readLE32(const unsigned char* in)
+    {
+        return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    }
+    
+    UNIT_TEST( TestWavWriterHeaderAndSamples )
+    {
+        const wxString path = wxFileName::CreateTempFileName(wxT("AriaWavTest"));
+        
+        // more frames than fit in the buffer, to go through several flushes
+        const int frameCount = 20000;
+        std::vector<float> samples(frameCount*2);
+        for (int n=0; n<frameCount; n++)
+        {
+            samples[n*2]     = 0.5f;
+            samples[n*2 + 1] = -2.0f; // out of range, must be clipped
+        }
+        
+        WavWriter writer;
+        require(writer.open(path, 44100, 2, WavWriter::PCM_24), "the file can be created");
+        require(writer.write(&samples[0], frameCount), "samples can be written");
+        require_e((int)writer.getFramesWritten(), ==, frameCount, "all frames are accounted for");
+        require(writer.close(), "the file can be closed");
+        
+        std::ifstream in(path.mb_str(), std::ios::binary);
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        wxRemoveFile(path);
+        
+        const uint32_t dataSize = frameCount*2*3;
+        require_e(data.size(), ==, 44 + dataSize, "file size matches header and samples");
+        require(memcmp(&data[0], "RIFF", 4) == 0 and memcmp(&data[8], "WAVE", 4) == 0, "RIFF/WAVE tags");
+        require_e(readLE32(&data[4]),  ==, 36 + dataSize, "RIFF size was patched");
+        require_e(readLE32(&data[24]), ==, 44100u, "sample rate");
+        require_e(data[34], ==, 24, "bits per sample");
+        require_e(readLE32(&data[40]), ==, dataSize, "data size was patched");
+        
+        // last frame : 0.5 then clipped -1.0
+        const unsigned char* last = &data[data.size() - 6];
+        const int32_t left  = (int32_t)((last[0] | (last[1] << 8) | (last[2] << 16)) << 8) >> 8;
+        const int32_t right = (int32_t)((last[3] | (last[4] << 8) | (last[5] << 16)) << 8) >> 8;
+        require_e(left,  ==, 4194303, "24-bit samples are truncated without dither");
+        require_e(right, ==, -8388607, "out of range samples are clipped");
+    }
+    
+    // ----------------------------------------------------------------------------------------------------------
+    
+    static std::vector<unsigned char> writeAndRead(const int channels, const WavWriter::SampleFormat format,
+                                                   const int frameCount)
+    {
+        const wxString path = wxFileName::CreateTempFileName(wxT("AriaWavTest"));
+        
+        std::vector<float> samples(frameCount*channels, 0.25f);
+        
+        WavWriter writer;
+        require(writer.open(path, 22050, channels, format), "the file can be created");
+        require(writer.write(&samples[0], frameCount), "samples can be written");
+        require(writer.close(), "the file can be closed");
+        
+        std::ifstream in(path.mb_str(), std::ios::binary);
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        wxRemoveFile(path);
+        return data;
+    }
+    
+    UNIT_TEST( TestWavWriterPadsOddDataChunk )
+    {
+        const int frameCount = 101;
+        const std::vector<unsigned char> data = writeAndRead(1, WavWriter::PCM_24, frameCount);
+        
+        const uint32_t dataSize = frameCount*3;
+        require_e(data.size(), ==, 44 + dataSize + 1, "a pad byte follows the odd-sized data chunk");
+        require_e(data[data.size() - 1], ==, 0, "the pad byte is zero");
+        require_e(readLE32(&data[4]),  ==, 36 + dataSize + 1, "RIFF size includes the pad byte");
+        require_e(readLE32(&data[40]), ==, dataSize, "data size does not include the pad byte");
+    }
+    
+    UNIT_TEST( TestWavWriterFloatHasFactChunk )
+    {
+        const int frameCount = 1000;
+        const std::vector<unsigned char> data = writeAndRead(2, WavWriter::FLOAT_32, frameCount);
+        
+        const uint32_t dataSize = frameCount*2*4;
+        require_e(data.size(), ==, 58 + dataSize, "header has an extended fmt chunk and a fact chunk");
+        require_e(readLE32(&data[4]),  ==, 50 + dataSize, "RIFF size");
+        require_e(readLE32(&data[16]), ==, 18u, "fmt chunk size");
+        require_e(data[20], ==, 3, "IEEE float format tag");
+        require_e((data[36] | (data[37] << 8)), ==, 0, "empty fmt extension");
+        require(memcmp(&data[38], "fact", 4) == 0, "fact chunk follows fmt");
+        require_e(readLE32(&data[42]), ==, 4u, "fact chunk size");
+        require_e(readLE32(&data[46]), ==, (uint32_t)frameCount, "fact chunk holds the frame count");
+        require(memcmp(&data[50], "data", 4) == 0, "data chunk follows fact");
+        require_e(readLE32(&data[54]), ==, dataSize, "data size");
+    }
+    
+    UNIT_TEST( TestWavWriterMultichannelIsExtensible )
+    {
+        const int frameCount = 100;
+        const std::vector<unsigned char> data = writeAndRead(6, WavWriter::PCM_16, frameCount);
+        
+        const uint32_t dataSize = frameCount*6*2;
+        require_e(data.size(), ==, 68 + dataSize, "header has an extensible fmt chunk");
+        require_e(readLE32(&data[16]), ==, 40u, "fmt chunk size");
+        require_e((data[20] | (data[21] << 8)), ==, 0xFFFE, "WAVE_FORMAT_EXTENSIBLE tag");
+        require_e(data[22], ==, 6, "channel count");
+        require_e((data[36] | (data[37] << 8)), ==, 22, "fmt extension size");
+        require_e((data[38] | (data[39] << 8)), ==, 16, "valid bits per sample");
+        require_e(readLE32(&data[40]), ==, 0x3Fu, "channel mask");
+        require_e((data[44] | (data[45] << 8)), ==, 1, "PCM sub-format");
+        require(memcmp(&data[60], "data", 4) == 0, "PCM has no fact chunk");
+        require_e(readLE32(&data[64]), ==, dataSize, "data size");
+        require_e((data[68] | (data[69] << 8)), ==, 8191, "16-bit samples are truncated without dither");
+    }
+    
+}
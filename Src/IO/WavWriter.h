@@ -0,0 +1,115 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __WAV_WRITER_H__
+#define __WAV_WRITER_H__
+
+#include "Utils.h"
+
+#include <stdint.h>
+#include <vector>
+#include <wx/file.h>
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief writes interleaved float audio to a WAV file as it is being rendered
+      *
+      * Samples are converted into an internal buffer which is written to disk in large blocks, so
+      * the whole render never has to be held in memory. The sizes in the header are only known at
+      * the end, so they are patched in by close().
+      *
+      * @ingroup io
+      */
+    class WavWriter
+    {
+    public:
+        
+        enum SampleFormat
+        {
+            PCM_16   = 0,
+            PCM_24   = 1,
+            FLOAT_32 = 2
+        };
+        
+    private:
+        
+        wxFile       m_file;
+        SampleFormat m_format;
+        int          m_sample_rate;
+        int          m_channels;
+        bool         m_dither;
+        uint32_t     m_dither_state;
+        
+        /** Converted samples not yet written to the file */
+        std::vector<unsigned char> m_buffer;
+        
+        uint64_t     m_data_bytes;
+        bool         m_failed;
+        
+        /** @return whether the header uses WAVE_FORMAT_EXTENSIBLE, which multichannel files need */
+        bool isExtensible() const;
+        int  getFormatChunkSize() const;
+        
+        /** @return the size of everything before the samples; it only depends on the format and channels */
+        int  getHeaderSize() const;
+        
+        bool writeHeader();
+        bool flush();
+        float ditherNoise();
+        
+    public:
+        LEAK_CHECK();
+        
+        WavWriter();
+        
+        /** @brief closes the file if it is still open */
+        ~WavWriter();
+        
+        /**
+          * @brief create (or overwrite) the file and write a provisional header
+          * @param dither  Add TPDF dither and round when quantizing; without it, PCM samples are truncated
+          *                toward zero. Ignored for float output.
+          * @return whether the file could be created
+          */
+        bool open(const wxString& path, const int sampleRate, const int channels,
+                  const SampleFormat format, const bool dither = false);
+        
+        /**
+          * @brief append frames to the file
+          * @param samples    frameCount * channels interleaved samples, nominally in [-1, 1]. PCM
+          *                   output is clipped to that range, float output is written as is.
+          * @return false if writing failed (the file is then left incomplete)
+          */
+        bool write(const float* samples, const int frameCount);
+        
+        /** @brief write what is left in the buffer (and a pad byte if its size is odd), patch the header,
+          *        and close the file */
+        bool close();
+        
+        bool isOpen() const { return m_file.IsOpened(); }
+        
+        uint64_t getFramesWritten() const;
+        
+        static int getBytesPerSample(const SampleFormat format);
+    };
+    
+}
+
+#endif
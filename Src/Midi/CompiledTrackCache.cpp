@@ -0,0 +1,85 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Midi/CompiledTrackCache.h"
+
+#include <iostream>
+
+using namespace AriaMaestosa;
+
+int CompiledTrackCache::s_hits   = 0;
+int CompiledTrackCache::s_misses = 0;
+
+// ----------------------------------------------------------------------------------------------------------
+
+CompiledTrackCache::CompiledTrackCache()
+{
+    m_length = -1;
+    m_valid  = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool CompiledTrackCache::matches(const CompiledTrackKey& key)
+{
+    if (m_valid and m_key == key)
+    {
+        s_hits++;
+        return true;
+    }
+    
+    s_misses++;
+    return false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+jdksmidi::MIDITrack* CompiledTrackCache::beginCompiling()
+{
+    m_valid = false;
+    m_events.Clear();
+    return &m_events;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompiledTrackCache::commit(const CompiledTrackKey& key, const int length)
+{
+    m_key    = key;
+    m_length = length;
+    m_valid  = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int CompiledTrackCache::appendTo(jdksmidi::MIDITrack* target) const
+{
+    ASSERT(m_valid);
+    
+    const int count = m_events.GetNumEvents();
+    for (int n=0; n<count; n++)
+    {
+        if (not target->PutEvent( *m_events.GetEventAddress(n) ))
+        {
+            std::cerr << "Error adding midi event!" << std::endl;
+        }
+    }
+    
+    return m_length;
+}
+
+// ----------------------------------------------------------------------------------------------------------
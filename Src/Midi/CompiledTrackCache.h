@@ -0,0 +1,124 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __COMPILED_TRACK_CACHE_H__
+#define __COMPILED_TRACK_CACHE_H__
+
+#include "Utils.h"
+
+#include "jdksmidi/world.h"
+#include "jdksmidi/track.h"
+
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief the parameters a track's MIDI events were compiled with
+      *
+      * Apart from the notes and controllers themselves (covered by the track revision), these are
+      * all the inputs that affect the output of Track::addMidiEvents.
+      *
+      * @ingroup midi
+      */
+    struct CompiledTrackKey
+    {
+        unsigned int m_revision;
+        int          m_channel;
+        int          m_first_tick;
+        int          m_last_tick_in_song;
+        int          m_program;
+        int          m_volume;
+        bool         m_played;
+        bool         m_drum;
+        wxString     m_name;
+        
+        bool operator==(const CompiledTrackKey& other) const
+        {
+            return m_revision          == other.m_revision          and
+                   m_channel           == other.m_channel           and
+                   m_first_tick        == other.m_first_tick        and
+                   m_last_tick_in_song == other.m_last_tick_in_song and
+                   m_program           == other.m_program           and
+                   m_volume            == other.m_volume            and
+                   m_played            == other.m_played            and
+                   m_drum              == other.m_drum              and
+                   m_name              == other.m_name;
+        }
+    };
+    
+    /**
+      * @brief keeps the MIDI events last generated for a track, so that playback does not need to
+      *        regenerate them when the track was not modified since.
+      *
+      * Each track owns one such cache. It is only a cache : the owner must check it is up to date
+      * (see 'matches') before using its content, and refill it otherwise.
+      *
+      * Hit and miss counters are kept globally (for all tracks) to evaluate the effectiveness of the cache.
+      *
+      * @ingroup midi
+      */
+    class CompiledTrackCache
+    {
+        jdksmidi::MIDITrack m_events;
+        CompiledTrackKey    m_key;
+        
+        /** Value returned by Track::addMidiEvents when the events were compiled */
+        int m_length;
+        
+        bool m_valid;
+        
+        static int s_hits;
+        static int s_misses;
+        
+    public:
+        LEAK_CHECK();
+        
+        CompiledTrackCache();
+        
+        /** @brief forget the cached events, they will need to be compiled again before being used */
+        void invalidate() { m_valid = false; }
+        
+        /**
+          * @return whether the cache holds events compiled with the given parameters.
+          * @note   Updates the hit/miss counters.
+          */
+        bool matches(const CompiledTrackKey& key);
+        
+        /**
+          * @brief  Get the (empty) track into which compiled events must be stored. Call 'commit' once done.
+          */
+        jdksmidi::MIDITrack* beginCompiling();
+        
+        /** @brief mark the events added since 'beginCompiling' as valid for the given parameters */
+        void commit(const CompiledTrackKey& key, const int length);
+        
+        /**
+          * @brief   Append the cached events at the end of the given track
+          * @return  the length that was returned when compiling these events
+          */
+        int appendTo(jdksmidi::MIDITrack* target) const;
+        
+        static int getHitCount()  { return s_hits;   }
+        static int getMissCount() { return s_misses; }
+        static void resetCounters() { s_hits = 0; s_misses = 0; }
+    };
+    
+}
+
+#endif
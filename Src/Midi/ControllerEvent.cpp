@@ -17,6 +17,7 @@
 #include "Midi/ControllerEvent.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
+#include "ObjectPool.h"
 
 #include "irrXML/irrXML.h"
 
@@ -33,6 +34,30 @@ ControllerEvent::ControllerEvent(unsigned short controller, int tick, wxFloat64
 
 // ----------------------------------------------------------------------------------------------------------
 
+namespace
+{
+    /** never deleted, events may still be around while static objects are destroyed */
+    ObjectPool* g_controller_event_pool = NULL;
+}
+
+void* ControllerEvent::operator new(size_t size)
+{
+    if (g_controller_event_pool == NULL)
+    {
+        g_controller_event_pool = new ObjectPool("ControllerEvent", sizeof(ControllerEvent));
+    }
+    return g_controller_event_pool->allocate(size);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ControllerEvent::operator delete(void* event, size_t size)
+{
+    g_controller_event_pool->deallocate(event, size);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void ControllerEvent::setTick(int i)
 {
     m_tick = i;
@@ -53,7 +78,7 @@ void ControllerEvent::setValue(wxFloat64 value)
 #pragma mark Serialization
 #endif
 
-void ControllerEvent::saveToFile(wxFileOutputStream& fileout)
+void ControllerEvent::saveToFile(wxOutputStream& fileout)
 {
 
     writeData( wxT("  <controlevent type=\"") + to_wxString(m_controller)           , fileout );
@@ -110,7 +135,7 @@ bool ControllerEvent::readFromFile(irr::io::IrrXMLReader* xml)
 
 // ----------------------------------------------------------------------------------------------------------
 
-void TextEvent::saveToFile(wxFileOutputStream& fileout)
+void TextEvent::saveToFile(wxOutputStream& fileout)
 {
     writeData( wxT("  <controlevent type=\"") + to_wxString(m_controller) , fileout );
     writeData( wxT("\" tick=\"")              + to_wxString(m_tick)       , fileout );
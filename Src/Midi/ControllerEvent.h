@@ -21,7 +21,7 @@
 #include "Renderers/RenderAPI.h"
 #include <math.h>
 
-class wxFileOutputStream;
+class wxOutputStream;
 // forward
 namespace irr { namespace io {
     class IXMLBase;
@@ -68,6 +68,10 @@ namespace AriaMaestosa
         ControllerEvent(unsigned short controller, int tick, wxFloat64 value);
         virtual ~ControllerEvent() {}
         
+        /** Events are allocated from an ObjectPool, see ControllerEvent.cpp; subclasses use the global heap */
+        static void* operator new(size_t size);
+        static void  operator delete(void* event, size_t size);
+        
         unsigned short getController() const { return m_controller; }
         int            getTick      () const { return m_tick;       }
         
@@ -143,7 +147,7 @@ namespace AriaMaestosa
         }
         
         // ---- serialization
-        virtual void saveToFile(wxFileOutputStream& fileout);
+        virtual void saveToFile(wxOutputStream& fileout);
         virtual bool readFromFile(irr::io::IrrXMLReader* xml);
     };
     
@@ -172,7 +176,7 @@ namespace AriaMaestosa
         void setText(const wxString& t)         { m_text.getModel()->setValue( t ); }
         
         // ---- serialization
-        virtual void saveToFile(wxFileOutputStream& fileout);
+        virtual void saveToFile(wxOutputStream& fileout);
         virtual bool readFromFile(irr::io::IrrXMLReader* xml);
     };
     
@@ -20,7 +20,7 @@
 
 #include "Utils.h"
 
-class wxFileOutputStream;
+class wxOutputStream;
 // forward
 namespace irr { namespace io {
     class IXMLBase;
@@ -60,7 +60,7 @@ namespace AriaMaestosa
         void setDivider(const int newVal);
         
         // serialization
-        void saveToFile(wxFileOutputStream& fileout);
+        void saveToFile(wxOutputStream& fileout);
         bool readFromFile(irr::io::IrrXMLReader* xml);
     };
     
@@ -20,6 +20,7 @@
 #include "Midi/Note.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Sequence.h"
+#include "ObjectPool.h"
 #include "Utils.h"
 #include "UnitTest.h"
 
@@ -59,6 +60,27 @@ Note::~Note()
 
 // ----------------------------------------------------------------------------------------------------------
 
+namespace
+{
+    /** never deleted, notes may still be around while static objects are destroyed */
+    ObjectPool* g_note_pool = NULL;
+}
+
+void* Note::operator new(size_t size)
+{
+    if (g_note_pool == NULL) g_note_pool = new ObjectPool("Note", sizeof(Note));
+    return g_note_pool->allocate(size);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Note::operator delete(void* note, size_t size)
+{
+    g_note_pool->deallocate(note, size);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 int Note::getString()
 {
     if (string == -1) findStringAndFretFromNote();
@@ -254,7 +276,7 @@ void Note::setEndTick(const int ticks)
 #pragma mark Serialization
 #endif
 
-void Note::saveToFile(wxFileOutputStream& fileout)
+void Note::saveToFile(wxOutputStream& fileout)
 {
     writeData( wxT("  <note pitch=\"") + to_wxString(m_pitch_ID)  , fileout );
     writeData( wxT("\" start=\"")      + to_wxString(m_start_tick), fileout );
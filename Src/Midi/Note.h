@@ -20,7 +20,7 @@
 #include "Utils.h"
 #include <wx/intl.h>
 
-class wxFileOutputStream;
+class wxOutputStream;
 
 // forward
 namespace irr { namespace io {
@@ -132,6 +132,8 @@ namespace AriaMaestosa
       */
     class Note
     {
+        friend class NoteChangeRecord;
+        
         Track* m_track;
         
         bool   m_selected;
@@ -167,6 +169,10 @@ namespace AriaMaestosa
         Note(Track* parent, const int pitchID=-1, const int startTick=-1, const int endTick=-1, const int volume=-1, const int string=-1, const int fret=-1); // guitar mode only
         ~Note();
         
+        /** Notes are allocated from an ObjectPool, see Note.cpp */
+        static void* operator new(size_t size);
+        static void  operator delete(void* note, size_t size);
+        
         void setParent(Track* parent);
         Track* getParent() { return m_track; }
         
@@ -274,7 +280,7 @@ namespace AriaMaestosa
         }
         
         // serialization
-        void saveToFile(wxFileOutputStream& fileout);
+        void saveToFile(wxOutputStream& fileout);
         bool readFromFile(irr::io::IrrXMLReader* xml);
     };
     
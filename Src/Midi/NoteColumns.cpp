@@ -0,0 +1,104 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Midi/NoteColumns.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace AriaMaestosa;
+
+// ----------------------------------------------------------------------------------------------------------
+
+NoteColumns::NoteColumns()
+{
+    m_revision           = 0;
+    m_selection_revision = 0;
+    m_valid              = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteColumns::rebuild(const ptr_vector<Note>& notes, const ptr_vector<Note, REF>& noteOffs,
+                          const unsigned int revision)
+{
+    const int noteAmount = notes.size();
+    ASSERT_E(noteOffs.size(), ==, noteAmount);
+    
+    // when the same notes are still in the same order, the IDs (and maybe the note offs) can be kept
+    bool sameNotes = ((int)m_note_address.size() == noteAmount);
+    for (int n=0; sameNotes and n<noteAmount; n++)
+    {
+        if (m_note_address[n] != notes.getConst(n)) sameNotes = false;
+    }
+    
+    m_start_tick.resize(noteAmount);
+    m_end_tick.resize(noteAmount);
+    m_pitch.resize(noteAmount);
+    m_volume.resize(noteAmount);
+    m_flags.resize(noteAmount);
+    m_note_address.resize(noteAmount);
+    
+    for (int n=0; n<noteAmount; n++)
+    {
+        const Note& note = notes[n];
+        ASSERT_E(note.getPitchID(), <, 256);
+        ASSERT_E(note.getVolume(),  <, 256);
+        
+        m_start_tick[n]   = note.getTick();
+        m_end_tick[n]     = note.getEndTick();
+        m_pitch[n]        = note.getPitchID();
+        m_volume[n]       = note.getVolume();
+        m_flags[n]        = (note.isSelected() ? FLAG_SELECTED : 0);
+        m_note_address[n] = &note;
+    }
+    
+    bool sameNoteOffs = sameNotes;
+    for (int n=0; sameNoteOffs and n<noteAmount; n++)
+    {
+        if (m_note_address[m_note_off[n]] != noteOffs.getConst(n)) sameNoteOffs = false;
+    }
+    
+    if (not sameNoteOffs) mapNoteOffs(noteOffs);
+    
+    m_revision = revision;
+    m_valid    = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteColumns::mapNoteOffs(const ptr_vector<Note, REF>& noteOffs)
+{
+    const int noteAmount = m_note_address.size();
+    
+    // used to find the ID of each note off; sorted by address
+    std::vector< std::pair<const Note*, int> > ids(noteAmount);
+    for (int n=0; n<noteAmount; n++)
+    {
+        ids[n] = std::make_pair(m_note_address[n], n);
+    }
+    
+    std::sort(ids.begin(), ids.end());
+    
+    m_note_off.resize(noteAmount);
+    for (int n=0; n<noteAmount; n++)
+    {
+        std::vector< std::pair<const Note*, int> >::const_iterator it =
+            std::lower_bound(ids.begin(), ids.end(), std::make_pair(noteOffs.getConst(n), -1));
+        ASSERT(it != ids.end() and it->first == noteOffs.getConst(n));
+        m_note_off[n] = it->second;
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NOTE_COLUMNS_H__
+#define __NOTE_COLUMNS_H__
+
+#include "Midi/Note.h"
+#include "ptr_vector.h"
+#include "Utils.h"
+
+#include <vector>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief contiguous copy of the fields of a track's notes that hot loops need
+      *
+      * Notes are heap objects reached through a vector of pointers, so a loop over all notes of a
+      * track chases one pointer per note and pulls unrelated fields into the cache. This keeps the
+      * start tick, end tick, pitch, volume and selection state of every note in one array each,
+      * in the same order as the track's notes, so rendering and MIDI compilation can iterate them
+      * directly. The order in which notes end is kept too, as indices into these arrays.
+      *
+      * The Note objects remain the editable model (and the stable handles that actions and undo
+      * hold on to); like NoteIntervalIndex, this is a cache that the owner rebuilds whenever the
+      * notes change (see Track::getRevision). Most edits (moving, resizing, transposing, changing
+      * the volume) keep the same notes in the same order, in which case the rebuild only copies
+      * the fields again and keeps the note off order when it is unchanged.
+      *
+      * @ingroup midi
+      */
+    class NoteColumns
+    {
+        std::vector<int> m_start_tick;
+        std::vector<int> m_end_tick;
+        std::vector<unsigned char> m_pitch;
+        std::vector<unsigned char> m_volume;
+        std::vector<unsigned char> m_flags;
+        
+        /** m_note_off[n] is the ID of the n-th note to end */
+        std::vector<int> m_note_off;
+        
+        /** Address of the note each ID was built from, to tell whether the next rebuild can reuse the IDs */
+        std::vector<const Note*> m_note_address;
+        
+        /** Revision of the owner the columns were built for */
+        unsigned int m_revision;
+        
+        /** Changed every time the selection column is updated in place, see getSelectionRevision */
+        unsigned int m_selection_revision;
+        
+        bool m_valid;
+        
+        enum
+        {
+            FLAG_SELECTED = 1
+        };
+        
+        /** @brief find the ID of every note off from scratch, by looking up the address of each note */
+        void mapNoteOffs(const ptr_vector<Note, REF>& noteOffs);
+        
+    public:
+        LEAK_CHECK();
+        
+        NoteColumns();
+        
+        /** @brief forget the cached data, it will need to be rebuilt before being used again */
+        void invalidate() { m_valid = false; }
+        
+        /** @return whether the columns were built for the given revision of their owner */
+        bool isUpToDate(const unsigned int revision) const
+        {
+            return m_valid and m_revision == revision;
+        }
+        
+        /**
+          * @brief bring the columns up to date with the notes
+          * @param notes    The notes, sorted by start tick
+          * @param noteOffs The same notes, sorted by end tick
+          * @param revision The current revision of the owner of the notes
+          */
+        void rebuild(const ptr_vector<Note>& notes, const ptr_vector<Note, REF>& noteOffs,
+                     const unsigned int revision);
+        
+        /**
+          * @brief keep the selection column in sync without a rebuild
+          *
+          * Selecting notes is not an edit, so it does not change the revision of the track.
+          */
+        void setSelected(const int id, const bool selected)
+        {
+            m_selection_revision++;
+            if (selected) m_flags[id] |= FLAG_SELECTED;
+            else          m_flags[id] &= ~FLAG_SELECTED;
+        }
+        
+        /**
+          * @return a number that changes every time setSelected is called; together with the revision
+          *         of the owner, it tells whether the selection may have changed
+          */
+        unsigned int getSelectionRevision() const { return m_selection_revision; }
+        
+        int  size()                    const { return m_start_tick.size();  }
+        int  getStartTick(const int id) const { return m_start_tick[id];     }
+        int  getEndTick  (const int id) const { return m_end_tick[id];       }
+        int  getPitchID  (const int id) const { return m_pitch[id];          }
+        int  getVolume   (const int id) const { return m_volume[id];         }
+        bool isSelected  (const int id) const { return (m_flags[id] & FLAG_SELECTED) != 0; }
+        
+        /** @return the ID of the n-th note to end, to walk the notes in the order of their note off */
+        int getNoteOffID(const int n) const { return m_note_off[n]; }
+    };
+    
+}
+
+#endif
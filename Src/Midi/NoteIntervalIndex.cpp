@@ -0,0 +1,103 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Midi/NoteIntervalIndex.h"
+
+#include <algorithm>
+
+using namespace AriaMaestosa;
+
+// ----------------------------------------------------------------------------------------------------------
+
+NoteIntervalIndex::NoteIntervalIndex()
+{
+    m_leaf_amount = 1;
+    m_note_amount = 0;
+    m_revision    = 0;
+    m_valid       = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteIntervalIndex::rebuild(const ptr_vector<Note>& notes, const unsigned int revision)
+{
+    m_note_amount = notes.size();
+    
+    m_leaf_amount = 1;
+    while (m_leaf_amount < m_note_amount) m_leaf_amount *= 2;
+    
+    m_max_end.assign(m_leaf_amount*2, -1);
+    
+    for (int n=0; n<m_note_amount; n++)
+    {
+        ASSERT(n == 0 or notes[n-1].getTick() <= notes[n].getTick());
+        m_max_end[m_leaf_amount + n] = notes[n].getEndTick();
+    }
+    for (int node=m_leaf_amount-1; node>0; node--)
+    {
+        m_max_end[node] = std::max(m_max_end[node*2], m_max_end[node*2 + 1]);
+    }
+    
+    m_revision = revision;
+    m_valid    = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int NoteIntervalIndex::findFirstNoteEndingAfter(const int tick) const
+{
+    ASSERT(m_valid);
+    if (m_note_amount == 0 or m_max_end[1] <= tick) return m_note_amount;
+    
+    // go down the leftmost branch that still holds a note ending after 'tick'
+    int node = 1;
+    while (node < m_leaf_amount)
+    {
+        node *= 2;
+        if (m_max_end[node] <= tick) node++;
+    }
+    return node - m_leaf_amount;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteIntervalIndex::findNotesEndingAfter(const int tick, const int noteLimit, std::vector<int>& noteIDs) const
+{
+    ASSERT(m_valid);
+    ASSERT_E(noteLimit,<=,m_note_amount);
+    if (m_note_amount == 0) return;
+    
+    collectNotesEndingAfter(1, 0, m_leaf_amount, tick, noteLimit, noteIDs);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteIntervalIndex::collectNotesEndingAfter(const int node, const int firstNote, const int noteSpan,
+                                                const int tick, const int noteLimit,
+                                                std::vector<int>& noteIDs) const
+{
+    if (firstNote >= noteLimit or m_max_end[node] <= tick) return;
+    
+    if (node >= m_leaf_amount)
+    {
+        noteIDs.push_back(firstNote);
+        return;
+    }
+    
+    const int half = noteSpan/2;
+    collectNotesEndingAfter(node*2,     firstNote,        half, tick, noteLimit, noteIDs);
+    collectNotesEndingAfter(node*2 + 1, firstNote + half, half, tick, noteLimit, noteIDs);
+}
@@ -0,0 +1,103 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NOTE_INTERVAL_INDEX_H__
+#define __NOTE_INTERVAL_INDEX_H__
+
+#include "Midi/Note.h"
+#include "ptr_vector.h"
+#include "Utils.h"
+
+#include <vector>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief interval tree over the notes of a track
+      *
+      * The notes of a track are kept sorted by start tick, which makes it easy to binary-search
+      * where a note starts, but not which notes are still playing at a given tick (a long note
+      * that started early may still be sounding). This index is an implicit binary tree laid over
+      * the start-sorted note vector, where each node holds the highest end tick among the notes
+      * below it. Subtrees in which every note ends too early are skipped, so a query costs
+      * O(log n) per note it returns instead of a scan of all the notes that start before the range.
+      *
+      * The index is a cache only; the owner rebuilds it lazily, on the first query after the notes
+      * changed (see Track::getRevision).
+      *
+      * @ingroup midi
+      */
+    class NoteIntervalIndex
+    {
+        /** Amount of leaves of the tree; a power of two, at least the amount of notes */
+        int m_leaf_amount;
+        
+        int m_note_amount;
+        
+        /**
+          * Node 1 is the root, the children of node i are 2i and 2i+1, and leaf m_leaf_amount+n is
+          * note n. Each node holds the highest end tick among the notes below it (-1 for leaves past
+          * the last note).
+          */
+        std::vector<int> m_max_end;
+        
+        /** Revision of the owner the index was built for */
+        unsigned int m_revision;
+        
+        bool m_valid;
+        
+        void collectNotesEndingAfter(const int node, const int firstNote, const int noteSpan, const int tick,
+                                     const int noteLimit, std::vector<int>& noteIDs) const;
+        
+    public:
+        LEAK_CHECK();
+        
+        NoteIntervalIndex();
+        
+        /** @brief forget the indexed data, it will need to be rebuilt before being used again */
+        void invalidate() { m_valid = false; }
+        
+        /** @return whether the index was built for the given revision of its owner */
+        bool isUpToDate(const unsigned int revision) const
+        {
+            return m_valid and m_revision == revision;
+        }
+        
+        /**
+          * @brief build the index from scratch, in linear time
+          * @param notes    The notes to index; must be sorted by start tick
+          * @param revision The current revision of the owner of the notes
+          */
+        void rebuild(const ptr_vector<Note>& notes, const unsigned int revision);
+        
+        /**
+          * @return the ID of the first note (in start order) that ends after the given tick. All notes
+          *         before this ID end at or before 'tick'. Returns the amount of notes if no note ends
+          *         after 'tick'.
+          */
+        int findFirstNoteEndingAfter(const int tick) const;
+        
+        /**
+          * @brief find the notes, among the first 'noteLimit' ones, that end after the given tick
+          * @param[out] noteIDs Receives the IDs of the matching notes, in start order (appended)
+          */
+        void findNotesEndingAfter(const int tick, const int noteLimit, std::vector<int>& noteIDs) const;
+    };
+    
+}
+
+#endif
@@ -226,7 +226,7 @@ public:
     ExitCode Entry()
     {
         AriaSequenceTimer timer(g_sequence);
-        timer.run(jdksequencer, songLengthInTicks);
+        timer.run(jdksequencer, songLengthInTicks, m_start_tick);
 
         must_stop = true;
         cleanup_after_playback();
@@ -98,7 +98,7 @@ namespace AriaMaestosa
         ExitCode Entry()
         {
             AriaSequenceTimer timer(sequence);
-            timer.run(jdksequencer, songLengthInTicks);
+            timer.run(jdksequencer, songLengthInTicks, m_start_tick);
 
             playing = false;
             cleanup_after_playback();
@@ -3,6 +3,11 @@
 #include <cmath>
 #include <cstdio>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GBA_SYNTH_SSE2
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -100,20 +105,140 @@ static double noiseKeyToHz(int key)
     return noiseNR43ToHz(gNoiseTable[key]);
 }
 
-GBASynthEngine::GBASynthEngine() : m_sampleRate(13379), m_nextTriggerOrder(0), m_globalFrameCounter(0)
+GBASynthEngine::GBASynthEngine() : m_sampleRate(13379), m_nextTriggerOrder(0), m_globalFrameCounter(0),
+                                   m_generation(0), m_renderedFrames(0), m_droppedCommands(0),
+                                   m_blockRendering(true)
 {
-    reset();
+    applyReset();
 }
 
 void GBASynthEngine::setSampleRate(int rate)
 {
-    wxMutexLocker lock(m_mutex);
     m_sampleRate = rate;
 }
 
+// ---- Command queue ----
+
+void GBASynthEngine::sendCommand(const SynthCommand& cmd)
+{
+    wxMutexLocker lock(m_producerMutex);
+
+    SynthCommand stamped = cmd;
+    stamped.generation = m_generation.load(std::memory_order_relaxed);
+
+    SPSCQueue<SynthCommand, SYNTH_COMMAND_QUEUE_SIZE>& queue = (cmd.frame == 0 ? m_immediateCommands : m_commands);
+    if (!queue.push(stamped))
+    {
+        // Only report the first drop, the queue stays full while nothing is rendering
+        if (m_droppedCommands++ == 0)
+            fprintf(stderr, "[GBA Synth] Command queue full, dropping events\n");
+    }
+}
+
+void GBASynthEngine::flushScheduledCommands()
+{
+    // Under the producer lock, so that every command is stamped either before or after the flush
+    wxMutexLocker lock(m_producerMutex);
+    m_generation.fetch_add(1, std::memory_order_release);
+}
+
+void GBASynthEngine::applyCommand(const SynthCommand& cmd)
+{
+    switch (cmd.type)
+    {
+        case SynthCommand::NOTE_ON:
+            applyNoteOn(cmd.data1, cmd.data2, cmd.channel, cmd.voice, cmd.isRhythm);
+            break;
+        case SynthCommand::NOTE_OFF:
+            applyNoteOff(cmd.data1, cmd.channel);
+            break;
+        case SynthCommand::ALL_NOTES_OFF:
+            applyAllNotesOff(cmd.channel);
+            break;
+        case SynthCommand::CONTROL_CHANGE:
+            applyControlChange(cmd.data1, cmd.data2, cmd.channel);
+            break;
+        case SynthCommand::PITCH_BEND:
+            applyPitchBend(cmd.data1, cmd.channel);
+            break;
+        case SynthCommand::RESET:
+            applyReset();
+            break;
+    }
+}
+
 void GBASynthEngine::reset()
 {
-    wxMutexLocker lock(m_mutex);
+    SynthCommand cmd;
+    cmd.type = SynthCommand::RESET;
+    sendCommand(cmd);
+}
+
+void GBASynthEngine::noteOn(int note, int velocity, int channel, const GBAVoice* voice, bool isRhythm,
+                            uint64_t frame)
+{
+    if (!voice || voice->type == GBAVoice::EMPTY) return;
+    if (channel < 0 || channel > 15) return;
+
+    SynthCommand cmd;
+    cmd.type = SynthCommand::NOTE_ON;
+    cmd.channel = channel;
+    cmd.data1 = note;
+    cmd.data2 = velocity;
+    cmd.voice = voice;
+    cmd.isRhythm = isRhythm;
+    cmd.frame = frame;
+    sendCommand(cmd);
+}
+
+void GBASynthEngine::noteOff(int note, int channel, uint64_t frame)
+{
+    SynthCommand cmd;
+    cmd.type = SynthCommand::NOTE_OFF;
+    cmd.channel = channel;
+    cmd.data1 = note;
+    cmd.frame = frame;
+    sendCommand(cmd);
+}
+
+void GBASynthEngine::allNotesOff(int channel, uint64_t frame)
+{
+    SynthCommand cmd;
+    cmd.type = SynthCommand::ALL_NOTES_OFF;
+    cmd.channel = channel;
+    cmd.frame = frame;
+    sendCommand(cmd);
+}
+
+void GBASynthEngine::controlChange(int controller, int value, int channel, uint64_t frame)
+{
+    if (channel < 0 || channel > 15) return;
+
+    SynthCommand cmd;
+    cmd.type = SynthCommand::CONTROL_CHANGE;
+    cmd.channel = channel;
+    cmd.data1 = controller;
+    cmd.data2 = value;
+    cmd.frame = frame;
+    sendCommand(cmd);
+}
+
+void GBASynthEngine::pitchBend(int value, int channel, uint64_t frame)
+{
+    if (channel < 0 || channel > 15) return;
+
+    SynthCommand cmd;
+    cmd.type = SynthCommand::PITCH_BEND;
+    cmd.channel = channel;
+    cmd.data1 = value;
+    cmd.frame = frame;
+    sendCommand(cmd);
+}
+
+// ---- Audio thread ----
+
+void GBASynthEngine::applyReset()
+{
     for (int i = 0; i < MAX_ACTIVE_VOICES; i++)
     {
         m_voices[i].active = false;
@@ -197,13 +322,8 @@ int GBASynthEngine::findFreeVoice()
     return oldest;
 }
 
-void GBASynthEngine::noteOn(int note, int velocity, int channel, const GBAVoice* voice, bool isRhythm)
+void GBASynthEngine::applyNoteOn(int note, int velocity, int channel, const GBAVoice* voice, bool isRhythm)
 {
-    if (!voice || voice->type == GBAVoice::EMPTY) return;
-    if (channel < 0 || channel > 15) return;
-
-    wxMutexLocker lock(m_mutex);
-
     // Kill any existing voice playing this same note+channel (GBA re-trigger behavior)
     for (int i = 0; i < MAX_ACTIVE_VOICES; i++)
     {
@@ -328,9 +448,8 @@ void GBASynthEngine::noteOn(int note, int velocity, int channel, const GBAVoice*
         computeEnvelopeStep(v);
 }
 
-void GBASynthEngine::noteOff(int note, int channel)
+void GBASynthEngine::applyNoteOff(int note, int channel)
 {
-    wxMutexLocker lock(m_mutex);
     for (int i = 0; i < MAX_ACTIVE_VOICES; i++)
     {
         if (m_voices[i].active && m_voices[i].note == note && m_voices[i].channel == channel
@@ -346,9 +465,8 @@ void GBASynthEngine::noteOff(int note, int channel)
     }
 }
 
-void GBASynthEngine::allNotesOff(int channel)
+void GBASynthEngine::applyAllNotesOff(int channel)
 {
-    wxMutexLocker lock(m_mutex);
     for (int i = 0; i < MAX_ACTIVE_VOICES; i++)
     {
         if (m_voices[i].active && m_voices[i].channel == channel)
@@ -359,11 +477,8 @@ void GBASynthEngine::allNotesOff(int channel)
     }
 }
 
-void GBASynthEngine::controlChange(int controller, int value, int channel)
+void GBASynthEngine::applyControlChange(int controller, int value, int channel)
 {
-    if (channel < 0 || channel > 15) return;
-
-    wxMutexLocker lock(m_mutex);
     switch (controller)
     {
         case 1: // MOD — modulation depth
@@ -414,7 +529,7 @@ void GBASynthEngine::controlChange(int controller, int value, int channel)
             m_channelMod[channel].xcmdType = (uint8_t)value;
             break;
         case 123: // All notes off
-            allNotesOff(channel);
+            applyAllNotesOff(channel);
             break;
     }
 }
@@ -499,11 +614,8 @@ void GBASynthEngine::updateVoicePitch(ActiveVoice& v)
     }
 }
 
-void GBASynthEngine::pitchBend(int value, int channel)
+void GBASynthEngine::applyPitchBend(int value, int channel)
 {
-    if (channel < 0 || channel > 15) return;
-
-    wxMutexLocker lock(m_mutex);
     float semitones = ((float)value / 8192.0f) * (float)m_channelPitchBendRange[channel];
     m_channelPitchBend[channel] = semitones;
 
@@ -818,11 +930,345 @@ float GBASynthEngine::renderProgWave(ActiveVoice& v)
     return s0 + frac * (s1 - s0);
 }
 
-void GBASynthEngine::renderFrames(float* output, int frameCount)
+void GBASynthEngine::mixFrames(float* output, int frameCount)
 {
-    wxMutexLocker lock(m_mutex);
     memset(output, 0, frameCount * 2 * sizeof(float));
 
+    // Split the block at each command's frame, so commands take effect at the exact sample
+    const uint64_t blockStart = m_renderedFrames.load(std::memory_order_relaxed);
+    const uint64_t blockEnd = blockStart + frameCount;
+    int rendered = 0;
+
+    while (const SynthCommand* cmd = m_immediateCommands.front())
+    {
+        applyCommand(*cmd);
+        m_immediateCommands.pop();
+    }
+
+    const unsigned int generation = m_generation.load(std::memory_order_acquire);
+
+    while (rendered < frameCount)
+    {
+        const SynthCommand* cmd = m_commands.front();
+
+        // Sent before a flush. Commands stamped after 'generation' was read are newer, not older.
+        if (cmd && (int)(cmd->generation - generation) < 0)
+        {
+            m_commands.pop();
+            continue;
+        }
+
+        if (cmd && cmd->frame < blockEnd)
+        {
+            const int offset = (cmd->frame > blockStart) ? (int)(cmd->frame - blockStart) : 0;
+            if (offset > rendered)
+            {
+                renderSegment(output + rendered * 2, offset - rendered);
+                rendered = offset;
+            }
+            applyCommand(*cmd);
+            m_commands.pop();
+        }
+        else
+        {
+            renderSegment(output + rendered * 2, frameCount - rendered);
+            rendered = frameCount;
+        }
+    }
+
+    m_renderedFrames.store(blockEnd, std::memory_order_release);
+
+    // Master gain to prevent clipping
+    static const float MASTER_GAIN = 1.0f / 8.0f;
+    for (int f = 0; f < frameCount * 2; f++)
+        output[f] *= MASTER_GAIN;
+}
+
+void GBASynthEngine::renderFrames(float* output, int frameCount)
+{
+    mixFrames(output, frameCount);
+
+    for (int f = 0; f < frameCount * 2; f++)
+    {
+        if (output[f] > 1.0f) output[f] = 1.0f;
+        if (output[f] < -1.0f) output[f] = -1.0f;
+    }
+}
+
+// ---- Block rendering ----
+
+// Linearly interpolates PCM from a sample starting at pos, stopping before the interpolation
+// would get within one sample of the end (the caller wraps or stops the voice there).
+// Returns the number of frames written.
+static int interpolatePcmBlock(float* output, int frameCount, double& pos, double step,
+                               const int8_t* pcm, uint32_t numSamples)
+{
+    // Keep a one-sample margin so float rounding of the offsets below can never read past the end
+    const double limit = (double)numSamples - 2.0;
+    if (pos >= limit) return 0;
+
+    int count = frameCount;
+    if (step > 0.0)
+    {
+        const double remaining = ceil((limit - pos) / step);
+        if (remaining < count) count = (int)remaining;
+    }
+
+    // Offsets within one block are small enough for single precision
+    const double base = floor(pos);
+    const int8_t* src = pcm + (uint32_t)base;
+    const float start = (float)(pos - base);
+    const float fstep = (float)step;
+
+    int f = 0;
+#ifdef GBA_SYNTH_SSE2
+    const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 vstep = _mm_set1_ps(fstep);
+    const __m128 vstart = _mm_set1_ps(start);
+    for (; f + 4 <= count; f += 4)
+    {
+        const __m128 p = _mm_add_ps(vstart, _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)f), lanes), vstep));
+        const __m128i idx = _mm_cvttps_epi32(p);
+        const __m128 frac = _mm_sub_ps(p, _mm_cvtepi32_ps(idx));
+
+        int32_t at[4];
+        _mm_storeu_si128((__m128i*)at, idx);
+        const __m128 s0 = _mm_setr_ps(src[at[0]], src[at[1]], src[at[2]], src[at[3]]);
+        const __m128 s1 = _mm_setr_ps(src[at[0] + 1], src[at[1] + 1], src[at[2] + 1], src[at[3] + 1]);
+
+        const __m128 out = _mm_add_ps(s0, _mm_mul_ps(frac, _mm_sub_ps(s1, s0)));
+        _mm_storeu_ps(output + f, _mm_mul_ps(out, scale));
+    }
+#endif
+    for (; f < count; f++)
+    {
+        const float p = start + (float)f * fstep;
+        const int idx = (int)p;
+        const float frac = p - (float)idx;
+        const float s0 = (float)src[idx];
+        const float s1 = (float)src[idx + 1];
+        output[f] = (s0 + frac * (s1 - s0)) * (1.0f / 128.0f);
+    }
+
+    pos += count * step;
+    return count;
+}
+
+// Generates a +/-0.5 square wave; phase is kept reduced to [0, 1)
+static void squareWaveBlock(float* output, int frameCount, double& phase, double phaseInc,
+                            float threshold)
+{
+    const double start = phase - floor(phase);
+    const float fstart = (float)start;
+    const float finc = (float)phaseInc;
+
+    int f = 0;
+#ifdef GBA_SYNTH_SSE2
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 vinc = _mm_set1_ps(finc);
+    const __m128 vstart = _mm_set1_ps(fstart);
+    const __m128 vthreshold = _mm_set1_ps(threshold);
+    const __m128 high = _mm_set1_ps(0.5f);
+    const __m128 low = _mm_set1_ps(-0.5f);
+    for (; f + 4 <= frameCount; f += 4)
+    {
+        const __m128 p = _mm_add_ps(vstart, _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)f), lanes), vinc));
+        const __m128 frac = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+        const __m128 mask = _mm_cmplt_ps(frac, vthreshold);
+        _mm_storeu_ps(output + f, _mm_or_ps(_mm_and_ps(mask, high), _mm_andnot_ps(mask, low)));
+    }
+#endif
+    for (; f < frameCount; f++)
+    {
+        const float p = fstart + (float)f * finc;
+        const float frac = p - (float)(int)p;
+        output[f] = (frac < threshold) ? 0.5f : -0.5f;
+    }
+
+    phase = start + frameCount * phaseInc;
+}
+
+// Adds a mono block to an interleaved stereo buffer
+static void mixBlock(float* output, const float* input, int frameCount, float gainL, float gainR)
+{
+    int f = 0;
+#ifdef GBA_SYNTH_SSE2
+    const __m128 gains = _mm_setr_ps(gainL, gainR, gainL, gainR);
+    for (; f + 4 <= frameCount; f += 4)
+    {
+        const __m128 in = _mm_loadu_ps(input + f);
+        float* out = output + f * 2;
+        const __m128 first = _mm_mul_ps(_mm_unpacklo_ps(in, in), gains);
+        const __m128 second = _mm_mul_ps(_mm_unpackhi_ps(in, in), gains);
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), first));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), second));
+    }
+#endif
+    for (; f < frameCount; f++)
+    {
+        output[f * 2 + 0] += input[f] * gainL;
+        output[f * 2 + 1] += input[f] * gainR;
+    }
+}
+
+// Renders frameCount mono samples of one voice; samples after the voice ends are silent
+void GBASynthEngine::renderVoiceBlock(ActiveVoice& v, float* output, int frameCount)
+{
+    static const float dutyThresholds[4] = { 0.125f, 0.25f, 0.5f, 0.75f };
+
+    int f = 0;
+    switch (v.voice->type)
+    {
+        case GBAVoice::DIRECT_SOUND:
+        {
+            const GBASample* smp = v.voice->sample;
+            if (!smp || smp->pcmData.empty()) break;
+
+            // Vectorized runs, with single scalar steps where the sample loops or ends
+            while (f < frameCount && v.active)
+            {
+                f += interpolatePcmBlock(output + f, frameCount - f, v.samplePos, v.sampleStep,
+                                         &smp->pcmData[0], (uint32_t)smp->pcmData.size());
+                if (f < frameCount)
+                    output[f++] = renderDirectSound(v);
+            }
+            break;
+        }
+        case GBAVoice::SQUARE_1:
+        case GBAVoice::SQUARE_2:
+        {
+            int duty = v.voice->dutyCycle;
+            if (duty < 0) duty = 0;
+            if (duty > 3) duty = 3;
+            squareWaveBlock(output, frameCount, v.squarePhase, v.squarePhaseInc, dutyThresholds[duty]);
+            f = frameCount;
+            break;
+        }
+        case GBAVoice::NOISE:
+            // The LFSR is inherently serial
+            for (; f < frameCount; f++)
+                output[f] = renderNoise(v);
+            break;
+        case GBAVoice::PROG_WAVE:
+            for (; f < frameCount; f++)
+                output[f] = renderProgWave(v);
+            break;
+        default:
+            break;
+    }
+
+    if (f < frameCount)
+        memset(output + f, 0, (frameCount - f) * sizeof(float));
+}
+
+void GBASynthEngine::renderSegment(float* output, int frameCount)
+{
+    if (!m_blockRendering)
+    {
+        renderSegmentPerSample(output, frameCount);
+        return;
+    }
+
+    static const double FRAME_INTERVAL = 1.0 / 59.7275; // GBA VBlank period in seconds
+    double samplesPerFrame = (double)m_sampleRate * FRAME_INTERVAL;
+
+    // Cache previous modM values per channel to detect LFO changes
+    int8_t prevModM[16];
+    for (int ch = 0; ch < 16; ch++)
+        prevModM[ch] = m_channelMod[ch].modM;
+
+    int f = 0;
+    while (f < frameCount)
+    {
+        // Check if we've crossed a ~60Hz frame boundary
+        m_globalFrameCounter += 1.0;
+        if (m_globalFrameCounter >= samplesPerFrame)
+        {
+            m_globalFrameCounter -= samplesPerFrame;
+
+            // Update LFO for all 16 channels
+            for (int ch = 0; ch < 16; ch++)
+            {
+                prevModM[ch] = m_channelMod[ch].modM;
+                updateLFO(ch);
+            }
+
+            // Envelope step + pitch update for all active voices
+            for (int i = 0; i < MAX_ACTIVE_VOICES; i++)
+            {
+                ActiveVoice& v = m_voices[i];
+                if (!v.active) continue;
+                computeEnvelopeStep(v);
+                if (!v.active) continue;
+                // If vibrato (modT==0) and modM changed, recalculate pitch
+                if (m_channelMod[v.channel].modT == 0 &&
+                    m_channelMod[v.channel].modM != prevModM[v.channel])
+                {
+                    updateVoicePitch(v);
+                }
+            }
+        }
+
+        // Envelopes, LFOs and pitch only change on frame boundaries (and commands split the
+        // segment), so gain and pan are constant until the next boundary: render up to it as one block
+        int blockSize = (int)ceil(samplesPerFrame - m_globalFrameCounter);
+        if (blockSize < 1) blockSize = 1;
+        if (blockSize > frameCount - f) blockSize = frameCount - f;
+        if (blockSize > VOICE_BLOCK_SIZE) blockSize = VOICE_BLOCK_SIZE;
+        m_globalFrameCounter += blockSize - 1;
+
+        for (int i = 0; i < MAX_ACTIVE_VOICES; i++)
+        {
+            ActiveVoice& v = m_voices[i];
+            if (!v.active) continue;
+
+            float envMax = v.isCgbVoice ? 15.0f : 255.0f;
+            float envGain = (float)v.envelopeVolume / envMax;
+            float velocityScale = (float)v.velocity / 127.0f;
+            float channelVol = m_channelVolume[v.channel];
+
+            float gain = envGain * velocityScale;
+
+            // Apply tremolo (modT==1): volume modulation
+            const ChannelModState& mod = m_channelMod[v.channel];
+            if (mod.modT == 1 && mod.modM != 0)
+            {
+                // m4a.c: x = (vol * volX) >> 5; x = (x * (modM + 128)) >> 7
+                // We apply as a multiplier to the combined gain
+                float tremoloMul = (float)((int)mod.modM + 128) / 128.0f;
+                gain *= tremoloMul;
+            }
+
+            gain *= channelVol;
+
+            // Apply auto-pan (modT==2): pan offset by modM
+            float panL = v.panL;
+            float panR = v.panR;
+            if (mod.modT == 2 && mod.modM != 0)
+            {
+                // m4a.c: y = 2*pan + panX + modM, clamped to -128..127
+                // We shift the existing pan position by modM/128
+                float panShift = (float)mod.modM / 128.0f;
+                float basePan = atan2f(panR, panL) / ((float)M_PI * 0.5f);
+                float newPan = basePan + panShift * 0.5f;
+                if (newPan < 0.0f) newPan = 0.0f;
+                if (newPan > 1.0f) newPan = 1.0f;
+                panL = cosf(newPan * (float)M_PI * 0.5f);
+                panR = sinf(newPan * (float)M_PI * 0.5f);
+            }
+
+            renderVoiceBlock(v, m_voiceBlock, blockSize);
+            mixBlock(output + f * 2, m_voiceBlock, blockSize, gain * panL, gain * panR);
+        }
+
+        f += blockSize;
+    }
+}
+
+// Renders one sample at a time, as before voices were rendered in blocks; see setBlockRendering
+void GBASynthEngine::renderSegmentPerSample(float* output, int frameCount)
+{
     static const double FRAME_INTERVAL = 1.0 / 59.7275; // GBA VBlank period in seconds
     double samplesPerFrame = (double)m_sampleRate * FRAME_INTERVAL;
 
@@ -929,15 +1375,6 @@ void GBASynthEngine::renderFrames(float* output, int frameCount)
             output[f * 2 + 1] += gain * panR;
         }
     }
-
-    // Master gain to prevent clipping
-    static const float MASTER_GAIN = 1.0f / 8.0f;
-    for (int f = 0; f < frameCount * 2; f++)
-    {
-        output[f] *= MASTER_GAIN;
-        if (output[f] > 1.0f) output[f] = 1.0f;
-        if (output[f] < -1.0f) output[f] = -1.0f;
-    }
 }
 
 }
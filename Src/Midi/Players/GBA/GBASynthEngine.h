@@ -2,6 +2,8 @@
 #define __GBA_SYNTH_ENGINE_H__
 
 #include "Midi/Players/GBA/VoicegroupParser.h"
+#include "Midi/Players/GBA/SPSCQueue.h"
+#include <atomic>
 #include <cstdint>
 #include <cmath>
 #include <wx/thread.h>
@@ -11,6 +13,9 @@ namespace AriaMaestosa
 
 static const int MAX_ACTIVE_VOICES = 24;
 
+// Voices are rendered this many samples at a time into a scratch buffer before being mixed
+static const int VOICE_BLOCK_SIZE = 256;
+
 struct ChannelModState
 {
     uint8_t mod;           // CC1: modulation depth
@@ -89,6 +94,29 @@ struct ActiveVoice
                     pseudoEchoVol(0), pseudoEchoLen(0), triggerOrder(0) {}
 };
 
+// A timestamped request sent to the engine; applied by renderFrames on the audio thread
+struct SynthCommand
+{
+    enum Type { NOTE_ON, NOTE_OFF, ALL_NOTES_OFF, CONTROL_CHANGE, PITCH_BEND, RESET };
+    Type type;
+    int channel;
+    int data1;            // note, controller or pitch bend value
+    int data2;            // velocity or controller value
+    const GBAVoice* voice;
+    bool isRhythm;
+    // Engine frame (see GBASynthEngine::getRenderedFrames) at which the command takes effect.
+    // Commands stamped in the past are applied at the start of the next rendered block; frame 0
+    // means "as soon as possible" (previews, resets) and bypasses the scheduled commands.
+    uint64_t frame;
+    // Set by GBASynthEngine::sendCommand, see GBASynthEngine::flushScheduledCommands
+    unsigned int generation;
+
+    SynthCommand() : type(NOTE_OFF), channel(0), data1(0), data2(0), voice(NULL),
+                     isRhythm(false), frame(0), generation(0) {}
+};
+
+static const unsigned int SYNTH_COMMAND_QUEUE_SIZE = 4096;
+
 class GBASynthEngine
 {
     ActiveVoice m_voices[MAX_ACTIVE_VOICES];
@@ -100,7 +128,33 @@ class GBASynthEngine
     int m_sampleRate;
     int m_nextTriggerOrder;
     double m_globalFrameCounter;
-    wxMutex m_mutex;
+
+    // Commands flow from the sequencer/GUI threads to the audio thread without locking the
+    // audio thread. Several threads may send commands, so producers serialize among themselves.
+    // Commands for frame 0 have a queue of their own, so that a preview never waits behind
+    // commands the sequencer scheduled for a later frame.
+    SPSCQueue<SynthCommand, SYNTH_COMMAND_QUEUE_SIZE> m_commands;
+    SPSCQueue<SynthCommand, SYNTH_COMMAND_QUEUE_SIZE> m_immediateCommands;
+    wxMutex m_producerMutex;
+    // Scheduled commands sent before the last flushScheduledCommands call are dropped
+    std::atomic<unsigned int> m_generation;
+    std::atomic<uint64_t> m_renderedFrames;
+    std::atomic<int> m_droppedCommands;
+    bool m_blockRendering;
+
+    // Mono scratch buffer one voice is rendered into before being panned into the mix
+    float m_voiceBlock[VOICE_BLOCK_SIZE];
+
+    void applyCommand(const SynthCommand& cmd);
+    void applyNoteOn(int note, int velocity, int channel, const GBAVoice* voice, bool isRhythm);
+    void applyNoteOff(int note, int channel);
+    void applyAllNotesOff(int channel);
+    void applyControlChange(int controller, int value, int channel);
+    void applyPitchBend(int value, int channel);
+    void applyReset();
+    void renderSegment(float* output, int frameCount);
+    void renderSegmentPerSample(float* output, int frameCount);
+    void renderVoiceBlock(ActiveVoice& v, float* output, int frameCount);
 
     int findFreeVoice();
     void computeEnvelopeStep(ActiveVoice& v);
@@ -114,17 +168,49 @@ class GBASynthEngine
 public:
     GBASynthEngine();
 
-    void noteOn(int note, int velocity, int channel, const GBAVoice* voice, bool isRhythm = false);
-    void noteOff(int note, int channel);
-    void allNotesOff(int channel);
-    void controlChange(int controller, int value, int channel);
-    void pitchBend(int value, int channel);
-
+    // These may be called from any thread; they are queued and take effect during the next
+    // renderFrames call (at the given frame, if it falls inside the rendered block)
+    void noteOn(int note, int velocity, int channel, const GBAVoice* voice, bool isRhythm = false,
+                uint64_t frame = 0);
+    void noteOff(int note, int channel, uint64_t frame = 0);
+    void allNotesOff(int channel, uint64_t frame = 0);
+    void controlChange(int controller, int value, int channel, uint64_t frame = 0);
+    void pitchBend(int value, int channel, uint64_t frame = 0);
+    void sendCommand(const SynthCommand& cmd);
+
+    // Drops the commands scheduled so far that were not applied yet (e.g. when playback stops).
+    // Commands sent afterwards, including immediate ones, are not affected.
+    void flushScheduledCommands();
+
+    // Called from the audio thread only; never blocks
     void renderFrames(float* output, int frameCount);
 
+    // Same as renderFrames, but without clipping, so that the output of several engines
+    // (e.g. one per channel during export) can be summed and clipped afterwards
+    void mixFrames(float* output, int frameCount);
+
+    // Only call while no audio is being rendered (e.g. with the audio device stopped)
     void setSampleRate(int rate);
     int getSampleRate() const { return m_sampleRate; }
 
+    // When disabled, voices are rendered with the original per-sample renderer, which computes
+    // gain and pan for every sample and does not use the vectorized kernels. Only meant as a
+    // reference to check and time the block renderer against (see GBASynthBenchmark); same
+    // threading rule as setSampleRate.
+    void setBlockRendering(bool enabled) { m_blockRendering = enabled; }
+
+    // Frame offset of a time (relative to some reference frame), at the current sample rate
+    uint64_t framesForMillis(double millis) const
+    {
+        return millis <= 0.0 ? 0 : (uint64_t)(millis * m_sampleRate / 1000.0 + 0.5);
+    }
+
+    // Number of frames rendered since the engine was created
+    uint64_t getRenderedFrames() const { return m_renderedFrames.load(std::memory_order_acquire); }
+
+    // Number of commands lost because the queue was full
+    int getDroppedCommandCount() const { return m_droppedCommands.load(); }
+
     void reset();
 };
 
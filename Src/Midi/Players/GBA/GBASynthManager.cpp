@@ -1,8 +1,12 @@
 #include "Midi/Players/GBA/GBASynthManager.h"
+#include "AriaCore.h"
+#include "GUI/MainFrame.h"
+#include "IO/WavWriter.h"
 #include "Midi/CommonMidiUtils.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Players/Sequencer.h"
 #include "Midi/Sequence.h"
+#include "Midi/TempoMap.h"
 #include "PreferencesData.h"
 
 #include "jdksmidi/world.h"
@@ -15,14 +19,17 @@
 #include <wx/intl.h>
 #include <wx/filename.h>
 #include <wx/textfile.h>
+#include <wx/wx.h>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "Midi/Players/GBA/miniaudio.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
-#include <fstream>
+#include <vector>
 
 namespace AriaMaestosa
 {
@@ -31,6 +38,9 @@ static ma_device g_audio_device;
 static bool g_device_initialized = false;
 static GBASynthEngine* g_callback_engine = NULL;
 
+// How far ahead of the audio thread live events are scheduled; must exceed the device period
+static const double LIVE_LOOKAHEAD_MS = 30.0;
+
 static void audioCallback(ma_device* pDevice, void* pOutput, const void* /*pInput*/, ma_uint32 frameCount)
 {
     (void)pDevice;
@@ -97,7 +107,7 @@ public:
     ExitCode Entry()
     {
         AriaSequenceTimer timer(m_sequence);
-        timer.run(m_jdksequencer, m_songLengthInTicks);
+        timer.run(m_jdksequencer, m_songLengthInTicks, m_startTick);
         // Only call stop() if the song ended naturally (not already stopped by user).
         // If user pressed stop and then started new playback, m_threadShouldContinue
         // is now true for the NEW playback — but we waited for this thread to finish
@@ -109,12 +119,192 @@ public:
     }
 };
 
+// ---- Offline export ----
+
+// Export renders this many frames of every channel at a time, then mixes them and writes them out
+static const int EXPORT_BLOCK_FRAMES = 16384;
+// Granularity at which events are queued into the channel engines during export
+static const int EXPORT_CHUNK_FRAMES = 512;
+
+// One MIDI channel of an export, rendered by its own engine (and thus its own voice pool)
+class ChannelExportJob
+{
+    GBASynthEngine m_engine;
+    std::vector<SynthCommand> m_commands; // in frame order
+    size_t m_nextCommand;
+    std::vector<float> m_block;
+
+public:
+    ChannelExportJob(int sampleRate) : m_nextCommand(0), m_block(EXPORT_BLOCK_FRAMES * 2, 0.0f)
+    {
+        m_engine.setSampleRate(sampleRate);
+        m_engine.reset();
+    }
+
+    void addCommand(const SynthCommand& cmd)
+    {
+        m_commands.push_back(cmd);
+    }
+
+    // Renders the next frameCount frames of this channel, unclipped, into getBlock()
+    void renderBlock(int frameCount)
+    {
+        int rendered = 0;
+        while (rendered < frameCount)
+        {
+            const int chunkSize = std::min(EXPORT_CHUNK_FRAMES, frameCount - rendered);
+            const uint64_t chunkEnd = m_engine.getRenderedFrames() + chunkSize;
+
+            // Queue the events starting within this chunk; the engine splits the chunk at each one
+            while (m_nextCommand < m_commands.size() && m_commands[m_nextCommand].frame < chunkEnd)
+                m_engine.sendCommand(m_commands[m_nextCommand++]);
+
+            m_engine.mixFrames(&m_block[rendered * 2], chunkSize);
+            rendered += chunkSize;
+        }
+    }
+
+    const float* getBlock() const { return &m_block[0]; }
+};
+
+// Renders the channel jobs of each export block in parallel. The calling thread renders jobs
+// too, so a pool without worker threads simply renders everything serially.
+class ExportWorkerPool
+{
+    class Worker : public wxThread
+    {
+        ExportWorkerPool* m_pool;
+
+    public:
+        Worker(ExportWorkerPool* pool) : wxThread(wxTHREAD_JOINABLE), m_pool(pool)
+        {
+        }
+
+        ExitCode Entry()
+        {
+            while (true)
+            {
+                m_pool->m_blockReady.Wait();
+                if (m_pool->m_quit) return 0;
+                m_pool->renderJobs();
+                m_pool->m_blockDone.Post();
+            }
+        }
+    };
+
+    std::vector<ChannelExportJob*>& m_jobs;
+    std::vector<Worker*> m_workers;
+    wxSemaphore m_blockReady;
+    wxSemaphore m_blockDone;
+    std::atomic<int> m_nextJob;
+    std::atomic<bool> m_quit;
+    int m_blockFrames;
+
+    void renderJobs()
+    {
+        int job;
+        while ((job = m_nextJob++) < (int)m_jobs.size())
+            m_jobs[job]->renderBlock(m_blockFrames);
+    }
+
+public:
+    ExportWorkerPool(std::vector<ChannelExportJob*>& jobs, int threadCount)
+        : m_jobs(jobs), m_nextJob(0), m_quit(false), m_blockFrames(0)
+    {
+        for (int n = 0; n < threadCount; n++)
+        {
+            Worker* worker = new Worker(this);
+            if (worker->Create() != wxTHREAD_NO_ERROR)
+            {
+                delete worker;
+                break;
+            }
+            worker->Run();
+            m_workers.push_back(worker);
+        }
+    }
+
+    ~ExportWorkerPool()
+    {
+        m_quit = true;
+        for (size_t n = 0; n < m_workers.size(); n++)
+            m_blockReady.Post();
+        for (size_t n = 0; n < m_workers.size(); n++)
+        {
+            m_workers[n]->Wait();
+            delete m_workers[n];
+        }
+    }
+
+    // Returns once every job has rendered frameCount more frames
+    void renderBlock(int frameCount)
+    {
+        m_blockFrames = frameCount;
+        m_nextJob = 0;
+        for (size_t n = 0; n < m_workers.size(); n++)
+            m_blockReady.Post();
+        renderJobs();
+        for (size_t n = 0; n < m_workers.size(); n++)
+            m_blockDone.Wait();
+    }
+};
+
+// ---- Export settings ----
+
+class GBAExportDialog : public wxDialog
+{
+    wxRadioBox* m_formatBox;
+    wxCheckBox* m_ditherBox;
+
+public:
+    GBAExportDialog(wxWindow* parent)
+        : wxDialog(parent, wxID_ANY, _("Settings"), wxDefaultPosition, wxSize(360, 220),
+                   wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER | wxCLOSE_BOX)
+    {
+        PreferencesData* prefs = PreferencesData::getInstance();
+
+        wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
+
+        // Same order as WavWriter::SampleFormat
+        wxArrayString choices;
+        choices.Add(_("16-bit PCM"));
+        choices.Add(_("24-bit PCM"));
+        choices.Add(_("32-bit float"));
+        m_formatBox = new wxRadioBox(this, wxID_ANY, _("WAV format"), wxDefaultPosition,
+                                     wxDefaultSize, choices, 1, wxRA_SPECIFY_COLS);
+        const long format = prefs->getIntValue(SETTING_ID_AUDIO_EXPORT_FORMAT);
+        m_formatBox->SetSelection((format >= 0 && format < (long)choices.size()) ? (int)format : 0);
+        sizer->Add(m_formatBox, 0, wxEXPAND | wxALL, 5);
+
+        m_ditherBox = new wxCheckBox(this, wxID_ANY, _("Dither (PCM formats)"));
+        m_ditherBox->SetValue(prefs->getBoolValue(SETTING_ID_AUDIO_EXPORT_DITHER, false));
+        sizer->Add(m_ditherBox, 0, wxALL, 5);
+
+        sizer->AddStretchSpacer();
+
+        wxStdDialogButtonSizer* buttons = new wxStdDialogButtonSizer();
+        buttons->AddButton(new wxButton(this, wxID_OK, _("OK")));
+        buttons->AddButton(new wxButton(this, wxID_CANCEL, _("Cancel")));
+        buttons->Realize();
+        sizer->Add(buttons, 0, wxALL | wxEXPAND, 5);
+        SetSizer(sizer);
+    }
+
+    void saveChoices()
+    {
+        PreferencesData* prefs = PreferencesData::getInstance();
+        prefs->setValue(SETTING_ID_AUDIO_EXPORT_FORMAT, wxString::Format(wxT("%i"), m_formatBox->GetSelection()));
+        prefs->setValue(SETTING_ID_AUDIO_EXPORT_DITHER, m_ditherBox->GetValue() ? wxT("1") : wxT("0"));
+    }
+};
+
 // ---- GBASynthManager implementation ----
 
 GBASynthManager::GBASynthManager()
     : m_parser(NULL), m_voicegroupNum(-1), m_playing(false),
       m_threadShouldContinue(false), m_threadRunning(false),
       m_currentTick(0), m_accurateTick(0),
+      m_frameAnchor(0), m_frameAnchorPending(true), m_eventFrame(0),
       m_sequence(NULL)
 {
     for (int i = 0; i < 16; i++) m_channelProgram[i] = 0;
@@ -213,14 +403,19 @@ void GBASynthManager::reloadVoicegroup(int voicegroupNum)
 
 void GBASynthManager::setSampleRate(int rate)
 {
-    m_engine.setSampleRate(rate);
-
-    if (g_device_initialized)
+    if (!g_device_initialized)
     {
+        m_engine.setSampleRate(rate);
+    }
+    else
+    {
+        // The engine may only be reconfigured while the audio callback isn't running
         ma_device_stop(&g_audio_device);
         ma_device_uninit(&g_audio_device);
         g_device_initialized = false;
 
+        m_engine.setSampleRate(rate);
+
         g_callback_engine = &m_engine;
 
         ma_device_config config = ma_device_config_init(ma_device_type_playback);
@@ -258,6 +453,7 @@ bool GBASynthManager::playSequence(Sequence* sequence, int* startTick)
 
     m_engine.reset();
     for (int i = 0; i < 16; i++) m_channelProgram[i] = 0;
+    resetLiveSchedule();
     m_sequence = sequence;
     m_playing = true;
     m_threadShouldContinue = true;
@@ -340,6 +536,7 @@ bool GBASynthManager::playSelected(Sequence* sequence, int* startTick)
 
     m_engine.reset();
     for (int i = 0; i < 16; i++) m_channelProgram[i] = 0;
+    resetLiveSchedule();
     m_sequence = sequence;
     m_playing = true;
     m_threadShouldContinue = true;
@@ -361,6 +558,7 @@ void GBASynthManager::stop()
 {
     m_threadShouldContinue = false;
     m_playing = false;
+    m_engine.flushScheduledCommands();
     m_engine.reset();
 }
 
@@ -397,11 +595,13 @@ void GBASynthManager::stopNote()
 
 void GBASynthManager::exportAudioFile(Sequence* sequence, wxString filepath)
 {
-    // Offline render: run sequencer in accelerated mode and write WAV
+    // Offline render: each MIDI channel is rendered by its own engine on a worker pool, and the
+    // mix is written to the WAV file block by block
     int exportRate = m_engine.getSampleRate();
-    GBASynthEngine offlineEngine;
-    offlineEngine.setSampleRate(exportRate);
-    offlineEngine.reset();
+
+    // Events left from live playback must not play once the live engine is reattached
+    m_engine.flushScheduledCommands();
+    m_engine.reset();
 
     // Save/restore voicegroup state
     GBASynthEngine* prevEngine = g_callback_engine;
@@ -414,17 +614,20 @@ void GBASynthManager::exportAudioFile(Sequence* sequence, wxString filepath)
     jdksmidi::MIDISequencer jdksequencer(&jdkmidiseq);
     jdksequencer.GoToTimeMs(0);
 
-    int bpm = sequence->getTempo();
-    int beatlen = sequence->ticksPerQuarterNote();
-    double ticksPerMs = (double)bpm * (double)beatlen / 60000.0;
+    // Sequencer ticks are relative to startTick; convert them to time with the song's tempo map
+    const std::shared_ptr<const TempoMap> publishedTempoMap = sequence->getPublishedTempoMap();
+    const TempoMap& tempoMap = *publishedTempoMap;
+    const int originTick = std::max(0, startTick);
+    const double startMs = tempoMap.tickToMillis(originTick);
 
     // Calculate total duration in samples
-    double totalMs = (double)songLengthInTicks / ticksPerMs;
+    double totalMs = tempoMap.tickToMillis(originTick + songLengthInTicks) - startMs;
     int totalSamples = (int)(totalMs / 1000.0 * exportRate) + exportRate; // +1 sec padding
 
-    // Render in chunks
-    std::vector<float> buffer(totalSamples * 2, 0.0f);
-    int samplesRendered = 0;
+    // Sort the events by channel, stamped with their exact frame (same tick->frame mapping as
+    // live playback, see seq_notify_event_time)
+    ChannelExportJob* channelJobs[16];
+    for (int i = 0; i < 16; i++) channelJobs[i] = NULL;
 
     jdksmidi::MIDITimedBigMessage ev;
     int evTrack;
@@ -433,121 +636,120 @@ void GBASynthManager::exportAudioFile(Sequence* sequence, wxString filepath)
     int exportProgram[16];
     for (int i = 0; i < 16; i++) exportProgram[i] = 0;
 
-    // Track cumulative time for correct tempo-change handling
-    double cumulativeMs = 0.0;
-    double lastEventTick = 0.0;
-
-    if (jdksequencer.GetNextEventTime(&tick))
+    while (jdksequencer.GetNextEventTime(&tick))
     {
-        double nextEventMs = (double)tick / ticksPerMs;
-        double currentMs = 0.0;
+        const uint64_t frame = m_engine.framesForMillis(tempoMap.tickToMillis(originTick + (double)tick) - startMs);
+        if (frame >= (uint64_t)totalSamples) break;
+        if (!jdksequencer.GetNextEvent(&evTrack, &ev)) break;
 
-        while (samplesRendered < totalSamples)
-        {
-            // Process events up to current time
-            while (nextEventMs <= currentMs)
-            {
-                if (!jdksequencer.GetNextEvent(&evTrack, &ev)) break;
+        SynthCommand cmd;
+        cmd.channel = ev.GetChannel();
+        cmd.frame = frame;
 
-                int channel = ev.GetChannel();
-                if (ev.IsNoteOn())
-                {
-                    int note = ev.GetNote();
-                    bool isRhythm = false;
-                    int prog = exportProgram[channel];
-                    if (prog >= 0 && prog < (int)m_voicegroup.voices.size())
-                        isRhythm = (m_voicegroup.voices[prog].type == GBAVoice::KEYSPLIT_ALL);
-                    const GBAVoice* voice = resolveVoice(prog, note);
-                    if (voice) offlineEngine.noteOn(note, ev.GetVelocity(), channel, voice, isRhythm);
-                }
-                else if (ev.IsNoteOff())
-                {
-                    offlineEngine.noteOff(ev.GetNote(), channel);
-                }
-                else if (ev.IsControlChange())
-                {
-                    offlineEngine.controlChange(ev.GetController(), ev.GetControllerValue(), channel);
-                }
-                else if (ev.IsPitchBend())
-                {
-                    offlineEngine.pitchBend(ev.GetBenderValue(), channel);
-                }
-                else if (ev.IsProgramChange())
-                {
-                    exportProgram[channel] = ev.GetPGValue();
-                }
-                else if (ev.IsTempo())
-                {
-                    int eventBpm = ev.GetTempo32() / 32;
-                    // Accumulate time at old tempo before switching
-                    double evTick = ev.GetTime();
-                    cumulativeMs += (evTick - lastEventTick) / ticksPerMs;
-                    lastEventTick = evTick;
-                    ticksPerMs = (double)eventBpm * (double)beatlen / 60000.0;
-                }
+        if (ev.IsNoteOn())
+        {
+            int note = ev.GetNote();
+            bool isRhythm = false;
+            int prog = exportProgram[cmd.channel];
+            if (prog >= 0 && prog < (int)m_voicegroup.voices.size())
+                isRhythm = (m_voicegroup.voices[prog].type == GBAVoice::KEYSPLIT_ALL);
+            const GBAVoice* voice = resolveVoice(prog, note);
+            if (!voice || voice->type == GBAVoice::EMPTY) continue;
+
+            cmd.type = SynthCommand::NOTE_ON;
+            cmd.data1 = note;
+            cmd.data2 = ev.GetVelocity();
+            cmd.voice = voice;
+            cmd.isRhythm = isRhythm;
+        }
+        else if (ev.IsNoteOff())
+        {
+            cmd.type = SynthCommand::NOTE_OFF;
+            cmd.data1 = ev.GetNote();
+        }
+        else if (ev.IsControlChange())
+        {
+            cmd.type = SynthCommand::CONTROL_CHANGE;
+            cmd.data1 = ev.GetController();
+            cmd.data2 = ev.GetControllerValue();
+        }
+        else if (ev.IsPitchBend())
+        {
+            cmd.type = SynthCommand::PITCH_BEND;
+            cmd.data1 = ev.GetBenderValue();
+        }
+        else
+        {
+            if (ev.IsProgramChange()) exportProgram[cmd.channel] = ev.GetPGValue();
+            continue;
+        }
 
-                if (!jdksequencer.GetNextEventTime(&tick)) break;
-                nextEventMs = cumulativeMs + ((double)tick - lastEventTick) / ticksPerMs;
-            }
+        if (!channelJobs[cmd.channel]) channelJobs[cmd.channel] = new ChannelExportJob(exportRate);
+        channelJobs[cmd.channel]->addCommand(cmd);
+    }
 
-            // Render a chunk
-            int chunkSize = 512;
-            if (samplesRendered + chunkSize > totalSamples)
-                chunkSize = totalSamples - samplesRendered;
+    std::vector<ChannelExportJob*> jobs;
+    for (int i = 0; i < 16; i++)
+    {
+        if (channelJobs[i]) jobs.push_back(channelJobs[i]);
+    }
 
-            offlineEngine.renderFrames(&buffer[samplesRendered * 2], chunkSize);
-            samplesRendered += chunkSize;
-            currentMs += (double)chunkSize / (double)exportRate * 1000.0;
+    PreferencesData* prefs = PreferencesData::getInstance();
+    long format = prefs->getIntValue(SETTING_ID_AUDIO_EXPORT_FORMAT);
+    if (format < WavWriter::PCM_16 || format > WavWriter::FLOAT_32) format = WavWriter::PCM_16;
+    const bool dither = prefs->getBoolValue(SETTING_ID_AUDIO_EXPORT_DITHER, false);
 
-            if (currentMs > totalMs + 1000.0) break;
-        }
+    WavWriter writer;
+    if (!writer.open(filepath, exportRate, 2, (WavWriter::SampleFormat)format, dither))
+    {
+        fprintf(stderr, "[GBA Synth] Could not open %s for writing\n", (const char*)filepath.mb_str());
     }
+    else
+    {
+        // The calling thread renders too, so one worker less than there are cores
+        int threadCount = std::min(wxThread::GetCPUCount(), (int)jobs.size()) - 1;
+        if (threadCount < 0) threadCount = 0;
+        ExportWorkerPool pool(jobs, threadCount);
+
+        std::vector<float> mix(EXPORT_BLOCK_FRAMES * 2);
 
-    // Write WAV file
-    std::ofstream out(filepath.mb_str(), std::ios::binary);
-    if (out.is_open())
-    {
-        int dataSize = samplesRendered * 2 * 2; // 2 channels, 16-bit
-        int fileSize = 36 + dataSize;
-
-        // WAV header
-        out.write("RIFF", 4);
-        int riffSize = fileSize;
-        out.write((char*)&riffSize, 4);
-        out.write("WAVE", 4);
-        out.write("fmt ", 4);
-        int fmtSize = 16;
-        out.write((char*)&fmtSize, 4);
-        short audioFormat = 1; // PCM
-        out.write((char*)&audioFormat, 2);
-        short numChannels = 2;
-        out.write((char*)&numChannels, 2);
-        int sampleRate = exportRate;
-        out.write((char*)&sampleRate, 4);
-        int byteRate = exportRate * 2 * 2;
-        out.write((char*)&byteRate, 4);
-        short blockAlign = 4;
-        out.write((char*)&blockAlign, 2);
-        short bitsPerSample = 16;
-        out.write((char*)&bitsPerSample, 2);
-        out.write("data", 4);
-        out.write((char*)&dataSize, 4);
-
-        // Convert float to 16-bit PCM
-        for (int i = 0; i < samplesRendered * 2; i++)
+        for (int samplesRendered = 0; samplesRendered < totalSamples; samplesRendered += EXPORT_BLOCK_FRAMES)
         {
-            float s = buffer[i];
-            if (s > 1.0f) s = 1.0f;
-            if (s < -1.0f) s = -1.0f;
-            short sample = (short)(s * 32767.0f);
-            out.write((char*)&sample, 2);
+            const int blockFrames = std::min(EXPORT_BLOCK_FRAMES, totalSamples - samplesRendered);
+            pool.renderBlock(blockFrames);
+
+            std::fill(mix.begin(), mix.begin() + blockFrames * 2, 0.0f);
+            for (size_t j = 0; j < jobs.size(); j++)
+            {
+                const float* block = jobs[j]->getBlock();
+                for (int i = 0; i < blockFrames * 2; i++)
+                    mix[i] += block[i];
+            }
+
+            // PCM formats are clipped by the writer; float keeps the full mix
+            if (!writer.write(&mix[0], blockFrames))
+            {
+                fprintf(stderr, "[GBA Synth] Error while writing %s\n", (const char*)filepath.mb_str());
+                break;
+            }
         }
-        out.close();
+        writer.close();
     }
 
+    for (size_t j = 0; j < jobs.size(); j++)
+        delete jobs[j];
+
     g_callback_engine = prevEngine;
 }
 
+bool GBASynthManager::audioExportSetup()
+{
+    GBAExportDialog dlg(getMainFrame());
+    if (dlg.ShowModal() != wxID_OK) return false;
+    dlg.saveChoices();
+    return true;
+}
+
 const wxString GBASynthManager::getAudioExtension()
 {
     return wxT(".wav");
@@ -575,13 +777,13 @@ void GBASynthManager::seq_note_on(const int note, const int volume, const int ch
     const GBAVoice* voice = resolveVoice(prog, note);
     if (voice)
     {
-        m_engine.noteOn(note, volume, channel, voice, isRhythm);
+        m_engine.noteOn(note, volume, channel, voice, isRhythm, getEventFrame());
     }
 }
 
 void GBASynthManager::seq_note_off(const int note, const int channel)
 {
-    m_engine.noteOff(note, channel);
+    m_engine.noteOff(note, channel, getEventFrame());
 }
 
 void GBASynthManager::seq_prog_change(const int instrument, const int channel)
@@ -592,12 +794,54 @@ void GBASynthManager::seq_prog_change(const int instrument, const int channel)
 
 void GBASynthManager::seq_controlchange(const int controller, const int value, const int channel)
 {
-    m_engine.controlChange(controller, value, channel);
+    m_engine.controlChange(controller, value, channel, getEventFrame());
 }
 
 void GBASynthManager::seq_pitch_bend(const int value, const int channel)
 {
-    m_engine.pitchBend(value, channel);
+    m_engine.pitchBend(value, channel, getEventFrame());
+}
+
+void GBASynthManager::seq_notify_event_time(const double millis)
+{
+    // Events are scheduled LIVE_LOOKAHEAD_MS ahead of what the audio thread has rendered, so that
+    // they land inside a later block at their exact frame instead of at the start of the next one.
+    const int64_t rendered = (int64_t)m_engine.getRenderedFrames();
+    const int64_t lookahead = (int64_t)m_engine.framesForMillis(LIVE_LOOKAHEAD_MS);
+    const int64_t offset = (int64_t)m_engine.framesForMillis(millis);
+
+    wxMutexLocker lock(m_scheduleLock);
+
+    if (m_frameAnchorPending)
+    {
+        m_frameAnchor = rendered + lookahead - offset;
+        m_frameAnchorPending = false;
+    }
+
+    int64_t frame = m_frameAnchor + offset;
+
+    // The audio device clock and the sequencer clock slowly drift apart (and the sequencer may
+    // fall behind under load); re-anchor whenever an event would leave the lookahead window
+    if (frame < rendered || frame > rendered + 2 * lookahead)
+    {
+        m_frameAnchor = rendered + lookahead - offset;
+        frame = rendered + lookahead;
+    }
+
+    m_eventFrame = (uint64_t)frame;
+}
+
+void GBASynthManager::resetLiveSchedule()
+{
+    wxMutexLocker lock(m_scheduleLock);
+    m_frameAnchorPending = true;
+    m_eventFrame = 0;
+}
+
+uint64_t GBASynthManager::getEventFrame()
+{
+    wxMutexLocker lock(m_scheduleLock);
+    return m_eventFrame;
 }
 
 void GBASynthManager::seq_notify_current_tick(const int tick)
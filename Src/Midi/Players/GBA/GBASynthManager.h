@@ -22,6 +22,17 @@ class GBASynthManager : public PlatformMidiManager
     int m_currentTick;
     int m_accurateTick;
 
+    // Live scheduling: engine frame corresponding to the start of playback, and frame of the
+    // event being sent by the sequencer thread. Reset from the main thread when playback starts and
+    // updated from the sequencer thread, always together under m_scheduleLock
+    int64_t m_frameAnchor;
+    bool m_frameAnchorPending;
+    uint64_t m_eventFrame;
+    wxMutex m_scheduleLock;
+
+    void resetLiveSchedule();
+    uint64_t getEventFrame();
+
     Sequence* m_sequence;
 
     const GBAVoice* resolveVoice(int programIndex, int note);
@@ -45,6 +56,7 @@ public:
     virtual void playNote(int noteNum, int volume, int duration, int channel, int instrument);
     virtual void stopNote();
 
+    virtual bool audioExportSetup();
     virtual void exportAudioFile(Sequence* sequence, wxString filepath);
     virtual const wxString getAudioExtension();
     virtual const wxString getAudioWildcard();
@@ -57,6 +69,7 @@ public:
     virtual void seq_prog_change(const int instrument, const int channel);
     virtual void seq_controlchange(const int controller, const int value, const int channel);
     virtual void seq_pitch_bend(const int value, const int channel);
+    virtual void seq_notify_event_time(const double millis);
     virtual void seq_notify_current_tick(const int tick);
     virtual void seq_notify_accurate_current_tick(const int tick);
     virtual bool seq_must_continue();
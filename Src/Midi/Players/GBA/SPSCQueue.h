@@ -0,0 +1,69 @@
+#ifndef __GBA_SPSC_QUEUE_H__
+#define __GBA_SPSC_QUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+
+namespace AriaMaestosa
+{
+
+// Wait-free single-producer/single-consumer ring buffer.
+// push() must only be called from one thread and front()/pop() from one other thread;
+// neither side ever blocks. CAPACITY must be a power of two.
+template<typename T, unsigned int CAPACITY>
+class SPSCQueue
+{
+    T m_items[CAPACITY];
+
+    // Written by the producer only; index of the next slot to fill
+    std::atomic<unsigned int> m_head;
+    // Written by the consumer only; index of the next slot to read
+    std::atomic<unsigned int> m_tail;
+
+    SPSCQueue(const SPSCQueue&);
+    SPSCQueue& operator=(const SPSCQueue&);
+
+public:
+    SPSCQueue() : m_head(0), m_tail(0)
+    {
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SPSCQueue capacity must be a power of two");
+    }
+
+    // Producer side. Returns false (and drops the item) if the queue is full.
+    bool push(const T& item)
+    {
+        const unsigned int head = m_head.load(std::memory_order_relaxed);
+        const unsigned int tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= CAPACITY) return false;
+
+        m_items[head & (CAPACITY - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns the oldest item without removing it, or NULL if the queue is empty.
+    const T* front() const
+    {
+        const unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        const unsigned int head = m_head.load(std::memory_order_acquire);
+        if (tail == head) return NULL;
+        return &m_items[tail & (CAPACITY - 1)];
+    }
+
+    // Consumer side. Removes the item returned by the last call to front().
+    void pop()
+    {
+        const unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    // Approximate when called concurrently with push() or pop()
+    unsigned int size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+};
+
+}
+
+#endif
@@ -254,7 +254,7 @@ namespace AriaMaestosa
         ExitCode Entry()
         {
             AriaSequenceTimer timer(m_sequence);
-            timer.run(jdksequencer, songLengthInTicks);
+            timer.run(jdksequencer, songLengthInTicks, m_start_tick);
             
             //must_stop = true;
             cleanup_after_playback();
@@ -219,6 +219,16 @@ namespace AriaMaestosa
         virtual void seq_controlchange(const int controller, const int value, const int channel) { }
         virtual void seq_pitch_bend   (const int value, const int channel)                       { }
         
+        /**
+          * @brief called by the generic sequencer right before sending an event, with the time the event
+          *        was scheduled for.
+          * @param millis Scheduled time of the event, in milliseconds since playback started. This time
+          *               keeps increasing when playback loops.
+          * @note  Players that can schedule events ahead of time (e.g. software synthesizers rendering
+          *        audio in blocks) can use this to place events precisely; others can ignore it.
+          */
+        virtual void seq_notify_event_time(const double millis) { }
+        
         /**
           * @brief called repeatedly by the generic sequencer to tell the midi player what is the current
           *        progression. the sequencer will call this with -1 as argument to indicate it exits.
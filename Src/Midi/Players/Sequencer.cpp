@@ -22,6 +22,7 @@
 #include "Midi/ControllerEvent.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
+#include "Midi/TempoMap.h"
 #include "Midi/Players/PlatformMidiManager.h"
 
 #include "jdksmidi/world.h"
@@ -39,12 +40,25 @@
 #define HAVE_FTIME 1
 #endif
 
-#if HAVE_GETIMEOFDAY
+#if defined(__linux__)
+#define HAVE_CLOCK_NANOSLEEP 1
+#else
+#define HAVE_CLOCK_NANOSLEEP 0
+#endif
+
+#if HAVE_CLOCK_NANOSLEEP
+#include <time.h>
+#include <errno.h>
+#elif HAVE_GETIMEOFDAY
 #include <sys/time.h>
 #else
 #include <sys/timeb.h>
 #endif
 
+#include <algorithm>
+
+#include "UnitTest.h"
+
 namespace AriaMaestosa
 {
 
@@ -56,7 +70,72 @@ namespace AriaMaestosa
 #pragma mark -
 #endif
 
-#if HAVE_GETIMEOFDAY
+#if HAVE_CLOCK_NANOSLEEP
+
+/** When sleeping until a deadline, wake up this many microseconds earlier and busy-wait the rest */
+const long PRECISE_SPIN_WINDOW_MICROS = 500;
+
+class MonotonicTimer
+{
+    timespec _init_time;
+    
+    static double to_micros(const timespec& t)
+    {
+        return t.tv_sec * 1000000.0 + t.tv_nsec / 1000.0;
+    }
+    
+public:
+    
+    void reset_and_start()
+    {
+        clock_gettime(CLOCK_MONOTONIC, &_init_time);
+    }
+    
+    void reset()
+    {
+        reset_and_start(); // in this timer implementation, both actions are the same
+    }
+    
+    double get_elapsed_millis()
+    {
+        timespec curr_time;
+        clock_gettime(CLOCK_MONOTONIC, &curr_time);
+        return (to_micros(curr_time) - to_micros(_init_time)) / 1000.0;
+    }
+    
+    /**
+      * Block until 'millis' milliseconds have elapsed since the timer was started. Most of the wait
+      * is spent in clock_nanosleep; the last PRECISE_SPIN_WINDOW_MICROS are busy-waited, since the
+      * scheduler may otherwise wake us up late.
+      */
+    void wait_until(double millis)
+    {
+        const double deadline_micros = to_micros(_init_time) + millis*1000.0;
+        const double sleep_until_micros = deadline_micros - PRECISE_SPIN_WINDOW_MICROS;
+        
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        
+        if (sleep_until_micros > to_micros(now))
+        {
+            timespec wake_time;
+            wake_time.tv_sec  = (time_t)(sleep_until_micros / 1000000.0);
+            wake_time.tv_nsec = (long)((sleep_until_micros - wake_time.tv_sec*1000000.0) * 1000.0);
+            if (wake_time.tv_nsec >= 1000000000L) { wake_time.tv_sec++; wake_time.tv_nsec -= 1000000000L; }
+            if (wake_time.tv_nsec < 0) wake_time.tv_nsec = 0;
+            
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake_time, NULL) == EINTR) {}
+        }
+        
+        do
+        {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while (to_micros(now) < deadline_micros);
+    }
+};
+typedef MonotonicTimer BasicTimer;
+
+#elif HAVE_GETIMEOFDAY
 
 class GetTimeOfDayTimer
 {
@@ -73,13 +152,13 @@ public:
         reset_and_start(); // in this timer implementation, both actions are the same
     }    
 
-    int get_elapsed_millis()
+    double get_elapsed_millis()
     {
         timeval curr_time;
         timeval elap_time;
         gettimeofday(&curr_time, 0);
         timersub(&curr_time, &_init_time, &elap_time);
-        return elap_time.tv_sec * 1000 + elap_time.tv_usec / 1000;
+        return elap_time.tv_sec * 1000.0 + elap_time.tv_usec / 1000.0;
     }
 };
 typedef GetTimeOfDayTimer BasicTimer;
@@ -108,7 +187,7 @@ public:
         reset_and_start(); // in this timer implementation, both actions are the same
     }
     
-    int get_elapsed_millis()
+    double get_elapsed_millis()
     {
         timeb tb;
         ftime(&tb);
@@ -132,23 +211,108 @@ class DummyTimer
     long time;
     public:
     void reset_and_start(){ time=0; }
-    int get_elapsed_millis(){ time+=13; return time; }
+    double get_elapsed_millis(){ time+=13; return time; }
 };
 typedef DummyTimer BasicTimer;
 
 #endif
 
+/** In precise scheduling mode, wake up at least this often even when no event is due, to notice
+  * when playback is stopped and to update the playback position */
+const double PRECISE_MAX_IDLE_MILLIS = 10.0;
+
+AriaSequenceTimer::SchedulingMode g_scheduling_mode = AriaSequenceTimer::SCHEDULING_PRECISE;
+
+LatenessHistogram g_lateness;
+
+// ------------------------------------------------------------
+//     lateness histogram
+// ------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#endif
+
+const int LatenessHistogram::BUCKET_LIMITS[LatenessHistogram::BUCKET_COUNT - 1] =
+    { 50, 100, 250, 500, 1000, 2000, 5000, 10000, 20000 };
+
+void LatenessHistogram::reset()
+{
+    for (int n=0; n<BUCKET_COUNT; n++) m_buckets[n] = 0;
+    m_count = 0;
+    m_total_micros = 0;
+    m_max_micros = 0;
+}
+
+void LatenessHistogram::record(double latenessMicros)
+{
+    if (latenessMicros < 0) latenessMicros = 0;
+    
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 and latenessMicros >= BUCKET_LIMITS[bucket]) bucket++;
+    
+    m_buckets[bucket]++;
+    m_count++;
+    m_total_micros += latenessMicros;
+    m_max_micros = std::max(m_max_micros, latenessMicros);
+}
+
+void LatenessHistogram::dump(std::ostream& out) const
+{
+    out << "[AriaSequenceTimer] lateness of " << m_count << " events (mean " << getMeanLatenessMicros()
+        << " us, max " << m_max_micros << " us)" << std::endl;
+    
+    for (int n=0; n<BUCKET_COUNT; n++)
+    {
+        if (n < BUCKET_COUNT - 1) out << "    < " << BUCKET_LIMITS[n] << " us : ";
+        else                      out << "   >= " << BUCKET_LIMITS[n-1] << " us : ";
+        out << m_buckets[n] << std::endl;
+    }
+}
+
+// ------------------------------------------------------------
+//     sequence timer
+// ------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#endif
+
 AriaSequenceTimer::AriaSequenceTimer(Sequence* seq)
 {
     m_seq = seq;
 }
 
+void AriaSequenceTimer::setSchedulingMode(SchedulingMode mode)
+{
+    g_scheduling_mode = mode;
+}
+
+AriaSequenceTimer::SchedulingMode AriaSequenceTimer::getSchedulingMode()
+{
+    return g_scheduling_mode;
+}
+
+bool AriaSequenceTimer::isPreciseSchedulingAvailable()
+{
+    return HAVE_CLOCK_NANOSLEEP;
+}
+
+const LatenessHistogram& AriaSequenceTimer::getLatenessHistogram()
+{
+    return g_lateness;
+}
+
 BasicTimer* timer = NULL;
 
 void cleanup_sequencer()
 {
     if (timer != NULL) delete timer;
     timer = NULL;
+    
+#ifdef _MORE_DEBUG_CHECKS
+    g_lateness.dump(std::cout);
+#endif
 }
 
 int count = 0;
@@ -171,7 +335,8 @@ public:
     }
 };
 
-void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int songLengthInTicks)
+void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int songLengthInTicks,
+                            const int startTick)
 {
     // Added because I suspect invalid reentrency is the cause of bug #113
     ReentrencyGuard guard;
@@ -188,14 +353,20 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
 
     jdksequencer->GoToTimeMs( 0 );
 
-    int bpm = m_seq->getTempo();
-    const int beatlen = m_seq->ticksPerQuarterNote();
-
-    double ticks_per_millis = (double)bpm * (double)beatlen / (double)60000.0;
-
-    //std::cout << "bpm = " << bpm << " beatlen=" << beatlen << " ticks_per_millis=" << ticks_per_millis << std::endl;
+    // ticks of the jdksmidi sequence are relative to the tick playback started from
+    const int start_tick = std::max(0, startTick);
+    
+    // the published map never changes, the sequence may be edited from the main thread while we play
+    const std::shared_ptr<const TempoMap> published_tempo_map = m_seq->getPublishedTempoMap();
+    const TempoMap& tempo_map = *published_tempo_map;
+    
+    // time of the song (since its beginning) at which our timer was started
+    double origin_millis = tempo_map.tickToMillis(start_tick);
 
-    float next_event_time = 0;
+    double next_event_time = 0;
+    
+    // time elapsed on previous loop iterations, so that event times keep increasing when looping
+    double loop_offset_millis = 0;
 
     jdksmidi::MIDITimedBigMessage ev;
     int ev_track;
@@ -212,14 +383,16 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
     
     long previous_tick = tick;
     
-    next_event_time = tick / ticks_per_millis;
+    next_event_time = tempo_map.tickToMillis(start_tick + tick) - origin_millis;
+    
+    const bool precise = (g_scheduling_mode == SCHEDULING_PRECISE and isPreciseSchedulingAvailable());
+    g_lateness.reset();
     
     timer = new BasicTimer();
     timer->reset_and_start();
     
-    long total_millis = 0;
-    long last_millis = 0;
-    long tick_time_offset = 0; // offset between timer-relative ticks and absolute song ticks
+    double total_millis = 0;
+    double last_millis = 0;
 
     // GBA loop: find [ and ] ticks directly from text events
     int loopBackTick = 0;
@@ -228,7 +401,7 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
     jdksmidi::MIDISequencerState* loopBackState = NULL;
     if (m_seq->isLoopEnabled())
     {
-        const int startTickOffset = m_seq->getPlaybackStartTick();
+        const int startTickOffset = start_tick;
         for (int i = 0; i < m_seq->getTextEventAmount(); i++)
         {
             const TextEvent* evt = m_seq->getTextEvent(i);
@@ -290,6 +463,12 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
                 }
             }
             const int channel = ev.GetChannel();
+            
+            PlatformMidiManager::get()->seq_notify_event_time(loop_offset_millis + next_event_time);
+            
+            // 'total_millis' was sampled when the wait ended, before the events due by then were sent;
+            // read the clock again so that time spent sending previous events counts as lateness
+            g_lateness.record( (timer->get_elapsed_millis() - next_event_time)*1000.0 );
 
             if (ev.IsNoteOn())
             {
@@ -331,9 +510,7 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
             }
             else if (ev.IsTempo())
             {
-                //std::cout << "tempo event" << std::endl;
-                const int event_bpm = ev.GetTempo32()/32;
-                ticks_per_millis = (double)event_bpm * (double)beatlen / (double)60000.0;
+                // nothing to do, tempo changes are already accounted for by the tempo map
             }
             /*
             else if ( ev.IsPolyPressure() )
@@ -409,9 +586,10 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
                 if ((long)tick < loopBackTick) tick = loopBackTick;
                 previous_tick = tick;
 
-                tick_time_offset = loopBackTick;
-                next_event_time = (tick - loopBackTick) / ticks_per_millis;
+                origin_millis = tempo_map.tickToMillis(start_tick + loopBackTick);
+                next_event_time = tempo_map.tickToMillis(start_tick + tick) - origin_millis;
 
+                loop_offset_millis += timer->get_elapsed_millis();
                 timer->reset();
                 total_millis = 0;
                 last_millis = 0;
@@ -438,10 +616,7 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
 
             PlatformMidiManager::get()->seq_notify_current_tick(previous_tick);
 
-            //std::cout << "next_event_time was " << next_event_time << " adding " <<
-            //((tick - previous_tick) / ticks_per_millis) << " tick=" << tick <<
-            //" previous_tick=" << previous_tick << "ticks_per_millis=" << ticks_per_millis << std::endl;
-            next_event_time += (tick - previous_tick) / ticks_per_millis;
+            next_event_time = tempo_map.tickToMillis(start_tick + tick) - origin_millis;
 
             /*
             static int i = 0;
@@ -454,21 +629,30 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
 
         }
         
-        wxThread::Sleep(2);
+        assert(timer != NULL);
         
+#if HAVE_CLOCK_NANOSLEEP
+        if (precise)
+        {
+            timer->wait_until( std::min<double>(next_event_time, total_millis + PRECISE_MAX_IDLE_MILLIS) );
+        }
+        else
+#endif
+        {
+            wxThread::Sleep(2);
+        }
         
         last_millis = total_millis;
-        assert(timer != NULL);
-        const int delta = (timer->get_elapsed_millis() - last_millis);
+        const double delta = (timer->get_elapsed_millis() - last_millis);
         
         total_millis += delta;
         
-        // FIXME; this will not play well with tempo changes
-        PlatformMidiManager::get()->seq_notify_accurate_current_tick(total_millis*ticks_per_millis + tick_time_offset);
+        const int current_tick = (int)tempo_map.millisToTick(origin_millis + total_millis) - start_tick;
+        PlatformMidiManager::get()->seq_notify_accurate_current_tick(current_tick);
         
         if (PlatformMidiManager::get()->isRecording())
         {
-            const int extend_tick = total_millis*ticks_per_millis + tick_time_offset;
+            const int extend_tick = current_tick;
             if (extend_tick >= next_beat)
             {
                 wxCommandEvent evt(wxEVT_EXTEND_TICK, wxID_ANY);
@@ -490,7 +674,34 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
     cleanup_sequencer();
 }
 
+// ------------------------------------------------------------
 
+namespace TestSequencer
+{
+    
+    UNIT_TEST( TestLatenessHistogram )
+    {
+        LatenessHistogram histogram;
+        
+        histogram.record(-5);      // early events count as on time
+        histogram.record(10);
+        histogram.record(50);      // limits are exclusive
+        histogram.record(1500);
+        histogram.record(100000);
+        
+        require_e(histogram.getEventCount(), ==, 5, "all events were recorded");
+        require_e(histogram.getBucketCount(0), ==, 2, "on-time events are in the first bucket");
+        require_e(histogram.getBucketCount(1), ==, 1, "bucket limits are exclusive");
+        require_e(histogram.getBucketCount(5), ==, 1, "events are sorted in the right bucket");
+        require_e(histogram.getBucketCount(LatenessHistogram::BUCKET_COUNT - 1), ==, 1,
+                  "very late events end up in the last bucket");
+        require(histogram.getMaxLatenessMicros() == 100000, "max lateness is tracked");
+        
+        histogram.reset();
+        require_e(histogram.getEventCount(), ==, 0, "histogram can be reset");
+    }
+    
+}
 
 }
 
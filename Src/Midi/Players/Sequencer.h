@@ -17,6 +17,8 @@
 #ifndef __ARIA_SEQUENCER_H__
 #define __ARIA_SEQUENCER_H__
 
+#include <iostream>
+
 namespace jdksmidi{ class MIDISequencer; }
 
 namespace AriaMaestosa
@@ -24,14 +26,80 @@ namespace AriaMaestosa
 
     class Sequence;
 
+    /**
+      * @brief distribution of how late events were sent by the sequencer, compared to their deadline
+      */
+    class LatenessHistogram
+    {
+    public:
+        enum { BUCKET_COUNT = 10 };
+        
+    private:
+        /** Upper bound (exclusive, in microseconds) of each bucket; the last bucket has no upper bound */
+        static const int BUCKET_LIMITS[BUCKET_COUNT - 1];
+        
+        int m_buckets[BUCKET_COUNT];
+        int m_count;
+        double m_total_micros;
+        double m_max_micros;
+        
+    public:
+        
+        LatenessHistogram() { reset(); }
+        
+        void reset();
+        
+        /** @param latenessMicros how late (in microseconds) an event was sent compared to its deadline */
+        void record(double latenessMicros);
+        
+        int getEventCount()         const { return m_count; }
+        int getBucketCount(int bucket) const { return m_buckets[bucket]; }
+        
+        /** @return upper bound (exclusive, in microseconds) of the given bucket, which cannot be the last */
+        static int getBucketLimit(int bucket) { return BUCKET_LIMITS[bucket]; }
+        double getMaxLatenessMicros()  const { return m_max_micros; }
+        double getMeanLatenessMicros() const { return (m_count == 0 ? 0.0 : m_total_micros / m_count); }
+        
+        /** @brief print the histogram in human-readable form */
+        void dump(std::ostream& out) const;
+    };
+    
     class AriaSequenceTimer
     {
         Sequence* m_seq;
         
     public:
+        
+        enum SchedulingMode
+        {
+            /** Wake up every 2 milliseconds and send the events that are due */
+            SCHEDULING_POLLING,
+            
+            /** Sleep until the deadline of the next event (only available on some platforms; when
+              * unavailable, polling is used) */
+            SCHEDULING_PRECISE
+        };
 
         AriaSequenceTimer(Sequence* seq);
-        void run(jdksmidi::MIDISequencer* jdksequencer, const int songLengthInTicks);
+        
+        /**
+          * @brief play the given sequence, returns when playback is over
+          * @param startTick the tick of the song that tick 0 of 'jdksequencer' corresponds to, as returned
+          *                  by makeJDKMidiSequence
+          */
+        void run(jdksmidi::MIDISequencer* jdksequencer, const int songLengthInTicks, const int startTick);
+        
+        static void setSchedulingMode(SchedulingMode mode);
+        static SchedulingMode getSchedulingMode();
+        
+        /** @return whether the precise scheduling mode is supported on this platform */
+        static bool isPreciseSchedulingAvailable();
+        
+        /**
+          * @return lateness of the events sent during the last (or current) playback.
+          * @note   only read it when playback is stopped, it is updated from the sequencer thread
+          */
+        static const LatenessHistogram& getLatenessHistogram();
     };
 
 }
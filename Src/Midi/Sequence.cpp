@@ -40,6 +40,7 @@ const int CURRENT_FILE_VERSION = 4;
 #include "PreferencesData.h"
 #include "Utils.h"
 
+#include <algorithm>
 #include <wx/intl.h>
 #include <wx/utils.h>
 #include <wx/msgdlg.h>
@@ -56,6 +57,7 @@ Sequence::Sequence(IPlaybackModeListener* playbackListener, IActionStackListener
     m_quarterNoteResolution     = 960;
     currentTrack                = 0;
     m_tempo                     = 120;
+    m_tempo_map_dirty           = true;
     m_importing                 = false;
     m_loop_enabled              = false;
     m_follow_playback           = PreferencesData::getInstance()->getBoolValue("followPlayback", false);
@@ -67,6 +69,11 @@ Sequence::Sequence(IPlaybackModeListener* playbackListener, IActionStackListener
     m_default_key_type          = KEY_TYPE_C;
     m_default_key_symbol_amount = 0;
     
+    // the setting is in MiB
+    long undoMemoryBudget = 64;
+    PreferencesData::getInstance()->getValue(SETTING_ID_UNDO_MEMORY_BUDGET).ToLong(&undoMemoryBudget);
+    setUndoMemoryBudget(std::max(undoMemoryBudget, 1L)*1024*1024);
+    
     m_sequence_filename     = new Model<wxString>( _("Untitled") );
     channelManagement = CHANNEL_AUTO;
     m_copyright = wxT("");
@@ -251,27 +258,42 @@ void Sequence::scale(float factor,
 void Sequence::setTempo(int tmp)
 {
     m_tempo = tmp;
+    invalidateTempoMap();
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
 float Sequence::getTempoAtTick(const int tick) const
 {
-    float outTempo = getTempo();
-    
-    const int amount = m_tempo_events.size();
-    for (int n=0; n<amount; n++)
+    return getTempoMap().getTempoAtTick(tick);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const TempoMap& Sequence::getTempoMap() const
+{
+    if (m_tempo_map_dirty or m_tempo_map.get() == NULL or
+        not m_tempo_map->isUpToDate(m_quarterNoteResolution))
     {
-        if (m_tempo_events[n].getTick() <= tick)
-        {
-            outTempo = convertTempoBendToBPM(m_tempo_events[n].getValue());
-        }
-        else
-        {
-            break;
-        }
+        TempoMap* tempoMap = new TempoMap();
+        tempoMap->rebuild(m_tempo, m_tempo_events, m_quarterNoteResolution);
+        std::shared_ptr<const TempoMap> built(tempoMap);
+        
+        // players may be copying the pointer from their thread
+        wxMutexLocker lock(m_tempo_map_lock);
+        m_tempo_map.swap(built);
+        m_tempo_map_dirty = false;
     }
-    return outTempo;
+    return *m_tempo_map;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<const TempoMap> Sequence::getPublishedTempoMap() const
+{
+    wxMutexLocker lock(m_tempo_map_lock);
+    ASSERT(m_tempo_map.get() != NULL);
+    return m_tempo_map;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -288,6 +310,7 @@ void Sequence::addTempoEvent(ControllerEvent* evt, wxFloat64* previousValue)
 void Sequence::addTempoEvent_import( ControllerEvent* evt )
 {
     m_tempo_events.push_back(evt);
+    invalidateTempoMap();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -297,14 +320,15 @@ void Sequence::addTempoEvent_import( ControllerEvent* evt )
  */
 void Sequence::sortTempoEvents()
 {
-    m_tempo_events.insertionSort();
+    m_tempo_events.mergeSort();
+    invalidateTempoMap();
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
 void Sequence::sortTextEvents()
 {
-    m_text_events.insertionSort();
+    m_text_events.mergeSort();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -472,6 +496,10 @@ void Sequence::action( Action::MultiTrackAction* actionObj)
     actionObj->setParentSequence(this, new SequenceVisitor(this));
     actionObj->perform();
     
+    // multi-track actions may have modified any track
+    for (int n=0; n<tracks.size(); n++) tracks[n].markModified();
+    invalidateTempoMap();
+    
     if (m_action_stack_listener != NULL) m_action_stack_listener->onActionStackChanged();
     
     ASSERT(invariant());
@@ -481,6 +509,9 @@ void Sequence::action( Action::MultiTrackAction* actionObj)
 
 void Sequence::addToUndoStack( Action::EditAction* actionObj )
 {
+    // a new action makes the undone ones meaningless
+    redoStack.clearAndDeleteAll();
+    
     undoStack.push_back(actionObj);
 
     if (PlatformMidiManager::get()->isRecording() and
@@ -492,14 +523,45 @@ void Sequence::addToUndoStack( Action::EditAction* actionObj )
         undoStack.swap(undoStack.size() - 1, undoStack.size() - 2);
     }
     
-    // remove old actions from undo stack, to not take memory uselessly
-    if (undoStack.size() > 8) undoStack.erase(0);
+    trimUndoHistory();
     
     if (m_action_stack_listener != NULL) m_action_stack_listener->onActionStackChanged();
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
+void Sequence::setUndoMemoryBudget(const size_t bytes)
+{
+    m_undo_memory_budget = bytes;
+    trimUndoHistory();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t Sequence::getUndoMemoryUsage() const
+{
+    size_t total = 0;
+    for (int n=0; n<undoStack.size(); n++) total += undoStack[n].getMemoryFootprint();
+    for (int n=0; n<redoStack.size(); n++) total += redoStack[n].getMemoryFootprint();
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Sequence::trimUndoHistory()
+{
+    size_t usage = getUndoMemoryUsage();
+    
+    // drop the oldest actions first, but always keep the last one so that it can be undone
+    while (usage > m_undo_memory_budget and undoStack.size() > 1)
+    {
+        usage -= undoStack[0].getMemoryFootprint();
+        undoStack.erase(0);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void Sequence::undo()
 {
     if (undoStack.size() < 1)
@@ -517,7 +579,22 @@ void Sequence::undo()
     }
     
     lastAction->undo();
-    undoStack.erase( undoStack.size() - 1 );
+    undoStack.remove( undoStack.size() - 1 );
+    
+    if (lastAction->canRedo())
+    {
+        redoStack.push_back(lastAction);
+    }
+    else
+    {
+        // actions further in the redo stack expect the changes of this one to be there
+        delete lastAction;
+        redoStack.clearAndDeleteAll();
+    }
+
+    // we don't know which tracks were affected by the undone action
+    for (int n=0; n<tracks.size(); n++) tracks[n].markModified();
+    invalidateTempoMap();
 
     if (m_seq_data_listener != NULL) m_seq_data_listener->onSequenceDataChanged();
     
@@ -528,6 +605,33 @@ void Sequence::undo()
 
 // ----------------------------------------------------------------------------------------------------------
 
+void Sequence::redo()
+{
+    if (redoStack.size() < 1 or PlatformMidiManager::get()->isRecording())
+    {
+        wxBell();
+        return;
+    }
+    
+    Action::EditAction* action = redoStack.get( redoStack.size() - 1 );
+    redoStack.remove( redoStack.size() - 1 );
+    undoStack.push_back(action);
+    
+    action->redo();
+    
+    // we don't know which tracks are affected by the action
+    for (int n=0; n<tracks.size(); n++) tracks[n].markModified();
+    invalidateTempoMap();
+    
+    if (m_seq_data_listener != NULL) m_seq_data_listener->onSequenceDataChanged();
+    
+    if (m_action_stack_listener != NULL) m_action_stack_listener->onActionStackChanged();
+    
+    ASSERT(invariant());
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 wxString Sequence::getTopActionName() const
 {
     if (undoStack.size() == 0) return wxEmptyString;
@@ -538,9 +642,19 @@ wxString Sequence::getTopActionName() const
 
 // ----------------------------------------------------------------------------------------------------------
 
+wxString Sequence::getRedoActionName() const
+{
+    if (redoStack.size() == 0) return wxEmptyString;
+    
+    return redoStack.getConst( redoStack.size() - 1 )->getName();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void Sequence::clearUndoStack()
 {
     undoStack.clearAndDeleteAll();
+    redoStack.clearAndDeleteAll();
     if (m_action_stack_listener != NULL) m_action_stack_listener->onActionStackChanged();
 }
 
@@ -792,7 +906,7 @@ void Sequence::pasteAtMouse()
 #pragma mark I/O
 #endif
 
-void Sequence::saveToFile(wxFileOutputStream& fileout)
+void Sequence::saveToFile(wxOutputStream& fileout, const bool includeTrackEvents)
 {
 
     writeData(wxT("<sequence"), fileout );
@@ -852,7 +966,7 @@ void Sequence::saveToFile(wxFileOutputStream& fileout)
     // ---- tracks
     for (int n=0; n<tracks.size(); n++)
     {
-        tracks[n].saveToFile(fileout);
+        tracks[n].saveToFile(fileout, includeTrackEvents);
     }
     
     writeData(wxT("</sequence>"), fileout );
@@ -894,6 +1008,7 @@ bool Sequence::readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq)
             m_tempo = 120;
             std::cerr << "Missing info from file: main tempo" << std::endl;
         }
+        invalidateTempoMap();
         
         const char* fileFormatVersion = xml->getAttributeValue("fileFormatVersion");
         int fileversion = -1;
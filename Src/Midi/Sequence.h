@@ -19,7 +19,7 @@
 
 #include <wx/string.h>
 
-class wxFileOutputStream;
+class wxOutputStream;
 // forward
 namespace irr { namespace io {
     class IXMLBase;
@@ -28,12 +28,15 @@ namespace irr { namespace io {
 
 #include "AriaCore.h"
 #include "Actions/EditAction.h"
+#include "Midi/TempoMap.h"
 #include "Midi/Track.h"
 #include "ptr_vector.h"
 #include "Utils.h"
 
 #include <math.h> // for 'round'
+#include <memory>
 #include <string>
+#include <wx/thread.h>
 
 
 namespace AriaMaestosa
@@ -123,6 +126,15 @@ namespace AriaMaestosa
         ChannelManagementType channelManagement;
 
         ptr_vector<Action::EditAction> undoStack;
+        
+        /** actions that were undone, the next one to redo at the end */
+        ptr_vector<Action::EditAction> redoStack;
+        
+        /** how much memory the undo and redo stacks may use together, in bytes */
+        size_t m_undo_memory_budget;
+        
+        /** @brief drop the oldest actions until the history fits in its memory budget */
+        void trimUndoHistory();
 
         IPlaybackModeListener* m_playback_listener;
         
@@ -148,6 +160,19 @@ namespace AriaMaestosa
         
         ptr_vector<ControllerEvent> m_tempo_events;
         ptr_vector<TextEvent>       m_text_events;
+        
+        /**
+          * Tick/time conversions derived from 'm_tempo' and 'm_tempo_events', rebuilt lazily on the main thread.
+          * Each rebuild publishes a new map instead of modifying the current one, so players can keep using
+          * the map they took (see getPublishedTempoMap) while the song is edited.
+          */
+        mutable std::shared_ptr<const TempoMap> m_tempo_map;
+        
+        /** whether the tempo changed since 'm_tempo_map' was built; main thread only */
+        mutable bool m_tempo_map_dirty;
+        
+        /** guards 'm_tempo_map' itself (not the tempo events), which players read from their own thread */
+        mutable wxMutex m_tempo_map_lock;
 
         /** this object is to be modified by MainFrame, to remember where to save this sequence */
         wxString m_filepath;
@@ -239,9 +264,15 @@ namespace AriaMaestosa
         /** @brief undo the Action at the top of the undo stack */
         void undo();
         
+        /** @brief do again the last action that was undone */
+        void redo();
+        
         /** @return the name of the Action at the top of the undo stack */
         wxString getTopActionName() const;
         
+        /** @return the name of the Action that redo() would do again, or an empty string */
+        wxString getRedoActionName() const;
+        
         /** @brief forbid undo, by dropping all undo information kept in memory. */
         void clearUndoStack();
         
@@ -250,6 +281,24 @@ namespace AriaMaestosa
         {
             return undoStack.size() > 0;
         }
+        
+        /** @return is there something to redo? */
+        bool somethingToRedo() const
+        {
+            return redoStack.size() > 0;
+        }
+        
+        /**
+          * @brief set how much memory the undo history may use, in bytes.
+          * The most recent action is always kept, whatever its size.
+          */
+        void setUndoMemoryBudget(const size_t bytes);
+        
+        /** @return how much memory the undo history currently uses, in bytes (approximately) */
+        size_t getUndoMemoryUsage() const;
+        
+        /** @return how many actions can currently be undone */
+        int getUndoLevelAmount() const { return undoStack.size(); }
 
         wxString suggestFileName() const;
         wxString suggestTitle() const;
@@ -319,6 +368,22 @@ namespace AriaMaestosa
         /** @return the tempo at any tick (not necessarily a tick where there is a tempo change event) */
         float getTempoAtTick(const int tick) const;
         
+        /**
+          * @return the tempo map of this song, rebuilding it first if the tempo changed since it was built.
+          * @note   main thread only; the returned reference is only valid until the tempo is next modified
+          */
+        const TempoMap& getTempoMap() const;
+        
+        /**
+          * @return the tempo map as it was last built by getTempoMap. Safe to call from any thread; the map
+          *         never changes, edits made meanwhile publish a new one. Players take it once playback started,
+          *         after makeJDKMidiSequence built the map on the main thread.
+          */
+        std::shared_ptr<const TempoMap> getPublishedTempoMap() const;
+        
+        /** @brief signal that the tempo or tempo events were (or are about to be) modified */
+        void invalidateTempoMap() { m_tempo_map_dirty = true; }
+        
         void  addTempoEvent(ControllerEvent* evt, wxFloat64* previousValue);
         void sortTempoEvents();
         void sortTextEvents();
@@ -327,9 +392,11 @@ namespace AriaMaestosa
         
         int                    getTempoEventAmount() const { return m_tempo_events.size();  }
         const ControllerEvent* getTempoEvent(int id) const { return m_tempo_events.getConst(id); }
-        void eraseTempoEvent(int id) { m_tempo_events.erase(id); }
-        void setTempoEventValue(int id, int newValue) { m_tempo_events[id].setValue(newValue); }
-        void setTempoEventTick (int id, int newTick)  { m_tempo_events[id].setTick(newTick);  }
+        void eraseTempoEvent(int id) { m_tempo_events.erase(id); invalidateTempoMap(); }
+        void setTempoEventValue(int id, int newValue) { m_tempo_events[id].setValue(newValue); invalidateTempoMap(); }
+        void setTempoEventTick (int id, int newTick)  { m_tempo_events[id].setTick(newTick); invalidateTempoMap(); }
+        
+        /** @note the returned event may only be modified from within an action, which invalidates the tempo map */
         ControllerEvent* getTempoEventAt(int tick);
 
         /** @return Returns the old value there was, if any, before this new event replaces it.*/
@@ -350,9 +417,10 @@ namespace AriaMaestosa
         {
             ControllerEvent* evt = m_tempo_events.get(id);
             m_tempo_events.markToBeRemoved(id);
+            invalidateTempoMap();
             return evt;
         }
-        void removeMarkedTempoEvents()        { m_tempo_events.removeMarked();      }
+        void removeMarkedTempoEvents()        { m_tempo_events.removeMarked(); invalidateTempoMap(); }
 
         TextEvent* extractTextEvent(int id)
         {
@@ -447,8 +515,11 @@ namespace AriaMaestosa
         
         // ---- serialization
         
-        /** Called when saving \<Sequence\> ... \</Sequence\> in .aria file */
-        void saveToFile(wxFileOutputStream& fileout);
+        /**
+          * Called when saving \<Sequence\> ... \</Sequence\> in .aria file
+          * @param includeTrackEvents whether to write the notes and controller events of each track
+          */
+        void saveToFile(wxOutputStream& fileout, const bool includeTrackEvents=true);
         
         /** Called when reading \<sequence\> ... \</sequence\> in .aria file */
         bool readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq);
@@ -0,0 +1,172 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Midi/TempoMap.h"
+#include "Midi/CommonMidiUtils.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    /** Compares a tick against the start of a segment, for binary searches */
+    template<typename SEGMENT>
+    struct TickBeforeSegment
+    {
+        bool operator()(const double tick, const SEGMENT& segment) const { return tick < segment.m_tick; }
+    };
+    
+    template<typename SEGMENT>
+    struct MillisBeforeSegment
+    {
+        bool operator()(const double millis, const SEGMENT& segment) const { return millis < segment.m_millis; }
+    };
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+TempoMap::TempoMap()
+{
+    m_ticks_per_beat = 0;
+    m_valid          = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void TempoMap::rebuild(const int mainTempo, const ptr_vector<ControllerEvent>& tempoEvents, const int ticksPerBeat)
+{
+    ASSERT_E(ticksPerBeat, >, 0);
+    
+    m_segments.clear();
+    m_ticks_per_beat = ticksPerBeat;
+    
+    Segment first;
+    first.m_tick            = 0;
+    first.m_millis          = 0.0;
+    first.m_bpm             = mainTempo;
+    first.m_millis_per_tick = 60000.0 / ((double)mainTempo * ticksPerBeat);
+    m_segments.push_back(first);
+    
+    const int amount = tempoEvents.size();
+    for (int n=0; n<amount; n++)
+    {
+        const int   tick = std::max(0, tempoEvents[n].getTick());
+        const float bpm  = convertTempoBendToBPM(tempoEvents[n].getValue());
+        
+        Segment& last = m_segments[m_segments.size() - 1];
+        ASSERT_E(tick, >=, last.m_tick);
+        
+        if (tick <= last.m_tick)
+        {
+            // several events on the same tick (or one on tick 0) : the last one wins
+            last.m_bpm             = bpm;
+            last.m_millis_per_tick = 60000.0 / ((double)bpm * ticksPerBeat);
+            continue;
+        }
+        
+        Segment segment;
+        segment.m_tick            = tick;
+        segment.m_millis          = last.m_millis + (tick - last.m_tick)*last.m_millis_per_tick;
+        segment.m_bpm             = bpm;
+        segment.m_millis_per_tick = 60000.0 / ((double)bpm * ticksPerBeat);
+        m_segments.push_back(segment);
+    }
+    
+    m_valid = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int TempoMap::findSegmentAtTick(const double tick) const
+{
+    ASSERT(m_valid);
+    
+    std::vector<Segment>::const_iterator it = std::upper_bound(m_segments.begin(), m_segments.end(), tick,
+                                                               TickBeforeSegment<Segment>());
+    if (it == m_segments.begin()) return 0;
+    return (it - m_segments.begin()) - 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int TempoMap::findSegmentAtMillis(const double millis) const
+{
+    ASSERT(m_valid);
+    
+    std::vector<Segment>::const_iterator it = std::upper_bound(m_segments.begin(), m_segments.end(), millis,
+                                                               MillisBeforeSegment<Segment>());
+    if (it == m_segments.begin()) return 0;
+    return (it - m_segments.begin()) - 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+double TempoMap::tickToMillis(const double tick) const
+{
+    const Segment& segment = m_segments[findSegmentAtTick(tick)];
+    return segment.m_millis + (tick - segment.m_tick)*segment.m_millis_per_tick;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+double TempoMap::millisToTick(const double millis) const
+{
+    const Segment& segment = m_segments[findSegmentAtMillis(millis)];
+    return segment.m_tick + (millis - segment.m_millis)/segment.m_millis_per_tick;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+float TempoMap::getTempoAtTick(const int tick) const
+{
+    return m_segments[findSegmentAtTick(tick)].m_bpm;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestTempoMap
+{
+    
+    UNIT_TEST( TestTempoMapConversions )
+    {
+        ptr_vector<ControllerEvent> events;
+        events.push_back( new ControllerEvent(PSEUDO_CONTROLLER_TEMPO, 960*4, convertBPMToTempoBend(60)) );
+        
+        TempoMap map;
+        map.rebuild(120 /* bpm */, events, 960 /* ticks per beat */);
+        
+        require_e(map.getSegmentAmount(), ==, 2, "one segment per distinct tempo");
+        
+        // 4 beats at 120 BPM last 2 seconds
+        require(fabs(map.tickToMillis(960*4) - 2000.0) < 0.5, "time before tempo change is correct");
+        
+        // then each beat lasts ~1 second
+        require(fabs(map.tickToMillis(960*6) - map.tickToMillis(960*4) - 2000.0) < 20.0,
+                "time after tempo change is correct");
+        
+        require(fabs(map.millisToTick(1000.0) - 960*2) < 0.5, "time to tick before tempo change");
+        require(fabs(map.millisToTick(map.tickToMillis(960*5 + 17)) - (960*5 + 17)) < 0.01,
+                "conversions are reversible after tempo change");
+        
+        require(fabs(map.getTempoAtTick(0) - 120.0f) < 0.01f, "main tempo is used before first event");
+        require(fabs(map.getTempoAtTick(960*4) - 60.0f) < 1.0f, "tempo event applies from its tick");
+    }
+    
+}
@@ -0,0 +1,98 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __TEMPO_MAP_H__
+#define __TEMPO_MAP_H__
+
+#include "Midi/ControllerEvent.h"
+#include "ptr_vector.h"
+#include "Utils.h"
+
+#include <vector>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief converts between ticks and time, taking tempo changes into account
+      *
+      * The song is split into segments of constant tempo. For each segment, the tick and time
+      * (in milliseconds since the start of the song) at which it starts are precomputed, so that
+      * conversions in both directions only need a binary search.
+      *
+      * The map is a cache only; the owner is responsible to rebuild it whenever the tempo changes
+      * (see Sequence::getTempoMap).
+      *
+      * @ingroup midi
+      */
+    class TempoMap
+    {
+        struct Segment
+        {
+            int    m_tick;
+            double m_millis;
+            double m_millis_per_tick;
+            float  m_bpm;
+        };
+        
+        /** Sorted by tick; the first segment always starts at tick 0 */
+        std::vector<Segment> m_segments;
+        
+        int  m_ticks_per_beat;
+        bool m_valid;
+        
+        int findSegmentAtTick(const double tick) const;
+        int findSegmentAtMillis(const double millis) const;
+        
+    public:
+        LEAK_CHECK();
+        
+        TempoMap();
+        
+        /** @brief forget the computed segments, the map will need to be rebuilt before being used again */
+        void invalidate() { m_valid = false; }
+        
+        /** @return whether the map was built, and for the given resolution */
+        bool isUpToDate(const int ticksPerBeat) const
+        {
+            return m_valid and m_ticks_per_beat == ticksPerBeat;
+        }
+        
+        /**
+          * @brief build the map from scratch
+          * @param mainTempo    Tempo (in BPM) at the start of the song, until the first tempo event
+          * @param tempoEvents  Tempo change events, sorted by tick
+          * @param ticksPerBeat Resolution of the song
+          */
+        void rebuild(const int mainTempo, const ptr_vector<ControllerEvent>& tempoEvents, const int ticksPerBeat);
+        
+        /** @return the time (in milliseconds since the start of the song) at the given tick */
+        double tickToMillis(const double tick) const;
+        
+        /** @return the tick (possibly fractional) reached after the given time since the start of the song */
+        double millisToTick(const double millis) const;
+        
+        /** @return the tempo (in BPM) at the given tick */
+        float getTempoAtTick(const int tick) const;
+        
+        /** @return the number of segments of constant tempo in the song */
+        int getSegmentAmount() const { return m_segments.size(); }
+    };
+    
+}
+
+#endif
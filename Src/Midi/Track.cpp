@@ -27,6 +27,7 @@
 #include "Editors/ControllerEditor.h"
 #include "Editors/DrumEditor.h"
 
+#include "IO/AriaBinaryFile.h"
 #include "IO/IOUtils.h"
 #include "Midi/Track.h"
 #include "Midi/Sequence.h"
@@ -34,7 +35,10 @@
 #include "Midi/DrumChoice.h"
 #include "Midi/MeasureData.h"
 #include "PreferencesData.h"
+#include "UnitTest.h"
+#include "UnitTestUtils.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "jdksmidi/world.h"
@@ -47,6 +51,9 @@
 
 using namespace AriaMaestosa;
 
+/** last revision given to a track, see Track::getRevision */
+static unsigned int g_last_revision = 0;
+
 // ----------------------------------------------------------------------------------------------------------
 
 Track::Track(Sequence* sequence)
@@ -58,6 +65,7 @@ Track::Track(Sequence* sequence)
 
     m_magnetic_grid = new MagneticGrid();
     
+    m_revision = ++g_last_revision;
     m_volume = 100;
     m_muted = false;
     m_soloed = false;
@@ -151,12 +159,23 @@ void Track::action( Action::SingleTrackAction* actionObj)
     actionObj->setParentTrack(this, new TrackVisitor(this));
     m_sequence->addToUndoStack( actionObj );
     actionObj->perform();
+    markModified();
+    
+    // controller actions may edit the tempo events, that are stored in the sequence
+    m_sequence->invalidateTempoMap();
     
     ASSERT(m_sequence->invariant());
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
+void Track::markModified()
+{
+    m_revision = ++g_last_revision;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 GraphicalTrack* Track::getGraphics()
 {
     return getMainFrame()->getCurrentGraphicalSequence()->getGraphicsFor(this);
@@ -180,8 +199,33 @@ const GraphicalTrack* Track::getGraphics() const
 #endif
 
 
+// Comparison functions used to binary-search the sorted note vectors
+static bool tickBeforeNoteStart(const int tick, const Note* note)
+{
+    return tick < note->getTick();
+}
+
+static bool noteStartBeforeTick(const Note* note, const int tick)
+{
+    return note->getTick() < tick;
+}
+
+static bool tickBeforeNoteEnd(const int tick, const Note* note)
+{
+    return tick < note->getEndTick();
+}
+
+static bool noteEndBeforeTick(const Note* note, const int tick)
+{
+    return note->getEndTick() < tick;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 bool Track::addNote(Note* note, bool check_for_overlapping_notes)
 {
+    markModified();
+    
     // if we're importing, just push it to the end, we know they're in time order
     if (m_sequence->isImportMode())
     {
@@ -190,64 +234,36 @@ bool Track::addNote(Note* note, bool check_for_overlapping_notes)
         return true;
     }
 
-    bool noteAdded=false;
-
     //------------------------ place note on -----------------------
-    // iterate through notes to place them in order
-    const int noteAmount = m_notes.size();
-    for (int n=0; n<noteAmount; n++)
+    // notes are sorted by start tick; the new note goes after all notes starting at or before it
+    std::vector<Note*>& notes = m_notes.contentsVector;
+    std::vector<Note*>::iterator insertAt = std::upper_bound(notes.begin(), notes.end(),
+                                                             note->getTick(), tickBeforeNoteStart);
+    
+    // check for overlapping notes; only notes starting on the same tick can overlap.
+    // the only time where this is not checked is when pasting, because it is then logical that notes are pasted on top of their originals
+    if (check_for_overlapping_notes)
     {
-        // check for overlapping notes
-        // the only time where this is not checked is when pasting, because it is then logical that notes are pasted on top of their originals
-        if (check_for_overlapping_notes and m_notes[n].getTick() == note->getTick() and
-            m_notes[n].getPitchID() == note->getPitchID() and
-           (not m_editor_mode[GUITAR] or m_notes[n].getString() == note->getString()) /*in guitar mode string must also match to be considered overlapping*/ )
+        std::vector<Note*>::iterator it = std::lower_bound(notes.begin(), insertAt,
+                                                           note->getTick(), noteStartBeforeTick);
+        for (; it != insertAt; it++)
         {
-            std::cout << "overlapping notes: rejected" << std::endl;
-            return false;
+            if ((*it)->getPitchID() == note->getPitchID() and
+                (not m_editor_mode[GUITAR] or (*it)->getString() == note->getString()) /*in guitar mode string must also match to be considered overlapping*/ )
+            {
+                std::cout << "overlapping notes: rejected" << std::endl;
+                return false;
+            }
         }
-
-        if (m_notes[n].getTick() > note->getTick())
-        {
-
-            m_notes.add(note, n);
-            noteAdded=true;
-            break;
-        }//endif
-
-
-    }//next
-
-    if (!noteAdded)
-    {
-        // add note at the end, or if the track does not yet contain any note
-        // (both cases in which the for loop either won't find a location for the note, or won't iterate at all)
-        m_notes.push_back(note);
     }
+    
+    m_notes.add(note, insertAt - notes.begin());
 
     //------------------------ place note off -----------------------
-    // iterate through notes to place them in order
-
-    noteAdded = false;
-
-    const int noteOffAmount = m_note_off.size();
-    for (int n=0; n<noteOffAmount; n++)
-    {
-        if (m_note_off[n].getEndTick() > note->getEndTick())
-        {
-            m_note_off.add(note, n);
-            noteAdded = true;
-            break;
-        }//endif
-    }//next
-
-    if (not noteAdded)
-    {
-        // add note at the end, or if the track does not yet contain any note
-        // (both cases in which the for loop either won't find a location for the note, or won't iterate at all)
-        m_note_off.push_back(note);
-    }
-
+    std::vector<Note*>& noteOffs = m_note_off.contentsVector;
+    std::vector<Note*>::iterator offAt = std::upper_bound(noteOffs.begin(), noteOffs.end(),
+                                                          note->getEndTick(), tickBeforeNoteEnd);
+    m_note_off.add(note, offAt - noteOffs.begin());
 
     return true;
 
@@ -259,10 +275,16 @@ void Track::addControlEvent( ControllerEvent* evt, wxFloat64* previousValue )
 {
     ptr_vector<ControllerEvent>* vector;
 
+    markModified();
+    
     if (previousValue != NULL) *previousValue = -1;
 
     // tempo events
-    if (evt->getController() == PSEUDO_CONTROLLER_TEMPO) vector = &m_sequence->m_tempo_events;
+    if (evt->getController() == PSEUDO_CONTROLLER_TEMPO)
+    {
+        vector = &m_sequence->m_tempo_events;
+        m_sequence->invalidateTempoMap();
+    }
     // controller and pitch bend events
     else vector = &m_control_events;
 
@@ -307,6 +329,7 @@ void Track::addControlEvent( ControllerEvent* evt, wxFloat64* previousValue )
 void Track::addControlEvent_import(const int x, const wxFloat64 value, const int controller)
 {
     ASSERT(m_sequence->isImportMode()); // not to be used when not importing
+    markModified();
     m_control_events.push_back(new ControllerEvent(controller, x, value) );
 }
 
@@ -329,6 +352,7 @@ void Track::setNoteEnd_import(const int tick, const int noteID)
     ASSERT_E(noteID,<,m_notes.size());
     ASSERT_E(noteID,>=,0);
 
+    markModified();
     m_notes[noteID].setEndTick(tick);
 }
 
@@ -336,20 +360,60 @@ void Track::setNoteEnd_import(const int tick, const int noteID)
 
 void Track::removeNote(const int id)
 {
+    delete extractNote(id);
+}
 
-    // also delete corresponding note off event
-    const int namount = m_note_off.size();
-    for (int i=0; i<namount; i++)
+// ----------------------------------------------------------------------------------------------------------
+
+Note* Track::extractNote(const int id)
+{
+    markModified();
+    
+    // also remove corresponding note off event. The note off vector is sorted by end tick so
+    // look among the notes ending on the same tick first
+    Note* note = m_notes.get(id);
+    std::vector<Note*>& noteOffs = m_note_off.contentsVector;
+    
+    bool found = false;
+    for (std::vector<Note*>::iterator it = std::lower_bound(noteOffs.begin(), noteOffs.end(),
+                                                            note->getEndTick(), noteEndBeforeTick);
+         it != noteOffs.end() and (*it)->getEndTick() == note->getEndTick(); it++)
     {
-        if (&m_note_off[i] == &m_notes[id])
+        if (*it == note)
         {
-            m_note_off.remove(i);
+            m_note_off.remove(it - noteOffs.begin());
+            found = true;
             break;
         }
     }
+    
+    // the note may have been modified without the note off vector being reordered yet
+    if (not found) m_note_off.remove(note);
 
-    m_notes.erase(id);
+    m_notes.remove(id);
+    return note;
+}
 
+// ----------------------------------------------------------------------------------------------------------
+
+int Track::findNoteID(const Note* note) const
+{
+    // notes are sorted by start tick, so look among the notes starting on the same tick first
+    const std::vector<Note*>& notes = m_notes.contentsVector;
+    for (std::vector<Note*>::const_iterator it = std::lower_bound(notes.begin(), notes.end(),
+                                                                  note->getTick(), noteStartBeforeTick);
+         it != notes.end() and (*it)->getTick() == note->getTick(); it++)
+    {
+        if (*it == note) return it - notes.begin();
+    }
+    
+    // the note may have been modified without the note vector being reordered yet
+    const int count = notes.size();
+    for (int n=0; n<count; n++)
+    {
+        if (notes[n] == note) return n;
+    }
+    return -1;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -359,6 +423,8 @@ void Track::markNoteToBeRemoved(const int id)
     ASSERT_E(id,>=,0);
     ASSERT_E(id,<,m_notes.size());
 
+    markModified();
+    
     // also delete corresponding note off event
     const int namount = m_note_off.size();
     Note* note = m_notes.get(id);
@@ -385,6 +451,7 @@ void Track::removeMarkedNotes()
 
     //std::cout << "removing marked" << std::endl;
 
+    markModified();
     m_notes.removeMarked();
     m_note_off.removeMarked();
 
@@ -406,7 +473,8 @@ int getNoteTick(Note* note)
 
 void Track::reorderNoteVector()
 {
-    m_notes.insertionSort(getNoteTick);
+    // saving reorders too, don't make caches think the track changed when nothing moved
+    if (m_notes.mergeSort(getNoteTick)) markModified();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -418,14 +486,14 @@ int getNoteEndTick(Note* note)
 
 void Track::reorderNoteOffVector()
 {
-    m_note_off.insertionSort(getNoteEndTick);
+    if (m_note_off.mergeSort(getNoteEndTick)) markModified();
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
 void Track::reorderControlVector()
 {
-    m_control_events.insertionSort();
+    if (m_control_events.mergeSort()) markModified();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -580,28 +648,67 @@ int Track::getNoteFretConst(const int id) const
 
 int Track::findFirstNoteInRange(const int fromTick, const int toTick) const
 {
-    const int noteAmount = m_notes.size();
-
-    for (int n=0; n<noteAmount; n++)
-    {
-        if (m_notes[n].getTick() >= fromTick and m_notes[n].getTick() < toTick) return n;
-        if (m_notes[n].getTick() >= toTick) return -1;
-    }
-    return -1;
+    const std::vector<Note*>& notes = m_notes.contentsVector;
+    
+    // first note starting at or after 'fromTick'
+    std::vector<Note*>::const_iterator it = std::lower_bound(notes.begin(), notes.end(),
+                                                             fromTick, noteStartBeforeTick);
+    if (it == notes.end() or (*it)->getTick() >= toTick) return -1;
+    return it - notes.begin();
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
 int Track::findLastNoteInRange(const int fromTick, const int toTick) const
 {
-    const int noteAmount = m_notes.size();
+    const std::vector<Note*>& notes = m_notes.contentsVector;
+    
+    // first note starting at or after 'toTick'; the note before it is the last one starting before 'toTick'
+    std::vector<Note*>::const_iterator it = std::lower_bound(notes.begin(), notes.end(),
+                                                             toTick, noteStartBeforeTick);
+    if (it == notes.begin()) return -1;
+    it--;
+    if ((*it)->getTick() < fromTick) return -1;
+    return it - notes.begin();
+}
 
-    for (int n=noteAmount-1; n>-1; n--)
-    {
-        if (m_notes[n].getTick() >= fromTick and m_notes[n].getTick() < toTick) return n;
-        if (m_notes[n].getTick() < fromTick) return -1;
-    }
-    return -1;
+// ----------------------------------------------------------------------------------------------------------
+
+const NoteIntervalIndex& Track::getNoteIndex() const
+{
+    if (not m_note_index.isUpToDate(m_revision)) m_note_index.rebuild(m_notes, m_revision);
+    return m_note_index;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const NoteColumns& Track::getNoteColumns() const
+{
+    if (not m_note_columns.isUpToDate(m_revision)) m_note_columns.rebuild(m_notes, m_note_off, m_revision);
+    return m_note_columns;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int Track::findFirstNoteEndingAfter(const int tick) const
+{
+    return getNoteIndex().findFirstNoteEndingAfter(tick);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int Track::findNotesIntersecting(const int fromTick, const int toTick, std::vector<int>& noteIDs) const
+{
+    noteIDs.clear();
+    
+    const std::vector<Note*>& notes = m_notes.contentsVector;
+    
+    // notes from 'last' on all start after the range ends; among the others, the index only visits
+    // the branches holding notes that end after the range starts
+    const int last = std::lower_bound(notes.begin(), notes.end(), toTick, noteStartBeforeTick) - notes.begin();
+    getNoteIndex().findNotesEndingAfter(fromTick, last, noteIDs);
+    
+    return noteIDs.size();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -695,6 +802,9 @@ int Track::getFirstSelectedNote() const
 void Track::selectNote(const int id, const bool selected, bool ignoreModifiers)
 {
     ASSERT(id != SELECTED_NOTES); // not supported in this function
+    
+    // selecting is not an edit and keeps the revision, so the note columns are updated as we go
+    const bool updateColumns = m_note_columns.isUpToDate(m_revision);
 
     if (not ignoreModifiers and not Display::isSelectMorePressed() and
         not Display::isSelectLessPressed())
@@ -717,6 +827,7 @@ void Track::selectNote(const int id, const bool selected, bool ignoreModifiers)
                 for (int n=0; n<count; n++)
                 {
                     m_notes[n].setSelected(selected);
+                    if (updateColumns) m_note_columns.setSelected(n, selected);
                 }//next
             }//end if
 
@@ -744,6 +855,8 @@ void Track::selectNote(const int id, const bool selected, bool ignoreModifiers)
                 else if (Display::isSelectLessPressed()) m_notes[id].setSelected(not selected);
             }
         }//end if
+        
+        if (updateColumns) m_note_columns.setSelected(id, m_notes[id].isSelected());
 
     }//end if
 }
@@ -1364,8 +1477,6 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
                          bool selectionOnly,
                          int& startTick)
 {
-    const bool DEBUG_NOTE_ORDER = false;
-    
     // ignore track if it has been muted
     // (but for some reason drum track can't be completely omitted)
     // if we only play selection, ignore mute and play anyway
@@ -1374,9 +1485,6 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         return -1;
     }
 
-    MeasureData* md = m_sequence->getMeasureData();
-    const int lastTickInSong = md->firstTickInMeasure( md->getMeasureAmount() );
-
     // if in manual mode, use the user-specified channel ID and not the stock one
     const bool manual_mode = (m_sequence->getChannelManagementType() == CHANNEL_MANUAL);
 
@@ -1392,14 +1500,6 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
     int firstNoteStartTick = -1;
     int selectedNoteAmount = 0;
 
-    for (int n=0; n<m_notes.size(); n++)
-    {
-        if (m_notes[n].getLength() <= 1)
-        {
-            fprintf(stderr, "EMPTY NOTE\n");
-        }
-    }
-
     if (selectionOnly)
     {
         const int noteAmount = m_notes.size();
@@ -1425,6 +1525,60 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         startTick = firstNoteStartTick;
     }
 
+    // selection previews depend on which notes are selected, which is not tracked; always compile them
+    if (selectionOnly)
+    {
+        const int length = compileMidiEvents(midiTrack, channel, firstNoteStartTick, true);
+        startTick = firstNoteStartTick;
+        return length;
+    }
+    
+    MeasureData* md = m_sequence->getMeasureData();
+    
+    CompiledTrackKey key;
+    key.m_revision          = m_revision;
+    key.m_channel           = channel;
+    key.m_first_tick        = firstNoteStartTick;
+    key.m_last_tick_in_song = md->firstTickInMeasure( md->getMeasureAmount() );
+    key.m_program           = (m_editor_mode[DRUM] ? getDrumKit() : getInstrument());
+    key.m_volume            = m_volume;
+    key.m_played            = m_played;
+    key.m_drum              = m_editor_mode[DRUM];
+    key.m_name              = m_track_name->getValue();
+    
+    if (not m_compiled_events.matches(key))
+    {
+        const int length = compileMidiEvents(m_compiled_events.beginCompiling(), channel,
+                                             firstNoteStartTick, false);
+        m_compiled_events.commit(key, length);
+    }
+    
+    return m_compiled_events.appendTo(midiTrack);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int Track::compileMidiEvents(jdksmidi::MIDITrack* midiTrack,
+                             int channel,
+                             int firstNoteStartTick,
+                             bool selectionOnly)
+{
+    const bool DEBUG_NOTE_ORDER = false;
+    
+    MeasureData* md = m_sequence->getMeasureData();
+    const int lastTickInSong = md->firstTickInMeasure( md->getMeasureAmount() );
+    
+    // the note loops below read the notes in columns, one contiguous array per field
+    const NoteColumns& notes = getNoteColumns();
+    
+    for (int n=0; n<notes.size(); n++)
+    {
+        if (notes.getEndTick(n) - notes.getStartTick(n) <= 1)
+        {
+            fprintf(stderr, "EMPTY NOTE\n");
+        }
+    }
+
     // set bank
     {
         jdksmidi::MIDITimedBigMessage m;
@@ -1566,8 +1720,8 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
     int note_off_id    = 0;
     int control_evt_id = 0;
 
-    const int noteOnAmount     = m_notes.size();
-    const int noteOffAmount    = m_note_off.size();
+    const int noteOnAmount     = notes.size();
+    const int noteOffAmount    = notes.size();
     const int controllerAmount = m_control_events.size();
 
     // find track end
@@ -1589,11 +1743,11 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         // if we only want to play what's selected, skip unselected notes
         if (selectionOnly)
         {
-            while (note_on_id < noteOnAmount   and not m_notes[note_on_id].isSelected())
+            while (note_on_id < noteOnAmount   and not notes.isSelected(note_on_id))
             {
                 note_on_id++;
             }
-            while (note_off_id < noteOffAmount and not m_note_off[note_off_id].isSelected())
+            while (note_off_id < noteOffAmount and not notes.isSelected(notes.getNoteOffID(note_off_id)))
             {
                 note_off_id++;
             }
@@ -1603,9 +1757,9 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         bool have_tick_off = (note_off_id < noteOffAmount);
 
         const int tick_on  = have_tick_on   ?
-                              m_notes[note_on_id].getTick() - firstNoteStartTick   :  -1;
+                              notes.getStartTick(note_on_id) - firstNoteStartTick   :  -1;
         const int tick_off = have_tick_off ?
-                              m_note_off[note_off_id].getEndTick() - firstNoteStartTick :  -1;
+                              notes.getEndTick(notes.getNoteOffID(note_off_id)) - firstNoteStartTick :  -1;
         
         // ignore control events when only playing selection
         bool have_tick_control = (control_evt_id < controllerAmount and not selectionOnly);
@@ -1627,7 +1781,7 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         //  ------------------------ add note on event ------------------------
         if (activeMin == 2)
         {
-            const int time = m_notes[note_on_id].getTick() - firstNoteStartTick;
+            const int time = notes.getStartTick(note_on_id) - firstNoteStartTick;
             if (time >= 0 and (time + firstNoteStartTick) <= lastTickInSong)
             {
                 ASSERT_E(time, >=, debug_curr_time); debug_curr_time = time;
@@ -1636,17 +1790,17 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
                 
                 if (m_editor_mode[DRUM])
                 {
-                    m.SetNoteOn(channel, m_notes[note_on_id].getPitchID(), computeNoteVolume(note_on_id));
+                    m.SetNoteOn(channel, notes.getPitchID(note_on_id), computeNoteVolume(notes.getVolume(note_on_id)));
                 }
                 else
                 {
-                    m.SetNoteOn(channel, 131-m_notes[note_on_id].getPitchID(), computeNoteVolume(note_on_id));
+                    m.SetNoteOn(channel, 131-notes.getPitchID(note_on_id), computeNoteVolume(notes.getVolume(note_on_id)));
                 }
 
                 // find track end
-                if (m_notes[note_on_id].getEndTick() > last_event_tick)
+                if (notes.getEndTick(note_on_id) > last_event_tick)
                 {
-                    last_event_tick = m_notes[note_on_id].getEndTick();
+                    last_event_tick = notes.getEndTick(note_on_id);
                 }
 
                 if (not midiTrack->PutEvent( m ))
@@ -1661,7 +1815,8 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         else if (activeMin == 0)
         {
 
-            const int time=m_note_off[note_off_id].getEndTick() - firstNoteStartTick;
+            const int noteID = notes.getNoteOffID(note_off_id);
+            const int time = notes.getEndTick(noteID) - firstNoteStartTick;
             if (time >= 0 and (time + firstNoteStartTick) <= lastTickInSong)
             {
                 ASSERT_E(time, >=, debug_curr_time); debug_curr_time = time;
@@ -1670,11 +1825,11 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
                 
                 if (m_editor_mode[DRUM])
                 {
-                    m.SetNoteOff( channel, m_note_off[note_off_id].getPitchID(), 0 );
+                    m.SetNoteOff( channel, notes.getPitchID(noteID), 0 );
                 }
                 else
                 {
-                    m.SetNoteOff( channel, 131 - m_note_off[note_off_id].getPitchID(), 0 );
+                    m.SetNoteOff( channel, 131 - notes.getPitchID(noteID), 0 );
                 }
 
                 // find track end
@@ -1854,8 +2009,6 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
 
     }//wend
 
-    if (selectionOnly) startTick = firstNoteStartTick;
-
     return last_event_tick - firstNoteStartTick;
 }
 
@@ -1867,7 +2020,7 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
 #pragma mark Serialization
 #endif
 
-void Track::saveToFile(wxFileOutputStream& fileout)
+void Track::saveToFile(wxOutputStream& fileout, const bool includeEvents)
 {
     reorderNoteVector();
     reorderNoteOffVector();
@@ -1919,23 +2072,180 @@ void Track::saveToFile(wxFileOutputStream& fileout)
 
     getGraphics()->saveToFile(fileout);
 
-    // notes
+    if (includeEvents)
+    {
+        // notes
+        const int noteCount = m_notes.size();
+        for (int n=0; n<noteCount; n++)
+        {
+            m_notes[n].saveToFile(fileout);
+        }
+
+        // controller changes
+        const int ctrlCount = m_control_events.size();
+        for (int n=0; n<ctrlCount; n++)
+        {
+            m_control_events[n].saveToFile(fileout);
+        }
+    }
+
+    writeData(wxT("</track>\n\n"), fileout );
+
+
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Track::saveEventsToBinary(BinaryWriter& out)
+{
+    reorderNoteVector();
+    reorderControlVector();
+
+    // each property is stored as its own column; ticks are stored as deltas from the previous event
+    // since both vectors are in time order, which keeps values small and compresses well
     const int noteCount = m_notes.size();
+    out.writeU32(noteCount);
+
+    int previousTick = 0;
     for (int n=0; n<noteCount; n++)
     {
-        m_notes[n].saveToFile(fileout);
+        out.writeI32(m_notes[n].getTick() - previousTick);
+        previousTick = m_notes[n].getTick();
     }
+    for (int n=0; n<noteCount; n++) out.writeI32(m_notes[n].getLength());
+    // frets are negative for notes lower than the lowest string, so they keep their full 16 bits
+    for (int n=0; n<noteCount; n++) out.writeU16(m_notes[n].getFretConst() & 0xFFFF);
+    for (int n=0; n<noteCount; n++) out.writeU8(m_notes[n].getPitchID());
+    for (int n=0; n<noteCount; n++) out.writeU8(m_notes[n].getVolume());
+    for (int n=0; n<noteCount; n++) out.writeU8(m_notes[n].getStringConst() + 1); // -1 (unset) stored as 0
+    for (int n=0; n<noteCount; n++) out.writeU8(m_notes[n].getPreferredAccidentalSign() + 1);
+    for (int n=0; n<noteCount; n++) out.writeU8(m_notes[n].isSelected() ? 1 : 0);
 
-    // controller changes
     const int ctrlCount = m_control_events.size();
+    out.writeU32(ctrlCount);
+
+    previousTick = 0;
     for (int n=0; n<ctrlCount; n++)
     {
-        m_control_events[n].saveToFile(fileout);
+        out.writeI32(m_control_events[n].getTick() - previousTick);
+        previousTick = m_control_events[n].getTick();
     }
+    for (int n=0; n<ctrlCount; n++) out.writeU16(m_control_events[n].getController());
+    for (int n=0; n<ctrlCount; n++) out.writeF64(m_control_events[n].getValue());
+}
 
-    writeData(wxT("</track>\n\n"), fileout );
+// ----------------------------------------------------------------------------------------------------------
+
+bool Track::readEventsFromBinary(BinaryReader& in)
+{
+    ASSERT(m_sequence->isImportMode());
+
+    markModified();
+    m_notes.clearAndDeleteAll();
+    m_note_off.clearWithoutDeleting(); // have already been deleted by previous command
+    m_control_events.clearAndDeleteAll();
+
+    const int noteCount = in.readU32();
+    if (in.failed() or noteCount < 0 or noteCount > 0x0FFFFFFF) return false;
+
+    // each column holds one byte or more per note; reject counts the data cannot possibly hold
+    // before allocating anything
+    const unsigned char* starts  = in.readBytes(noteCount*4);
+    const unsigned char* lengths = in.readBytes(noteCount*4);
+    const unsigned char* frets   = in.readBytes(noteCount*2);
+    const unsigned char* columns = in.readBytes(noteCount*5);
+    if (starts == NULL or lengths == NULL or frets == NULL or columns == NULL) return false;
+
+    BinaryReader startColumn(starts, noteCount*4);
+    BinaryReader lengthColumn(lengths, noteCount*4);
+    BinaryReader fretColumn(frets, noteCount*2);
+
+    const int stringCount = m_tuning->tuning.size();
+
+    m_notes.contentsVector.reserve(noteCount);
+    m_note_off.contentsVector.reserve(noteCount);
+    int tick = 0;
+    for (int n=0; n<noteCount; n++)
+    {
+        tick += startColumn.readI32();
+        const int length = lengthColumn.readI32();
+        int       fret   = (short)fretColumn.readU16();
+
+        const int pitch          = columns[n];
+        const int volume         = columns[noteCount + n];
+        int       string         = columns[noteCount*2 + n] - 1;
+        const int accidentalSign = columns[noteCount*3 + n] - 1;
+
+        // values out of range would index past the end of tables (pitch names, guitar strings, ...)
+        // later on, so consider the data corrupt rather than loading them
+        if (tick < 0 or length < 0 or pitch > 127 or volume > 127 or string >= stringCount or
+            accidentalSign > PITCH_SIGN_NONE)
+        {
+            std::cerr << "[Track] ERROR: note " << n << " has out of range values (tick " << tick
+                      << ", length " << length << ", pitch " << pitch << ", volume " << volume
+                      << ", string " << string << ", accidental " << accidentalSign << ")" << std::endl;
+            return false;
+        }
+
+        // string and fret are derived from the pitch; if they give a pitch out of range, forget them
+        // so that they get computed again from the pitch when needed
+        if (string >= 0)
+        {
+            const int fretPitch = m_tuning->tuning[string] - fret;
+            if (fretPitch < 0 or fretPitch > 127)
+            {
+                string = -1;
+                fret   = -1;
+            }
+        }
+
+        Note* note = new Note(this, pitch, tick, tick + length, volume, string, fret);
+        note->setPreferredAccidentalSign(accidentalSign);
+        note->setSelected(columns[noteCount*4 + n] != 0);
+        addNote(note);
+    }
+
+    const int ctrlCount = in.readU32();
+    if (in.failed() or ctrlCount < 0 or ctrlCount > 0x0FFFFFFF) return false;
+
+    const unsigned char* ticks       = in.readBytes(ctrlCount*4);
+    const unsigned char* controllers = in.readBytes(ctrlCount*2);
+    const unsigned char* values      = in.readBytes(ctrlCount*8);
+    if (ticks == NULL or controllers == NULL or values == NULL) return false;
+
+    BinaryReader tickColumn(ticks, ctrlCount*4);
+    BinaryReader controllerColumn(controllers, ctrlCount*2);
+    BinaryReader valueColumn(values, ctrlCount*8);
+
+    tick = 0;
+    for (int n=0; n<ctrlCount; n++)
+    {
+        tick += tickColumn.readI32();
+        if (tick < 0) return false;
+        const int controller = controllerColumn.readU16();
+        m_control_events.push_back( new ControllerEvent(controller, tick, valueColumn.readF64()) );
+    }
+
+    finishLoading();
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
 
+void Track::finishLoading()
+{
+    reorderNoteVector();
+    reorderNoteOffVector();
+    reorderControlVector();
 
+    ASSERT(invariant());
+
+    // now that we have the set of notes, we can collapse the view if needed
+    GraphicalTrack* gtrack = getGraphics();
+    if (gtrack != NULL and gtrack->getDrumEditor()->showOnlyUsedDrums())
+    {
+        gtrack->getDrumEditor()->useCustomDrumSet();
+    }
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -1944,6 +2254,7 @@ void Track::saveToFile(wxFileOutputStream& fileout)
 bool Track::readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq)
 {
 
+    markModified();
     m_notes.clearAndDeleteAll();
     m_note_off.clearWithoutDeleting(); // have already been deleted by previous command
     m_control_events.clearAndDeleteAll();
@@ -2327,19 +2638,7 @@ bool Track::readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq)
 
                 if (strcmp("track", xml->getNodeName()) == 0)
                 {
-                    reorderNoteVector();
-                    reorderNoteOffVector();
-                    reorderControlVector();
-
-                    ASSERT(invariant());
-
-                    // now that we have the set of notes, we can collapse the view if needed
-                    GraphicalTrack* gtrack = getGraphics();
-                    if (gtrack->getDrumEditor()->showOnlyUsedDrums())
-                    {
-                        gtrack->getDrumEditor()->useCustomDrumSet();
-                    }
-
+                    finishLoading();
                     return true;
                 }
             }
@@ -2364,9 +2663,9 @@ bool Track::readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq)
 // In the MIDI standard, a note velocity of 0 turns a note on event into a note
 // off event, don't let that happen by using a max
 // prevents value from being greater than 127 by using a min
-int Track::computeNoteVolume(int noteId)
+int Track::computeNoteVolume(const int noteVolume) const
 {
-    return std::min(SCHAR_MAX, std::max(1, m_notes[noteId].getVolume() * m_volume / 100));
+    return std::min(SCHAR_MAX, std::max(1, noteVolume * m_volume / 100));
 }
 
 
@@ -2407,3 +2706,225 @@ bool Track::invariant()
     
     return true;
 }
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestTrack
+{
+    
+    UNIT_TEST( TestNoteRangeQueries )
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        Track* t = new Track(seq);
+        
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(100 /* pitch */, 0   /* start */, 1000 /* end */, 127 /* volume */, -1);
+            t->addNote_import(101 /* pitch */, 100 /* start */, 200  /* end */, 127 /* volume */, -1);
+            t->addNote_import(102 /* pitch */, 300 /* start */, 400  /* end */, 127 /* volume */, -1);
+            t->addNote_import(103 /* pitch */, 500 /* start */, 600  /* end */, 127 /* volume */, -1);
+        }
+        t->reorderNoteOffVector();
+        seq->addTrack(t);
+        
+        require_e(t->findFirstNoteInRange(50, 400),  ==, 1,  "first note starting in range is found");
+        require_e(t->findLastNoteInRange (50, 400),  ==, 2,  "last note starting in range is found");
+        require_e(t->findFirstNoteInRange(600, 700), ==, -1, "no note starts in range");
+        require_e(t->findLastNoteInRange (600, 700), ==, -1, "no note starts in range");
+        
+        std::vector<int> ids;
+        require_e(t->findNotesIntersecting(350, 450, ids), ==, 2, "sustained notes are found");
+        require_e(ids[0], ==, 0, "sustained notes are found");
+        require_e(ids[1], ==, 2, "sustained notes are found");
+        
+        require_e(t->findNotesIntersecting(1000, 2000, ids), ==, 0, "note ending at range start does not intersect");
+        require_e(t->findFirstNoteEndingAfter(150), ==, 0, "long note is found");
+        
+        // the index must follow edits
+        require(t->addNote(new Note(t, 104, 1500, 1600, 127)), "note is added");
+        require_e(t->findNotesIntersecting(1000, 2000, ids), ==, 1, "index was updated after adding a note");
+        require_e(ids[0], ==, 4, "index was updated after adding a note");
+        require_e(t->getNoteOffVector()[4].getEndTick(), ==, 1600, "note off vector is properly ordered");
+        
+        Note* overlapping = new Note(t, 102, 300, 350, 127);
+        require(not t->addNote(overlapping), "overlapping note is rejected");
+        delete overlapping;
+        
+        require(t->addNote(new Note(t, 105, 300, 350, 127)), "note on same tick but another pitch is accepted");
+        require_e(t->getNote(3)->getPitchID(), ==, 105, "note inserted after notes on the same tick");
+        require_e(t->getNoteOffVector()[1].getEndTick(), ==, 350, "note off vector is properly ordered");
+        
+        t->removeNote(3);
+        require_e(t->getNoteAmount(), ==, 5, "note was removed");
+        require_e(t->getNoteOffVector().size(), ==, 5, "note off was removed");
+        require_e(t->getNoteOffVector()[1].getEndTick(), ==, 400, "the right note off was removed");
+        
+        delete seq;
+    }
+    
+    // ----------------------------------------------------------------------------------------------------------
+    
+    UNIT_TEST( TestNoteIntervalQueriesMatchScan )
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        Track* t = new Track(seq);
+        
+        // mostly short notes, with a few long ones spanning many others
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            unsigned int random = 12345;
+            for (int n=0; n<1000; n++)
+            {
+                random = random*1103515245 + 12345;
+                const int length = ((random >> 16) % 50 == 0 ? 5000 : 10 + (random >> 8) % 200);
+                t->addNote_import(40 + n % 60 /* pitch */, n*20 /* start */, n*20 + length /* end */,
+                                  127 /* volume */, -1);
+            }
+        }
+        t->reorderNoteOffVector();
+        seq->addTrack(t);
+        
+        std::vector<int> ids;
+        for (int from=0; from<22000; from += 370)
+        {
+            const int to = from + 1 + from % 700;
+            
+            std::vector<int> expected;
+            for (int n=0; n<t->getNoteAmount(); n++)
+            {
+                if (t->getNote(n)->getTick() < to and t->getNote(n)->getEndTick() > from) expected.push_back(n);
+            }
+            
+            t->findNotesIntersecting(from, to, ids);
+            require(ids == expected, "the interval index finds the same notes as a full scan");
+            
+            int firstEndingAfter = 0;
+            while (firstEndingAfter < t->getNoteAmount() and
+                   t->getNote(firstEndingAfter)->getEndTick() <= from) firstEndingAfter++;
+            require_e(t->findFirstNoteEndingAfter(from), ==, firstEndingAfter, "first note ending after tick");
+        }
+        
+        delete seq;
+    }
+    
+    UNIT_TEST( TestNoteColumns )
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        Track* t = new Track(seq);
+        
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(100 /* pitch */, 0   /* start */, 1000 /* end */, 90  /* volume */, -1);
+            t->addNote_import(101 /* pitch */, 100 /* start */, 200  /* end */, 100 /* volume */, -1);
+            t->addNote_import(102 /* pitch */, 300 /* start */, 400  /* end */, 110 /* volume */, -1);
+        }
+        t->reorderNoteOffVector();
+        seq->addTrack(t);
+        
+        const NoteColumns& columns = t->getNoteColumns();
+        require_e(columns.size(), ==, 3, "all notes are in the columns");
+        for (int n=0; n<3; n++)
+        {
+            require_e(columns.getStartTick(n), ==, t->getNoteStartInMidiTicks(n), "start ticks match the notes");
+            require_e(columns.getEndTick(n),   ==, t->getNoteEndInMidiTicks(n),   "end ticks match the notes");
+            require_e(columns.getPitchID(n),   ==, t->getNotePitchID(n),          "pitches match the notes");
+            require_e(columns.getVolume(n),    ==, t->getNoteVolume(n),           "volumes match the notes");
+            require(not columns.isSelected(n), "no note is selected");
+        }
+        
+        require_e(columns.getNoteOffID(0), ==, 1, "note offs are in end order");
+        require_e(columns.getNoteOffID(1), ==, 2, "note offs are in end order");
+        require_e(columns.getNoteOffID(2), ==, 0, "note offs are in end order");
+        
+        // selecting does not change the revision, the columns must follow anyway
+        t->selectNote(2, true, true);
+        require(t->getNoteColumns().isSelected(2), "selection is reflected in the columns");
+        t->selectNote(ALL_NOTES, false, true);
+        require(not t->getNoteColumns().isSelected(2), "deselection is reflected in the columns");
+        
+        // edits rebuild the columns
+        require(t->addNote(new Note(t, 103, 50, 60, 127)), "note is added");
+        require_e(t->getNoteColumns().size(), ==, 4, "added note is in the columns");
+        require_e(t->getNoteColumns().getPitchID(1), ==, 103, "added note is in start order");
+        require_e(t->getNoteColumns().getNoteOffID(0), ==, 1, "added note ends first");
+        
+        // edits that keep the notes in place refresh the columns without remapping them
+        t->getNote(1)->setVolume(30);
+        t->markModified();
+        require_e(t->getNoteColumns().getVolume(1), ==, 30, "edited volume is in the columns");
+        require_e(t->getNoteColumns().getNoteOffID(0), ==, 1, "note offs are kept");
+        
+        t->getNote(1)->setEndTick(500);
+        t->reorderNoteOffVector();
+        require_e(t->getNoteColumns().getEndTick(1), ==, 500, "edited end tick is in the columns");
+        require_e(t->getNoteColumns().getNoteOffID(0), ==, 2, "note offs follow the new end order");
+        require_e(t->getNoteColumns().getNoteOffID(1), ==, 3, "note offs follow the new end order");
+        require_e(t->getNoteColumns().getNoteOffID(2), ==, 1, "note offs follow the new end order");
+        require_e(t->getNoteColumns().getNoteOffID(3), ==, 0, "note offs follow the new end order");
+        
+        delete seq;
+    }
+    
+    UNIT_TEST( TestCompiledEventsCache )
+    {
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+        
+        Track* t = new Track(seq);
+        
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(100 /* pitch */, 0   /* start */, 100 /* end */, 127 /* volume */, -1);
+            t->addNote_import(101 /* pitch */, 200 /* start */, 300 /* end */, 127 /* volume */, -1);
+        }
+        t->reorderNoteOffVector();
+        seq->addTrack(t);
+        
+        CompiledTrackCache::resetCounters();
+        
+        int startTick = -1;
+        jdksmidi::MIDITrack first;
+        const int length = t->addMidiEvents(&first, 0, 0, false, startTick);
+        require_e(CompiledTrackCache::getMissCount(), ==, 1, "events are compiled the first time");
+        
+        jdksmidi::MIDITrack second;
+        require_e(t->addMidiEvents(&second, 0, 0, false, startTick), ==, length, "cached length is returned");
+        require_e(CompiledTrackCache::getHitCount(), ==, 1, "events are reused when nothing changed");
+        require_e(second.GetNumEvents(), ==, first.GetNumEvents(), "cached events are complete");
+        
+        for (int n=0; n<first.GetNumEvents(); n++)
+        {
+            require(*first.GetEventAddress(n) == *second.GetEventAddress(n), "cached events are identical");
+        }
+        
+        // a different channel produces different events
+        jdksmidi::MIDITrack otherChannel;
+        t->addMidiEvents(&otherChannel, 1, 0, false, startTick);
+        require_e(CompiledTrackCache::getMissCount(), ==, 2, "changing parameters invalidates the cache");
+        
+        // editing the track must invalidate the cache too
+        require(t->addNote(new Note(t, 102, 400, 500, 127)), "note is added");
+        jdksmidi::MIDITrack third;
+        t->addMidiEvents(&third, 1, 0, false, startTick);
+        require_e(CompiledTrackCache::getMissCount(), ==, 3, "editing the track invalidates the cache");
+        require_e(third.GetNumEvents(), ==, first.GetNumEvents() + 2, "new note is part of compiled events");
+        
+        delete seq;
+    }
+    
+}
@@ -17,7 +17,7 @@
 #ifndef __TRACK_H__
 #define __TRACK_H__
 
-class wxFileOutputStream;
+class wxOutputStream;
 // forward
 namespace irr { namespace io {
     class IXMLBase;
@@ -26,19 +26,26 @@ namespace irr { namespace io {
 
 namespace jdksmidi { class MIDITrack; }
 
+#include "Midi/CompiledTrackCache.h"
 #include "Midi/ControllerEvent.h"
 #include "Midi/DrumChoice.h"
 #include "Midi/GuitarTuning.h"
 #include "Midi/InstrumentChoice.h"
 #include "Midi/MagneticGrid.h"
 #include "Midi/Note.h"
+#include "Midi/NoteColumns.h"
+#include "Midi/NoteIntervalIndex.h"
 
 #include "ptr_vector.h"
 
+#include <vector>
+
 namespace AriaMaestosa
 {
     
     class Sequence; // forward
+    class BinaryReader;
+    class BinaryWriter;
     class GraphicalTrack;
     class MainFrame;
     class ControllerEvent;
@@ -113,6 +120,25 @@ namespace AriaMaestosa
         /** Holds all controller events from this track */
         ptr_vector<ControllerEvent> m_control_events;
         
+        /** Changed every time the contents of this track may have changed (see Track::getRevision) */
+        unsigned int m_revision;
+        
+        /** Interval tree over 'm_notes', rebuilt lazily when 'm_revision' changes */
+        mutable NoteIntervalIndex m_note_index;
+        
+        /** @return the note interval index, rebuilding it first if the track changed since it was built */
+        const NoteIntervalIndex& getNoteIndex() const;
+        
+        /** Columnar copy of 'm_notes', rebuilt lazily when 'm_revision' changes */
+        mutable NoteColumns m_note_columns;
+        
+        /** MIDI events generated the last time this track was played, reused while nothing changed */
+        CompiledTrackCache m_compiled_events;
+        
+        /** @brief actual implementation of 'addMidiEvents', called when compiled events can't be reused */
+        int compileMidiEvents(jdksmidi::MIDITrack* midiTrack, int channel, int firstNoteStartTick,
+                              bool selectionOnly);
+        
         int m_track_id;
         
         /** Only used if in manual channel management mode */
@@ -162,7 +188,7 @@ namespace AriaMaestosa
         void doSetDrumKit(int i, bool recursive=false);
         
     
-        int computeNoteVolume(int noteId);
+        int computeNoteVolume(const int noteVolume) const;
         
         
         /** The sequence this track is part of */
@@ -206,15 +232,25 @@ namespace AriaMaestosa
                 m_track = other.m_track;
             }
             
+            // Handing out the vectors for modification invalidates any index built over them
             ptr_vector<Note>&            getNotesVector()
             {
                 ASSERT( MAGIC_NUMBER_OK() );
                 ASSERT( MAGIC_NUMBER_OK_FOR(*m_track) );
                 ASSERT( MAGIC_NUMBER_OK_FOR(m_track->m_notes) );
+                m_track->markModified();
                 return m_track->m_notes;
             }
-            ptr_vector<Note, REF>&       getNoteOffVector()      { return m_track->m_note_off;       }
-            ptr_vector<ControllerEvent>& getControlEventVector() { return m_track->m_control_events; }
+            ptr_vector<Note, REF>&       getNoteOffVector()
+            {
+                m_track->markModified();
+                return m_track->m_note_off;
+            }
+            ptr_vector<ControllerEvent>& getControlEventVector()
+            {
+                m_track->markModified();
+                return m_track->m_control_events;
+            }
             
             LEAK_CHECK();
         };
@@ -240,7 +276,10 @@ namespace AriaMaestosa
         void setInstrumentListener(IInstrumentChoiceListener* l) { m_next_instrument_listener = l; }
         void setDrumListener      (IDrumChoiceListener* l)       { m_next_drumkit_listener    = l; }
         
-        /** @brief place events in time order */
+        /**
+          * @brief place events in time order
+          * The revision (see getRevision) only changes if events actually had to be moved.
+          */
         void reorderNoteVector();
         
         /** @brief place events in time order */
@@ -251,6 +290,18 @@ namespace AriaMaestosa
         
         void removeNote(const int id);
         
+        /**
+          * @brief remove a note (and its note off event) from this track without deleting it
+          * @return the note, which the caller now owns and may add back later with addNote
+          */
+        Note* extractNote(const int id);
+        
+        /**
+          * @param note a note that is still allocated (it does not need to be in this track)
+          * @return the ID of this note in this track, or -1 if it is not part of this track
+          */
+        int findNoteID(const Note* note) const;
+        
         void setId(const int id);
         
         int getId() const { return m_track_id; }
@@ -342,6 +393,13 @@ namespace AriaMaestosa
         /** use only if other getters can't provide what you want! (FIXME) */
         Note* getNote                 (const int id);
         
+        /**
+         * @brief the notes of this track in columns, for loops that visit many notes
+         * @return the columns, rebuilt first if the track changed since they were last built. The
+         *         reference stays valid, but its contents must be fetched again after any edit.
+         */
+        const NoteColumns& getNoteColumns() const;
+        
         /**
          * Returns the first note in the given range, or -1 if there is none
          */
@@ -352,6 +410,35 @@ namespace AriaMaestosa
          */
         int findLastNoteInRange(const int fromTick, const int toTick) const;
         
+        /**
+         * @brief find the first note that is still sounding after the given tick
+         * @return the ID of the first note (in start order) that ends after 'tick'; all notes before it
+         *         end at or before 'tick'. Returns the amount of notes if there is no such note.
+         */
+        int findFirstNoteEndingAfter(const int tick) const;
+        
+        /**
+         * @brief find all notes that intersect the range [fromTick, toTick)
+         *
+         * Unlike findFirstNoteInRange/findLastNoteInRange, which only consider where notes start,
+         * this also returns notes that started before 'fromTick' but are still sounding.
+         *
+         * @param[out] noteIDs Receives the IDs of the matching notes, in start order
+         * @return the number of notes that were found
+         */
+        int findNotesIntersecting(const int fromTick, const int toTick, std::vector<int>& noteIDs) const;
+        
+        /**
+         * @brief  Used to know when data derived from this track must be recomputed.
+         * @return a number that changes every time notes or events of this track may have changed.
+         *         Revisions are never reused, even across tracks, so a (track, revision) pair stays
+         *         unique after the track is deleted and another one takes its address.
+         */
+        unsigned int getRevision() const { return m_revision; }
+        
+        /** @brief signal that the notes or events of this track were (or are about to be) modified */
+        void markModified();
+        
         void playNote(const int id, const bool noteChange=false);
         
         void markNoteToBeRemoved(const int id);
@@ -435,6 +522,7 @@ namespace AriaMaestosa
           * @param id of the control event to retrieve (from 0 to count-1)
           * @param controllerTypeID only to determine whether the app is searching for a control event
           *                         or for a tempo event (FIXME: ugly)
+          * @note  tempo events may only be modified from within an action, which invalidates the tempo map
           */
         ControllerEvent* getControllerEvent(const int id, const int controllerTypeID);
         
@@ -511,6 +599,9 @@ namespace AriaMaestosa
         /**
          * @brief Add Midi Events to JDKMidi track object
          * @param channel in manual channel mode, this argument is NOT considered
+         *
+         * Unless only the selection is played, the generated events are cached and reused the next
+         * time if neither the track nor the parameters changed (see CompiledTrackCache).
          */
         int addMidiEvents(jdksmidi::MIDITrack* track, int channel, int firstMeasure,
                           bool selectionOnly, int& startTick); // returns length
@@ -589,8 +680,29 @@ namespace AriaMaestosa
         bool invariant();
         
         // serialization
-        void saveToFile(wxFileOutputStream& fileout);
+        
+        /**
+          * @param includeEvents whether to write notes and controller events; binary .aria files store
+          *                      them separately, see saveEventsToBinary
+          */
+        void saveToFile(wxOutputStream& fileout, const bool includeEvents=true);
         bool readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq);
+        
+        /** @brief write the notes and controller events of this track as packed columns */
+        void saveEventsToBinary(BinaryWriter& out);
+        
+        /**
+          * @brief replace the notes and controller events of this track with columns written by
+          *        saveEventsToBinary
+          * @note  the sequence must be in import mode
+          * @return false if the data is truncated or holds values out of range
+          */
+        bool readEventsFromBinary(BinaryReader& in);
+        
+    private:
+        
+        /** @brief sort events and update the views that depend on them once the track is loaded */
+        void finishLoading();
     };
     
 }
@@ -0,0 +1,283 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ObjectPool.h"
+
+#include "UnitTest.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <wx/thread.h>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    /** never destroyed, objects may outlive any static destructor */
+    std::vector<ObjectPool*>* g_pools = NULL;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+ObjectPool::ObjectPool(const char* name, const size_t objectSize, const int blocksPerSlab)
+{
+    // blocks must be big enough to hold the free list link, and keep any type aligned
+    const size_t alignment = sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*);
+    const size_t size = (objectSize < sizeof(void*) ? sizeof(void*) : objectSize);
+    
+    m_name             = name;
+    m_block_size       = (size + alignment - 1) / alignment * alignment;
+    m_blocks_per_slab  = blocksPerSlab;
+    m_free_list        = NULL;
+    m_live_count       = 0;
+    m_peak_count       = 0;
+    m_allocation_count = 0;
+    m_released_bytes   = 0;
+    
+    if (g_pools == NULL) g_pools = new std::vector<ObjectPool*>();
+    g_pools->push_back(this);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+ObjectPool::~ObjectPool()
+{
+    for (unsigned int n=0; n<m_slabs.size(); n++) ::operator delete(m_slabs[n]);
+    
+    for (unsigned int n=0; n<g_pools->size(); n++)
+    {
+        if ((*g_pools)[n] == this)
+        {
+            g_pools->erase(g_pools->begin() + n);
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ObjectPool::addSlab()
+{
+    char* slab = (char*)::operator new(m_block_size * m_blocks_per_slab);
+    m_slabs.push_back(slab);
+    
+    // chain the new blocks, first block of the slab first
+    for (int n=m_blocks_per_slab-1; n>=0; n--)
+    {
+        void* block = slab + n*m_block_size;
+        *(void**)block = m_free_list;
+        m_free_list = block;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void* ObjectPool::allocate(const size_t size)
+{
+    if (size > m_block_size) return ::operator new(size);
+    
+    ASSERT(wxThread::IsMain());
+    
+    if (m_free_list == NULL) addSlab();
+    
+    void* block = m_free_list;
+    m_free_list = *(void**)block;
+    
+    m_live_count++;
+    m_allocation_count++;
+    if (m_live_count > m_peak_count) m_peak_count = m_live_count;
+    
+    return block;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ObjectPool::deallocate(void* block, const size_t size)
+{
+    if (block == NULL) return;
+    if (size > m_block_size)
+    {
+        ::operator delete(block);
+        return;
+    }
+    
+    ASSERT(wxThread::IsMain());
+    ASSERT_E(m_live_count, >, 0);
+    
+    *(void**)block = m_free_list;
+    m_free_list = block;
+    m_live_count--;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int ObjectPool::findSlab(const void* block) const
+{
+    std::vector<char*>::const_iterator it = std::upper_bound(m_slabs.begin(), m_slabs.end(), (char*)block,
+                                                             std::less<char*>());
+    ASSERT(it != m_slabs.begin());
+    return (it - m_slabs.begin()) - 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ObjectPool::releaseUnusedMemory()
+{
+    if (m_slabs.empty()) return 0;
+    
+    ASSERT(wxThread::IsMain());
+    
+    // count the free blocks of each slab
+    std::sort(m_slabs.begin(), m_slabs.end(), std::less<char*>());
+    std::vector<int> freeBlocks(m_slabs.size(), 0);
+    for (void* block = m_free_list; block != NULL; block = *(void**)block)
+    {
+        freeBlocks[findSlab(block)]++;
+    }
+    
+    std::vector<bool> release(m_slabs.size(), false);
+    bool any = false;
+    for (unsigned int n=0; n<m_slabs.size(); n++)
+    {
+        if (freeBlocks[n] == m_blocks_per_slab) release[n] = any = true;
+    }
+    if (not any) return 0;
+    
+    // unlink the blocks of the slabs about to be freed, keeping the others in the same order
+    void* remaining = NULL;
+    void** tail = &remaining;
+    for (void* block = m_free_list; block != NULL; block = *(void**)block)
+    {
+        if (release[findSlab(block)]) continue;
+        *tail = block;
+        tail  = (void**)block;
+    }
+    *tail = NULL;
+    m_free_list = remaining;
+    
+    size_t freed = 0;
+    std::vector<char*> kept;
+    for (unsigned int n=0; n<m_slabs.size(); n++)
+    {
+        if (release[n])
+        {
+            ::operator delete(m_slabs[n]);
+            freed += m_block_size * m_blocks_per_slab;
+        }
+        else
+        {
+            kept.push_back(m_slabs[n]);
+        }
+    }
+    m_slabs.swap(kept);
+    
+    m_released_bytes += freed;
+    return freed;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const std::vector<ObjectPool*>& ObjectPool::getPools()
+{
+    if (g_pools == NULL) g_pools = new std::vector<ObjectPool*>();
+    return *g_pools;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+size_t ObjectPool::releaseAllUnusedMemory()
+{
+    if (g_pools == NULL) return 0;
+    
+    size_t freed = 0;
+    for (unsigned int n=0; n<g_pools->size(); n++) freed += (*g_pools)[n]->releaseUnusedMemory();
+    return freed;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ------------------------------------------------ Tests ---------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestObjectPool
+{
+    using namespace AriaMaestosa;
+    
+    UNIT_TEST( TestBlocksAreRecycled )
+    {
+        ObjectPool pool("test", 20, 4);
+        
+        std::vector<void*> blocks;
+        for (int n=0; n<10; n++)
+        {
+            char* block = (char*)pool.allocate(20);
+            for (int i=0; i<20; i++) block[i] = n; // blocks must not overlap
+            blocks.push_back(block);
+        }
+        require_e(pool.getSlabCount(), ==, 3, "slabs are added as needed");
+        require_e(pool.getLiveCount(), ==, 10, "live blocks are counted");
+        
+        for (int n=0; n<10; n++)
+        {
+            for (int i=0; i<20; i++) require_e(((char*)blocks[n])[i], ==, n, "blocks do not overlap");
+        }
+        
+        void* last = blocks[9];
+        pool.deallocate(last, 20);
+        require(pool.allocate(20) == last, "freed blocks are reused first");
+        for (int i=0; i<20; i++) ((char*)last)[i] = 9;
+        
+        require_e(pool.releaseUnusedMemory(), ==, 0, "slabs are kept while blocks are in use");
+        require_e(pool.getSlabCount(), ==, 3, "slabs are kept while blocks are in use");
+        
+        // the first slab holds the first 4 blocks; the others stay in use
+        for (int n=0; n<4; n++) pool.deallocate(blocks[n], 20);
+        const size_t slabBytes = pool.getReservedBytes() / 3;
+        require_e(pool.releaseUnusedMemory(), ==, slabBytes, "an empty slab is released while others are in use");
+        require_e(pool.getSlabCount(), ==, 2, "only the empty slab is released");
+        for (int n=4; n<10; n++)
+        {
+            for (int i=0; i<20; i++) require_e(((char*)blocks[n])[i], ==, n, "blocks in use are untouched");
+        }
+        
+        // the free blocks left are those of the remaining slabs
+        for (int n=0; n<4; n++)
+        {
+            blocks[n] = pool.allocate(20);
+            for (int i=0; i<20; i++) ((char*)blocks[n])[i] = n;
+        }
+        require_e(pool.getSlabCount(), ==, 3, "a slab is added once the free blocks are used up");
+        for (int n=0; n<10; n++)
+        {
+            for (int i=0; i<20; i++) require_e(((char*)blocks[n])[i], ==, n, "blocks do not overlap");
+        }
+        
+        for (int n=0; n<10; n++) pool.deallocate(blocks[n], 20);
+        require_e(pool.getLiveCount(), ==, 0, "all blocks are free");
+        require_e(pool.getPeakCount(), ==, 10, "peak is remembered");
+        require_e(pool.getAllocationCount(), ==, 15, "allocations are counted");
+        
+        require_e(pool.releaseUnusedMemory(), ==, slabBytes*3, "all slabs are released once all blocks are free");
+        require_e(pool.getSlabCount(), ==, 0, "slabs are released once all blocks are free");
+        require_e(pool.getReleasedBytes(), ==, slabBytes*4, "released memory is counted");
+        
+        // larger requests (e.g. from subclasses) bypass the pool
+        void* big = pool.allocate(100);
+        require_e(pool.getLiveCount(), ==, 0, "larger requests do not use the pool");
+        pool.deallocate(big, 100);
+    }
+}
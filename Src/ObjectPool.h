@@ -0,0 +1,105 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __OBJECT_POOL_H__
+#define __OBJECT_POOL_H__
+
+#include <cstddef>
+#include <vector>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief Fixed-size block allocator for the small objects that sequences hold by the thousands
+      *
+      * Blocks are carved out of large slabs and recycled through a free list, so creating and
+      * deleting notes and controller events does not go through malloc and free for each object.
+      * Classes use it from their own operator new and operator delete. Requests of another size
+      * (subclasses) are passed to the global allocator.
+      *
+      * Slabs are only given back to the system by releaseUnusedMemory, which frees every slab none
+      * of whose blocks are in use; call it after closing a sequence. Pools are shared by all
+      * sequences and the clipboard, so a slab is only freed once none of them uses it any more.
+      *
+      * Pools are not thread-safe; the objects they hold must only be created and destroyed from the
+      * main thread.
+      */
+    class ObjectPool
+    {
+        const char* m_name;
+        size_t m_block_size;
+        int m_blocks_per_slab;
+        
+        std::vector<char*> m_slabs;
+        
+        /** Singly-linked list of free blocks, the link being stored in the block itself */
+        void* m_free_list;
+        
+        int  m_live_count;
+        int  m_peak_count;
+        long m_allocation_count;
+        size_t m_released_bytes;
+        
+        void addSlab();
+        
+        /** @return the index in 'm_slabs' of the slab holding 'block'; 'm_slabs' must be sorted */
+        int findSlab(const void* block) const;
+        
+        ObjectPool(const ObjectPool&);
+        ObjectPool& operator=(const ObjectPool&);
+        
+    public:
+        
+        /**
+          * @param name       Shown in the debug statistics
+          * @param objectSize Size of the objects this pool serves
+          */
+        ObjectPool(const char* name, const size_t objectSize, const int blocksPerSlab = 1024);
+        ~ObjectPool();
+        
+        void* allocate(const size_t size);
+        void  deallocate(void* block, const size_t size);
+        
+        /**
+          * @brief give back to the system every slab that has no block in use
+          * @return the amount of bytes freed
+          */
+        size_t releaseUnusedMemory();
+        
+        const char* getName()         const { return m_name;             }
+        int  getLiveCount()           const { return m_live_count;       }
+        int  getPeakCount()           const { return m_peak_count;       }
+        long getAllocationCount()     const { return m_allocation_count; }
+        int  getSlabCount()           const { return m_slabs.size();     }
+        size_t getReservedBytes()     const { return m_slabs.size() * m_blocks_per_slab * m_block_size; }
+        
+        /** @return how many bytes releaseUnusedMemory freed so far */
+        size_t getReleasedBytes()     const { return m_released_bytes;   }
+        
+        /** @return every pool created so far, for debug statistics */
+        static const std::vector<ObjectPool*>& getPools();
+        
+        /**
+          * @brief call releaseUnusedMemory on every pool
+          * @return the amount of bytes freed
+          */
+        static size_t releaseAllUnusedMemory();
+    };
+    
+}
+
+#endif
@@ -362,6 +362,33 @@ void PreferencesData::fillSettingsVector()
                                      SETTING_INT, SETTING_CATEGORY_HIDDEN, to_wxString(wxPAPER_LETTER) );
     m_settings.push_back( paperType );
     
+    // Default=0 => WavWriter::PCM_16
+    Setting* audioExportFormat = new Setting(fromCString(SETTING_ID_AUDIO_EXPORT_FORMAT),
+                                     wxT("Audio Export Format"),
+                                     SETTING_INT, SETTING_CATEGORY_HIDDEN, wxT("0"));
+    m_settings.push_back( audioExportFormat );
+    
+    Setting* audioExportDither = new Setting(fromCString(SETTING_ID_AUDIO_EXPORT_DITHER),
+                                     wxT("Audio Export Dither"),
+                                     SETTING_BOOL, SETTING_CATEGORY_HIDDEN, wxT("0"));
+    m_settings.push_back( audioExportDither );
+
+    Setting* compressProjects = new Setting(fromCString(SETTING_ID_COMPRESS_PROJECTS),
+                                     wxT("Compress Projects"),
+                                     SETTING_BOOL, SETTING_CATEGORY_HIDDEN, wxT("1"));
+    m_settings.push_back( compressProjects );
+
+    // in seconds; 0 disables crash-recovery copies
+    Setting* autosaveInterval = new Setting(fromCString(SETTING_ID_AUTOSAVE_INTERVAL),
+                                     wxT("Autosave Interval"),
+                                     SETTING_INT, SETTING_CATEGORY_HIDDEN, wxT("60"));
+    m_settings.push_back( autosaveInterval );
+
+    // in MiB; how much memory the undo history of each sequence may use
+    Setting* undoMemoryBudget = new Setting(fromCString(SETTING_ID_UNDO_MEMORY_BUDGET),
+                                     wxT("Undo Memory Budget"),
+                                     SETTING_INT, SETTING_CATEGORY_HIDDEN, wxT("64"));
+    m_settings.push_back( undoMemoryBudget );
     
 #ifdef __WXGTK__
     // Default=0 => FLUIDSYNTH
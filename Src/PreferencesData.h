@@ -120,6 +120,12 @@ static const wxString SYSTEM_BANK = _("System soundbank");
 #endif
 
     EXTERN const char* SETTING_ID_GBA_PROJECT_DIR  DEFAULT("gbaProjectDir");
+    
+    EXTERN const char* SETTING_ID_AUDIO_EXPORT_FORMAT DEFAULT("audioExportFormat");
+    EXTERN const char* SETTING_ID_AUDIO_EXPORT_DITHER DEFAULT("audioExportDither");
+    EXTERN const char* SETTING_ID_COMPRESS_PROJECTS DEFAULT("compressProjects");
+    EXTERN const char* SETTING_ID_AUTOSAVE_INTERVAL DEFAULT("autosaveInterval");
+    EXTERN const char* SETTING_ID_UNDO_MEMORY_BUDGET DEFAULT("undoMemoryBudget");
 
 #undef EXTERN
 #undef DEFAULT
@@ -17,6 +17,7 @@
 #ifdef RENDERER_OPENGL
 
 #include "Renderers/Drawable.h"
+#include "Renderers/GLPrimitiveBatch.h"
 #include "Renderers/ImageBase.h"
 #include "Utils.h"
 #include <iostream>
@@ -34,6 +35,7 @@ void Drawable::render()
 {
     ASSERT(m_image != NULL);
     
+    AriaRender::flushPrimitives();
     glLoadIdentity();
     
     glTranslatef(m_x*10.0, m_y*10.0, 0);
@@ -0,0 +1,230 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_OPENGL
+
+#include "Renderers/GLGlyphAtlas.h"
+#include "Renderers/GLPrimitiveBatch.h"
+#include "AriaCore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <wx/bitmap.h>
+#include <wx/dc.h>
+#include <wx/dcmemory.h>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    /** width of the atlas texture; glyphs go on as many rows as needed */
+    const int ATLAS_WIDTH = 512;
+
+    /** empty pixels around each glyph, so that filtering never reads from a neighbour */
+    const int GLYPH_PADDING = 1;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+GlyphAtlas::GlyphAtlas(const wxFont& font) : m_font(font)
+{
+    m_texture_w   = 0;
+    m_texture_h   = 0;
+    m_line_height = 0;
+
+    for (int n=0; n<256; n++)
+    {
+        m_latin1[n].m_x     = 0;
+        m_latin1[n].m_y     = 0;
+        m_latin1[n].m_width = -1;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void GlyphAtlas::build()
+{
+    std::vector<wxChar> characters;
+    for (int c=32; c<127; c++) characters.push_back(c);
+
+#if wxUSE_UNICODE
+    for (int c=0xA1; c<=0xFF; c++) characters.push_back(c);
+
+    // flat, natural and sharp signs
+    characters.push_back(0x266D);
+    characters.push_back(0x266E);
+    characters.push_back(0x266F);
+#endif
+
+    // measure all glyphs and lay them out in rows
+    wxDC* dc = Display::renderDC;
+    dc->SetFont(m_font);
+
+    std::vector<Glyph> glyphs(characters.size());
+    int x = GLYPH_PADDING;
+    int y = GLYPH_PADDING;
+    m_line_height = 0;
+
+    for (unsigned int n=0; n<characters.size(); n++)
+    {
+        int w, h;
+        dc->GetTextExtent(wxString(characters[n], 1), &w, &h);
+        m_line_height = std::max(m_line_height, h);
+        glyphs[n].m_width = w;
+    }
+
+    for (unsigned int n=0; n<characters.size(); n++)
+    {
+        if (x + glyphs[n].m_width + GLYPH_PADDING > ATLAS_WIDTH)
+        {
+            x  = GLYPH_PADDING;
+            y += m_line_height + GLYPH_PADDING;
+        }
+        glyphs[n].m_x = x;
+        glyphs[n].m_y = y;
+        x += glyphs[n].m_width + GLYPH_PADDING;
+    }
+
+    m_texture_w = ATLAS_WIDTH;
+    m_texture_h = 32;
+    while (m_texture_h < y + m_line_height + GLYPH_PADDING) m_texture_h *= 2;
+
+    // rasterise them, black on white as TextTexture expects
+    wxBitmap bmp(m_texture_w, m_texture_h);
+    ASSERT(bmp.IsOk());
+
+    {
+        wxMemoryDC temp_dc(bmp);
+
+        temp_dc.SetBrush(*wxWHITE_BRUSH);
+        temp_dc.Clear();
+        temp_dc.SetFont(m_font);
+
+        for (unsigned int n=0; n<characters.size(); n++)
+        {
+            temp_dc.DrawText(wxString(characters[n], 1), glyphs[n].m_x, glyphs[n].m_y);
+        }
+    }
+
+    m_texture = new TextTexture(bmp);
+
+    for (unsigned int n=0; n<characters.size(); n++)
+    {
+        const unsigned int code = characters[n];
+        if (code < 256) m_latin1[code] = glyphs[n];
+        else            m_others[characters[n]] = glyphs[n];
+    }
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+const GlyphAtlas::Glyph* GlyphAtlas::findGlyph(const wxChar c) const
+{
+    const unsigned int code = c;
+    if (code < 256)
+    {
+        return (m_latin1[code].m_width == -1 ? NULL : &m_latin1[code]);
+    }
+
+    std::map<wxChar, Glyph>::const_iterator it = m_others.find(c);
+    return (it == m_others.end() ? NULL : &it->second);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void GlyphAtlas::addQuad(const Glyph& glyph, const int x, const int y, const int width)
+{
+    // the texture is upside down compared to the bitmap (see TextTexture)
+    const float u1 = (float)glyph.m_x / (float)m_texture_w;
+    const float u2 = (float)(glyph.m_x + width) / (float)m_texture_w;
+    const float v1 = 1.0f - (float)glyph.m_y / (float)m_texture_h;
+    const float v2 = 1.0f - (float)(glyph.m_y + m_line_height) / (float)m_texture_h;
+
+    AriaRender::PrimitiveBatch::get().texturedQuad(x*10, (y - m_line_height)*10, (x + width)*10, y*10,
+                                                   u1, v1, u2, v2);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+bool GlyphAtlas::canRender(const wxString& text)
+{
+    if (m_texture == NULL) build();
+
+    for (wxString::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        if (findGlyph(*it) == NULL) return false;
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void GlyphAtlas::renderString(const wxString& text, const int x, const int y, const int maxWidth)
+{
+    if (m_texture == NULL) build();
+
+    AriaRender::PrimitiveBatch& batch = AriaRender::PrimitiveBatch::get();
+    batch.beginText(m_texture->getID()[0]);
+
+    int penX = x;
+    for (wxString::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        const Glyph* glyph = findGlyph(*it);
+        if (glyph == NULL) continue;
+
+        // cut the last glyph that fits partially
+        int width = glyph->m_width;
+        if (maxWidth != -1)
+        {
+            width = std::min(width, x + maxWidth - penX);
+            if (width <= 0) break;
+        }
+
+        addQuad(*glyph, penX, y, width);
+        penX += glyph->m_width;
+    }
+
+    batch.end();
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void GlyphAtlas::renderNumber(const char* number, const int x, const int y)
+{
+    if (m_texture == NULL) build();
+
+    AriaRender::PrimitiveBatch& batch = AriaRender::PrimitiveBatch::get();
+    batch.beginText(m_texture->getID()[0]);
+
+    int penX = x;
+    for (int c=0; number[c] != 0; c++)
+    {
+        const Glyph& glyph = m_latin1[(unsigned char)number[c]];
+        if (glyph.m_width == -1)
+        {
+            printf("Warning: character %c unexpected in number!\n", number[c]);
+            continue;
+        }
+
+        addQuad(glyph, penX, y, glyph.m_width);
+        penX += glyph.m_width;
+    }
+
+    batch.end();
+}
+
+#endif
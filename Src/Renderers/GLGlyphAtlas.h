@@ -0,0 +1,106 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __GL_GLYPH_ATLAS_H__
+#define __GL_GLYPH_ATLAS_H__
+
+#ifdef RENDERER_OPENGL
+
+#include "Renderers/GLwxString.h"
+#include "Utils.h"
+
+#include <map>
+#include <wx/font.h>
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief OpenGL render backend : all the glyphs of a font, rasterised once in a single texture
+      *
+      * Holds the printable ASCII and Latin-1 characters and the accidental signs. Strings are drawn
+      * as one textured quad per character, added to the primitive batch (see
+      * AriaRender::PrimitiveBatch), so that consecutive strings of the same font take a single
+      * texture bind and a single draw call, and nothing is rasterised or uploaded after the first use.
+      *
+      * Characters are placed side by side using the width of each of them alone, so kerning is lost.
+      *
+      * @ingroup renderers
+      */
+    class GlyphAtlas
+    {
+        struct Glyph
+        {
+            /** position of the glyph in the atlas bitmap, in pixels */
+            int m_x, m_y;
+
+            /** width the glyph takes in a string, in pixels; -1 if the glyph is not in the atlas */
+            int m_width;
+        };
+
+        wxFont m_font;
+        OwnerPtr<TextTexture> m_texture;
+        int m_texture_w, m_texture_h;
+
+        /** height of a line of text, which is also the height of every glyph */
+        int m_line_height;
+
+        /** glyphs of the ASCII and Latin-1 ranges, indexed by character code */
+        Glyph m_latin1[256];
+
+        /** other glyphs */
+        std::map<wxChar, Glyph> m_others;
+
+        /** rasterises all glyphs and uploads the texture, on first use */
+        void build();
+
+        /** @return the glyph for this character, or NULL if it is not in the atlas */
+        const Glyph* findGlyph(const wxChar c) const;
+
+        void addQuad(const Glyph& glyph, const int x, const int y, const int width);
+
+        GlyphAtlas(const GlyphAtlas&);
+        GlyphAtlas& operator=(const GlyphAtlas&);
+
+    public:
+        LEAK_CHECK();
+
+        GlyphAtlas(const wxFont& font);
+        virtual ~GlyphAtlas() {}
+
+        /** @return whether all characters of this string are in the atlas */
+        bool canRender(const wxString& text);
+
+        /**
+          * @brief draws a string with the current color, its bottom-left corner at (x, y)
+          * @param maxWidth the string is cut past this width, or -1 for no limit
+          * @pre   all characters are in the atlas (see canRender)
+          */
+        void renderString(const wxString& text, const int x, const int y, const int maxWidth);
+
+        /**
+          * @brief draws a number with the current color, its bottom-left corner at (x, y)
+          * Characters missing from the atlas are skipped.
+          */
+        void renderNumber(const char* number, const int x, const int y);
+    };
+
+}
+
+#endif
+
+#endif
@@ -19,6 +19,7 @@
 #include "Utils.h"
 
 #include "Renderers/GLPane.h"
+#include "Renderers/GLPrimitiveBatch.h"
 #include "AriaCore.h"
 
 #include "OpenGL.h"
@@ -167,6 +168,7 @@ void GLPane::beginFrame()
 
 void GLPane::endFrame()
 {
+    AriaRender::flushPrimitives();
     glFlush();
     SwapBuffers();
 }
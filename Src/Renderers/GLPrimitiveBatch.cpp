@@ -0,0 +1,191 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_OPENGL
+
+#include "Renderers/GLPrimitiveBatch.h"
+#include "Utils.h"
+
+using namespace AriaMaestosa;
+using namespace AriaMaestosa::AriaRender;
+
+namespace
+{
+    /** flush even in the middle of a run of primitives past this many vertices, to bound memory */
+    const unsigned int MAX_BATCH_VERTICES = 16384;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+PrimitiveBatch::PrimitiveBatch()
+{
+    m_kind       = NOTHING;
+    m_texture    = 0;
+    m_color[0]   = 1.0f;
+    m_color[1]   = 1.0f;
+    m_color[2]   = 1.0f;
+    m_color[3]   = 1.0f;
+    m_line_width = -1.0f;
+    m_point_size = -1.0f;
+    m_batching   = false;
+    m_vertices.reserve(MAX_BATCH_VERTICES);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+PrimitiveBatch& PrimitiveBatch::get()
+{
+    static PrimitiveBatch batch;
+    return batch;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::setBatching(const bool batching)
+{
+    flush();
+    m_batching = batching;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::setColor(const float r, const float g, const float b, const float a)
+{
+    m_color[0] = r;
+    m_color[1] = g;
+    m_color[2] = b;
+    m_color[3] = a;
+    
+    // images and text use the current OpenGL color; vertices in the batch have their own
+    glColor4fv(m_color);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::setLineWidth(const float width)
+{
+    if (width == m_line_width) return;
+    if (m_kind == LINES) flush();
+    
+    glLineWidth(width);
+    m_line_width = width;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::setPointSize(const float size)
+{
+    if (size == m_point_size) return;
+    if (m_kind == POINTS) flush();
+    
+    glPointSize(size);
+    m_point_size = size;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::quad(const float x1, const float y1, const float x2, const float y2,
+                          const float x3, const float y3, const float x4, const float y4)
+{
+    begin(TRIANGLES);
+    vertex(x1, y1);
+    vertex(x2, y2);
+    vertex(x3, y3);
+    
+    vertex(x1, y1);
+    vertex(x3, y3);
+    vertex(x4, y4);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::texturedQuad(const float x1, const float y1, const float x2, const float y2,
+                                  const float u1, const float v1, const float u2, const float v2)
+{
+    ASSERT(m_kind == TEXT);
+    
+    const Vertex topLeft     = { x1, y1, u1, v1, m_color[0], m_color[1], m_color[2], m_color[3] };
+    const Vertex topRight    = { x2, y1, u2, v1, m_color[0], m_color[1], m_color[2], m_color[3] };
+    const Vertex bottomRight = { x2, y2, u2, v2, m_color[0], m_color[1], m_color[2], m_color[3] };
+    const Vertex bottomLeft  = { x1, y2, u1, v2, m_color[0], m_color[1], m_color[2], m_color[3] };
+    
+    m_vertices.push_back(topLeft);
+    m_vertices.push_back(topRight);
+    m_vertices.push_back(bottomRight);
+    
+    m_vertices.push_back(topLeft);
+    m_vertices.push_back(bottomRight);
+    m_vertices.push_back(bottomLeft);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::end()
+{
+    if ((not m_batching and m_kind != TEXT) or m_vertices.size() >= MAX_BATCH_VERTICES) flush();
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void PrimitiveBatch::flush()
+{
+    if (m_vertices.empty()) return;
+    
+    GLenum mode;
+    switch (m_kind)
+    {
+        case TRIANGLES: mode = GL_TRIANGLES; break;
+        case LINES:     mode = GL_LINES;     break;
+        case POINTS:    mode = GL_POINTS;    break;
+        case TEXT:      mode = GL_TRIANGLES; break;
+        default:
+            m_vertices.clear();
+            return;
+    }
+    
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &m_vertices[0].x);
+    glColorPointer (4, GL_FLOAT, sizeof(Vertex), &m_vertices[0].r);
+    
+    // text may be flushed after another texture was bound for the next image, restore it after
+    GLint previousTexture = 0;
+    if (m_kind == TEXT)
+    {
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &m_vertices[0].u);
+    }
+    
+    glDrawArrays(mode, 0, m_vertices.size());
+    
+    if (m_kind == TEXT)
+    {
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+    }
+    
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    
+    // the current color is undefined after drawing with a color array
+    glColor4fv(m_color);
+    
+    m_vertices.clear();
+}
+
+#endif
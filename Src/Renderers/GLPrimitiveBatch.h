@@ -0,0 +1,147 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __GL_PRIMITIVE_BATCH_H__
+#define __GL_PRIMITIVE_BATCH_H__
+
+#ifdef RENDERER_OPENGL
+
+#include "OpenGL.h"
+#include <vector>
+
+namespace AriaMaestosa
+{
+    namespace AriaRender
+    {
+        
+        /**
+          * @brief collects the primitives drawn through AriaRender in a client-side vertex array
+          *
+          * Each vertex carries its own color, so color changes do not interrupt a batch. The batch is
+          * drawn with a single glDrawArrays call when the kind of primitive changes (filled shapes,
+          * lines, points), when some GL state they depend on changes (line width, point size,
+          * smoothing, scissors), before anything else is drawn directly with OpenGL, and at the end of
+          * the frame. Primitives are thus always drawn in the order they were submitted.
+          *
+          * Batching only happens in primitive mode (see AriaRender::primitives); in image mode every
+          * primitive is drawn right away, as before. Text quads (see GlyphAtlas) are the exception:
+          * they are always batched, as long as they come from the same texture.
+          *
+          * @ingroup renderers
+          */
+        class PrimitiveBatch
+        {
+        public:
+            
+            enum Kind
+            {
+                NOTHING,
+                TRIANGLES,
+                LINES,
+                POINTS,
+                TEXT
+            };
+            
+        private:
+            
+            struct Vertex
+            {
+                GLfloat x, y;
+                GLfloat u, v;
+                GLfloat r, g, b, a;
+            };
+            
+            std::vector<Vertex> m_vertices;
+            Kind m_kind;
+            
+            /** texture the pending text quads are taken from */
+            GLuint m_texture;
+            
+            /** color given to the next vertices (also the current OpenGL color outside batches) */
+            GLfloat m_color[4];
+            
+            /** last line width and point size given to OpenGL, or -1 when unknown */
+            float m_line_width;
+            float m_point_size;
+            
+            bool m_batching;
+            
+        public:
+            
+            PrimitiveBatch();
+            
+            /** @brief the batch all AriaRender primitives go through */
+            static PrimitiveBatch& get();
+            
+            /** @brief whether to keep primitives until a flush, or draw each of them immediately */
+            void setBatching(const bool batching);
+            
+            void setColor(const float r, const float g, const float b, const float a);
+            void setLineWidth(const float width);
+            void setPointSize(const float size);
+            
+            /** @brief prepare to add a primitive of the given kind, flushing primitives of another kind */
+            void begin(const Kind kind)
+            {
+                if (kind != m_kind)
+                {
+                    flush();
+                    m_kind = kind;
+                }
+            }
+            
+            /** @brief prepare to add text quads taken from the given texture */
+            void beginText(const GLuint texture)
+            {
+                if (m_kind != TEXT or texture != m_texture)
+                {
+                    flush();
+                    m_kind    = TEXT;
+                    m_texture = texture;
+                }
+            }
+            
+            /** @brief add a vertex, in the OpenGL coordinates AriaRender uses (pixels times 10) */
+            void vertex(const float x, const float y)
+            {
+                Vertex v = { x, y, 0.0f, 0.0f, m_color[0], m_color[1], m_color[2], m_color[3] };
+                m_vertices.push_back(v);
+            }
+            
+            /** @brief add a textured quad, with its top-left and bottom-right corners */
+            void texturedQuad(const float x1, const float y1, const float x2, const float y2,
+                              const float u1, const float v1, const float u2, const float v2);
+            
+            /** @brief add a convex quad, as two triangles */
+            void quad(const float x1, const float y1, const float x2, const float y2,
+                      const float x3, const float y3, const float x4, const float y4);
+            
+            /** @brief call after adding a whole primitive; draws it right away when not batching */
+            void end();
+            
+            /** @brief draw the pending primitives */
+            void flush();
+        };
+        
+        /** @brief draw pending primitives; call before drawing anything with OpenGL directly */
+        inline void flushPrimitives() { PrimitiveBatch::get().flush(); }
+        
+    }
+}
+
+#endif
+
+#endif
@@ -20,8 +20,11 @@
 #include "AriaCore.h"
 #include "Singleton.h"
 #include "PreferencesData.h"
+#include "Renderers/GLGlyphAtlas.h"
+#include "Renderers/GLPrimitiveBatch.h"
 #include "Renderers/RenderAPI.h"
 #include "OpenGL.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -33,12 +36,14 @@ namespace AriaRender
 
 void primitives()
 {
+    PrimitiveBatch::get().setBatching(true);
     glDisable(GL_TEXTURE_2D);
     glLoadIdentity();
 }
 
 void images()
 {
+    PrimitiveBatch::get().setBatching(false);
     glEnable(GL_TEXTURE_2D);
     glLoadIdentity();
 }
@@ -74,73 +79,77 @@ void setImageState(const ImageState imgst)
 
 void color(const float r, const float g, const float b)
 {
-    glColor3f(r,g,b);
+    PrimitiveBatch::get().setColor(r, g, b, 1.0f);
 }
 
 void color(const float r, const float g, const float b, const float a)
 {
-    glColor4f(r,g,b,a);
+    PrimitiveBatch::get().setColor(r, g, b, a);
 }
 
 void line(const int x1, const int y1, const int x2, const int y2)
 {
-    glBegin(GL_LINES);
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
-    glEnd();
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.begin(PrimitiveBatch::LINES);
+    batch.vertex(x1*10.0, y1*10.0);
+    batch.vertex(x2*10.0, y2*10.0);
+    batch.end();
 }
 
 void lineWidth(const int n)
 {
-    glLineWidth(n * Display::getContentScaleFactor());
+    PrimitiveBatch::get().setLineWidth(n * Display::getContentScaleFactor());
 }
 
 void lineSmooth(const bool enabled)
 {
+    flushPrimitives();
     if (enabled) glEnable (GL_LINE_SMOOTH);
     else glDisable (GL_LINE_SMOOTH);
 }
 
 void point(const int x, const int y)
 {
-    glBegin(GL_POINTS);
-    glVertex2f(x*10.0, y*10.0);
-    glEnd();
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.begin(PrimitiveBatch::POINTS);
+    batch.vertex(x*10.0, y*10.0);
+    batch.end();
 }
 
 void pointSize(const int n)
 {
-    glPointSize(n * Display::getContentScaleFactor());
+    PrimitiveBatch::get().setPointSize(n * Display::getContentScaleFactor());
 }
 
 void rect(const int x1, const int y1, const int x2, const int y2)
 {
-    glBegin(GL_QUADS);
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
-    glVertex2f(x1*10.0, y2*10.0);
-    glEnd();
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.quad(x1*10.0, y1*10.0,
+               x2*10.0, y1*10.0,
+               x2*10.0, y2*10.0,
+               x1*10.0, y2*10.0);
+    batch.end();
 }
 
 void bordered_rect_no_start(const int x1, const int y1, const int x2, const int y2)
 {
     rect(x1,y1,x2,y2);
 
-    glColor3f(0,0,0);
-    glLineWidth(Display::getContentScaleFactor());
-    glBegin(GL_LINES);
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.setColor(0,0,0,1);
+    batch.setLineWidth(Display::getContentScaleFactor());
+    batch.begin(PrimitiveBatch::LINES);
 
-    glVertex2f(round(x1*10.0), round((y2+0.5)*10.0));
-    glVertex2f(round(x2*10.0), round((y2+0.5)*10.0));
+    batch.vertex(round(x1*10.0), round((y2+0.5)*10.0));
+    batch.vertex(round(x2*10.0), round((y2+0.5)*10.0));
 
-    glVertex2f(round((x2+1)*10.0), round(y2*10.0));
-    glVertex2f(round((x2+1)*10.0), round((y1+0.5)*10.0));
+    batch.vertex(round((x2+1)*10.0), round(y2*10.0));
+    batch.vertex(round((x2+1)*10.0), round((y1+0.5)*10.0));
 
-    glVertex2f(round((x1+0.5)*10.0), round(y1*10.0));
-    glVertex2f(round(x2*10.0), round(y1*10.0));
+    batch.vertex(round((x1+0.5)*10.0), round(y1*10.0));
+    batch.vertex(round(x2*10.0), round(y1*10.0));
 
-    glEnd();
+    batch.end();
 }
 
 void bordered_rect(const int x1, const int y1, const int x2, const int y2)
@@ -151,86 +160,89 @@ void bordered_rect(const int x1, const int y1, const int x2, const int y2)
         to work on all computers i have access to... damn those graphics
         drivers and their inconsistent rounding!*/
 
-    glColor3f(0,0,0);
-    glLineWidth(Display::getContentScaleFactor());
-    glBegin(GL_LINES);
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.setColor(0,0,0,1);
+    batch.setLineWidth(Display::getContentScaleFactor());
+    batch.begin(PrimitiveBatch::LINES);
 
-    glVertex2f(round(x1*10.0), round(y2*10.0));
-    glVertex2f(round(x1*10.0), round((y1+0.549)*10.0));
+    batch.vertex(round(x1*10.0), round(y2*10.0));
+    batch.vertex(round(x1*10.0), round((y1+0.549)*10.0));
 
-    glVertex2f(round(x1*10.0), round((y2+0.5)*10.0));
-    glVertex2f(round(x2*10.0), round((y2+0.5)*10.0));
+    batch.vertex(round(x1*10.0), round((y2+0.5)*10.0));
+    batch.vertex(round(x2*10.0), round((y2+0.5)*10.0));
 
-    glVertex2f(round((x2+1)*10.0), round(y2*10.0));
-    glVertex2f(round((x2+1)*10.0), round((y1+0.5)*10.0));
+    batch.vertex(round((x2+1)*10.0), round(y2*10.0));
+    batch.vertex(round((x2+1)*10.0), round((y1+0.5)*10.0));
 
-    glVertex2f(round((x1+0.5)*10.0), round(y1*10.0));
-    glVertex2f(round(x2*10.0), round(y1*10.0));
+    batch.vertex(round((x1+0.5)*10.0), round(y1*10.0));
+    batch.vertex(round(x2*10.0), round(y1*10.0));
 
-    glEnd();
+    batch.end();
 }
 
 void hollow_rect(const int x1, const int y1, const int x2, const int y2)
 {
-    glBegin(GL_LINES);
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.begin(PrimitiveBatch::LINES);
 
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x1*10.0, y2*10.0);
+    batch.vertex(x1*10.0, y1*10.0);
+    batch.vertex(x1*10.0, y2*10.0);
 
-    glVertex2f(round(x1-1.0)*10.0, y2*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
+    batch.vertex(round(x1-1.0)*10.0, y2*10.0);
+    batch.vertex(x2*10.0, y2*10.0);
 
-    glVertex2f(x2*10.0, y2*10.0);
-    glVertex2f(x2*10.0, y1*10.0);
+    batch.vertex(x2*10.0, y2*10.0);
+    batch.vertex(x2*10.0, y1*10.0);
 
-    glVertex2f(round(x1-1.0)*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y1*10.0);
+    batch.vertex(round(x1-1.0)*10.0, y1*10.0);
+    batch.vertex(x2*10.0, y1*10.0);
 
-    glEnd();
+    batch.end();
 }
 
 
 void select_rect(const int x1, const int y1, const int x2, const int y2)
 {
-    glColor4f(0.0f, 0.83f, 0.16f, 0.3f);
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.setColor(0.0f, 0.83f, 0.16f, 0.3f);
 
-    glBegin(GL_QUADS);
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
-    glVertex2f(x1*10.0, y2*10.0);
-    glEnd();
+    batch.quad(x1*10.0, y1*10.0,
+               x2*10.0, y1*10.0,
+               x2*10.0, y2*10.0,
+               x1*10.0, y2*10.0);
 
-    glColor4f(0.0f, 0.83f, 0.16, 1.0f);
+    batch.setColor(0.0f, 0.83f, 0.16, 1.0f);
 
-    glBegin(GL_LINES);
+    batch.begin(PrimitiveBatch::LINES);
 
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x1*10.0, y2*10.0);
+    batch.vertex(x1*10.0, y1*10.0);
+    batch.vertex(x1*10.0, y2*10.0);
 
-    glVertex2f(round(x1-1.0)*10.0, y2*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
+    batch.vertex(round(x1-1.0)*10.0, y2*10.0);
+    batch.vertex(x2*10.0, y2*10.0);
 
-    glVertex2f(x2*10.0, y2*10.0);
-    glVertex2f(x2*10.0, y1*10.0);
+    batch.vertex(x2*10.0, y2*10.0);
+    batch.vertex(x2*10.0, y1*10.0);
 
-    glVertex2f(round(x1-1.0)*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y1*10.0);
+    batch.vertex(round(x1-1.0)*10.0, y1*10.0);
+    batch.vertex(x2*10.0, y1*10.0);
 
-    glEnd();
+    batch.end();
 }
 
 void triangle(const int x1, const int y1, const int x2, const int y2, const int x3, const int y3)
 {
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
-    glVertex2f(x3*10.0, y3*10.0);
-    glEnd();
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.begin(PrimitiveBatch::TRIANGLES);
+    batch.vertex(x1*10.0, y1*10.0);
+    batch.vertex(x2*10.0, y2*10.0);
+    batch.vertex(x3*10.0, y3*10.0);
+    batch.end();
 }
 
 void arc(int center_x, int center_y, int radius_x, int radius_y, bool show_above)
 {
+    flushPrimitives();
     glLoadIdentity();
 
     const int y_mult = (show_above ? -radius_y*10.0 : radius_y*10.0);
@@ -238,14 +250,15 @@ void arc(int center_x, int center_y, int radius_x, int radius_y, bool show_above
     center_y *= 10.0f;
     radius_x *= 10.0f;
 
-    glColor3f(0,0,0);
-    glBegin(GL_LINES);
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.setColor(0,0,0,1);
+    batch.begin(PrimitiveBatch::LINES);
     for (float angle = 0.2; angle<=M_PI; angle +=0.2)
     {
-        glVertex2f( center_x + std::cos(angle)    *radius_x, center_y + std::sin(angle)*y_mult );
-        glVertex2f( center_x + std::cos(angle-0.2)*radius_x, center_y + std::sin(angle-0.2)*y_mult );
+        batch.vertex( center_x + std::cos(angle)    *radius_x, center_y + std::sin(angle)*y_mult );
+        batch.vertex( center_x + std::cos(angle-0.2)*radius_x, center_y + std::sin(angle-0.2)*y_mult );
     }
-    glEnd();
+    batch.end();
 }
 
 void quad(const int x1, const int y1,
@@ -253,23 +266,26 @@ void quad(const int x1, const int y1,
           const int x3, const int y3,
           const int x4, const int y4)
 {
-    glBegin(GL_QUADS);
-    glVertex2f(x1*10.0, y1*10.0);
-    glVertex2f(x2*10.0, y2*10.0);
-    glVertex2f(x3*10.0, y3*10.0);
-    glVertex2f(x4*10.0, y4*10.0);
-    glEnd();
-
+    PrimitiveBatch& batch = PrimitiveBatch::get();
+    batch.quad(x1*10.0, y1*10.0,
+               x2*10.0, y2*10.0,
+               x3*10.0, y3*10.0,
+               x4*10.0, y4*10.0);
+    batch.end();
 }
 
-class NumberRendererSingleton : public wxGLNumberRenderer, public Singleton<NumberRendererSingleton>
+class NoteNamesAtlas : public GlyphAtlas, public Singleton<NoteNamesAtlas>
 {
 public:
-    NumberRendererSingleton() : wxGLNumberRenderer()
+    NoteNamesAtlas() : GlyphAtlas(getNoteNamesFont())
     {
     }
+};
 
-    virtual ~NumberRendererSingleton()
+class NumbersAtlas : public GlyphAtlas, public Singleton<NumbersAtlas>
+{
+public:
+    NumbersAtlas() : GlyphAtlas(getNumberFont())
     {
     }
 };
@@ -320,14 +336,20 @@ void renderNumber(const float number, const int x, const int y)
 
 void renderNumber(const char* number, const int x, const int y)
 {
-    NumberRendererSingleton* singleton = NumberRendererSingleton::getInstance();
-    singleton->bind();
-    singleton->renderNumber(number, x, y-1);
+    NumbersAtlas::getInstance()->renderNumber(number, x, y-1);
 }
 
 
 void renderString(const wxString& string, const int x, const int y, const int maxWidth)
 {
+    NoteNamesAtlas* atlas = NoteNamesAtlas::getInstance();
+    if (atlas->canRender(string))
+    {
+        atlas->renderString(string, x, y, maxWidth);
+        return;
+    }
+
+    // translated note names may use characters the atlas does not have
     Model<wxString> model(string);
     wxGLString glString(&model, false);
     glString.setFont(getNoteNamesFont());
@@ -340,6 +362,7 @@ void renderString(const wxString& string, const int x, const int y, const int ma
 
 void beginScissors(const int x, const int y, const int width, const int height)
 {
+    flushPrimitives();
     glEnable(GL_SCISSOR_TEST);
     // glScissor operates in framebuffer (physical pixel) coordinates, scale for Retina/HiDPI
     const double s = Display::getContentScaleFactor();
@@ -347,12 +370,124 @@ void beginScissors(const int x, const int y, const int width, const int height)
 }
 void endScissors()
 {
+    flushPrimitives();
     glDisable(GL_SCISSOR_TEST);
 }
 
+/** a copy of the back buffer, kept in a texture */
+class SavedArea
+{
+public:
+    GLuint m_texture;
+
+    /** where the copy was taken, in pane coordinates */
+    int m_x, m_y, m_width, m_height;
+
+    /** size of the copy in framebuffer pixels, and of the texture that holds it */
+    int m_pixel_width, m_pixel_height;
+    int m_texture_width, m_texture_height;
+};
+
+static int nextPowerOfTwo(const int value)
+{
+    int power = 32;
+    while (power < value) power *= 2;
+    return power;
+}
+
+SavedArea* saveArea(SavedArea* area, const int x, const int y, const int width, const int height)
+{
+    flushPrimitives();
+
+    if (area == NULL)
+    {
+        area = new SavedArea();
+        glGenTextures(1, &area->m_texture);
+        area->m_texture_width  = 0;
+        area->m_texture_height = 0;
+    }
+
+    const int x1 = std::max(x, 0);
+    const int y1 = std::max(y, 0);
+    const int x2 = std::min(x + width,  Display::getWidth());
+    const int y2 = std::min(y + height, Display::getHeight());
+
+    area->m_x      = x1;
+    area->m_y      = y1;
+    area->m_width  = std::max(x2 - x1, 0);
+    area->m_height = std::max(y2 - y1, 0);
+    if (area->m_width == 0 or area->m_height == 0) return area;
+
+    // the framebuffer is in physical pixels with its origin at the bottom, like glScissor
+    const double s = Display::getContentScaleFactor();
+    area->m_pixel_width  = (int)(area->m_width  * s);
+    area->m_pixel_height = (int)(area->m_height * s);
+
+    GLint previousTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    glBindTexture(GL_TEXTURE_2D, area->m_texture);
+
+    if (area->m_pixel_width > area->m_texture_width or area->m_pixel_height > area->m_texture_height)
+    {
+        area->m_texture_width  = nextPowerOfTwo(area->m_pixel_width);
+        area->m_texture_height = nextPowerOfTwo(area->m_pixel_height);
+
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, area->m_texture_width, area->m_texture_height, 0,
+                     GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    }
+
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (int)(x1 * s), (int)((Display::getHeight() - y2) * s),
+                        area->m_pixel_width, area->m_pixel_height);
+
+    glBindTexture(GL_TEXTURE_2D, previousTexture);
+    return area;
+}
+
+void restoreArea(const SavedArea* area)
+{
+    if (area->m_width == 0 or area->m_height == 0) return;
+
+    images();
+    color(1, 1, 1, 1);
+    glBindTexture(GL_TEXTURE_2D, area->m_texture);
+
+    // the bottom row of the copy is at the bottom of the texture
+    const float u = (float)area->m_pixel_width  / (float)area->m_texture_width;
+    const float v = (float)area->m_pixel_height / (float)area->m_texture_height;
+
+    const int x1 = area->m_x;
+    const int y1 = area->m_y;
+    const int x2 = area->m_x + area->m_width;
+    const int y2 = area->m_y + area->m_height;
+
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, v);
+    glVertex2f(x1*10, y1*10);
+    glTexCoord2f(u, v);
+    glVertex2f(x2*10, y1*10);
+    glTexCoord2f(u, 0);
+    glVertex2f(x2*10, y2*10);
+    glTexCoord2f(0, 0);
+    glVertex2f(x1*10, y2*10);
+    glEnd();
+}
+
+void freeSavedArea(SavedArea* area)
+{
+    if (area == NULL) return;
+
+    glDeleteTextures(1, &area->m_texture);
+    delete area;
+}
+
 }
 
-DEFINE_SINGLETON( AriaRender::NumberRendererSingleton );
+DEFINE_SINGLETON( AriaRender::NoteNamesAtlas );
+DEFINE_SINGLETON( AriaRender::NumbersAtlas );
 }
 
 
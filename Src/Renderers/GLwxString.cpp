@@ -17,6 +17,7 @@
 #ifdef RENDERER_OPENGL
 
 #include "GLwxString.h"
+#include "Renderers/GLPrimitiveBatch.h"
 #include "Utils.h"
 
 #ifdef __WXMAC__
@@ -184,6 +185,7 @@ void TextGLDrawable::render()
     if (m_w == 0) fprintf(stderr, "[TextGLDrawable] WARNING: empty width image\n");
     if (m_h == 0) fprintf(stderr, "[TextGLDrawable] WARNING: empty height image\n");
 
+    AriaRender::flushPrimitives();
     glPushMatrix();
     glTranslatef(m_x*10,(m_y - m_h - y_offset)*10,0);
 
@@ -18,6 +18,7 @@ namespace AriaMaestosa
     class wxGLString;
     class wxGLStringArray;
     class wxGLStringNumber;
+    class GlyphAtlas;
 
     /**
      * @brief   OpenGL render backend : text renderer helper class (OpenGL backend)
@@ -28,6 +29,7 @@ namespace AriaMaestosa
         friend class wxGLString;
         friend class wxGLStringArray;
         friend class wxGLStringNumber;
+        friend class GlyphAtlas;
     private:
 
         /** here I don't use GLuint to avoid including OpenGL everywhere in the project */
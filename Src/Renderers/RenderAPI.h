@@ -175,6 +175,29 @@ namespace AriaMaestosa
                   const int x2, const int y2,
                   const int x3, const int y3,
                   const int x4, const int y4);
+        
+        /**
+          * @brief a copy of a rectangle of the pane, see AriaRender::saveArea
+          */
+        class SavedArea;
+        
+        /**
+          * @brief copies what has been drawn so far in a rectangle of the pane, to draw it again later
+          *        without redrawing its contents (only the part inside the pane is kept)
+          * @param area a previous copy whose memory can be reused, or NULL
+          * @return the copy, to draw with AriaRender::restoreArea and free with AriaRender::freeSavedArea
+          */
+        SavedArea* saveArea(SavedArea* area, const int x, const int y, const int width, const int height);
+        
+        /**
+          * @brief draws a copy made by AriaRender::saveArea back where it was taken
+          */
+        void restoreArea(const SavedArea* area);
+        
+        /**
+          * @brief frees a copy made by AriaRender::saveArea (does nothing if NULL)
+          */
+        void freeSavedArea(SavedArea* area);
     }
 }
 #endif
@@ -304,6 +304,48 @@ void endScissors()
     Display::renderDC -> DestroyClippingRegion();
 }
 
+/** a copy of part of the pane's back buffer (see MainPane::paintEvent) */
+class SavedArea
+{
+public:
+    wxBitmap m_bitmap;
+    int m_x, m_y;
+};
+
+SavedArea* saveArea(SavedArea* area, const int x, const int y, const int width, const int height)
+{
+    if (area == NULL) area = new SavedArea();
+
+    area->m_x = x;
+    area->m_y = y;
+
+    if (width <= 0 or height <= 0)
+    {
+        area->m_bitmap = wxNullBitmap;
+        return area;
+    }
+
+    if (not area->m_bitmap.IsOk() or area->m_bitmap.GetWidth() != width or area->m_bitmap.GetHeight() != height)
+    {
+        area->m_bitmap.Create(width, height);
+    }
+
+    wxMemoryDC copy(area->m_bitmap);
+    copy.Blit(0, 0, width, height, Display::renderDC, x, y);
+    return area;
+}
+
+void restoreArea(const SavedArea* area)
+{
+    if (not area->m_bitmap.IsOk()) return;
+    Display::renderDC -> DrawBitmap(area->m_bitmap, area->m_x, area->m_y, false);
+}
+
+void freeSavedArea(SavedArea* area)
+{
+    delete area;
+}
+
 }
 }
 #endif
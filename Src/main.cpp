@@ -23,6 +23,7 @@
 #include <wx/filename.h>
 #include <wx/tokenzr.h>
 
+#include "Benchmarks/Benchmark.h"
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
 #include "Midi/Players/PlatformMidiManager.h"
@@ -214,6 +215,16 @@ bool wxWidgetApp::OnInit()
             UnitTestCase::showMenu();
             exit(0);
         }
+        else if (wxString(argv[n]) == wxT("--benchmark"))
+        {
+            okToLog = false;
+            Core::setPlayDuringEdit(PLAY_NEVER);
+            prefs = PreferencesData::getInstance();
+            prefs->init();
+
+            BenchmarkCase::runAll();
+            exit(0);
+        }
         else if (wxString(argv[n]) == wxT("--verbose"))
         {
             wxLog::SetLogLevel(wxLOG_Info);
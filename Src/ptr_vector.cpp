@@ -54,4 +54,53 @@ namespace AriaMaestosa
         require_e(s[9],  ==, 98, "Vector sorted correctly");
         require_e(s[10], ==, 99, "Vector sorted correctly");
     }
+    
+    UNIT_TEST( VectorMergeSortTest )
+    {
+        SortableVector<int> s;
+        for (int n=0; n<100; n++) s.push_back(99-n);
+        for (int n=0; n<100; n++) s.push_back(n % 7);
+        
+        s.mergeSort();
+        
+        for (int n=1; n<200; n++) require_e(s[n-1], <=, s[n], "Vector sorted correctly");
+    }
+    
+    struct SortTestItem
+    {
+        int m_key, m_original_position;
+        SortTestItem(int key, int pos) : m_key(key), m_original_position(pos) {}
+        bool operator<(const SortTestItem& other) const { return m_key < other.m_key; }
+    };
+    
+    static int getSortTestItemKey(SortTestItem* item) { return item->m_key; }
+    
+    UNIT_TEST( PtrVectorMergeSortIsStable )
+    {
+        ptr_vector<SortTestItem> v1;
+        ptr_vector<SortTestItem> v2;
+        
+        // a sorted block, a block that was moved back, then reversed elements with duplicate keys
+        int pos = 0;
+        for (int n=0; n<100; n++, pos++) { v1.push_back(new SortTestItem(n*2, pos));     v2.push_back(new SortTestItem(n*2, pos));     }
+        for (int n=0; n<50;  n++, pos++) { v1.push_back(new SortTestItem(n*3, pos));     v2.push_back(new SortTestItem(n*3, pos));     }
+        for (int n=0; n<50;  n++, pos++) { v1.push_back(new SortTestItem(100-n/2, pos)); v2.push_back(new SortTestItem(100-n/2, pos)); }
+        
+        v1.mergeSort();
+        v2.mergeSort(getSortTestItemKey);
+        
+        for (int n=1; n<v1.size(); n++)
+        {
+            require_e(v1[n-1].m_key, <=, v1[n].m_key, "Vector sorted correctly");
+            require_e(v2[n-1].m_key, <=, v2[n].m_key, "Vector sorted correctly");
+            if (v1[n-1].m_key == v1[n].m_key)
+            {
+                require_e(v1[n-1].m_original_position, <, v1[n].m_original_position, "Sort is stable");
+            }
+            if (v2[n-1].m_key == v2[n].m_key)
+            {
+                require_e(v2[n-1].m_original_position, <, v2[n].m_original_position, "Sort is stable");
+            }
+        }
+    }
 }
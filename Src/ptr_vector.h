@@ -22,8 +22,11 @@
 #ifndef _ptr_vector_
 #define _ptr_vector_
 
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include <iostream>
+#include <utility>
 
 #include "Utils.h"
 
@@ -36,6 +39,119 @@ namespace AriaMaestosa
         HOLD
     };
     
+    /** Runs shorter than this are extended with insertion sort before merging (like timsort does) */
+    const unsigned int MERGE_SORT_MIN_RUN = 32;
+    
+    /**
+      * @brief stable, adaptive merge sort (a.k.a. natural merge sort)
+      *
+      * Runs of elements that are already in order (or in strictly reverse order, which are flipped)
+      * are detected first, then merged pairwise until a single run remains. Data that is already
+      * sorted costs a single O(n) pass, data made of a few sorted runs (e.g. a block of notes that
+      * was moved past other notes) costs O(n log runs), and the worst case is O(n log n), whereas
+      * insertion sort degrades to O(n^2).
+      *
+      * @param data  The vector to sort
+      * @param less  Strict weak ordering, called as less(a, b)
+      * @param start Elements before this index are left untouched
+      */
+    template<typename T, typename LESS>
+    void naturalMergeSort(std::vector<T>& data, LESS less, unsigned int start=0)
+    {
+        const unsigned int count = data.size();
+        if (start + 1 >= count) return;
+        
+        // ---- find runs. runs[n] is where run n starts, the last entry is the end of the data
+        std::vector<unsigned int> runs;
+        unsigned int runStart = start;
+        while (runStart < count)
+        {
+            runs.push_back(runStart);
+            
+            unsigned int runEnd = runStart + 1;
+            if (runEnd < count and less(data[runEnd], data[runStart]))
+            {
+                // strictly descending run; since no two elements are equal, reversing it is stable
+                while (runEnd < count and less(data[runEnd], data[runEnd-1])) runEnd++;
+                std::reverse(data.begin() + runStart, data.begin() + runEnd);
+            }
+            else
+            {
+                while (runEnd < count and not less(data[runEnd], data[runEnd-1])) runEnd++;
+            }
+            
+            // extend short runs with insertion sort, merging many tiny runs is wasteful
+            const unsigned int minEnd = std::min(count, runStart + MERGE_SORT_MIN_RUN);
+            for (; runEnd < minEnd; runEnd++)
+            {
+                T t = data[runEnd];
+                unsigned int i = runEnd;
+                while (i > runStart and less(t, data[i-1]))
+                {
+                    data[i] = data[i-1];
+                    i--;
+                }
+                data[i] = t;
+            }
+            
+            runStart = runEnd;
+        }
+        
+        // already sorted
+        if (runs.size() == 1) return;
+        
+        runs.push_back(count);
+        
+        // ---- merge adjacent runs pairwise, going back and forth between 'data' and a buffer
+        std::vector<T> buffer(data);
+        std::vector<T>* from = &data;
+        std::vector<T>* to   = &buffer;
+        
+        while (runs.size() > 2)
+        {
+            std::vector<unsigned int> merged;
+            unsigned int n = 0;
+            for (; n+2 < runs.size(); n += 2)
+            {
+                // std::merge is stable : on ties, elements of the first range come first
+                std::merge(from->begin() + runs[n],   from->begin() + runs[n+1],
+                           from->begin() + runs[n+1], from->begin() + runs[n+2],
+                           to->begin() + runs[n], less);
+                merged.push_back(runs[n]);
+            }
+            
+            // odd run out is copied as-is
+            if (n+1 < runs.size())
+            {
+                std::copy(from->begin() + runs[n], from->begin() + runs[n+1], to->begin() + runs[n]);
+                merged.push_back(runs[n]);
+            }
+            merged.push_back(count);
+            
+            runs.swap(merged);
+            std::swap(from, to);
+        }
+        
+        if (from != &data) data.swap(buffer);
+    }
+    
+    /** @brief comparator for naturalMergeSort, compares pointed-to objects with operator< */
+    template<typename TYPE>
+    struct PointeeLess
+    {
+        bool operator()(const TYPE* a, const TYPE* b) const { return *a < *b; }
+    };
+    
+    /** @brief comparator for naturalMergeSort, compares (key, value) pairs by key only */
+    template<typename KEY, typename VALUE>
+    struct KeyLess
+    {
+        bool operator()(const std::pair<KEY, VALUE>& a, const std::pair<KEY, VALUE>& b) const
+        {
+            return a.first < b.first;
+        }
+    };
+    
     template<typename TYPE, VECTOR_TYPE type=HOLD>
     class ptr_vector
     {
@@ -426,6 +542,80 @@ namespace AriaMaestosa
                 contentsVector[i] = t;
             }
         }
+        
+        // ------------------------------------------------------------------------
+        
+        /**
+          * @brief stable sort using operator<, see naturalMergeSort.
+          *
+          * Same order as insertionSort, but stays O(n log n) when many elements are out of place.
+          * (Equal elements keep their relative order here; insertionSort may swap neighbouring ones.)
+          * @return whether the order of the elements changed
+          */
+        bool mergeSort(unsigned int start=0)
+        {
+            ASSERT( MAGIC_NUMBER_OK() );
+            ASSERT( not m_performing_deletion );
+            
+            // fast path : nothing to do if the vector is still in order
+            const unsigned int count = contentsVector.size();
+            unsigned int n = start + 1;
+            while (n < count and not (*contentsVector[n] < *contentsVector[n-1])) n++;
+            if (n >= count) return false;
+            
+            naturalMergeSort(contentsVector, PointeeLess<TYPE>(), start);
+            return true;
+        }
+        
+        // ------------------------------------------------------------------------
+        
+        /**
+          * @brief stable sort on the field returned by 'getSortFieldFn', see naturalMergeSort.
+          *
+          * Same order as the corresponding insertionSort, but stays O(n log n) when many elements are
+          * out of place; unlike it, equal elements always keep their relative order. The sort fields are extracted once up-front, so the comparisons do not need
+          * to go through the function and the object pointers.
+          * @return whether the order of the elements changed
+          */
+        template<typename F, typename T>
+        bool mergeSort(F (*getSortFieldFn)(T*))
+        {
+            ASSERT( MAGIC_NUMBER_OK() );
+            ASSERT( not m_performing_deletion );
+            
+            const unsigned int count = contentsVector.size();
+            if (count < 2) return false;
+            
+            // fast path : nothing to do if the vector is still in order
+            bool sorted = true;
+            F previous = getSortFieldFn(contentsVector[0]);
+            for (unsigned int n=1; n<count; n++)
+            {
+                F current = getSortFieldFn(contentsVector[n]);
+                if (current < previous)
+                {
+                    sorted = false;
+                    break;
+                }
+                previous = current;
+            }
+            if (sorted) return false;
+            
+            std::vector< std::pair<F, TYPE*> > keyed;
+            keyed.reserve(count);
+            for (unsigned int n=0; n<count; n++)
+            {
+                keyed.push_back( std::make_pair(getSortFieldFn(contentsVector[n]), contentsVector[n]) );
+            }
+            
+            naturalMergeSort(keyed, KeyLess<F, TYPE*>());
+            
+            for (unsigned int n=0; n<count; n++)
+            {
+                contentsVector[n] = keyed[n].second;
+            }
+            return true;
+        }
     };
     
     template<typename T>
@@ -452,7 +642,11 @@ namespace AriaMaestosa
             }
         }
         
-        
+        /** @brief stable sort using operator<, see naturalMergeSort */
+        void mergeSort(unsigned int start=0)
+        {
+            naturalMergeSort(*this, std::less<T>(), start);
+        }
     };
     
 }
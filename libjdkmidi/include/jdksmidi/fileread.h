@@ -55,7 +55,7 @@ class MIDIFileRead;
 class MIDIFileReadStream
 {
 public:
-    MIDIFileReadStream()
+    MIDIFileReadStream() : buf_cur ( 0 ), buf_end ( 0 )
     {
     }
 
@@ -66,6 +66,28 @@ public:
     virtual void Rewind() = 0;
 
     virtual int ReadChar() = 0;
+
+    // non-virtual fast path used by MIDIFileRead : returns the next byte of the current buffer
+    // window, and only goes through a virtual call when the window is exhausted
+    int GetChar()
+    {
+        if ( buf_cur < buf_end )
+            return *buf_cur++;
+
+        return Refill();
+    }
+
+protected:
+    // called by GetChar() when the buffer window is empty. Buffered streams set up a new window
+    // and return its first byte (or -1 at the end of the stream); unbuffered streams keep the
+    // default, which reads one byte at a time
+    virtual int Refill()
+    {
+        return ReadChar();
+    }
+
+    const unsigned char *buf_cur;
+    const unsigned char *buf_end;
 };
 
 class MIDIFileReadStreamFile : public MIDIFileReadStream
@@ -119,6 +141,87 @@ private:
     FILE *f;
 };
 
+// reads the file in large blocks instead of one fgetc() per byte
+class MIDIFileReadStreamBufferedFile : public MIDIFileReadStream
+{
+public:
+    enum { BUFFER_SIZE = 64 * 1024 };
+
+    explicit MIDIFileReadStreamBufferedFile ( const char *fname );
+#ifdef WIN32
+    explicit MIDIFileReadStreamBufferedFile ( const wchar_t *fname );
+#endif
+    explicit MIDIFileReadStreamBufferedFile ( FILE *f_ );
+
+    virtual ~MIDIFileReadStreamBufferedFile();
+
+    virtual void Rewind();
+
+    bool IsValid()
+    {
+        return f != 0;
+    }
+
+    virtual int ReadChar()
+    {
+        return GetChar();
+    }
+
+protected:
+    virtual int Refill();
+
+private:
+    FILE *f;
+    unsigned char *buffer;
+};
+
+// maps the whole file in memory, so reading is a pointer increment. Where the file can't be
+// mapped, it is read in memory in one go instead
+class MIDIFileReadStreamMapped : public MIDIFileReadStream
+{
+public:
+    explicit MIDIFileReadStreamMapped ( const char *fname );
+#ifdef WIN32
+    explicit MIDIFileReadStreamMapped ( const wchar_t *fname );
+#endif
+
+    virtual ~MIDIFileReadStreamMapped();
+
+    virtual void Rewind()
+    {
+        buf_cur = data;
+        buf_end = data + size;
+    }
+
+    bool IsValid()
+    {
+        return valid;
+    }
+
+    virtual int ReadChar()
+    {
+        return GetChar();
+    }
+
+protected:
+    virtual int Refill()
+    {
+        return -1;
+    }
+
+private:
+    void MapFile ( FILE *f );
+    void Release();
+
+    const unsigned char *data;
+    unsigned long size;
+    bool valid;
+    bool mapped;       // false if data was read in a heap buffer
+#ifdef WIN32
+    void *mapping;     // HANDLE of the file mapping
+#endif
+};
+
 class MIDIFileEvents : protected MIDIFile
 {
 public:
@@ -38,6 +38,15 @@
 #include "jdksmidi/world.h"
 #include "jdksmidi/fileread.h"
 
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // Standard MIDI-File Format Spec. 1.1, page 9 of 18:
 // "Sysex events and meta events cancel any running status which was in effect.
 // Running status does not apply to and may not be used for these messages."
@@ -48,6 +57,170 @@
 namespace jdksmidi
 {
 
+MIDIFileReadStreamBufferedFile::MIDIFileReadStreamBufferedFile ( const char *fname )
+{
+    f = fopen ( fname, "rb" );
+    buffer = new unsigned char[BUFFER_SIZE];
+}
+
+#ifdef WIN32
+MIDIFileReadStreamBufferedFile::MIDIFileReadStreamBufferedFile ( const wchar_t *fname )
+{
+    f = _wfopen ( fname, L"rb" );
+    buffer = new unsigned char[BUFFER_SIZE];
+}
+#endif
+
+MIDIFileReadStreamBufferedFile::MIDIFileReadStreamBufferedFile ( FILE *f_ ) : f ( f_ )
+{
+    buffer = new unsigned char[BUFFER_SIZE];
+}
+
+MIDIFileReadStreamBufferedFile::~MIDIFileReadStreamBufferedFile()
+{
+    if ( f ) fclose ( f );
+    jdks_safe_delete_array( buffer );
+}
+
+void MIDIFileReadStreamBufferedFile::Rewind()
+{
+    if ( f ) rewind ( f );
+    buf_cur = buf_end = 0;
+}
+
+int MIDIFileReadStreamBufferedFile::Refill()
+{
+    if ( !f || feof ( f ) || ferror ( f ) )
+        return -1;
+
+    size_t n = fread ( buffer, 1, BUFFER_SIZE, f );
+    if ( n == 0 )
+        return -1;
+
+    buf_cur = buffer;
+    buf_end = buffer + n;
+    return *buf_cur++;
+}
+
+
+MIDIFileReadStreamMapped::MIDIFileReadStreamMapped ( const char *fname )
+    : data ( 0 ), size ( 0 ), valid ( false ), mapped ( false )
+#ifdef WIN32
+    , mapping ( 0 )
+#endif
+{
+    FILE *f = fopen ( fname, "rb" );
+    if ( f )
+    {
+        MapFile ( f );
+        fclose ( f );
+    }
+    Rewind();
+}
+
+#ifdef WIN32
+MIDIFileReadStreamMapped::MIDIFileReadStreamMapped ( const wchar_t *fname )
+    : data ( 0 ), size ( 0 ), valid ( false ), mapped ( false ), mapping ( 0 )
+{
+    FILE *f = _wfopen ( fname, L"rb" );
+    if ( f )
+    {
+        MapFile ( f );
+        fclose ( f );
+    }
+    Rewind();
+}
+#endif
+
+MIDIFileReadStreamMapped::~MIDIFileReadStreamMapped()
+{
+    Release();
+}
+
+void MIDIFileReadStreamMapped::MapFile ( FILE *f )
+{
+    // the mapping stays valid after the file is closed
+#ifdef WIN32
+    HANDLE file = (HANDLE) _get_osfhandle ( _fileno ( f ) );
+    LARGE_INTEGER file_size;
+    if ( file != INVALID_HANDLE_VALUE && GetFileSizeEx ( file, &file_size ) && file_size.QuadPart > 0 &&
+         file_size.QuadPart < 0x7FFFFFFF )
+    {
+        size = (unsigned long) file_size.QuadPart;
+        HANDLE m = CreateFileMapping ( file, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( m != NULL )
+        {
+            void *view = MapViewOfFile ( m, FILE_MAP_READ, 0, 0, 0 );
+            if ( view != NULL )
+            {
+                mapping = (void *) m;
+                data = (const unsigned char *) view;
+                mapped = true;
+                valid = true;
+                return;
+            }
+            CloseHandle ( m );
+        }
+    }
+#else
+    struct stat st;
+    if ( fstat ( fileno ( f ), &st ) == 0 && st.st_size > 0 && st.st_size < 0x7FFFFFFF )
+    {
+        size = (unsigned long) st.st_size;
+        void *view = mmap ( NULL, size, PROT_READ, MAP_PRIVATE, fileno ( f ), 0 );
+        if ( view != MAP_FAILED )
+        {
+            data = (const unsigned char *) view;
+            mapped = true;
+            valid = true;
+            return;
+        }
+    }
+#endif
+
+    // could not map the file (empty file, unsupported file system...) : read it in one go
+    rewind ( f );
+    size = 0;
+    unsigned long capacity = 64 * 1024;
+    unsigned char *buffer = new unsigned char[capacity];
+    size_t n;
+    while ( ( n = fread ( buffer + size, 1, capacity - size, f ) ) > 0 )
+    {
+        size += (unsigned long) n;
+        if ( size == capacity )
+        {
+            unsigned char *bigger = new unsigned char[capacity * 2];
+            memcpy ( bigger, buffer, size );
+            delete[] buffer;
+            buffer = bigger;
+            capacity *= 2;
+        }
+    }
+    data = buffer;
+    valid = !ferror ( f );
+}
+
+void MIDIFileReadStreamMapped::Release()
+{
+    if ( mapped )
+    {
+#ifdef WIN32
+        UnmapViewOfFile ( (LPCVOID) data );
+        CloseHandle ( (HANDLE) mapping );
+#else
+        munmap ( (void *) data, size );
+#endif
+    }
+    else
+    {
+        delete[] data;
+    }
+    data = 0;
+    size = 0;
+    buf_cur = buf_end = 0;
+}
+
+
 void MIDIFileEvents::UpdateTime ( MIDIClockTime delta_time )
 {
 }
@@ -576,7 +749,7 @@ int MIDIFileRead::Read16Bit()
 int MIDIFileRead::EGetC()
 {
     int c;
-    c = input_stream->ReadChar();
+    c = input_stream->GetChar();
 
     if ( c < 0 )
     {